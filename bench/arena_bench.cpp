@@ -0,0 +1,302 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+
+#include "linkedlist.h"
+#include "datatypes.h"
+#include "distance.h"
+#include "rtree.h"
+#include "damage.h"
+#include "framebuffer.h"
+#include "render.h"
+#include "arena.h"
+#include "bench.h"
+
+// Compares scratch vertices taken from an arena with vertices from the pool and from malloc,
+// then checks the arena itself: alignment, growing in place, oversized allocations and block reuse.
+// Last it drags drafts over a headless canvas the way the tracking loops do, with the points of each
+// drag in an interaction arena and the node arrays of each repaint in a frame arena, and counts the
+// heap allocations of every frame after the first drag. With glibc, malloc is counted directly.
+// The same drags are repainted with node arrays from the heap, and both canvases must end the same.
+// Exits with 1 if any check fails or a steady-state frame allocates.
+// Build: g++ -O2 -std=c++11 -Iinclude bench/arena_bench.cpp src/arena.cpp src/damage.cpp src/datatypes.cpp
+//        src/distance.cpp src/framebuffer.cpp src/generate.cpp src/hittest.cpp src/linkedlist.cpp src/misc.cpp
+//        src/pool.cpp src/ptrmap.cpp src/render.cpp src/rtree.cpp src/shapestore.cpp
+
+#define BENCH_ROUNDS 2000000
+// Scratch vertices of one interaction, as in moveItem(): cursor, start and end points, and one spare
+#define BENCH_ROUND_VERTICES 4
+#define BENCH_WIDTH 1280
+#define BENCH_HEIGHT 960
+#define BENCH_SHAPES 20000
+#define BENCH_SHAPE_SIZE 60
+#define BENCH_DRAGS 200
+#define BENCH_DRAG_MOVES 40
+
+#define BENCH_SHAPE_COLOR 0xFFFFFF
+#define BENCH_DRAFT_COLOR 0xFF8000
+
+#ifdef __GLIBC__
+extern "C" void * __libc_malloc(size_t size);
+extern "C" void * __libc_calloc(size_t num, size_t size);
+extern "C" void * __libc_realloc(void *ptr, size_t size);
+
+static long long int heapAllocNum = 0;
+
+extern "C" void * malloc(size_t size) {
+    heapAllocNum++;
+    return __libc_malloc(size);
+}
+
+extern "C" void * calloc(size_t num, size_t size) {
+    heapAllocNum++;
+    return __libc_calloc(num, size);
+}
+
+extern "C" void * realloc(void *ptr, size_t size) {
+    heapAllocNum++;
+    return __libc_realloc(ptr, size);
+}
+#define BENCH_COUNTS_HEAP true
+#else
+// Elsewhere only the blocks of the arenas are counted
+static long long int heapAllocNum = 0;
+#define BENCH_COUNTS_HEAP false
+#endif
+
+/* Scratch vertices */
+
+static void benchScratch() {
+    long long int sum = 0;
+    struct Arena arena = ARENA_INITIALIZER("Bench", ARENA_BLOCK_SIZE);
+    double startMs = getNowMs();
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        for (int j = 0; j < BENCH_ROUND_VERTICES; j++) {
+            struct Vertex *vtx = (struct Vertex *)arenaAlloc(&arena, sizeof(struct Vertex));
+            vtx -> x = i;
+            vtx -> y = j;
+            sum += vtx -> x + vtx -> y;
+        }
+        resetArena(&arena);
+    }
+    double arenaMs = getNowMs() - startMs;
+    destroyArena(&arena);
+
+    struct Vertex *vtxs[BENCH_ROUND_VERTICES];
+    startMs = getNowMs();
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        for (int j = 0; j < BENCH_ROUND_VERTICES; j++) {
+            vtxs[j] = makeVertex(i, j);
+            sum += vtxs[j] -> x + vtxs[j] -> y;
+        }
+        for (int j = 0; j < BENCH_ROUND_VERTICES; j++) {
+            destroyVertex(vtxs[j]);
+        }
+    }
+    double poolMs = getNowMs() - startMs;
+
+    startMs = getNowMs();
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        for (int j = 0; j < BENCH_ROUND_VERTICES; j++) {
+            vtxs[j] = (struct Vertex *)malloc(sizeof(struct Vertex));
+            vtxs[j] -> x = i;
+            vtxs[j] -> y = j;
+            sum += vtxs[j] -> x + vtxs[j] -> y;
+        }
+        for (int j = 0; j < BENCH_ROUND_VERTICES; j++) {
+            free(vtxs[j]);
+        }
+    }
+    double mallocMs = getNowMs() - startMs;
+
+    double vertexNum = (double)BENCH_ROUNDS * BENCH_ROUND_VERTICES;
+    printf("scratch vertices: arena %.2f ns, pool %.2f ns, malloc %.2f ns per vertex (checksum %lld)\n",
+           arenaMs * 1e6 / vertexNum, poolMs * 1e6 / vertexNum, mallocMs * 1e6 / vertexNum, sum);
+}
+
+/* Arena checks */
+
+static bool checkArena() {
+    struct Arena arena = ARENA_INITIALIZER("Check", 256);
+    bool isPassed = true;
+
+    // Every allocation is aligned and apart from the others
+    char *prev = NULL;
+    for (int size = 1; size < 100; size += 7) {
+        char *cnt = (char *)arenaAlloc(&arena, size);
+        isPassed = isPassed && cnt != NULL && (size_t)cnt % ARENA_ALIGNMENT == 0;
+        if (cnt != NULL) {
+            memset(cnt, size, size);
+        }
+        isPassed = isPassed && (prev == NULL || prev[0] != cnt[0]);
+        prev = cnt;
+    }
+
+    // The latest allocation grows in place while its block has room, and keeps its bytes when moved
+    resetArena(&arena);
+    int *ints = (int *)arenaAlloc(&arena, sizeof(int) * 4);
+    for (int i = 0; i < 4; i++) {
+        ints[i] = i;
+    }
+    int *grown = (int *)arenaRealloc(&arena, ints, sizeof(int) * 4, sizeof(int) * 16);
+    isPassed = isPassed && grown == ints;
+    int *moved = (int *)arenaRealloc(&arena, grown, sizeof(int) * 16, sizeof(int) * 1000);
+    isPassed = isPassed && moved != NULL && moved != grown && moved[0] == 0 && moved[3] == 3;
+
+    // Once a round has run, the same rounds are served by the blocks kept, without asking the system again
+    long long int blockNum = -1;
+    for (int round = 0; round < 10; round++) {
+        if (round == 1) {
+            blockNum = arena.blockNum;
+        }
+        resetArena(&arena);
+        for (int size = 1; size < 100; size += 7) {
+            arenaAlloc(&arena, size);
+        }
+        arenaAlloc(&arena, sizeof(int) * 1000);
+    }
+    isPassed = isPassed && arena.blockNum == blockNum;
+
+    struct ArenaStats stats;
+    getArenaStats(&arena, &stats);
+    printf("arena checks: %lld allocations, %lld blocks, %lld bytes reserved, %s\n",
+           stats.allocNum, stats.blockNum, (long long int)stats.reservedBytes, isPassed ? "ok" : "FAILED");
+    destroyArena(&arena);
+    return isPassed;
+}
+
+/* Drags */
+
+// Box of the shape a drag from startPt to endPt draws, as getShapeBoundingBox() finds it
+static void getDraftBox(const struct Vertex *startPt, const struct Vertex *endPt, int shapeType, struct BoundingBox *box) {
+    struct Vertex centerPt = {(startPt -> x + endPt -> x) / 2, (startPt -> y + endPt -> y) / 2};
+    int xRadius = abs(endPt -> x - centerPt.x), yRadius = abs(endPt -> y - centerPt.y);
+    if (shapeType == DATATYPE_CIRCLE) {
+        xRadius = yRadius = sqrt(getSqrEuclideanDistance(&centerPt, endPt));
+    }
+    if (shapeType == DATATYPE_CIRCLE || shapeType == DATATYPE_ELLIPSE) {
+        box -> minx = centerPt.x - xRadius;
+        box -> miny = centerPt.y - yRadius;
+        box -> maxx = centerPt.x + xRadius;
+        box -> maxy = centerPt.y + yRadius;
+    } else {
+        box -> minx = min(startPt -> x, endPt -> x);
+        box -> miny = min(startPt -> y, endPt -> y);
+        box -> maxx = max(startPt -> x, endPt -> x);
+        box -> maxy = max(startPt -> y, endPt -> y);
+    }
+}
+
+// Play every drag on fb, taking node arrays from frameArena unless it is NULL
+// Returns the heap allocations of the frames after the first drag
+static long long int playDrags(struct LinkedList *list, struct FrameBuffer *fb, struct Arena *frameArena, double *frameMs) {
+    struct Arena interactionArena = ARENA_INITIALIZER("Interaction", ARENA_BLOCK_SIZE);
+    struct DamagePainter painter;
+    initFrameBufferPainter(fb, &painter);
+    painter.scratch = frameArena;
+    struct RenderBackend backend;
+    initFrameBufferBackend(fb, &backend);
+    struct BoundingBox screenBox = {0, 0, fb -> width - 1, fb -> height - 1};
+
+    fbRedrawAll(fb, list);
+    randomState = 977u;
+    long long int steadyAllocNum = 0;
+    double startMs = getNowMs();
+    for (int drag = 0; drag < BENCH_DRAGS; drag++) {
+        resetArena(&interactionArena);
+        int shapeType = DATATYPE_SEGMENT + drag % 4;
+        struct Vertex *startPt = (struct Vertex *)arenaAlloc(&interactionArena, sizeof(struct Vertex));
+        struct Vertex *endPt = (struct Vertex *)arenaAlloc(&interactionArena, sizeof(struct Vertex));
+        startPt -> x = endPt -> x = nextRandom(BENCH_WIDTH);
+        startPt -> y = endPt -> y = nextRandom(BENCH_HEIGHT);
+        int deltax = nextRandom(300) - 150, deltay = nextRandom(300) - 150;
+        struct BoundingBox draftBox;
+        getDraftBox(startPt, endPt, shapeType, &draftBox);
+
+        for (int move = 1; move <= BENCH_DRAG_MOVES; move++) {
+            long long int frameAllocNum = heapAllocNum;
+            if (frameArena != NULL) {
+                resetArena(frameArena);
+            }
+            endPt -> x = startPt -> x + deltax * move / BENCH_DRAG_MOVES;
+            endPt -> y = startPt -> y + deltay * move / BENCH_DRAG_MOVES;
+
+            struct Damage damage;
+            initDamage(&damage);
+            addDamage(&damage, &draftBox);
+            getDraftBox(startPt, endPt, shapeType, &draftBox);
+            addDamage(&damage, &draftBox);
+            clipDamage(&damage, &screenBox);
+            repaintDamage(list, &damage, &painter);
+            renderShape(&backend, startPt, endPt, shapeType, BENCH_DRAFT_COLOR);
+
+            if (drag > 0) {
+                steadyAllocNum += heapAllocNum - frameAllocNum;
+            }
+        }
+        // The draft is dropped, as redrawAll() does once the drag ends
+        struct Damage damage;
+        initDamage(&damage);
+        addDamage(&damage, &draftBox);
+        clipDamage(&damage, &screenBox);
+        repaintDamage(list, &damage, &painter);
+    }
+    *frameMs = (getNowMs() - startMs) / (BENCH_DRAGS * BENCH_DRAG_MOVES);
+
+    if (!BENCH_COUNTS_HEAP) {
+        steadyAllocNum = interactionArena.blockNum - 1 + (frameArena != NULL ? frameArena -> blockNum - 1 : 0);
+    }
+    destroyArena(&interactionArena);
+    return steadyAllocNum;
+}
+
+static bool checkDrags() {
+    struct GenerateOptions options;
+    initBenchOptions(&options, BENCH_SHAPES, BENCH_WIDTH, BENCH_HEIGHT, BENCH_SHAPE_SIZE);
+    struct LinkedList list;
+    initLinkedList(&list);
+    if (generateDrawing(&list, &options) != BENCH_SHAPES) {
+        return false;
+    }
+    struct RTree *tree = makeRTree();
+    struct FrameBuffer *fb = makeFrameBuffer(BENCH_WIDTH, BENCH_HEIGHT);
+    struct FrameBuffer *heapFb = makeFrameBuffer(BENCH_WIDTH, BENCH_HEIGHT);
+    if (tree == NULL || fb == NULL || heapFb == NULL) {
+        return false;
+    }
+    buildRTree(tree, &list);
+    attachIndex(&list, &tree -> index);
+    fb -> color = heapFb -> color = BENCH_SHAPE_COLOR;
+
+    struct Arena frameArena = ARENA_INITIALIZER("Frame", DAMAGE_SCRATCH_BLOCK_SIZE);
+    double frameMs = 0.0, heapFrameMs = 0.0;
+    long long int allocNum = playDrags(&list, fb, &frameArena, &frameMs);
+    long long int heapAllocNum = playDrags(&list, heapFb, NULL, &heapFrameMs);
+    bool isSame = memcmp(fb -> pixels, heapFb -> pixels, sizeof(unsigned int) * BENCH_WIDTH * BENCH_HEIGHT) == 0;
+
+    const char *counted = BENCH_COUNTS_HEAP ? "heap allocations" : "arena blocks added";
+    printf("drags with scratch arenas: %.3f ms per frame, %lld %s after the first drag\n", frameMs, allocNum, counted);
+    printf("drags with heap arrays:    %.3f ms per frame, %lld %s after the first drag\n", heapFrameMs, heapAllocNum, counted);
+    printf("frame arena: %lld blocks, %lld bytes at most per frame\n", frameArena.blockNum, (long long int)frameArena.peakBytes);
+    if (!isSame) {
+        printf("the canvases differ\n");
+    }
+
+    destroyArena(&frameArena);
+    detachIndex(&list, &tree -> index);
+    destroyRTree(tree);
+    destroyLinkedList(&list, destroyRule);
+    destroyFrameBuffer(fb);
+    destroyFrameBuffer(heapFb);
+    return isSame && allocNum == 0;
+}
+
+int main() {
+    benchScratch();
+    bool isPassed = checkArena();
+    isPassed = checkDrags() && isPassed;
+    printf(isPassed ? "all checks passed\n" : "checks FAILED\n");
+    return isPassed ? 0 : 1;
+}
@@ -0,0 +1,52 @@
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <time.h>
+#include <chrono>
+
+#include "linkedlist.h"
+#include "datatypes.h"
+#include "generate.h"
+
+// Shared by the benches: clocks, a repeatable random sequence, and drawings from the generator.
+// Each bench is a program of its own, so everything here is static to it, and inline so that unused parts go quietly.
+// Include it after the standard headers, <chrono> among them, as misc.h defines min and max.
+
+// Returns wall time in milliseconds
+static inline double getNowMs() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Returns processor time spent since start in milliseconds
+static inline double getElapsedMs(clock_t start) {
+    return (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+static unsigned int randomState = 2463534242u;
+
+// Returns an integer in [0, range), the same sequence on every run
+static inline int nextRandom(int range) {
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return (int)(randomState % (unsigned int)range);
+}
+
+// Fill options with shapeNum shapes of sizes up to maxSize centered over a width x height page,
+// so that those near its edges stick out of it
+// Returns nothing
+static inline void initBenchOptions(struct GenerateOptions *options, int shapeNum, int width, int height, int maxSize) {
+    initGenerateOptions(options);
+    options -> shapeNum = shapeNum;
+    options -> width = width;
+    options -> height = height;
+    options -> maxSize = maxSize;
+    options -> minSize = min(options -> minSize, maxSize);
+}
+
+// Returns one more shape as the drawing of options has them, following the random sequence
+static inline struct NodeData * makeRandomData(const struct GenerateOptions *options) {
+    return generateShape(options, (unsigned int)nextRandom(1 << 30));
+}
+
+#endif
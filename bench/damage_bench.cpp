@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <chrono>
+
+#include "linkedlist.h"
+#include "datatypes.h"
+#include "rtree.h"
+#include "damage.h"
+#include "framebuffer.h"
+#include "render.h"
+#include "bench.h"
+
+// Drags a draft shape over random shapes on a headless framebuffer,
+// repainting only the damaged rectangles each frame, and compares the pixels
+// with a full redraw of the same frame. Timing is reported with and without an R-tree.
+// Exits with 1 if any frame differs.
+// Build: g++ -O2 -std=c++11 -Iinclude bench/damage_bench.cpp src/arena.cpp src/damage.cpp src/datatypes.cpp src/distance.cpp
+//        src/framebuffer.cpp src/generate.cpp src/linkedlist.cpp src/misc.cpp src/pool.cpp src/render.cpp
+//        src/rtree.cpp src/hittest.cpp src/ptrmap.cpp src/shapestore.cpp
+
+#define BENCH_WIDTH 1280
+#define BENCH_HEIGHT 960
+#define BENCH_SHAPE_SIZE 60
+#define BENCH_FRAME_NUM 400
+
+#define BENCH_SHAPE_COLOR 0xFFFFFF
+#define BENCH_DRAFT_COLOR 0xFF8000
+
+// Move the draft ellipse along a Lissajous-like path, growing and shrinking as it goes
+static void moveDraft(struct NodeData *draft, int frame) {
+    struct Ellipse *elp = (struct Ellipse *)draft -> content;
+    int phase = frame % 200 < 100 ? frame % 100 : 100 - frame % 100;
+    elp -> centerPt -> x = BENCH_WIDTH / 8 + (BENCH_WIDTH * 3 / 4) * phase / 100;
+    elp -> centerPt -> y = BENCH_HEIGHT / 2 + (frame * 7 % 301) - 150;
+    elp -> majorSemiAxis = 20 + frame % 37;
+    elp -> minorSemiAxis = 15 + frame * 3 % 29;
+}
+
+static void drawDraft(struct FrameBuffer *fb, const struct NodeData *draft) {
+    struct RenderBackend backend;
+    initFrameBufferBackend(fb, &backend);
+    renderNodeData(&backend, draft, BENCH_DRAFT_COLOR, true, 0, 0);
+}
+
+// Play every frame with damage repaints on fb and, if reference is not NULL, a full redraw on reference
+// Returns the number of frames whose pixels differ
+static int playFrames(struct LinkedList *list, struct FrameBuffer *fb, struct FrameBuffer *reference) {
+    struct DamagePainter painter;
+    initFrameBufferPainter(fb, &painter);
+    struct NodeData *draft = makeData(makeEllipse(makeVertex(0, 0), 1, 1), DATATYPE_ELLIPSE);
+
+    moveDraft(draft, 0);
+    fbRedrawAll(fb, list);
+    drawDraft(fb, draft);
+    struct BoundingBox draftBox;
+    getDataBoundingBox(draft, &draftBox);
+
+    int mismatchNum = 0;
+    for (int frame = 1; frame < BENCH_FRAME_NUM; frame++) {
+        struct Damage damage;
+        initDamage(&damage);
+        addDamage(&damage, &draftBox);
+        moveDraft(draft, frame);
+        getDataBoundingBox(draft, &draftBox);
+        addDamage(&damage, &draftBox);
+
+        struct BoundingBox screenBox = {0, 0, fb -> width - 1, fb -> height - 1};
+        clipDamage(&damage, &screenBox);
+        repaintDamage(list, &damage, &painter);
+        drawDraft(fb, draft);
+
+        if (reference != NULL) {
+            fbRedrawAll(reference, list);
+            drawDraft(reference, draft);
+            size_t byteNum = sizeof(unsigned int) * fb -> width * fb -> height;
+            mismatchNum += memcmp(fb -> pixels, reference -> pixels, byteNum) != 0;
+        }
+    }
+
+    destroyRule(draft);
+    return mismatchNum;
+}
+
+// Play every frame with full redraws only
+static void playFullFrames(struct LinkedList *list, struct FrameBuffer *fb) {
+    struct NodeData *draft = makeData(makeEllipse(makeVertex(0, 0), 1, 1), DATATYPE_ELLIPSE);
+    for (int frame = 0; frame < BENCH_FRAME_NUM; frame++) {
+        moveDraft(draft, frame);
+        fbRedrawAll(fb, list);
+        drawDraft(fb, draft);
+    }
+    destroyRule(draft);
+}
+
+int main() {
+    struct FrameBuffer *fb = makeFrameBuffer(BENCH_WIDTH, BENCH_HEIGHT);
+    struct FrameBuffer *reference = makeFrameBuffer(BENCH_WIDTH, BENCH_HEIGHT);
+    if (fb == NULL || reference == NULL) {
+        return 1;
+    }
+    fb -> color = reference -> color = BENCH_SHAPE_COLOR;
+
+    bool isAllMatched = true;
+    printf("%8s %8s %10s %14s %14s %10s\n", "shapes", "rtree", "mismatch", "full ms/frame", "damage ms/frame", "speedup");
+    for (int shapeNum = 1000; shapeNum <= 100000; shapeNum *= 10) {
+        for (int isTreed = 0; isTreed <= 1; isTreed++) {
+            struct LinkedList list;
+            initLinkedList(&list);
+            struct RTree *tree = makeRTree();
+            if (isTreed) {
+                attachIndex(&list, &tree -> index);
+            }
+            // Some shapes stick out of the framebuffer
+            struct GenerateOptions options;
+            initBenchOptions(&options, shapeNum, BENCH_WIDTH, BENCH_HEIGHT, BENCH_SHAPE_SIZE);
+            if (generateDrawing(&list, &options) != shapeNum) {
+                return 1;
+            }
+
+            int mismatchNum = playFrames(&list, fb, reference);
+            isAllMatched = isAllMatched && mismatchNum == 0;
+
+            clock_t start = clock();
+            playFullFrames(&list, reference);
+            double fullMs = getElapsedMs(start) / BENCH_FRAME_NUM;
+
+            start = clock();
+            playFrames(&list, fb, NULL);
+            double damageMs = getElapsedMs(start) / BENCH_FRAME_NUM;
+
+            printf("%8d %8s %10d %14.3f %14.3f %9.1fx\n", shapeNum, isTreed ? "yes" : "no", mismatchNum,
+                   fullMs, damageMs, damageMs > 0 ? fullMs / damageMs : 0.0);
+
+            destroyLinkedList(&list, destroyRule);
+            if (isTreed) {
+                detachIndex(&list, &tree -> index);
+            }
+            destroyRTree(tree);
+        }
+    }
+
+    destroyFrameBuffer(fb);
+    destroyFrameBuffer(reference);
+    return isAllMatched ? 0 : 1;
+}
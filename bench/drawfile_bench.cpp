@@ -0,0 +1,228 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "linkedlist.h"
+#include "datatypes.h"
+#include "drawfile.h"
+#include "shapestore.h"
+#include "framebuffer.h"
+#include "render.h"
+#include "bench.h"
+
+// Saves a large drawing, then compares opening it by mapping with rebuilding every shape.
+// The mapped store is checked against the list it was saved from, pixel for pixel, and again
+// after edits that write into its private pages and force it off the mapping.
+// The shape count defaults to 1000000, the first argument overrides it down to 100.
+// Exits with 1 if anything differs or a damaged file is accepted.
+// Build: g++ -O2 -std=c++11 -Iinclude bench/drawfile_bench.cpp src/datatypes.cpp src/distance.cpp
+//        src/drawfile.cpp src/framebuffer.cpp src/generate.cpp src/hittest.cpp src/linkedlist.cpp
+//        src/misc.cpp src/pool.cpp src/ptrmap.cpp src/render.cpp src/rtree.cpp src/shapestore.cpp
+
+#define BENCH_PATH "drawfile_bench.cdw"
+#define BENCH_SHAPES 1000000
+#define BENCH_WIDTH 1280
+#define BENCH_HEIGHT 960
+#define BENCH_SHAPE_SIZE 80
+
+// Check that two lists hold the same shapes in the same order
+static bool isSameList(const struct LinkedList *list, const struct LinkedList *other) {
+    if (list -> listSize != other -> listSize) {
+        return false;
+    }
+    const struct LinkedNode *otherNode = other -> head;
+    for (const struct LinkedNode *cntNode = list -> head; cntNode != NULL; cntNode = cntNode -> next, otherNode = otherNode -> next) {
+        if (cntNode -> data -> type != otherNode -> data -> type ||
+            memcmp(&cntNode -> box, &otherNode -> box, sizeof(struct BoundingBox)) != 0) {
+            return false;
+        }
+        if (cntNode -> data -> type == DATATYPE_TEXT) {
+            const struct Text *txt = (const struct Text *)cntNode -> data -> content;
+            const struct Text *otherTxt = (const struct Text *)otherNode -> data -> content;
+            if (strcmp(txt -> content, otherTxt -> content) != 0 || txt -> fontWidth != otherTxt -> fontWidth ||
+                txt -> fontHeight != otherTxt -> fontHeight) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Render every live slot of a store in z-order, without any list
+static void renderStore(struct FrameBuffer *fb, const struct ShapeStore *store) {
+    struct RenderBackend backend;
+    initFrameBufferBackend(fb, &backend);
+    fbFillRect(fb, 0, 0, fb -> width - 1, fb -> height - 1, fb -> bgColor);
+    for (int i = store -> orderBegin; i < store -> orderEnd; i++) {
+        if (store -> order[i] != SHAPESTORE_HOLE) {
+            renderStoreShape(&backend, store, store -> order[i], fb -> color, false);
+        }
+    }
+}
+
+// Render the list walking its nodes, whatever index is attached
+static void renderNodes(struct FrameBuffer *fb, const struct LinkedList *list) {
+    struct RenderBackend backend;
+    initFrameBufferBackend(fb, &backend);
+    fbFillRect(fb, 0, 0, fb -> width - 1, fb -> height - 1, fb -> bgColor);
+    for (const struct LinkedNode *cntNode = list -> head; cntNode != NULL; cntNode = cntNode -> next) {
+        renderNodeData(&backend, cntNode -> data, fb -> color, false, 0, 0);
+    }
+}
+
+static bool isSamePixels(const struct FrameBuffer *fb, const struct FrameBuffer *other) {
+    return memcmp(fb -> pixels, other -> pixels, sizeof(unsigned int) * fb -> width * fb -> height) == 0;
+}
+
+// Write the first size bytes of the file at path into damagedPath, with one byte changed
+static bool writeDamagedCopy(const char *path, const char *damagedPath, long size, long changedPos) {
+    FILE *in = fopen(path, "rb"), *out = fopen(damagedPath, "wb");
+    bool isWritten = in != NULL && out != NULL;
+    for (long i = 0; i < size && isWritten; i++) {
+        int c = fgetc(in);
+        isWritten = c != EOF && fputc(i == changedPos ? c ^ 0x55 : c, out) != EOF;
+    }
+    if (in != NULL) {
+        fclose(in);
+    }
+    return out != NULL && fclose(out) == 0 && isWritten;
+}
+
+int main(int argc, char *argv[]) {
+    // The edits below need a few shapes, texts among them
+    int shapeNum = max(argc > 1 ? atoi(argv[1]) : BENCH_SHAPES, 100);
+    struct FrameBuffer *fb = makeFrameBuffer(BENCH_WIDTH, BENCH_HEIGHT);
+    struct FrameBuffer *reference = makeFrameBuffer(BENCH_WIDTH, BENCH_HEIGHT);
+    if (fb == NULL || reference == NULL) {
+        return 1;
+    }
+
+    struct GenerateOptions options;
+    initBenchOptions(&options, shapeNum, BENCH_WIDTH, BENCH_HEIGHT, BENCH_SHAPE_SIZE);
+    struct LinkedList list;
+    initLinkedList(&list);
+    if (generateDrawing(&list, &options) != shapeNum) {
+        return 1;
+    }
+
+    double start = getNowMs();
+    if (!saveDrawFile(&list, BENCH_PATH)) {
+        return 1;
+    }
+    double saveMs = getNowMs() - start;
+
+    // Open by mapping: the store is usable for redraws and hit tests right away
+    start = getNowMs();
+    struct DrawFile *file = openDrawFile(BENCH_PATH);
+    if (file == NULL) {
+        return 1;
+    }
+    double openMs = getNowMs() - start;
+    struct ShapeStore *mappedStore = makeShapeStore();
+    start = getNowMs();
+    if (mappedStore == NULL || !mapShapeStore(mappedStore, file, NULL)) {
+        return 1;
+    }
+    double mapMs = getNowMs() - start;
+
+    // Open by rebuilding every node, then copying it into a store
+    struct LinkedList loaded;
+    initLinkedList(&loaded);
+    start = getNowMs();
+    if (!loadDrawFile(&loaded, file)) {
+        return 1;
+    }
+    double loadMs = getNowMs() - start;
+    struct ShapeStore *builtStore = makeShapeStore();
+    start = getNowMs();
+    if (builtStore == NULL || !buildShapeStore(builtStore, &loaded)) {
+        return 1;
+    }
+    double buildMs = getNowMs() - start;
+
+    printf("%d shapes, %.1f MB on disk, saved in %.1f ms\n", shapeNum, file -> size / 1048576.0, saveMs);
+    printf("%28s %12s\n", "step", "ms");
+    printf("%28s %12.3f\n", "map and check file", openMs);
+    printf("%28s %12.3f\n", "point store into mapping", mapMs);
+    printf("%28s %12.3f\n", "rebuild nodes from file", loadMs);
+    printf("%28s %12.3f\n", "copy nodes into store", buildMs);
+    printf("ready to draw: %.3f ms mapped, %.3f ms rebuilt (%.1fx)\n", openMs + mapMs, openMs + loadMs + buildMs,
+           openMs + mapMs > 0 ? (openMs + loadMs + buildMs) / (openMs + mapMs) : 0.0);
+    // The editor still needs the nodes, so it maps the store and rebuilds them too
+    printf("open in the editor: %.3f ms\n", openMs + mapMs + loadMs);
+
+    bool isPassed = true;
+    if (!isSameList(&list, &loaded)) {
+        printf("loaded list differs from the saved one\n");
+        isPassed = false;
+    }
+    renderNodes(reference, &list);
+    renderStore(fb, mappedStore);
+    if (!isSamePixels(fb, reference)) {
+        printf("mapped store draws differently from the saved list\n");
+        isPassed = false;
+    }
+    destroyShapeStore(builtStore);
+    destroyShapeStore(mappedStore);
+
+    // Edit a list bound to a mapped store: writes land in private pages, growing leaves the mapping
+    mappedStore = makeShapeStore();
+    if (mappedStore == NULL || !mapShapeStore(mappedStore, file, &loaded)) {
+        return 1;
+    }
+    attachIndex(&loaded, &mappedStore -> index);
+    deleteNode(&loaded, loaded.head -> next, destroyRule);
+    editNode(&loaded, loaded.tail, makeRandomData(&options), destroyRule);
+    moveToTail(&loaded, loaded.head);
+    bool wasMapped = mappedStore -> mappedFile != NULL;
+    addNodeAtTail(&loaded, makeRandomData(&options));
+    addNodeAtHead(&loaded, makeRandomData(&options));
+    renderNodes(reference, &loaded);
+    renderStore(fb, mappedStore);
+    if (!wasMapped || mappedStore -> mappedFile != NULL || !isSamePixels(fb, reference)) {
+        printf("mapped store went out of sync with its list\n");
+        isPassed = false;
+    }
+    destroyLinkedList(&loaded, destroyRule);
+    detachIndex(&loaded, &mappedStore -> index);
+    destroyShapeStore(mappedStore);
+    closeDrawFile(file);
+
+    // The file itself is untouched, and damaged copies are refused
+    file = openDrawFile(BENCH_PATH);
+    if (file == NULL || !loadDrawFile(&loaded, file) || !isSameList(&list, &loaded)) {
+        printf("edits leaked into the file\n");
+        isPassed = false;
+    }
+    if (file == NULL || file -> textNum == 0) {
+        return 1;
+    }
+    // Truncation, magic, version, a shape type, and the high byte of a content offset
+    long fileSize = (long)file -> size;
+    long typeOffset = (long)((const char *)file -> type - (const char *)file -> base);
+    long textOffset = (long)((const char *)file -> texts - (const char *)file -> base);
+    closeDrawFile(file);
+    const long damages[][2] = {{fileSize - 1, -1}, {fileSize, 0}, {fileSize, 8}, {fileSize, typeOffset},
+                               {fileSize, textOffset + (long)sizeof(struct DrawFileText) - 1}};
+    for (int i = 0; i < (int)(sizeof(damages) / sizeof(damages[0])); i++) {
+        if (!writeDamagedCopy(BENCH_PATH, BENCH_PATH ".bad", damages[i][0], damages[i][1])) {
+            return 1;
+        }
+        struct DrawFile *damaged = openDrawFile(BENCH_PATH ".bad");
+        if (damaged != NULL) {
+            printf("damaged file %d was accepted\n", i);
+            closeDrawFile(damaged);
+            isPassed = false;
+        }
+    }
+    remove(BENCH_PATH ".bad");
+    remove(BENCH_PATH);
+
+    destroyLinkedList(&loaded, destroyRule);
+    destroyLinkedList(&list, destroyRule);
+    destroyFrameBuffer(fb);
+    destroyFrameBuffer(reference);
+    printf(isPassed ? "all checks passed\n" : "checks FAILED\n");
+    return isPassed ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "linkedlist.h"
+#include "datatypes.h"
+#include "dxf.h"
+#include "bench.h"
+
+// Measures DXF export and import throughput on a large drawing, and checks that a round trip
+// gives the same shapes back. A small hand written file then checks what is read and what is skipped.
+// The shape count defaults to 1000000, the first argument overrides it.
+// Exits with 1 if anything differs.
+// Build: g++ -O2 -std=c++11 -Iinclude bench/dxf_bench.cpp src/datatypes.cpp src/distance.cpp src/dxf.cpp
+//        src/generate.cpp src/linkedlist.cpp src/misc.cpp src/pool.cpp src/textwriter.cpp
+
+#define BENCH_PATH "dxf_bench.dxf"
+#define BENCH_SHAPES 1000000
+#define BENCH_PAGE_HEIGHT 960
+#define BENCH_WIDTH 1280
+#define BENCH_SHAPE_SIZE 80
+
+// Check that two lists hold the same shapes in the same order
+static bool isSameList(const struct LinkedList *list, const struct LinkedList *other) {
+    if (list -> listSize != other -> listSize) {
+        return false;
+    }
+    const struct LinkedNode *otherNode = other -> head;
+    for (const struct LinkedNode *cntNode = list -> head; cntNode != NULL; cntNode = cntNode -> next, otherNode = otherNode -> next) {
+        if (cntNode -> data -> type != otherNode -> data -> type ||
+            memcmp(&cntNode -> box, &otherNode -> box, sizeof(struct BoundingBox)) != 0) {
+            return false;
+        }
+        if (cntNode -> data -> type == DATATYPE_TEXT &&
+            strcmp(((const struct Text *)cntNode -> data -> content) -> content,
+                   ((const struct Text *)otherNode -> data -> content) -> content) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool countBatchHook(void *arg, const struct DxfShape *shapes, int shapeNum) {
+    (void)shapes;
+    *(int *)arg += shapeNum;
+    return true;
+}
+
+// Entities to be read, to be skipped, and some to be ignored altogether
+static const char *sampleDxf =
+    "  0\r\nSECTION\r\n  2\r\nBLOCKS\r\n  0\r\nLINE\r\n 10\r\n0\r\n 20\r\n0\r\n 11\r\n5\r\n 21\r\n5\r\n  0\r\nENDSEC\r\n"
+    "  0\r\nSECTION\r\n  2\r\nENTITIES\r\n"
+    "  0\r\nLINE\r\n  8\r\nwalls\r\n 10\r\n10.4\r\n 20\r\n100\r\n 30\r\n0.0\r\n 11\r\n2.5e1\r\n 21\r\n90\r\n"
+    "  0\r\nCIRCLE\r\n 10\r\n50\r\n 20\r\n50\r\n 40\r\n12.5\r\n"
+    "  0\r\nARC\r\n 10\r\n50\r\n 20\r\n50\r\n 40\r\n12\r\n 50\r\n0\r\n 51\r\n90\r\n"
+    "  0\r\nELLIPSE\r\n 10\r\n200\r\n 20\r\n100\r\n 11\r\n0\r\n 21\r\n-30\r\n 40\r\n0.5\r\n 41\r\n0\r\n 42\r\n6.283185307179586\r\n"
+    "  0\r\nELLIPSE\r\n 10\r\n200\r\n 20\r\n100\r\n 11\r\n20\r\n 21\r\n20\r\n 40\r\n0.5\r\n"
+    "  0\r\nLWPOLYLINE\r\n 90\r\n5\r\n 70\r\n0\r\n 10\r\n0\r\n 20\r\n0\r\n 10\r\n40\r\n 20\r\n0\r\n 10\r\n40\r\n 20\r\n30\r\n"
+    " 10\r\n0\r\n 20\r\n30\r\n 10\r\n0\r\n 20\r\n0\r\n"
+    "  0\r\nLWPOLYLINE\r\n 90\r\n3\r\n 70\r\n1\r\n 10\r\n0\r\n 20\r\n0\r\n 10\r\n40\r\n 20\r\n0\r\n 10\r\n40\r\n 20\r\n30\r\n"
+    "  0\r\nPOLYLINE\r\n 66\r\n1\r\n  0\r\nVERTEX\r\n 10\r\n1\r\n 20\r\n1\r\n  0\r\nVERTEX\r\n 10\r\n2\r\n 20\r\n2\r\n  0\r\nSEQEND\r\n"
+    "  0\r\nTEXT\r\n 10\r\n300\r\n 20\r\n400\r\n 40\r\n20\r\n  1\r\n hello\r\n"
+    "  0\r\nMTEXT\r\n 10\r\n300\r\n 20\r\n500\r\n 40\r\n10\r\n 41\r\n150\r\n  3\r\nfirst \r\n  1\r\nlast\r\n"
+    "  0\r\nENDSEC\r\n  0\r\nEOF\r\n";
+
+// Expected shapes of sampleDxf on a page BENCH_PAGE_HEIGHT high: type, then the columns of shapestore.h
+static const int sampleShapes[][7] = {
+    {DATATYPE_SEGMENT, 10, BENCH_PAGE_HEIGHT - 100, 25, BENCH_PAGE_HEIGHT - 90, 0, 0},
+    {DATATYPE_CIRCLE, 50, BENCH_PAGE_HEIGHT - 50, 0, 0, 13, 0},
+    {DATATYPE_ELLIPSE, 200, BENCH_PAGE_HEIGHT - 100, 0, 0, 15, 30},
+    {DATATYPE_RECTANGLE, 0, BENCH_PAGE_HEIGHT - 30, 40, BENCH_PAGE_HEIGHT, 0, 0},
+    {DATATYPE_TEXT, 300, BENCH_PAGE_HEIGHT - 420, 360, BENCH_PAGE_HEIGHT - 400, 0, 0},
+    {DATATYPE_TEXT, 300, BENCH_PAGE_HEIGHT - 500, 450, BENCH_PAGE_HEIGHT - 490, 0, 0},
+};
+static const char *sampleTexts[] = {" hello", "first last"};
+#define SAMPLE_READ_NUM 6
+#define SAMPLE_SKIPPED_NUM 4
+
+static bool isSampleShape(const struct DxfShape *shape, int index) {
+    const int *expected = sampleShapes[index];
+    return shape -> type == expected[0] && shape -> x0 == expected[1] && shape -> y0 == expected[2] &&
+           shape -> x1 == expected[3] && shape -> y1 == expected[4] && shape -> r0 == expected[5] && shape -> r1 == expected[6];
+}
+
+struct SampleCheck {
+    int shapeNum;
+    bool isMatched;
+};
+
+static bool checkSampleHook(void *arg, const struct DxfShape *shapes, int shapeNum) {
+    struct SampleCheck *check = (struct SampleCheck *)arg;
+    for (int i = 0; i < shapeNum; i++, check -> shapeNum++) {
+        int index = check -> shapeNum;
+        bool isMatched = index < SAMPLE_READ_NUM && isSampleShape(shapes + i, index);
+        if (isMatched && shapes[i].type == DATATYPE_TEXT) {
+            isMatched = strcmp(shapes[i].text, sampleTexts[index - 4]) == 0;
+        }
+        if (!isMatched) {
+            printf("sample shape %d: type %d (%d, %d) (%d, %d) r %d %d \"%s\"\n", index, shapes[i].type, shapes[i].x0, shapes[i].y0,
+                   shapes[i].x1, shapes[i].y1, shapes[i].r0, shapes[i].r1, shapes[i].text);
+        }
+        check -> isMatched = check -> isMatched && isMatched;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    int shapeNum = argc > 1 ? atoi(argv[1]) : BENCH_SHAPES;
+    struct GenerateOptions options;
+    initBenchOptions(&options, shapeNum, BENCH_WIDTH, BENCH_PAGE_HEIGHT, BENCH_SHAPE_SIZE);
+    struct LinkedList list;
+    initLinkedList(&list);
+    if (generateDrawing(&list, &options) != shapeNum) {
+        return 1;
+    }
+
+    double start = getNowMs();
+    if (!exportDxf(&list, BENCH_PATH, BENCH_PAGE_HEIGHT)) {
+        return 1;
+    }
+    double exportMs = getNowMs() - start;
+
+    int parsedNum = 0;
+    struct DxfStats stats;
+    start = getNowMs();
+    if (!readDxf(BENCH_PATH, BENCH_PAGE_HEIGHT, countBatchHook, &parsedNum, &stats)) {
+        return 1;
+    }
+    double parseMs = getNowMs() - start;
+
+    struct LinkedList imported;
+    initLinkedList(&imported);
+    start = getNowMs();
+    if (!importDxf(&imported, BENCH_PATH, BENCH_PAGE_HEIGHT, &stats)) {
+        return 1;
+    }
+    double importMs = getNowMs() - start;
+
+    FILE *file = fopen(BENCH_PATH, "rb");
+    fseek(file, 0, SEEK_END);
+    double fileMb = ftell(file) / 1048576.0;
+    fclose(file);
+    remove(BENCH_PATH);
+
+    printf("%d shapes, %.1f MB of DXF\n", shapeNum, fileMb);
+    printf("%16s %12s %16s\n", "step", "ms", "Mentities/s");
+    printf("%16s %12.1f %16.2f\n", "export", exportMs, exportMs > 0 ? shapeNum / exportMs / 1000 : 0.0);
+    printf("%16s %12.1f %16.2f\n", "parse only", parseMs, parseMs > 0 ? parsedNum / parseMs / 1000 : 0.0);
+    printf("%16s %12.1f %16.2f\n", "import to list", importMs, importMs > 0 ? stats.readNum / importMs / 1000 : 0.0);
+
+    bool isPassed = true;
+    if (parsedNum != shapeNum || stats.readNum != shapeNum || stats.skippedNum != 0 || !isSameList(&list, &imported)) {
+        printf("round trip differs: %d parsed, %d read, %d skipped\n", parsedNum, stats.readNum, stats.skippedNum);
+        isPassed = false;
+    }
+    destroyLinkedList(&imported, destroyRule);
+    destroyLinkedList(&list, destroyRule);
+
+    file = fopen(BENCH_PATH, "wb");
+    if (file == NULL || fputs(sampleDxf, file) == EOF || fclose(file) != 0) {
+        return 1;
+    }
+    struct SampleCheck check = {0, true};
+    if (!readDxf(BENCH_PATH, BENCH_PAGE_HEIGHT, checkSampleHook, &check, &stats) || !check.isMatched ||
+        check.shapeNum != SAMPLE_READ_NUM || stats.readNum != SAMPLE_READ_NUM || stats.skippedNum != SAMPLE_SKIPPED_NUM) {
+        printf("sample file misread: %d read, %d skipped\n", stats.readNum, stats.skippedNum);
+        isPassed = false;
+    }
+    remove(BENCH_PATH);
+
+    printf(isPassed ? "all checks passed\n" : "checks FAILED\n");
+    return isPassed ? 0 : 1;
+}
@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "linkedlist.h"
+#include "datatypes.h"
+#include "drawfile.h"
+#include "generate.h"
+#include "bench.h"
+
+// Checks that the synthetic generator is deterministic for every layout and size mode, that it follows
+// the type weights and keeps grid segments axis-aligned, then times generating a large drawing and
+// compares the resident memory it peaked at with what the drawing holds once built.
+// The shape count defaults to 10000000, the first argument overrides it. Given a second argument,
+// the large drawing is also saved there as a .cdw file.
+// Exits with 1 on any failed check.
+// Build: g++ -O2 -std=c++11 -Iinclude bench/generate_bench.cpp src/datatypes.cpp src/distance.cpp
+//        src/drawfile.cpp src/generate.cpp src/hittest.cpp src/linkedlist.cpp src/misc.cpp src/pool.cpp src/ptrmap.cpp
+//        src/rtree.cpp src/shapestore.cpp
+
+#define BENCH_SHAPES 10000000
+#define BENCH_CHECK_SHAPES 100000
+
+// Read a field of /proc/self/status in kB, where there is one
+// Returns -1 elsewhere
+static long getStatusKb(const char *field) {
+    FILE *file = fopen("/proc/self/status", "r");
+    if (file == NULL) {
+        return -1;
+    }
+    char line[256];
+    long kb = -1;
+    size_t fieldLength = strlen(field);
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (strncmp(line, field, fieldLength) == 0 && line[fieldLength] == ':') {
+            kb = atol(line + fieldLength + 1);
+            break;
+        }
+    }
+    fclose(file);
+    return kb;
+}
+
+static void hashBytes(unsigned long long int *hash, const void *bytes, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        *hash ^= ((const unsigned char *)bytes)[i];
+        *hash *= 1099511628211ull;
+    }
+}
+
+static unsigned long long int hashList(const struct LinkedList *list) {
+    unsigned long long int hash = 14695981039346656037ull;
+    for (const struct LinkedNode *cntNode = list -> head; cntNode != NULL; cntNode = cntNode -> next) {
+        hashBytes(&hash, &cntNode -> data -> type, sizeof(int));
+        hashBytes(&hash, &cntNode -> box, sizeof(struct BoundingBox));
+        if (cntNode -> data -> type == DATATYPE_TEXT) {
+            const struct Text *txt = (const struct Text *)cntNode -> data -> content;
+            hashBytes(&hash, txt -> content, strlen(txt -> content));
+        }
+    }
+    return hash;
+}
+
+static unsigned long long int hashGenerated(const struct GenerateOptions *options) {
+    struct LinkedList list;
+    initLinkedList(&list);
+    int addedNum = generateDrawing(&list, options);
+    unsigned long long int hash = addedNum == options -> shapeNum ? hashList(&list) : 0;
+    destroyLinkedList(&list, destroyRule);
+    return hash;
+}
+
+static bool checkDeterminism() {
+    static const char *layoutNames[] = {"", "uniform", "clusters", "grid"};
+    static const char *sizeModeNames[] = {"", "uniform", "log"};
+    bool isPassed = true;
+    for (int layout = GENERATE_LAYOUT_UNIFORM; layout <= GENERATE_LAYOUT_GRID; layout++) {
+        for (int sizeMode = GENERATE_SIZE_UNIFORM; sizeMode <= GENERATE_SIZE_LOG; sizeMode++) {
+            struct GenerateOptions options;
+            initGenerateOptions(&options);
+            options.shapeNum = BENCH_CHECK_SHAPES;
+            options.layout = layout;
+            options.sizeMode = sizeMode;
+            options.maxSize = 400;
+            unsigned long long int hash = hashGenerated(&options);
+            bool isSame = hash != 0 && hashGenerated(&options) == hash;
+            options.seed++;
+            bool isSeeded = hashGenerated(&options) != hash;
+            printf("%-8s layout, %-7s sizes: %016llx, %s\n", layoutNames[layout], sizeModeNames[sizeMode], hash,
+                   !isSame ? "NOT REPEATABLE" : !isSeeded ? "IGNORES SEED" : "ok");
+            isPassed = isPassed && isSame && isSeeded;
+        }
+    }
+    return isPassed;
+}
+
+// Segments and texts only, three texts to a segment, on a grid
+static bool checkMixAndGrid() {
+    struct GenerateOptions options;
+    initGenerateOptions(&options);
+    options.shapeNum = BENCH_CHECK_SHAPES;
+    options.layout = GENERATE_LAYOUT_GRID;
+    memset(options.typeWeights, 0, sizeof(options.typeWeights));
+    options.typeWeights[DATATYPE_SEGMENT - DATATYPE_SEGMENT] = 1;
+    options.typeWeights[DATATYPE_TEXT - DATATYPE_SEGMENT] = 3;
+
+    struct LinkedList list;
+    initLinkedList(&list);
+    int addedNum = generateDrawing(&list, &options);
+    int segmentNum = 0, textNum = 0, otherNum = 0, slantedNum = 0;
+    for (const struct LinkedNode *cntNode = list.head; cntNode != NULL; cntNode = cntNode -> next) {
+        if (cntNode -> data -> type == DATATYPE_SEGMENT) {
+            segmentNum++;
+            slantedNum += cntNode -> box.minx != cntNode -> box.maxx && cntNode -> box.miny != cntNode -> box.maxy;
+        } else if (cntNode -> data -> type == DATATYPE_TEXT) {
+            textNum++;
+        } else {
+            otherNum++;
+        }
+    }
+    destroyLinkedList(&list, destroyRule);
+    double textShare = (double)textNum / max(addedNum, 1);
+    bool isPassed = addedNum == options.shapeNum && otherNum == 0 && slantedNum == 0 && textShare > 0.74 && textShare < 0.76;
+    printf("grid mix: %d segments, %d texts, %d others, %d slanted segments, %s\n",
+           segmentNum, textNum, otherNum, slantedNum, isPassed ? "ok" : "WRONG");
+    return isPassed;
+}
+
+int main(int argc, char *argv[]) {
+    int shapeNum = argc > 1 ? atoi(argv[1]) : BENCH_SHAPES;
+    const char *path = argc > 2 ? argv[2] : NULL;
+    if (shapeNum <= 0) {
+        fprintf(stderr, "usage: %s [shapes] [path.cdw]\n", argv[0]);
+        return 1;
+    }
+    bool isPassed = checkDeterminism();
+    isPassed = checkMixAndGrid() && isPassed;
+
+    struct GenerateOptions options;
+    initGenerateOptions(&options);
+    options.shapeNum = shapeNum;
+    options.layout = GENERATE_LAYOUT_CLUSTERS;
+    options.sizeMode = GENERATE_SIZE_LOG;
+    options.width = options.height = 100000;
+    options.clusterNum = 256;
+    options.clusterSpread = 2000;
+    options.minSize = 4;
+    options.maxSize = 2000;
+
+    struct LinkedList list;
+    initLinkedList(&list);
+    long startKb = getStatusKb("VmRSS");
+    double startMs = getNowMs();
+    int addedNum = generateDrawing(&list, &options);
+    double generateMs = getNowMs() - startMs;
+    long builtKb = getStatusKb("VmRSS"), peakKb = getStatusKb("VmHWM");
+    printf("generate: %d shapes in %.0f ms, %.1f M shapes/s\n", addedNum, generateMs, addedNum / generateMs / 1e3);
+    if (startKb >= 0 && builtKb >= 0 && peakKb >= 0) {
+        long drawingKb = builtKb - startKb;
+        printf("memory: %.1f MB held, %.1f bytes per shape, peak %.1f MB over the drawing\n",
+               drawingKb / 1024.0, drawingKb * 1024.0 / max(addedNum, 1), (peakKb - builtKb) / 1024.0);
+        // Only the batch on the stack should come on top of the shapes
+        if (peakKb - builtKb > drawingKb / 20 + 1024) {
+            printf("memory: peak well above the final footprint\n");
+            isPassed = false;
+        }
+    } else {
+        printf("memory: not measured on this platform\n");
+    }
+    if (addedNum != shapeNum) {
+        printf("generate: only %d of %d shapes\n", addedNum, shapeNum);
+        isPassed = false;
+    }
+
+    if (path != NULL) {
+        startMs = getNowMs();
+        if (saveDrawFile(&list, path)) {
+            printf("save: %s in %.0f ms\n", path, getNowMs() - startMs);
+        } else {
+            printf("save: cannot write %s\n", path);
+            isPassed = false;
+        }
+    }
+
+    startMs = getNowMs();
+    destroyLinkedList(&list, destroyRule);
+    printf("destroy: %.0f ms\n", getNowMs() - startMs);
+    return isPassed ? 0 : 1;
+}
@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <chrono>
+
+#include "linkedlist.h"
+#include "datatypes.h"
+#include "shapestore.h"
+#include "hittest.h"
+#include "rtree.h"
+#include "bench.h"
+
+// Checks every hit test kernel the CPU supports against findRule() on random shapes,
+// and picks of the store through an R-tree, then compares their speed on a store of typical shapes.
+// Exits with 1 if any kernel or pick disagrees with findRule().
+// Build: g++ -O2 -std=c++11 -Iinclude bench/hittest_bench.cpp src/datatypes.cpp src/distance.cpp
+//        src/generate.cpp src/hittest.cpp src/linkedlist.cpp src/misc.cpp src/pool.cpp src/ptrmap.cpp
+//        src/rtree.cpp src/shapestore.cpp
+
+#define BENCH_CHECK_SHAPES 20000
+#define BENCH_CHECK_QUERIES 20000
+#define BENCH_CHECK_OPS 10000
+#define BENCH_SHAPES 100000
+#define BENCH_QUERY_NUM 2000
+// One shape of the check in this many lies anywhere within BENCH_HUGE_COORD of the origin
+#define BENCH_HUGE_SHARE 50
+
+// Beyond HITTEST_SIMD_LIMIT, yet small enough for the scalar rules to stay exact
+#define BENCH_HUGE_COORD 15000
+
+static int nextCoord(int worldSize) {
+    // A few values land beyond the SIMD limit, some of them negative
+    if (nextRandom(BENCH_HUGE_SHARE) == 0) {
+        return nextRandom(2 * BENCH_HUGE_COORD + 1) - BENCH_HUGE_COORD;
+    }
+    return nextRandom(worldSize);
+}
+
+static struct LinkedNode * findLinear(struct LinkedList *list, const struct Vertex *cursorPt) {
+    for (struct LinkedNode *cntNode = list -> tail; cntNode != NULL; cntNode = cntNode -> prev) {
+        if (findRule(cursorPt, cntNode)) {
+            return cntNode;
+        }
+    }
+    return NULL;
+}
+
+static struct LinkedNode * findKernel(struct ShapeStore *store, const struct Vertex *cursorPt, int kernel) {
+    struct HitColumns cols = { store -> type, store -> x0, store -> y0, store -> x1, store -> y1, store -> r0, store -> r1 };
+    int pos = findTopHit(&cols, store -> order, store -> orderBegin, store -> orderEnd, cursorPt -> x, cursorPt -> y, kernel);
+    return pos == -1 ? NULL : store -> node[store -> order[pos]];
+}
+
+static struct LinkedNode * getRandomNode(struct LinkedList *list) {
+    struct LinkedNode *cntNode = list -> head;
+    for (int i = nextRandom(list -> listSize); i > 0; i--) {
+        cntNode = cntNode -> next;
+    }
+    return cntNode;
+}
+
+int main() {
+    // Shapes of the check straddle HITTEST_SIMD_LIMIT
+    const int checkWorldSize = 8000, checkShapeSize = 100;
+    const int worldSize = 4000, shapeSize = 40;
+
+    struct GenerateOptions checkOptions, hugeOptions;
+    initBenchOptions(&hugeOptions, BENCH_CHECK_SHAPES / BENCH_HUGE_SHARE, 2 * BENCH_HUGE_COORD, 2 * BENCH_HUGE_COORD, checkShapeSize);
+    hugeOptions.originx = hugeOptions.originy = -BENCH_HUGE_COORD;
+    hugeOptions.seed++;
+    initBenchOptions(&checkOptions, BENCH_CHECK_SHAPES - hugeOptions.shapeNum, checkWorldSize, checkWorldSize, checkShapeSize);
+
+    // Differential check, with holes and reordering in the store
+    struct LinkedList list;
+    initLinkedList(&list);
+    struct ShapeStore *store = makeShapeStore();
+    struct RTree *tree = makeRTree();
+    if (store == NULL || tree == NULL) {
+        return 1;
+    }
+    // The store answers picks, testing the shapes the tree finds
+    attachIndex(&list, &store -> index);
+    attachIndex(&list, &tree -> index);
+    store -> tree = tree;
+    if (generateDrawing(&list, &checkOptions) != checkOptions.shapeNum ||
+        generateDrawing(&list, &hugeOptions) != hugeOptions.shapeNum) {
+        return 1;
+    }
+    for (int i = 0; i < BENCH_CHECK_OPS; i++) {
+        struct LinkedNode *cntNode = getRandomNode(&list);
+        switch (nextRandom(4)) {
+            case 0: {
+                moveToHead(&list, cntNode);
+                break;
+            }
+            case 1: {
+                moveToTail(&list, cntNode);
+                break;
+            }
+            case 2: {
+                const struct GenerateOptions *options = nextRandom(BENCH_HUGE_SHARE) == 0 ? &hugeOptions : &checkOptions;
+                editNode(&list, cntNode, makeRandomData(options), destroyRule);
+                break;
+            }
+            default: {
+                deleteNode(&list, cntNode, destroyRule);
+                break;
+            }
+        }
+    }
+
+    int mismatchNum[HITTEST_KERNEL_NUM] = {0};
+    int pickMismatchNum = 0;
+    int hitNum = 0;
+    for (int i = 0; i < BENCH_CHECK_QUERIES; i++) {
+        struct Vertex cursorPt;
+        cursorPt.x = nextCoord(checkWorldSize);
+        cursorPt.y = nextCoord(checkWorldSize);
+        struct LinkedNode *expected = findLinear(&list, &cursorPt);
+        hitNum += expected != NULL;
+        for (int kernel = 0; kernel < HITTEST_KERNEL_NUM; kernel++) {
+            if (isHitKernelSupported(kernel) && findKernel(store, &cursorPt, kernel) != expected) {
+                mismatchNum[kernel]++;
+            }
+        }
+        if (findNode(&list, &cursorPt, findRule) != expected) {
+            pickMismatchNum++;
+        }
+    }
+
+    bool isAllMatched = true;
+    printf("differential check: %d shapes, %d queries, %d hits\n", list.listSize, BENCH_CHECK_QUERIES, hitNum);
+    for (int kernel = 0; kernel < HITTEST_KERNEL_NUM; kernel++) {
+        if (!isHitKernelSupported(kernel)) {
+            printf("%10s %s\n", getHitKernelName(kernel), "unsupported");
+            continue;
+        }
+        printf("%10s %d mismatches\n", getHitKernelName(kernel), mismatchNum[kernel]);
+        isAllMatched = isAllMatched && mismatchNum[kernel] == 0;
+    }
+    printf("%10s %d mismatches\n", "store+tree", pickMismatchNum);
+    isAllMatched = isAllMatched && pickMismatchNum == 0;
+
+    destroyLinkedList(&list, destroyRule);
+
+    // Speed on shapes that all fit the SIMD limit, queries mostly miss so the whole store is scanned
+    struct GenerateOptions options;
+    initBenchOptions(&options, BENCH_SHAPES, worldSize, worldSize, shapeSize);
+    if (generateDrawing(&list, &options) != BENCH_SHAPES) {
+        return 1;
+    }
+    struct Vertex queries[BENCH_QUERY_NUM];
+    for (int i = 0; i < BENCH_QUERY_NUM; i++) {
+        queries[i].x = nextRandom(HITTEST_SIMD_LIMIT * 2) - HITTEST_SIMD_LIMIT;
+        queries[i].y = nextRandom(HITTEST_SIMD_LIMIT * 2) - HITTEST_SIMD_LIMIT;
+    }
+
+    printf("\n%10s %14s %10s\n", "kernel", "us/query", "speedup");
+    clock_t start = clock();
+    int linearHits = 0;
+    for (int i = 0; i < BENCH_QUERY_NUM; i++) {
+        linearHits += findLinear(&list, &queries[i]) != NULL;
+    }
+    double linearUs = getElapsedMs(start) * 1000.0 / BENCH_QUERY_NUM;
+    printf("%10s %14.2f %9.1fx\n", "list", linearUs, 1.0);
+
+    for (int kernel = 0; kernel < HITTEST_KERNEL_NUM; kernel++) {
+        if (!isHitKernelSupported(kernel)) {
+            continue;
+        }
+        start = clock();
+        int kernelHits = 0;
+        for (int i = 0; i < BENCH_QUERY_NUM; i++) {
+            kernelHits += findKernel(store, &queries[i], kernel) != NULL;
+        }
+        double kernelUs = getElapsedMs(start) * 1000.0 / BENCH_QUERY_NUM;
+        printf("%10s %14.2f %9.1fx", getHitKernelName(kernel), kernelUs, kernelUs > 0 ? linearUs / kernelUs : 0.0);
+        printf(kernelHits == linearHits ? "\n" : " (hit count differs)\n");
+    }
+
+    // Picks as the editor makes them, the tree alone and the store testing what the tree finds
+    start = clock();
+    int treeHits = 0;
+    for (int i = 0; i < BENCH_QUERY_NUM; i++) {
+        treeHits += findRTree(tree, &queries[i], findRule) != NULL;
+    }
+    double treeUs = getElapsedMs(start) * 1000.0 / BENCH_QUERY_NUM;
+    printf("%10s %14.2f %9.1fx", "rtree", treeUs, treeUs > 0 ? linearUs / treeUs : 0.0);
+    printf(treeHits == linearHits ? "\n" : " (hit count differs)\n");
+    start = clock();
+    int pickHits = 0;
+    for (int i = 0; i < BENCH_QUERY_NUM; i++) {
+        pickHits += findNode(&list, &queries[i], findRule) != NULL;
+    }
+    double pickUs = getElapsedMs(start) * 1000.0 / BENCH_QUERY_NUM;
+    printf("%10s %14.2f %9.1fx", "store+tree", pickUs, pickUs > 0 ? linearUs / pickUs : 0.0);
+    printf(pickHits == linearHits ? "\n" : " (hit count differs)\n");
+
+    destroyLinkedList(&list, destroyRule);
+    detachIndex(&list, &tree -> index);
+    detachIndex(&list, &store -> index);
+    destroyRTree(tree);
+    destroyShapeStore(store);
+    return isAllMatched ? 0 : 1;
+}
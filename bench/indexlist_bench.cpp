@@ -0,0 +1,255 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "linkedlist.h"
+#include "datatypes.h"
+#include "generate.h"
+#include "indexlist.h"
+#include "bench.h"
+
+// Builds a drawing as a LinkedList, the way the editor does, then hands the very same shapes to an IndexList
+// and to a second LinkedList, measuring what each structure adds on top of the shapes. The second LinkedList
+// gets its nodes in a row from fresh slabs, its best case for walking. Both lists then go
+// through the same random moves and deletions, and must keep the same order. Finally times a walk over
+// every node and picking with both, with and without skipping nodes on their box first, and checks
+// that every pick finds the same shape.
+// The shape count defaults to 2000000, the first argument overrides it.
+// Exits with 1 on any mismatch.
+// Build: g++ -O2 -std=c++11 -Iinclude bench/indexlist_bench.cpp src/datatypes.cpp src/distance.cpp src/generate.cpp
+//        src/indexlist.cpp src/linkedlist.cpp src/misc.cpp src/pool.cpp
+
+#define BENCH_SHAPES 2000000
+// Moves and deletions, each in this share of the nodes
+#define BENCH_CHANGE_RATIO 10
+#define BENCH_PICKS 200
+#define BENCH_WALKS 10
+
+// Read a field of /proc/self/status in kB, where there is one
+// Returns -1 elsewhere
+static long getStatusKb(const char *field) {
+    FILE *file = fopen("/proc/self/status", "r");
+    if (file == NULL) {
+        return -1;
+    }
+    char line[256];
+    long kb = -1;
+    size_t fieldLength = strlen(field);
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (strncmp(line, field, fieldLength) == 0 && line[fieldLength] == ':') {
+            kb = atol(line + fieldLength + 1);
+            break;
+        }
+    }
+    fclose(file);
+    return kb;
+}
+
+static bool isSameOrder(const struct LinkedList *list, const struct IndexList *indexList) {
+    if (list -> listSize != indexList -> listSize) {
+        return false;
+    }
+    int slot = indexList -> head;
+    for (const struct LinkedNode *cntNode = list -> head; cntNode != NULL; cntNode = cntNode -> next) {
+        if (slot == INDEX_LIST_NONE || indexList -> cold[slot] != cntNode -> data -> content ||
+            indexList -> hot[slot].type != cntNode -> data -> type) {
+            return false;
+        }
+        slot = indexList -> links[slot].next;
+    }
+    return slot == INDEX_LIST_NONE;
+}
+
+// Moves and deletions drawn at random, applied to both lists alike
+static void shuffleLists(struct LinkedList *list, struct IndexList *indexList, struct LinkedNode **nodes, int *slots, int nodeNum) {
+    int changeNum = nodeNum / BENCH_CHANGE_RATIO;
+    for (int i = 0; i < changeNum; i++) {
+        int id = nextRandom(nodeNum);
+        if (nodes[id] == NULL) {
+            continue;
+        }
+        switch (nextRandom(3)) {
+            case 0: {
+                moveToHead(list, nodes[id]);
+                moveIndexNodeToHead(indexList, slots[id]);
+                break;
+            }
+            case 1: {
+                moveToTail(list, nodes[id]);
+                moveIndexNodeToTail(indexList, slots[id]);
+                break;
+            }
+            default: {
+                // The shape goes with the list node, the IndexList only lets go of it
+                deleteIndexNode(indexList, slots[id], NULL);
+                deleteNode(list, nodes[id], destroyRule);
+                nodes[id] = NULL;
+                break;
+            }
+        }
+    }
+}
+
+static long long int walkLinkedList(const struct LinkedList *list) {
+    long long int sum = 0;
+    for (const struct LinkedNode *cntNode = list -> head; cntNode != NULL; cntNode = cntNode -> next) {
+        sum += cntNode -> box.minx + cntNode -> data -> type;
+    }
+    return sum;
+}
+
+static long long int walkIndexList(const struct IndexList *list) {
+    long long int sum = 0;
+    for (int slot = list -> head; slot != INDEX_LIST_NONE; slot = list -> links[slot].next) {
+        sum += list -> hot[slot].box.minx + list -> hot[slot].type;
+    }
+    return sum;
+}
+
+// Same as findNode(), skipping nodes whose box is away from the point
+static const struct LinkedNode * findLinkedNodeInBox(const struct LinkedList *list, const struct Vertex *pt,
+                                                     const struct BoundingBox *findBox) {
+    for (const struct LinkedNode *cntNode = list -> tail; cntNode != NULL; cntNode = cntNode -> prev) {
+        if (isBoxIntersected(&cntNode -> box, findBox) && findRule(pt, cntNode)) {
+            return cntNode;
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    int shapeNum = argc > 1 ? atoi(argv[1]) : BENCH_SHAPES;
+    if (shapeNum <= 0) {
+        fprintf(stderr, "usage: %s [shapes]\n", argv[0]);
+        return 1;
+    }
+    struct GenerateOptions options;
+    initGenerateOptions(&options);
+    options.shapeNum = shapeNum;
+    options.layout = GENERATE_LAYOUT_CLUSTERS;
+    options.sizeMode = GENERATE_SIZE_LOG;
+    options.width = options.height = 100000;
+    options.clusterNum = 256;
+    options.clusterSpread = 2000;
+    options.minSize = 4;
+    options.maxSize = 2000;
+
+    struct LinkedList drawing;
+    initLinkedList(&drawing);
+    if (generateDrawing(&drawing, &options) != shapeNum) {
+        fprintf(stderr, "indexlist_bench: out of memory\n");
+        return 1;
+    }
+
+    // The same shapes under both structures, the drawing itself only held them while they were made
+    long startKb = getStatusKb("VmRSS");
+    struct IndexList indexList;
+    initIndexList(&indexList);
+    for (const struct LinkedNode *cntNode = drawing.head; cntNode != NULL; cntNode = cntNode -> next) {
+        addIndexNodeAtTail(&indexList, cntNode -> data -> content, cntNode -> data -> type);
+    }
+    long indexKb = getStatusKb("VmRSS");
+    struct LinkedList list;
+    initLinkedList(&list);
+    for (const struct LinkedNode *cntNode = drawing.head; cntNode != NULL; cntNode = cntNode -> next) {
+        addNodeAtTail(&list, makeData(cntNode -> data -> content, cntNode -> data -> type));
+    }
+    long listKb = getStatusKb("VmRSS");
+    destroyLinkedList(&drawing, destroyData);
+    bool isPassed = list.listSize == shapeNum && indexList.listSize == shapeNum;
+
+    printf("%d shapes, bytes per shape on top of it:\n", shapeNum);
+    printf("  LinkedList: %3d by layout (%d of links), %.1f measured\n",
+           (int)(sizeof(struct LinkedNode) + sizeof(struct NodeData)), (int)(3 * sizeof(void *)),
+           startKb < 0 ? -1.0 : (listKb - indexKb) * 1024.0 / shapeNum);
+    printf("  IndexList:  %3d by layout (%d of links), %.1f measured\n",
+           (int)(sizeof(struct IndexLink) + sizeof(struct IndexHot) + sizeof(void *)), (int)sizeof(struct IndexLink),
+           startKb < 0 ? -1.0 : (indexKb - startKb) * 1024.0 / shapeNum);
+
+    struct LinkedNode **nodes = (struct LinkedNode **)malloc(sizeof(struct LinkedNode *) * shapeNum);
+    int *slots = (int *)malloc(sizeof(int) * shapeNum);
+    if (nodes == NULL || slots == NULL) {
+        fprintf(stderr, "indexlist_bench: out of memory\n");
+        return 1;
+    }
+    int id = 0;
+    for (struct LinkedNode *cntNode = list.head; cntNode != NULL; cntNode = cntNode -> next, id++) {
+        nodes[id] = cntNode;
+    }
+    id = 0;
+    for (int slot = indexList.head; slot != INDEX_LIST_NONE; slot = indexList.links[slot].next, id++) {
+        slots[id] = slot;
+    }
+    shuffleLists(&list, &indexList, nodes, slots, shapeNum);
+    bool isSame = isSameOrder(&list, &indexList);
+    printf("after %d random moves and deletions: %d shapes left, order %s\n",
+           shapeNum / BENCH_CHANGE_RATIO, list.listSize, isSame ? "same" : "DIFFERENT");
+    isPassed = isPassed && isSame;
+
+    double startMs = getNowMs();
+    long long int listSum = 0, indexSum = 0;
+    for (int i = 0; i < BENCH_WALKS; i++) {
+        listSum += walkLinkedList(&list);
+    }
+    double listWalkMs = (getNowMs() - startMs) / BENCH_WALKS;
+    startMs = getNowMs();
+    for (int i = 0; i < BENCH_WALKS; i++) {
+        indexSum += walkIndexList(&indexList);
+    }
+    double indexWalkMs = (getNowMs() - startMs) / BENCH_WALKS;
+    printf("walk, type and box of every node: LinkedList %.2f ms, IndexList %.2f ms (%.1fx)\n",
+           listWalkMs, indexWalkMs, listWalkMs / indexWalkMs);
+    isPassed = isPassed && listSum == indexSum;
+
+    // Picks around shapes, most of them hitting one
+    struct Vertex picks[BENCH_PICKS];
+    for (int i = 0; i < BENCH_PICKS; i++) {
+        int slot = slots[nextRandom(shapeNum)];
+        while (indexList.hot[slot].type == DATATYPE_UNDEFINED) {
+            slot = slots[nextRandom(shapeNum)];
+        }
+        picks[i].x = indexList.hot[slot].box.minx;
+        picks[i].y = (indexList.hot[slot].box.miny + indexList.hot[slot].box.maxy) / 2;
+    }
+    const struct LinkedNode *listHits[BENCH_PICKS];
+    int indexHits[BENCH_PICKS];
+    double pickMs[3];
+    startMs = getNowMs();
+    for (int i = 0; i < BENCH_PICKS; i++) {
+        listHits[i] = findNode(&list, &picks[i], findRule);
+    }
+    pickMs[0] = (getNowMs() - startMs) / BENCH_PICKS;
+    int mismatchNum = 0;
+    startMs = getNowMs();
+    for (int i = 0; i < BENCH_PICKS; i++) {
+        struct BoundingBox findBox = {picks[i].x - FINDRULE_VARIATION, picks[i].y - FINDRULE_VARIATION,
+                                      picks[i].x + FINDRULE_VARIATION, picks[i].y + FINDRULE_VARIATION};
+        mismatchNum += findLinkedNodeInBox(&list, &picks[i], &findBox) != listHits[i];
+    }
+    pickMs[1] = (getNowMs() - startMs) / BENCH_PICKS;
+    startMs = getNowMs();
+    for (int i = 0; i < BENCH_PICKS; i++) {
+        struct BoundingBox findBox = {picks[i].x - FINDRULE_VARIATION, picks[i].y - FINDRULE_VARIATION,
+                                      picks[i].x + FINDRULE_VARIATION, picks[i].y + FINDRULE_VARIATION};
+        indexHits[i] = findIndexNode(&indexList, &findBox, &picks[i], findDataRule);
+    }
+    pickMs[2] = (getNowMs() - startMs) / BENCH_PICKS;
+    int hitNum = 0;
+    for (int i = 0; i < BENCH_PICKS; i++) {
+        const void *indexContent = indexHits[i] == INDEX_LIST_NONE ? NULL : indexList.cold[indexHits[i]];
+        mismatchNum += indexContent != (listHits[i] == NULL ? NULL : listHits[i] -> data -> content);
+        hitNum += listHits[i] != NULL;
+    }
+    printf("pick, per point: LinkedList %.2f ms, with box test %.2f ms, IndexList with box test %.2f ms (%.1fx)\n",
+           pickMs[0], pickMs[1], pickMs[2], pickMs[1] / pickMs[2]);
+    printf("%d of %d picks hit a shape, %d picks differ\n", hitNum, BENCH_PICKS, mismatchNum);
+    isPassed = isPassed && mismatchNum == 0;
+
+    free(nodes);
+    free(slots);
+    destroyIndexList(&indexList, NULL);
+    destroyLinkedList(&list, destroyRule);
+    printf("%s\n", isPassed ? "all checks passed" : "SOME CHECKS FAILED");
+    return isPassed ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#include "input.h"
+#include "bench.h"
+
+// Feeds flicks of mouse moves, each ended by a click, through an input queue at the pace of a fast mouse,
+// while the taker spends a slow redraw on every move it takes, once with a reader thread and once pumping
+// the queue itself. With coalescing, the delay between a message being due and its answer should stay
+// around one redraw; without it, moves pile up and the delay keeps growing.
+// Clicks must all arrive, in order, and the last move before each click must never be coalesced away.
+// Exits with 1 on any mismatch.
+// Build: g++ -O2 -std=c++11 -pthread -Iinclude bench/input_bench.cpp src/input.cpp src/misc.cpp src/ringbuffer.cpp
+
+#define BENCH_FLICKS 10
+#define BENCH_FLICK_MOVES 100
+// A move every this many microseconds, about what a 1000 Hz mouse sends
+#define BENCH_MOVE_US 1000
+#define BENCH_REDRAW_US 4000
+
+#define BENCH_EVENT_MOVE 1
+#define BENCH_EVENT_DOWN 2
+#define BENCH_EVENT_UP 3
+
+struct BenchEvent {
+    int kind;
+    int seq;
+    double sentMs;
+};
+
+struct BenchSource {
+    int sentNum, eventNum;
+    double startMs;
+    bool isCoalescing;
+};
+
+static int getEventKind(int seq) {
+    int offset = seq % (BENCH_FLICK_MOVES + 2);
+    return offset < BENCH_FLICK_MOVES ? BENCH_EVENT_MOVE : (offset == BENCH_FLICK_MOVES ? BENCH_EVENT_DOWN : BENCH_EVENT_UP);
+}
+
+// Hands out the events of the script once their time has come
+static bool readScriptHook(void *impl, void *event) {
+    struct BenchSource *source = (struct BenchSource *)impl;
+    double nowMs = getNowMs();
+    if (source -> sentNum == source -> eventNum || nowMs < source -> startMs + source -> sentNum * BENCH_MOVE_US / 1000.0) {
+        return false;
+    }
+    struct BenchEvent *cntEvent = (struct BenchEvent *)event;
+    cntEvent -> seq = source -> sentNum++;
+    cntEvent -> kind = getEventKind(cntEvent -> seq);
+    // When it was due, which is when a mouse would have sent it
+    cntEvent -> sentMs = source -> startMs + cntEvent -> seq * BENCH_MOVE_US / 1000.0;
+    return true;
+}
+
+static bool isMoveHook(void *impl, const void *event) {
+    return ((struct BenchSource *)impl) -> isCoalescing && ((const struct BenchEvent *)event) -> kind == BENCH_EVENT_MOVE;
+}
+
+static void spinFor(int us) {
+    double endMs = getNowMs() + us / 1000.0;
+    while (getNowMs() < endMs) {
+    }
+}
+
+static int compareDouble(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static bool runQueue(bool isCoalescing, bool isThreaded) {
+    struct BenchSource source = {0, BENCH_FLICKS * (BENCH_FLICK_MOVES + 2), getNowMs() + 10, isCoalescing};
+    struct InputSource inputSource = {&source, readScriptHook, isMoveHook, NULL};
+    struct InputQueue *queue = makeInputQueue(&inputSource, sizeof(struct BenchEvent), isThreaded);
+    if (queue == NULL) {
+        return false;
+    }
+
+    double *delays = (double *)malloc(source.eventNum * sizeof(double));
+    int delayNum = 0, lastSeq = -1, clickNum = 0;
+    bool isPassed = delays != NULL;
+    while (isPassed && clickNum < BENCH_FLICKS * 2) {
+        struct BenchEvent event;
+        takeInput(queue, &event);
+        delays[delayNum++] = getNowMs() - event.sentMs;
+        // Events come in order, only moves may be skipped, and never the one before a click
+        isPassed = event.seq > lastSeq;
+        for (int seq = lastSeq + 1; seq < event.seq && isPassed; seq++) {
+            isPassed = getEventKind(seq) == BENCH_EVENT_MOVE && getEventKind(seq + 1) == BENCH_EVENT_MOVE;
+        }
+        lastSeq = event.seq;
+        if (event.kind == BENCH_EVENT_MOVE) {
+            spinFor(BENCH_REDRAW_US);
+        } else {
+            clickNum++;
+        }
+    }
+
+    struct InputStats stats;
+    getInputStats(queue, &stats);
+    destroyInputQueue(queue);
+    isPassed = isPassed && stats.droppedNum == 0 && stats.takenNum + stats.coalescedNum == stats.readNum;
+
+    if (delayNum > 0) {
+        qsort(delays, delayNum, sizeof(double), compareDouble);
+        printf("%s, %s: %lld messages, %lld taken, %lld coalesced, %lld dropped, %d queued at most; "
+               "delay median %.1f ms, p99 %.1f ms, max %.1f ms\n", isThreaded ? "reader thread" : "pumped",
+               isCoalescing ? "coalescing" : "one by one", stats.readNum, stats.takenNum, stats.coalescedNum,
+               stats.droppedNum, stats.maxQueuedNum, delays[delayNum / 2], delays[delayNum * 99 / 100], delays[delayNum - 1]);
+    }
+    if (!isPassed) {
+        printf("%s, %s: messages lost or out of order\n", isThreaded ? "reader thread" : "pumped",
+               isCoalescing ? "coalescing" : "one by one");
+    }
+    free(delays);
+    return isPassed;
+}
+
+int main() {
+    bool isPassed = true;
+    for (int i = 0; i < 4; i++) {
+        isPassed = runQueue(i % 2 == 0, i < 2) && isPassed;
+    }
+    printf(isPassed ? "all checks passed\n" : "checks FAILED\n");
+    return isPassed ? 0 : 1;
+}
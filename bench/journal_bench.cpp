@@ -0,0 +1,211 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "linkedlist.h"
+#include "datatypes.h"
+#include "journal.h"
+#include "bench.h"
+
+// Journals a long run of random changes on a drawing, then measures how fast the journal is recovered
+// and checks that recovery gives the list back as it was. A torn and a damaged copy of the journal
+// must recover up to the record before the damage.
+// The shape and operation counts default to 100000 and 1000000, the first two arguments override them.
+// Exits with 1 if anything differs.
+// Build: g++ -O2 -std=c++11 -pthread -Iinclude bench/journal_bench.cpp src/datatypes.cpp src/distance.cpp
+//        src/generate.cpp src/journal.cpp src/linkedlist.cpp src/misc.cpp src/pool.cpp src/ptrmap.cpp
+//        src/ringbuffer.cpp
+
+#define BENCH_PATH "journal_bench.journal"
+#define BENCH_COPY_PATH "journal_bench_copy.journal"
+#define BENCH_SHAPES 100000
+#define BENCH_OPERATIONS 1000000
+#define BENCH_WIDTH 1280
+#define BENCH_HEIGHT 960
+#define BENCH_SHAPE_SIZE 80
+
+// Check that two lists hold the same shapes in the same order
+static bool isSameList(const struct LinkedList *list, const struct LinkedList *other) {
+    if (list -> listSize != other -> listSize) {
+        return false;
+    }
+    const struct LinkedNode *otherNode = other -> head;
+    for (const struct LinkedNode *cntNode = list -> head; cntNode != NULL; cntNode = cntNode -> next, otherNode = otherNode -> next) {
+        if (cntNode -> data -> type != otherNode -> data -> type ||
+            memcmp(&cntNode -> box, &otherNode -> box, sizeof(struct BoundingBox)) != 0) {
+            return false;
+        }
+        if (cntNode -> data -> type == DATATYPE_TEXT) {
+            const struct Text *txt = (const struct Text *)cntNode -> data -> content;
+            const struct Text *otherTxt = (const struct Text *)otherNode -> data -> content;
+            if (strcmp(txt -> content, otherTxt -> content) != 0 || txt -> fontWidth != otherTxt -> fontWidth ||
+                txt -> fontHeight != otherTxt -> fontHeight) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Live nodes, so that operations can pick one at random
+struct NodeArray {
+    int size, capacity;
+    struct LinkedNode **nodes;
+};
+
+static void pushNode(struct NodeArray *array, struct LinkedNode *node) {
+    if (array -> size == array -> capacity) {
+        array -> capacity = array -> capacity == 0 ? 1024 : array -> capacity * 2;
+        array -> nodes = (struct LinkedNode **)realloc(array -> nodes, array -> capacity * sizeof(struct LinkedNode *));
+    }
+    array -> nodes[array -> size++] = node;
+}
+
+// Apply operationNum random changes, asking for a checkpoint two thirds of the way
+// Returns the slowest change in milliseconds
+static double runOperations(struct LinkedList *list, struct NodeArray *array, struct Journal *journal, int operationNum,
+                            const struct GenerateOptions *options) {
+    double slowestMs = 0;
+    for (int i = 0; i < operationNum; i++) {
+        if (i == operationNum * 2 / 3) {
+            requestCheckpoint(journal);
+        }
+        int choice = array -> size == 0 ? 0 : nextRandom(100);
+        int pick = array -> size == 0 ? 0 : nextRandom(array -> size);
+        double start = getNowMs();
+        if (i == operationNum / 10) {
+            destroyLinkedList(list, destroyRule);
+            array -> size = 0;
+        } else if (choice < 30) {
+            struct NodeData *data = makeRandomData(options);
+            pushNode(array, nextRandom(2) == 0 ? addNodeAtHead(list, data) : addNodeAtTail(list, data));
+        } else if (choice < 60) {
+            editNode(list, array -> nodes[pick], makeRandomData(options), destroyRule);
+        } else if (choice < 80) {
+            if (nextRandom(2) == 0) {
+                moveToHead(list, array -> nodes[pick]);
+            } else {
+                moveToTail(list, array -> nodes[pick]);
+            }
+        } else {
+            deleteNode(list, array -> nodes[pick], destroyRule);
+            array -> nodes[pick] = array -> nodes[--array -> size];
+        }
+        double elapsedMs = getNowMs() - start;
+        slowestMs = elapsedMs > slowestMs ? elapsedMs : slowestMs;
+    }
+    return slowestMs;
+}
+
+// Copy the journal, dropping its last bytes and flipping one byte at given distance from the end if any
+static bool copyDamaged(int droppedSize, long flippedDistance) {
+    FILE *file = fopen(BENCH_PATH, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *content = (char *)malloc(size);
+    bool isRead = content != NULL && fread(content, 1, size, file) == (size_t)size;
+    fclose(file);
+    if (!isRead) {
+        free(content);
+        return false;
+    }
+    if (flippedDistance > 0) {
+        content[size - flippedDistance] ^= 0x5A;
+    }
+    file = fopen(BENCH_COPY_PATH, "wb");
+    bool isWritten = file != NULL && fwrite(content, 1, size - droppedSize, file) == (size_t)(size - droppedSize);
+    isWritten = file != NULL && fclose(file) == 0 && isWritten;
+    free(content);
+    return isWritten;
+}
+
+static bool checkDamaged(const char *name, int droppedSize, long flippedDistance, const struct JournalStats *whole) {
+    struct LinkedList list;
+    initLinkedList(&list);
+    struct JournalStats stats;
+    bool isPassed = copyDamaged(droppedSize, flippedDistance) && recoverJournal(&list, BENCH_COPY_PATH, &stats) &&
+                    stats.isTorn && stats.snapshotNum == whole -> snapshotNum && stats.replayedNum == whole -> replayedNum - 1;
+    if (!isPassed) {
+        printf("%s journal misrecovered\n", name);
+    }
+    destroyLinkedList(&list, destroyRule);
+    remove(BENCH_COPY_PATH);
+    return isPassed;
+}
+
+int main(int argc, char *argv[]) {
+    int shapeNum = argc > 1 ? atoi(argv[1]) : BENCH_SHAPES;
+    int operationNum = argc > 2 ? atoi(argv[2]) : BENCH_OPERATIONS;
+    struct GenerateOptions options;
+    initBenchOptions(&options, shapeNum, BENCH_WIDTH, BENCH_HEIGHT, BENCH_SHAPE_SIZE);
+    struct LinkedList list;
+    initLinkedList(&list);
+    if (generateDrawing(&list, &options) != shapeNum) {
+        return 1;
+    }
+    struct NodeArray array = {0, 0, NULL};
+    for (struct LinkedNode *cntNode = list.head; cntNode != NULL; cntNode = cntNode -> next) {
+        pushNode(&array, cntNode);
+    }
+
+    double start = getNowMs();
+    struct Journal *journal = openJournal(&list, BENCH_PATH);
+    if (journal == NULL) {
+        return 1;
+    }
+    double openMs = getNowMs() - start;
+
+    start = getNowMs();
+    double slowestMs = runOperations(&list, &array, journal, operationNum, &options);
+    double operationMs = getNowMs() - start;
+
+    struct JournalStatus status;
+    getJournalStatus(journal, &status);
+    start = getNowMs();
+    bool isClosed = closeJournal(journal, &list);
+    double closeMs = getNowMs() - start;
+
+    FILE *file = fopen(BENCH_PATH, "rb");
+    fseek(file, 0, SEEK_END);
+    double fileMb = ftell(file) / 1048576.0;
+    fclose(file);
+
+    struct LinkedList recovered;
+    initLinkedList(&recovered);
+    struct JournalStats stats;
+    start = getNowMs();
+    bool isRecovered = recoverJournal(&recovered, BENCH_PATH, &stats);
+    double recoverMs = getNowMs() - start;
+
+    printf("%d shapes, %d operations, %.1f MB of journal\n", shapeNum, operationNum, fileMb);
+    printf("open %.1f ms, operations %.1f ms (%.2f us each, slowest %.3f ms), close %.1f ms\n",
+           openMs, operationMs, operationMs * 1000 / operationNum, slowestMs, closeMs);
+    printf("%lld records written before close, %d checkpoints, ring full %d times\n",
+           status.recordNum, status.checkpointNum, status.stallNum);
+    printf("recovered %d snapshot shapes and replayed %d records in %.1f ms (%.2f Mrecords/s)\n",
+           stats.snapshotNum, stats.replayedNum, recoverMs,
+           recoverMs > 0 ? (stats.snapshotNum + stats.replayedNum) / recoverMs / 1000 : 0.0);
+
+    bool isPassed = isClosed && isRecovered && !stats.isTorn;
+    if (!isPassed || !isSameList(&list, &recovered)) {
+        printf("recovered list differs\n");
+        isPassed = false;
+    }
+    if (isPassed && stats.replayedNum > 0) {
+        isPassed = checkDamaged("torn", 3, 0, &stats) && isPassed;
+        isPassed = checkDamaged("damaged", 0, 2, &stats) && isPassed;
+    }
+    remove(BENCH_PATH);
+
+    destroyLinkedList(&recovered, destroyRule);
+    destroyLinkedList(&list, destroyRule);
+    free(array.nodes);
+
+    printf(isPassed ? "all checks passed\n" : "checks FAILED\n");
+    return isPassed ? 0 : 1;
+}
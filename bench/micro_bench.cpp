@@ -0,0 +1,348 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "linkedlist.h"
+#include "datatypes.h"
+#include "rtree.h"
+#include "bench.h"
+
+// Microbenchmarks of hit rules, findNode(), list churn and shape construction, printed as JSON.
+// Every case runs BENCH_WARMUP repetitions that are thrown away, then BENCH_REPS timed ones,
+// and reports the median time per operation with its median absolute deviation, so that
+// two builds can be compared on numbers that do not move with the odd slow repetition.
+// A case runs only if its name contains the first argument, when given.
+// Build: g++ -O2 -std=c++11 -Iinclude bench/micro_bench.cpp src/datatypes.cpp src/distance.cpp src/generate.cpp
+//        src/hittest.cpp src/linkedlist.cpp src/misc.cpp src/pool.cpp src/rtree.cpp
+
+#define BENCH_WARMUP 3
+#define BENCH_REPS 15
+// Operations of a repetition are picked so that it lasts about this long
+#define BENCH_REP_NS 20000000.0
+#define BENCH_MIN_SIZE 100
+#define BENCH_MAX_SIZE 1000000
+#define BENCH_CHURN_SIZE 100000
+// Shapes and cursor points hit rules cycle through, a power of two
+#define BENCH_HIT_NUM 4096
+#define BENCH_WIDTH 4096
+#define BENCH_HEIGHT 4096
+#define BENCH_SHAPE_SIZE 80
+
+static double getNowNs() {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Results are folded in here, so that the compiler cannot drop the work
+static volatile long long int sink;
+
+static struct NodeData * makeShapeData(int type) {
+    int x = nextRandom(BENCH_WIDTH), y = nextRandom(BENCH_HEIGHT);
+    switch (type) {
+        case DATATYPE_SEGMENT: {
+            return makeData(makeSegment(makeVertex(x, y), makeVertex(x + nextRandom(BENCH_SHAPE_SIZE), y + nextRandom(BENCH_SHAPE_SIZE))), DATATYPE_SEGMENT);
+        }
+        case DATATYPE_RECTANGLE: {
+            return makeData(makeRectangle(makeVertex(x, y), makeVertex(x + nextRandom(BENCH_SHAPE_SIZE) + 1, y + nextRandom(BENCH_SHAPE_SIZE) + 1)), DATATYPE_RECTANGLE);
+        }
+        case DATATYPE_CIRCLE: {
+            return makeData(makeCircle(makeVertex(x, y), nextRandom(BENCH_SHAPE_SIZE / 2) + 1), DATATYPE_CIRCLE);
+        }
+        case DATATYPE_ELLIPSE: {
+            return makeData(makeEllipse(makeVertex(x, y), nextRandom(BENCH_SHAPE_SIZE / 2) + 1, nextRandom(BENCH_SHAPE_SIZE / 2) + 1), DATATYPE_ELLIPSE);
+        }
+        default: {
+            return makeData(makeText(makeRectangle(makeVertex(x, y), makeVertex(x + 5 * 12, y + 16)), "bench", 12, 16), DATATYPE_TEXT);
+        }
+    }
+}
+
+/* Harness */
+
+struct BenchCase {
+    const char *name;
+    // Shapes involved, 0 if it does not apply
+    int size;
+    void *ctx;
+    // Run opNum operations
+    void (*runFunc)(void *ctx, long long int opNum);
+};
+
+static const char *caseFilter = NULL;
+static bool isFirstResult = true;
+
+static int compareDouble(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static double getMedian(double *values, int num) {
+    qsort(values, num, sizeof(double), compareDouble);
+    return num % 2 == 1 ? values[num / 2] : (values[num / 2 - 1] + values[num / 2]) / 2;
+}
+
+static bool isCaseSelected(const char *name) {
+    return caseFilter == NULL || strstr(name, caseFilter) != NULL;
+}
+
+static void runCase(const struct BenchCase *benchCase) {
+    if (!isCaseSelected(benchCase -> name)) {
+        return;
+    }
+    // Grow the repetition until it is long enough to time
+    long long int opNum = 1;
+    while (true) {
+        double start = getNowNs();
+        benchCase -> runFunc(benchCase -> ctx, opNum);
+        double elapsedNs = getNowNs() - start;
+        if (elapsedNs >= BENCH_REP_NS / 10 || opNum >= (1LL << 40)) {
+            opNum = elapsedNs <= 0 ? opNum : (long long int)(opNum * BENCH_REP_NS / elapsedNs) + 1;
+            break;
+        }
+        opNum *= 10;
+    }
+
+    double perOpNs[BENCH_REPS], deviations[BENCH_REPS];
+    for (int i = 0; i < BENCH_WARMUP; i++) {
+        benchCase -> runFunc(benchCase -> ctx, opNum);
+    }
+    for (int i = 0; i < BENCH_REPS; i++) {
+        double start = getNowNs();
+        benchCase -> runFunc(benchCase -> ctx, opNum);
+        perOpNs[i] = (getNowNs() - start) / opNum;
+    }
+    double median = getMedian(perOpNs, BENCH_REPS);
+    for (int i = 0; i < BENCH_REPS; i++) {
+        deviations[i] = perOpNs[i] > median ? perOpNs[i] - median : median - perOpNs[i];
+    }
+    double mad = getMedian(deviations, BENCH_REPS);
+    // perOpNs is sorted by now
+
+    printf("%s    {\"name\": \"%s\", \"size\": %d, \"ops_per_rep\": %lld, \"reps\": %d, "
+           "\"median_ns\": %.3f, \"mad_ns\": %.3f, \"min_ns\": %.3f, \"max_ns\": %.3f}",
+           isFirstResult ? "" : ",\n", benchCase -> name, benchCase -> size, opNum, BENCH_REPS,
+           median, mad, perOpNs[0], perOpNs[BENCH_REPS - 1]);
+    isFirstResult = false;
+    fflush(stdout);
+}
+
+/* Hit rules */
+
+struct HitContext {
+    int type;
+    struct NodeData *datas[BENCH_HIT_NUM];
+    struct Vertex points[BENCH_HIT_NUM];
+};
+
+static void runHitRule(void *ctx, long long int opNum) {
+    struct HitContext *hit = (struct HitContext *)ctx;
+    long long int hitNum = 0;
+    for (long long int i = 0; i < opNum; i++) {
+        const struct Vertex *cursorPt = &hit -> points[i & (BENCH_HIT_NUM - 1)];
+        const void *content = hit -> datas[(i * 7) & (BENCH_HIT_NUM - 1)] -> content;
+        switch (hit -> type) {
+            case DATATYPE_SEGMENT: {
+                hitNum += findSegmentRule(cursorPt, (const struct Segment *)content);
+                break;
+            }
+            case DATATYPE_RECTANGLE: {
+                hitNum += findRectangleRule(cursorPt, (const struct Rectangle *)content);
+                break;
+            }
+            case DATATYPE_CIRCLE: {
+                hitNum += findCircleRule(cursorPt, (const struct Circle *)content);
+                break;
+            }
+            case DATATYPE_ELLIPSE: {
+                hitNum += findEllipseRule(cursorPt, (const struct Ellipse *)content);
+                break;
+            }
+            default: {
+                hitNum += findTextRule(cursorPt, (const struct Text *)content);
+                break;
+            }
+        }
+    }
+    sink = sink + hitNum;
+}
+
+static void runHitRules() {
+    static const char *names[] = {"findSegmentRule", "findRectangleRule", "findCircleRule", "findEllipseRule", "findTextRule"};
+    for (int type = DATATYPE_SEGMENT; type <= DATATYPE_TEXT; type++) {
+        if (!isCaseSelected(names[type - DATATYPE_SEGMENT])) {
+            continue;
+        }
+        struct HitContext *hit = (struct HitContext *)malloc(sizeof(struct HitContext));
+        hit -> type = type;
+        for (int i = 0; i < BENCH_HIT_NUM; i++) {
+            hit -> datas[i] = makeShapeData(type);
+        }
+        for (int i = 0; i < BENCH_HIT_NUM; i++) {
+            // Each point falls around the shape it is tested against, so that rules see hits and near misses
+            struct BoundingBox box;
+            getDataBoundingBox(hit -> datas[(i * 7) & (BENCH_HIT_NUM - 1)], &box);
+            hit -> points[i].x = box.minx + nextRandom(box.maxx - box.minx + 2 * FINDRULE_VARIATION + 1) - FINDRULE_VARIATION;
+            hit -> points[i].y = box.miny + nextRandom(box.maxy - box.miny + 2 * FINDRULE_VARIATION + 1) - FINDRULE_VARIATION;
+        }
+        struct BenchCase benchCase = {names[type - DATATYPE_SEGMENT], 0, hit, runHitRule};
+        runCase(&benchCase);
+        for (int i = 0; i < BENCH_HIT_NUM; i++) {
+            destroyRule(hit -> datas[i]);
+        }
+        free(hit);
+    }
+}
+
+/* findNode */
+
+struct FindContext {
+    struct LinkedList *list;
+    struct Vertex points[BENCH_HIT_NUM];
+};
+
+static void runFindNode(void *ctx, long long int opNum) {
+    struct FindContext *find = (struct FindContext *)ctx;
+    long long int foundNum = 0;
+    for (long long int i = 0; i < opNum; i++) {
+        foundNum += findNode(find -> list, &find -> points[i & (BENCH_HIT_NUM - 1)], findRule) != NULL;
+    }
+    sink = sink + foundNum;
+}
+
+static void runFindNodes() {
+    if (!isCaseSelected("findNode")) {
+        return;
+    }
+    for (int size = BENCH_MIN_SIZE; size <= BENCH_MAX_SIZE; size *= 10) {
+        struct GenerateOptions options;
+        initBenchOptions(&options, size, BENCH_WIDTH, BENCH_HEIGHT, BENCH_SHAPE_SIZE);
+        struct LinkedList list;
+        initLinkedList(&list);
+        if (generateDrawing(&list, &options) != size) {
+            return;
+        }
+        struct FindContext find;
+        find.list = &list;
+        for (int i = 0; i < BENCH_HIT_NUM; i++) {
+            find.points[i].x = nextRandom(BENCH_WIDTH);
+            find.points[i].y = nextRandom(BENCH_HEIGHT);
+        }
+        struct BenchCase benchCase = {"findNode/list", size, &find, runFindNode};
+        runCase(&benchCase);
+
+        struct RTree *tree = makeRTree();
+        buildRTree(tree, &list);
+        attachIndex(&list, &tree -> index);
+        benchCase.name = "findNode/rtree";
+        runCase(&benchCase);
+
+        destroyLinkedList(&list, destroyRule);
+        detachIndex(&list, &tree -> index);
+        destroyRTree(tree);
+    }
+}
+
+/* List churn */
+
+struct ChurnContext {
+    struct LinkedList list;
+    struct LinkedNode **nodes;
+    int nodeNum;
+    // Shared by the nodes added by the add and delete case, each of them wraps it in a NodeData of its own
+    struct Segment *seg;
+};
+
+static void collectNodes(struct ChurnContext *churn) {
+    churn -> nodeNum = 0;
+    for (struct LinkedNode *cntNode = churn -> list.head; cntNode != NULL; cntNode = cntNode -> next) {
+        churn -> nodes[churn -> nodeNum++] = cntNode;
+    }
+}
+
+// Every operation adds a node at the tail and deletes a random one, so the list keeps its size
+static void runAddDelete(void *ctx, long long int opNum) {
+    struct ChurnContext *churn = (struct ChurnContext *)ctx;
+    for (long long int i = 0; i < opNum; i++) {
+        int pick = nextRandom(churn -> nodeNum);
+        deleteNode(&churn -> list, churn -> nodes[pick], NULL);
+        churn -> nodes[pick] = addNodeAtTail(&churn -> list, makeData(churn -> seg, DATATYPE_SEGMENT));
+    }
+}
+
+static void runMoveToHead(void *ctx, long long int opNum) {
+    struct ChurnContext *churn = (struct ChurnContext *)ctx;
+    for (long long int i = 0; i < opNum; i++) {
+        moveToHead(&churn -> list, churn -> nodes[nextRandom(churn -> nodeNum)]);
+    }
+}
+
+static void runMoveToTail(void *ctx, long long int opNum) {
+    struct ChurnContext *churn = (struct ChurnContext *)ctx;
+    for (long long int i = 0; i < opNum; i++) {
+        moveToTail(&churn -> list, churn -> nodes[nextRandom(churn -> nodeNum)]);
+    }
+}
+
+static void runChurn() {
+    if (!isCaseSelected("addNodeAtTail+deleteNode") && !isCaseSelected("moveToHead") && !isCaseSelected("moveToTail")) {
+        return;
+    }
+    struct ChurnContext churn;
+    initLinkedList(&churn.list);
+    churn.seg = makeSegment(makeVertex(0, 0), makeVertex(BENCH_SHAPE_SIZE, BENCH_SHAPE_SIZE));
+    churn.nodes = (struct LinkedNode **)malloc(BENCH_CHURN_SIZE * sizeof(struct LinkedNode *));
+    for (int i = 0; i < BENCH_CHURN_SIZE; i++) {
+        addNodeAtTail(&churn.list, makeData(churn.seg, DATATYPE_SEGMENT));
+    }
+    collectNodes(&churn);
+
+    struct BenchCase cases[] = {
+        {"addNodeAtTail+deleteNode", BENCH_CHURN_SIZE, &churn, runAddDelete},
+        {"moveToHead", BENCH_CHURN_SIZE, &churn, runMoveToHead},
+        {"moveToTail", BENCH_CHURN_SIZE, &churn, runMoveToTail},
+    };
+    for (int i = 0; i < (int)(sizeof(cases) / sizeof(cases[0])); i++) {
+        runCase(&cases[i]);
+    }
+
+    // The nodes only wrap the shared segment, which goes last
+    while (churn.list.head != NULL) {
+        deleteNode(&churn.list, churn.list.head, NULL);
+    }
+    destroySegment(churn.seg);
+    free(churn.nodes);
+}
+
+/* Construction */
+
+struct MakeContext {
+    int type;
+};
+
+static void runMakeDestroy(void *ctx, long long int opNum) {
+    struct MakeContext *make = (struct MakeContext *)ctx;
+    for (long long int i = 0; i < opNum; i++) {
+        destroyRule(makeShapeData(make -> type));
+    }
+}
+
+static void runConstruction() {
+    static const char *names[] = {"make+destroy/segment", "make+destroy/rectangle", "make+destroy/circle",
+                                  "make+destroy/ellipse", "make+destroy/text"};
+    for (int type = DATATYPE_SEGMENT; type <= DATATYPE_TEXT; type++) {
+        struct MakeContext make = {type};
+        struct BenchCase benchCase = {names[type - DATATYPE_SEGMENT], 0, &make, runMakeDestroy};
+        runCase(&benchCase);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    caseFilter = argc > 1 ? argv[1] : NULL;
+    printf("{\"warmup\": %d, \"reps\": %d, \"unit\": \"ns/op\", \"results\": [\n", BENCH_WARMUP, BENCH_REPS);
+    runHitRules();
+    runFindNodes();
+    runChurn();
+    runConstruction();
+    printf("\n]}\n");
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <chrono>
+
+#include "linkedlist.h"
+#include "datatypes.h"
+#include "pool.h"
+#include "bench.h"
+
+// Builds and tears down large drawings, then prints the pool counters.
+// Build twice, with and without -DCADET_NO_POOL, to compare against malloc:
+// g++ -O2 -std=c++11 -Iinclude bench/pool_bench.cpp src/datatypes.cpp
+//     src/distance.cpp src/linkedlist.cpp src/misc.cpp src/pool.cpp
+
+#define BENCH_SHAPES 1000000
+#define BENCH_ROUNDS 3
+
+int main() {
+#ifdef CADET_NO_POOL
+    printf("allocator: malloc\n");
+#else
+    printf("allocator: pool\n");
+#endif
+
+    struct LinkedList list;
+    initLinkedList(&list);
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        clock_t start = clock();
+        for (int i = 0; i < BENCH_SHAPES; i++) {
+            int x = (int)((i * 7919LL) % 4096), y = (int)((i * 104729LL) % 4096);
+            struct NodeData *data;
+            if (i % 2 == 0) {
+                data = makeData(makeSegment(makeVertex(x, y), makeVertex(x + 50, y + 20)), DATATYPE_SEGMENT);
+            } else {
+                data = makeData(makeCircle(makeVertex(x, y), 30), DATATYPE_CIRCLE);
+            }
+            addNodeAtTail(&list, data);
+        }
+        double buildMs = getElapsedMs(start);
+
+        // Walk the list the way redrawAll does
+        start = clock();
+        long long int checksum = 0;
+        for (struct LinkedNode *cntNode = list.head; cntNode != NULL; cntNode = cntNode -> next) {
+            struct BoundingBox box;
+            getDataBoundingBox(cntNode -> data, &box);
+            checksum += box.minx + box.maxy;
+        }
+        double walkMs = getElapsedMs(start);
+
+        start = clock();
+        destroyLinkedList(&list, destroyRule);
+        double destroyMs = getElapsedMs(start);
+
+        printf("round %d: build %.1f ms, walk %.1f ms, destroy %.1f ms (checksum %lld)\n",
+               round, buildMs, walkMs, destroyMs, checksum);
+    }
+
+    printPoolStats(stdout);
+    return 0;
+}
@@ -0,0 +1,264 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "linkedlist.h"
+#include "datatypes.h"
+#include "generate.h"
+#include "undo.h"
+#include "bench.h"
+
+// Checks the z-order ranks of LinkedList nodes under their worst case, nodes put again and again into one
+// and the same gap, which keeps relabeling the nodes around it: the time per node must grow no faster
+// than log n as the count grows tenfold, and ranks must keep increasing from head to tail. Then times telling
+// which of two nodes is above by rank against walking from one to the other, churns the list with moves
+// to both ends and in between, and finally checks that undoing and redoing changes across relabeling
+// brings back the very same order.
+// The drawing defaults to 1000000 shapes, the first argument overrides it.
+// Exits with 1 on any failed check.
+// Build: g++ -O2 -std=c++11 -Iinclude bench/rank_bench.cpp src/datatypes.cpp src/distance.cpp src/generate.cpp
+//        src/linkedlist.cpp src/misc.cpp src/pool.cpp src/undo.cpp
+
+#define BENCH_SHAPES 1000000
+#define BENCH_MIN_INSERTS 10000
+#define BENCH_MAX_INSERTS 1000000
+// Inserting ten times as many nodes into one gap may cost at most this many times more per node
+#define BENCH_MAX_GROWTH 3.0
+#define BENCH_COMPARES 100
+#define BENCH_MOVES 1000000
+#define BENCH_UNDO_SHAPES 1000
+#define BENCH_UNDO_CHANGES 4000
+
+static void initOptions(struct GenerateOptions *options, int shapeNum) {
+    initGenerateOptions(options);
+    options -> shapeNum = shapeNum;
+    options -> width = options -> height = 100000;
+}
+
+static struct NodeData * makeDot(int id) {
+    return makeData(makeCircle(makeVertex(id % 1000, id / 1000 % 1000), 4), DATATYPE_CIRCLE);
+}
+
+static bool isRankOrdered(const struct LinkedList *list) {
+    int nodeNum = 0;
+    for (const struct LinkedNode *cntNode = list -> head; cntNode != NULL; cntNode = cntNode -> next, nodeNum++) {
+        if (cntNode -> next != NULL && !isNodeAbove(cntNode -> next, cntNode)) {
+            return false;
+        }
+    }
+    return nodeNum == list -> listSize;
+}
+
+// Order of the nodes themselves, which undo and redo hand back as they were
+static unsigned long long int hashOrder(const struct LinkedList *list) {
+    unsigned long long int hash = 14695981039346656037ull;
+    for (const struct LinkedNode *cntNode = list -> head; cntNode != NULL; cntNode = cntNode -> next) {
+        hash ^= (unsigned long long int)(size_t)cntNode;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Fill one gap of a drawing with insertNum nodes, each right after the same node
+// Returns the nanoseconds per node, or -1 if the list went wrong
+static double timeOneGap(int shapeNum, int insertNum) {
+    struct GenerateOptions options;
+    initOptions(&options, shapeNum);
+    struct LinkedList list;
+    initLinkedList(&list);
+    if (generateDrawing(&list, &options) != shapeNum) {
+        return -1;
+    }
+    struct LinkedNode *anchorNode = list.head;
+    for (int i = 0; i < shapeNum / 2; i++) {
+        anchorNode = anchorNode -> next;
+    }
+    struct LinkedNode *afterNode = anchorNode -> next;
+
+    double startMs = getNowMs();
+    int addedNum = 0;
+    for (; addedNum < insertNum; addedNum++) {
+        if (addNodeAfter(&list, anchorNode, makeDot(addedNum)) == NULL) {
+            break;
+        }
+    }
+    double insertMs = getNowMs() - startMs;
+
+    // The latest node comes right after the anchor, the first one right before the node that followed it
+    bool isPassed = addedNum == insertNum && list.listSize == shapeNum + insertNum && isRankOrdered(&list);
+    const struct LinkedNode *cntNode = anchorNode -> next;
+    for (int i = 0; i < insertNum && isPassed; i++, cntNode = cntNode -> next) {
+        const struct Circle *circle = (const struct Circle *)cntNode -> data -> content;
+        int id = insertNum - 1 - i;
+        isPassed = cntNode -> data -> type == DATATYPE_CIRCLE && circle -> centerPt -> x == id % 1000 &&
+                   circle -> centerPt -> y == id / 1000 % 1000;
+    }
+    isPassed = isPassed && cntNode == afterNode;
+    destroyLinkedList(&list, destroyRule);
+    return isPassed ? insertMs * 1e6 / insertNum : -1;
+}
+
+static bool checkOneGap(int shapeNum) {
+    bool isPassed = true;
+    double lastNs = -1;
+    for (int insertNum = BENCH_MIN_INSERTS; insertNum <= BENCH_MAX_INSERTS; insertNum *= 10) {
+        double insertNs = timeOneGap(shapeNum, insertNum);
+        bool isFlat = lastNs <= 0 || insertNs <= lastNs * BENCH_MAX_GROWTH;
+        printf("%8d nodes into one gap: %7.1f ns per node, %s\n", insertNum, insertNs,
+               insertNs < 0 ? "WRONG ORDER" : isFlat ? "ok" : "TOO SLOW");
+        isPassed = isPassed && insertNs >= 0 && isFlat;
+        lastNs = insertNs;
+    }
+    return isPassed;
+}
+
+// Whether a is above b by walking from b toward the tail
+static bool isAboveByWalk(const struct LinkedNode *a, const struct LinkedNode *b) {
+    for (const struct LinkedNode *cntNode = b -> next; cntNode != NULL; cntNode = cntNode -> next) {
+        if (cntNode == a) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool checkCompares(struct LinkedList *list, struct LinkedNode **nodes, int nodeNum) {
+    struct LinkedNode *pairs[BENCH_COMPARES][2];
+    for (int i = 0; i < BENCH_COMPARES; i++) {
+        pairs[i][0] = nodes[nextRandom(nodeNum)];
+        pairs[i][1] = nodes[nextRandom(nodeNum)];
+    }
+    bool isAbove[BENCH_COMPARES];
+    double startMs = getNowMs();
+    for (int i = 0; i < BENCH_COMPARES; i++) {
+        isAbove[i] = isAboveByWalk(pairs[i][0], pairs[i][1]);
+    }
+    double walkMs = getNowMs() - startMs;
+    int mismatchNum = 0;
+    startMs = getNowMs();
+    for (int i = 0; i < BENCH_COMPARES; i++) {
+        mismatchNum += isNodeAbove(pairs[i][0], pairs[i][1]) != isAbove[i];
+    }
+    double rankMs = getNowMs() - startMs;
+    printf("is above, per pair of %d nodes: walking %.3f ms, by rank %.6f ms, %d differ\n",
+           list -> listSize, walkMs / BENCH_COMPARES, rankMs / BENCH_COMPARES, mismatchNum);
+    return mismatchNum == 0;
+}
+
+// Moves to either end or right after another node, the latter filling the gaps the former leave
+static bool checkMoves(struct LinkedList *list, struct LinkedNode **nodes, int nodeNum) {
+    double startMs = getNowMs();
+    for (int i = 0; i < BENCH_MOVES; i++) {
+        struct LinkedNode *node = nodes[nextRandom(nodeNum)];
+        switch (nextRandom(3)) {
+            case 0: {
+                moveToHead(list, node);
+                break;
+            }
+            case 1: {
+                moveToTail(list, node);
+                break;
+            }
+            default: {
+                struct LinkedNode *prevNode = nodes[nextRandom(nodeNum)];
+                if (prevNode != node) {
+                    moveNodeAfter(list, node, prevNode, node -> rank);
+                }
+                break;
+            }
+        }
+    }
+    double moveMs = getNowMs() - startMs;
+    bool isOrdered = isRankOrdered(list);
+    printf("%d random moves: %.1f ns per move, ranks %s\n", BENCH_MOVES, moveMs * 1e6 / BENCH_MOVES,
+           isOrdered ? "ordered" : "OUT OF ORDER");
+    return isOrdered;
+}
+
+// Random changes on a small drawing, most of them into a few gaps so that relabeling moves ranks
+// of nodes the history holds, undone and redone all the way
+static bool checkUndo() {
+    struct GenerateOptions options;
+    initOptions(&options, BENCH_UNDO_SHAPES);
+    struct LinkedList list;
+    initLinkedList(&list);
+    bool isPassed = generateDrawing(&list, &options) == BENCH_UNDO_SHAPES;
+    struct LinkedNode *anchors[4] = {list.head, list.head -> next, list.tail -> prev, list.tail};
+    unsigned long long int originalHash = hashOrder(&list);
+    struct UndoHistory *history = makeUndoHistory(&list, destroyRule);
+    if (history == NULL) {
+        return false;
+    }
+
+    for (int i = 0; i < BENCH_UNDO_CHANGES; i++) {
+        struct LinkedNode *node = list.head;
+        for (int skip = nextRandom(list.listSize); skip > 0; skip--) {
+            node = node -> next;
+        }
+        // Anchors stay in the list
+        bool isAnchor = node == anchors[0] || node == anchors[1] || node == anchors[2] || node == anchors[3];
+        int choice = nextRandom(10);
+        if (choice < 6 || isAnchor) {
+            addNodeAfter(&list, anchors[nextRandom(4)], makeDot(i));
+        } else if (choice < 8) {
+            deleteNode(&list, node, destroyRule);
+        } else if (choice == 8) {
+            moveToHead(&list, node);
+        } else {
+            moveNodeAfter(&list, node, anchors[nextRandom(4)], node -> rank);
+        }
+    }
+    unsigned long long int changedHash = hashOrder(&list);
+    bool isOrdered = isRankOrdered(&list);
+
+    // Moving the head to head changes nothing and leaves no step
+    struct UndoStatus status;
+    getUndoStatus(history, &status);
+    int undoneNum = 0;
+    while (undoChange(history, &list)) {
+        undoneNum++;
+        isOrdered = isOrdered && (undoneNum % 100 != 0 || isRankOrdered(&list));
+    }
+    bool isUndone = undoneNum == status.undoNum && undoneNum > BENCH_UNDO_CHANGES / 2 && hashOrder(&list) == originalHash && isRankOrdered(&list);
+    while (redoChange(history, &list)) {
+    }
+    bool isRedone = hashOrder(&list) == changedHash && isRankOrdered(&list);
+    destroyUndoHistory(history, &list);
+    destroyLinkedList(&list, destroyRule);
+
+    printf("%d changes undone and redone across relabeling: undo %s, redo %s, ranks %s\n", BENCH_UNDO_CHANGES,
+           isUndone ? "ok" : "WRONG", isRedone ? "ok" : "WRONG", isOrdered ? "ordered" : "OUT OF ORDER");
+    return isPassed && isUndone && isRedone && isOrdered;
+}
+
+int main(int argc, char *argv[]) {
+    int shapeNum = argc > 1 ? atoi(argv[1]) : BENCH_SHAPES;
+    if (shapeNum < 2) {
+        fprintf(stderr, "usage: %s [shapes]\n", argv[0]);
+        return 1;
+    }
+    bool isPassed = checkOneGap(shapeNum);
+
+    struct GenerateOptions options;
+    initOptions(&options, shapeNum);
+    struct LinkedList list;
+    initLinkedList(&list);
+    struct LinkedNode **nodes = (struct LinkedNode **)malloc(sizeof(struct LinkedNode *) * shapeNum);
+    if (nodes == NULL || generateDrawing(&list, &options) != shapeNum) {
+        fprintf(stderr, "rank_bench: out of memory\n");
+        return 1;
+    }
+    int id = 0;
+    for (struct LinkedNode *cntNode = list.head; cntNode != NULL; cntNode = cntNode -> next, id++) {
+        nodes[id] = cntNode;
+    }
+    isPassed = checkMoves(&list, nodes, shapeNum) && isPassed;
+    isPassed = checkCompares(&list, nodes, shapeNum) && isPassed;
+    free(nodes);
+    destroyLinkedList(&list, destroyRule);
+
+    isPassed = checkUndo() && isPassed;
+    printf("%s\n", isPassed ? "all checks passed" : "SOME CHECKS FAILED");
+    return isPassed ? 0 : 1;
+}
@@ -0,0 +1,261 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "linkedlist.h"
+#include "datatypes.h"
+#include "generate.h"
+#include "undo.h"
+#include "pool.h"
+#include "bench.h"
+
+// Times clearing drawings of growing size node by node against giving documentRegion back at once,
+// which should stay flat. Then checks that a clear stays undoable on a list owning the region: undo brings
+// the very same drawing back, edits made before the clear included, redo clears it again at the same cost,
+// and forgetting the clear leaves only what was drawn after it. Finally checks that drawing again after
+// a clear reuses the slabs of the region instead of growing the process.
+// The largest drawing defaults to 4000000 shapes, the first argument overrides it.
+// Builds with -DCADET_NO_POOL as well, clearing then walks in both cases.
+// Exits with 1 on any failed check.
+// Build: g++ -O2 -std=c++11 -Iinclude bench/region_bench.cpp src/datatypes.cpp src/distance.cpp src/generate.cpp
+//        src/linkedlist.cpp src/misc.cpp src/pool.cpp src/undo.cpp
+
+#define BENCH_SHAPES 4000000
+#define BENCH_CHECK_SHAPES 100000
+#define BENCH_EDITS 1000
+#define BENCH_LATER_SHAPES 1000
+// Clearing through the region must not take longer than this, whatever the size of the drawing
+#define BENCH_MAX_CLEAR_MS 1.0
+
+// With CADET_NO_POOL objects come from malloc, the region cannot give them back at once and clearing walks
+#ifdef CADET_NO_POOL
+#define BENCH_HAS_REGION false
+#else
+#define BENCH_HAS_REGION true
+#endif
+
+// Read a field of /proc/self/status in kB, where there is one
+// Returns -1 elsewhere
+static long getStatusKb(const char *field) {
+    FILE *file = fopen("/proc/self/status", "r");
+    if (file == NULL) {
+        return -1;
+    }
+    char line[256];
+    long kb = -1;
+    size_t fieldLength = strlen(field);
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (strncmp(line, field, fieldLength) == 0 && line[fieldLength] == ':') {
+            kb = atol(line + fieldLength + 1);
+            break;
+        }
+    }
+    fclose(file);
+    return kb;
+}
+
+static void hashBytes(unsigned long long int *hash, const void *bytes, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        *hash ^= ((const unsigned char *)bytes)[i];
+        *hash *= 1099511628211ull;
+    }
+}
+
+static unsigned long long int hashList(const struct LinkedList *list) {
+    unsigned long long int hash = 14695981039346656037ull;
+    for (const struct LinkedNode *cntNode = list -> head; cntNode != NULL; cntNode = cntNode -> next) {
+        hashBytes(&hash, &cntNode -> data -> type, sizeof(int));
+        hashBytes(&hash, &cntNode -> box, sizeof(struct BoundingBox));
+        if (cntNode -> data -> type == DATATYPE_TEXT) {
+            const struct Text *txt = (const struct Text *)cntNode -> data -> content;
+            hashBytes(&hash, txt -> content, strlen(txt -> content));
+        }
+    }
+    return hash;
+}
+
+static void initOptions(struct GenerateOptions *options, int shapeNum, unsigned int seed) {
+    initGenerateOptions(options);
+    options -> shapeNum = shapeNum;
+    options -> seed = seed;
+    options -> layout = GENERATE_LAYOUT_CLUSTERS;
+    options -> sizeMode = GENERATE_SIZE_LOG;
+    options -> width = options -> height = 100000;
+    options -> clusterNum = 256;
+    options -> clusterSpread = 2000;
+    options -> minSize = 4;
+    options -> maxSize = 2000;
+}
+
+// Build a drawing, then time destroying it
+// Returns the milliseconds, or -1 if the drawing could not be built
+static double timeClear(int shapeNum, bool isOwner) {
+    struct GenerateOptions options;
+    initOptions(&options, shapeNum, 1);
+    struct LinkedList list;
+    initLinkedList(&list);
+    if (isOwner) {
+        claimDocumentRegion(&list);
+    }
+    int addedNum = generateDrawing(&list, &options);
+    double startMs = getNowMs();
+    destroyLinkedList(&list, destroyRule);
+    double clearMs = getNowMs() - startMs;
+    return addedNum == shapeNum && list.listSize == 0 && getPoolRegionBytes(&documentRegion, NULL) == 0 ? clearMs : -1;
+}
+
+static bool checkScaling(int maxShapeNum) {
+    bool isPassed = true;
+    for (int shapeNum = maxShapeNum / 4; shapeNum <= maxShapeNum; shapeNum *= 2) {
+        double walkMs = timeClear(shapeNum, false), regionMs = timeClear(shapeNum, true);
+        bool isFlat = walkMs >= 0 && regionMs >= 0 && (!BENCH_HAS_REGION || regionMs <= BENCH_MAX_CLEAR_MS);
+        printf("%8d shapes: cleared node by node in %8.2f ms, through the region in %6.3f ms, %s\n",
+               shapeNum, walkMs, regionMs, isFlat ? "ok" : "TOO SLOW");
+        isPassed = isPassed && isFlat;
+    }
+    return isPassed;
+}
+
+// Replace every shape of a stretch of the list by a circle, so that the history holds data from before the clear
+static void editShapes(struct LinkedList *list, int editNum) {
+    struct LinkedNode *cntNode = list -> head;
+    for (int i = 0; i < editNum && cntNode != NULL; i++, cntNode = cntNode -> next) {
+        editNode(list, cntNode, makeData(makeCircle(makeVertex(cntNode -> box.minx, cntNode -> box.miny), 8 + i % 32),
+                                         DATATYPE_CIRCLE), destroyRule);
+    }
+}
+
+static bool checkUndo() {
+    struct GenerateOptions options;
+    initOptions(&options, BENCH_CHECK_SHAPES, 2);
+    struct LinkedList list;
+    initLinkedList(&list);
+    claimDocumentRegion(&list);
+    bool isPassed = generateDrawing(&list, &options) == BENCH_CHECK_SHAPES;
+    unsigned long long int originalHash = hashList(&list);
+
+    struct UndoHistory *history = makeUndoHistory(&list, destroyRule);
+    if (history == NULL) {
+        return false;
+    }
+    editShapes(&list, BENCH_EDITS);
+    unsigned long long int editedHash = hashList(&list);
+
+    double startMs = getNowMs();
+    destroyLinkedList(&list, destroyRule);
+    double clearMs = getNowMs() - startMs;
+    initOptions(&options, BENCH_LATER_SHAPES, 3);
+    isPassed = generateDrawing(&list, &options) == BENCH_LATER_SHAPES && isPassed;
+    unsigned long long int laterHash = hashList(&list);
+
+    // Back over the later shapes and the clear
+    for (int i = 0; i < BENCH_LATER_SHAPES; i++) {
+        undoChange(history, &list);
+    }
+    startMs = getNowMs();
+    undoChange(history, &list);
+    double undoMs = getNowMs() - startMs;
+    bool isUndone = hashList(&list) == editedHash;
+    for (int i = 0; i < BENCH_EDITS; i++) {
+        undoChange(history, &list);
+    }
+    isUndone = isUndone && hashList(&list) == originalHash;
+
+    for (int i = 0; i < BENCH_EDITS; i++) {
+        redoChange(history, &list);
+    }
+    startMs = getNowMs();
+    redoChange(history, &list);
+    double redoMs = getNowMs() - startMs;
+    for (int i = 0; i < BENCH_LATER_SHAPES; i++) {
+        redoChange(history, &list);
+    }
+    bool isRedone = hashList(&list) == laterHash;
+
+    // Forgetting the clear gives the generation before it back, only the later shapes are left
+    clearUndoHistory(history);
+    bool isForgotten = hashList(&list) == laterHash && list.listSize == BENCH_LATER_SHAPES;
+    destroyUndoHistory(history, &list);
+    destroyLinkedList(&list, destroyRule);
+    bool isEmpty = getPoolRegionBytes(&documentRegion, NULL) == 0;
+
+    printf("undoable clear of %d shapes: cleared in %.3f ms, undone in %.2f ms, redone in %.3f ms\n",
+           BENCH_CHECK_SHAPES, clearMs, undoMs, redoMs);
+    printf("undo %s, redo %s, forgetting the clear %s, region %s\n", isUndone ? "ok" : "WRONG", isRedone ? "ok" : "WRONG",
+           isForgotten ? "ok" : "WRONG", isEmpty ? "empty" : "STILL HOLDS OBJECTS");
+    return isPassed && isUndone && isRedone && isForgotten && isEmpty && clearMs <= BENCH_MAX_CLEAR_MS &&
+           redoMs <= BENCH_MAX_CLEAR_MS;
+}
+
+// Undone changes are forgotten by the next one, including an undone clear holding the generation after it
+static bool checkRedoBranch() {
+    struct GenerateOptions options;
+    initOptions(&options, BENCH_CHECK_SHAPES, 4);
+    struct LinkedList list;
+    initLinkedList(&list);
+    claimDocumentRegion(&list);
+    bool isPassed = generateDrawing(&list, &options) == BENCH_CHECK_SHAPES;
+    struct UndoHistory *history = makeUndoHistory(&list, destroyRule);
+    if (history == NULL) {
+        return false;
+    }
+    destroyLinkedList(&list, destroyRule);
+    initOptions(&options, BENCH_LATER_SHAPES, 5);
+    isPassed = generateDrawing(&list, &options) == BENCH_LATER_SHAPES && isPassed;
+    for (int i = 0; i <= BENCH_LATER_SHAPES; i++) {
+        undoChange(history, &list);
+    }
+    unsigned long long int hash = hashList(&list);
+    editShapes(&list, BENCH_EDITS);
+    struct UndoStatus status;
+    getUndoStatus(history, &status);
+    bool isBranched = status.undoNum == BENCH_EDITS && status.redoNum == 0;
+    for (int i = 0; i < BENCH_EDITS; i++) {
+        undoChange(history, &list);
+    }
+    isBranched = isBranched && !undoChange(history, &list) && hashList(&list) == hash && list.listSize == BENCH_CHECK_SHAPES;
+
+    destroyUndoHistory(history, &list);
+    destroyLinkedList(&list, destroyRule);
+    bool isEmpty = getPoolRegionBytes(&documentRegion, NULL) == 0;
+    printf("new change after undoing a clear: %s, region %s\n", isBranched ? "ok" : "WRONG",
+           isEmpty ? "empty" : "STILL HOLDS OBJECTS");
+    return isPassed && isBranched && isEmpty;
+}
+
+static bool checkReuse(int shapeNum) {
+    struct GenerateOptions options;
+    initOptions(&options, shapeNum, 6);
+    struct LinkedList list;
+    initLinkedList(&list);
+    claimDocumentRegion(&list);
+    bool isPassed = generateDrawing(&list, &options) == shapeNum;
+    destroyLinkedList(&list, destroyRule);
+    long clearedKb = getStatusKb("VmRSS");
+    isPassed = generateDrawing(&list, &options) == shapeNum && isPassed;
+    long redrawnKb = getStatusKb("VmRSS");
+    destroyLinkedList(&list, destroyRule);
+    if (clearedKb < 0 || redrawnKb < 0) {
+        printf("memory: not measured on this platform\n");
+        return isPassed;
+    }
+    printf("memory: drawing %d shapes again after a clear grew the process by %.1f MB\n",
+           shapeNum, (redrawnKb - clearedKb) / 1024.0);
+    return isPassed && redrawnKb - clearedKb < clearedKb / 20 + 1024;
+}
+
+int main(int argc, char *argv[]) {
+    int shapeNum = argc > 1 ? atoi(argv[1]) : BENCH_SHAPES;
+    if (shapeNum < 4) {
+        fprintf(stderr, "usage: %s [shapes]\n", argv[0]);
+        return 1;
+    }
+    bool isPassed = checkScaling(shapeNum);
+    isPassed = checkUndo() && isPassed;
+    isPassed = checkRedoBranch() && isPassed;
+    isPassed = checkReuse(shapeNum / 4) && isPassed;
+    printPoolStats(stdout);
+    printf("%s\n", isPassed ? "all checks passed" : "SOME CHECKS FAILED");
+    return isPassed ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <chrono>
+
+#include "linkedlist.h"
+#include "datatypes.h"
+#include "shapestore.h"
+#include "framebuffer.h"
+#include "render.h"
+#include "bench.h"
+
+// Measures software rendering throughput of the list and of the flat store on a headless framebuffer.
+// Both paths must give the same pixels, whose FNV-1a hash is printed for golden comparisons.
+// Then a drawing much larger than the framebuffer is rendered with and without culling.
+// With an argument, the last frame is also written there as a PPM image.
+// Exits with 1 if the paths or the culling disagree, or if the image cannot be written.
+// Build: g++ -O2 -std=c++11 -Iinclude bench/render_bench.cpp src/datatypes.cpp src/distance.cpp src/framebuffer.cpp
+//        src/generate.cpp src/hittest.cpp src/linkedlist.cpp src/misc.cpp src/pool.cpp src/ptrmap.cpp src/render.cpp
+//        src/rtree.cpp src/shapestore.cpp
+
+#define BENCH_WIDTH 1280
+#define BENCH_HEIGHT 960
+#define BENCH_SHAPE_SIZE 80
+#define BENCH_SHAPES 20000
+#define BENCH_FRAME_NUM 20
+// The large drawing spans this many framebuffers each way
+#define BENCH_WORLD_SCALE 8
+
+// Shapes centered on the framebuffer, spread over scale framebuffers each way
+static bool makeDrawing(struct LinkedList *list, int scale) {
+    struct GenerateOptions options;
+    initBenchOptions(&options, BENCH_SHAPES, BENCH_WIDTH * scale, BENCH_HEIGHT * scale, BENCH_SHAPE_SIZE);
+    options.originx = -BENCH_WIDTH * (scale - 1) / 2;
+    options.originy = -BENCH_HEIGHT * (scale - 1) / 2;
+    return generateDrawing(list, &options) == BENCH_SHAPES;
+}
+
+static unsigned int hashPixels(const struct FrameBuffer *fb) {
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < (size_t)fb -> width * fb -> height; i++) {
+        hash = (hash ^ fb -> pixels[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Render the list BENCH_FRAME_NUM times, culling shapes outside fb unless isCulled is false
+// Returns the milliseconds per frame
+static double renderFrames(struct FrameBuffer *fb, const struct LinkedList *list, bool isCulled, struct RenderStats *stats) {
+    struct RenderBackend backend;
+    initFrameBufferBackend(fb, &backend);
+    clock_t start = clock();
+    for (int frame = 0; frame < BENCH_FRAME_NUM; frame++) {
+        stats -> drawnNum = stats -> culledNum = 0;
+        fbFillRect(fb, 0, 0, fb -> width - 1, fb -> height - 1, fb -> bgColor);
+        renderList(&backend, list, fb -> color, false, isCulled ? &fb -> clip : NULL, stats);
+    }
+    return getElapsedMs(start) / BENCH_FRAME_NUM;
+}
+
+int main(int argc, char *argv[]) {
+    struct FrameBuffer *fb = makeFrameBuffer(BENCH_WIDTH, BENCH_HEIGHT);
+    if (fb == NULL) {
+        return 1;
+    }
+
+    struct LinkedList list;
+    initLinkedList(&list);
+    if (!makeDrawing(&list, 1)) {
+        return 1;
+    }
+
+    struct RenderStats stats;
+    double listMs = renderFrames(fb, &list, true, &stats);
+    unsigned int listHash = hashPixels(fb);
+
+    struct ShapeStore *store = makeShapeStore();
+    if (store == NULL || !buildShapeStore(store, &list)) {
+        return 1;
+    }
+    attachIndex(&list, &store -> index);
+    double storeMs = renderFrames(fb, &list, true, &stats);
+    unsigned int storeHash = hashPixels(fb);
+
+    printf("%d shapes on %dx%d\n", BENCH_SHAPES, BENCH_WIDTH, BENCH_HEIGHT);
+    printf("%8s %12s %14s %10s\n", "path", "ms/frame", "Mshapes/s", "hash");
+    printf("%8s %12.3f %14.2f   %08x\n", "list", listMs, listMs > 0 ? BENCH_SHAPES / listMs / 1000.0 : 0.0, listHash);
+    printf("%8s %12.3f %14.2f   %08x\n", "store", storeMs, storeMs > 0 ? BENCH_SHAPES / storeMs / 1000.0 : 0.0, storeHash);
+
+    bool isPassed = listHash == storeHash;
+    if (!isPassed) {
+        printf("list and store pixels differ\n");
+    }
+    if (argc > 1) {
+        isPassed = saveFrameBufferPPM(fb, argv[1]) && isPassed;
+    }
+
+    destroyLinkedList(&list, destroyRule);
+    detachIndex(&list, &store -> index);
+    destroyShapeStore(store);
+
+    // Most of a large drawing lies off screen
+    if (!makeDrawing(&list, BENCH_WORLD_SCALE)) {
+        return 1;
+    }
+    double fullMs = renderFrames(fb, &list, false, &stats);
+    unsigned int fullHash = hashPixels(fb);
+    double culledMs = renderFrames(fb, &list, true, &stats);
+    unsigned int culledHash = hashPixels(fb);
+    // The store culls on its own box column instead of the boxes of the nodes
+    store = makeShapeStore();
+    if (store == NULL || !buildShapeStore(store, &list)) {
+        return 1;
+    }
+    attachIndex(&list, &store -> index);
+    double storeCulledMs = renderFrames(fb, &list, true, &stats);
+    unsigned int storeCulledHash = hashPixels(fb);
+
+    printf("\n%d shapes over %dx%d framebuffers, %d drawn, %d culled\n", BENCH_SHAPES,
+           BENCH_WORLD_SCALE, BENCH_WORLD_SCALE, stats.drawnNum, stats.culledNum);
+    printf("%8s %12s %10s %10s\n", "culling", "ms/frame", "speedup", "hash");
+    printf("%8s %12.3f %9.1fx   %08x\n", "off", fullMs, 1.0, fullHash);
+    printf("%8s %12.3f %9.1fx   %08x\n", "on", culledMs, culledMs > 0 ? fullMs / culledMs : 0.0, culledHash);
+    printf("%8s %12.3f %9.1fx   %08x\n", "store", storeCulledMs, storeCulledMs > 0 ? fullMs / storeCulledMs : 0.0, storeCulledHash);
+    if (fullHash != culledHash || fullHash != storeCulledHash) {
+        printf("culling changed the pixels\n");
+        isPassed = false;
+    }
+    destroyLinkedList(&list, destroyRule);
+    detachIndex(&list, &store -> index);
+    destroyShapeStore(store);
+    destroyFrameBuffer(fb);
+    return isPassed ? 0 : 1;
+}
@@ -0,0 +1,518 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <chrono>
+
+#include "linkedlist.h"
+#include "datatypes.h"
+#include "rtree.h"
+#include "damage.h"
+#include "framebuffer.h"
+#include "render.h"
+#include "undo.h"
+#include "tracking.h"
+#include "inputlog.h"
+#include "bench.h"
+
+// Replays an input log, as recorded with CADET_INPUT_LOG, against a headless canvas and reports how long
+// each message took to answer, by kind, and the processor time of the whole replay.
+// The modes of main.cpp are followed on a framebuffer: buttons switch between selecting and drawing,
+// a drag draws or moves a shape through the frames of tracking.h, which the tracking loops draw the canvas with,
+// a right click brings a shape to the head, and undo, redo and clear work on the list. Texts are added with fixed content, as there is no input box.
+// Without a log given, a session of drawing and dragging is generated, saved and loaded back first.
+// The log is replayed twice, answering every move, then only the last move of each 60 Hz frame like
+// the tracking loops do; both passes must end on the same drawing and the same pixels.
+// Exits with 1 on any mismatch.
+// Build: g++ -O2 -std=c++11 -pthread -Iinclude bench/replay_bench.cpp src/arena.cpp src/damage.cpp src/datatypes.cpp src/distance.cpp
+//        src/framebuffer.cpp src/generate.cpp src/hittest.cpp src/inputlog.cpp src/linkedlist.cpp src/misc.cpp
+//        src/pool.cpp src/ptrmap.cpp src/render.cpp src/rtree.cpp src/shapestore.cpp src/tracking.cpp src/undo.cpp
+
+#define BENCH_PATH "replay_bench.input"
+// Screen of the generated session, the canvas is what the menu leaves
+#define BENCH_SCREEN_WIDTH 1280
+#define BENCH_SCREEN_HEIGHT 960
+#define BENCH_MENU_WIDTH (BENCH_SCREEN_WIDTH / 5)
+#define BENCH_SHAPES 20000
+#define BENCH_SHAPE_SIZE 80
+#define BENCH_DRAGS 400
+#define BENCH_DRAG_MOVES 40
+// Milliseconds between generated moves, and the frame the coalescing pass folds moves into
+#define BENCH_MOVE_MS 2
+#define BENCH_FRAME_MS (1000 / 60)
+
+#define BENCH_SHAPE_COLOR 0xFFFFFF
+// EDIT_ASSIST_COLOR, the shape being dragged is drawn in it where it was
+#define BENCH_ASSIST_COLOR 0xA9A9A9
+
+// Buttons, with the ids of layout.h
+#define BENCH_BUTTON_TEXT 4
+#define BENCH_BUTTON_CLEAR 5
+#define BENCH_BUTTON_EXIT 6
+#define BENCH_BUTTON_UNDO 7
+#define BENCH_BUTTON_REDO 8
+#define BENCH_BUTTON_NONE -1
+
+// What each message is counted as
+#define BENCH_KIND_MOVE 0
+#define BENCH_KIND_PRESS 1
+#define BENCH_KIND_RELEASE 2
+#define BENCH_KIND_BUTTON 3
+#define BENCH_KIND_NUM 4
+
+static const char *kindNames[BENCH_KIND_NUM] = {"move", "press", "release", "button"};
+
+static int getCanvasWidth() {
+    return BENCH_SCREEN_WIDTH - BENCH_MENU_WIDTH - 1;
+}
+
+// A point findRule() picks data at, in canvas coordinates
+static void getPickPoint(const struct NodeData *data, int *x, int *y) {
+    switch (data -> type) {
+        case DATATYPE_SEGMENT: {
+            const struct Segment *seg = (const struct Segment *)data -> content;
+            *x = seg -> leftPt -> x;
+            *y = seg -> leftPt -> y;
+            break;
+        }
+        case DATATYPE_CIRCLE: {
+            const struct Circle *cir = (const struct Circle *)data -> content;
+            *x = cir -> centerPt -> x + cir -> radius;
+            *y = cir -> centerPt -> y;
+            break;
+        }
+        case DATATYPE_ELLIPSE: {
+            const struct Ellipse *elp = (const struct Ellipse *)data -> content;
+            *x = elp -> centerPt -> x + elp -> majorSemiAxis;
+            *y = elp -> centerPt -> y;
+            break;
+        }
+        default: {
+            struct BoundingBox box;
+            getDataBoundingBox(data, &box);
+            *x = box.minx;
+            *y = box.miny;
+            break;
+        }
+    }
+}
+
+/* Generated session */
+
+struct Script {
+    int size, capacity;
+    struct InputLogEvent *events;
+    unsigned int timeMs;
+};
+
+static void pushEvent(struct Script *script, int kind, int x, int y, int flags, int delayMs) {
+    if (script -> size == script -> capacity) {
+        script -> capacity = script -> capacity == 0 ? 1024 : script -> capacity * 2;
+        script -> events = (struct InputLogEvent *)realloc(script -> events, script -> capacity * sizeof(struct InputLogEvent));
+    }
+    script -> timeMs += delayMs;
+    struct InputLogEvent *event = &script -> events[script -> size++];
+    event -> timeMs = script -> timeMs;
+    event -> x = (int16_t)x;
+    event -> y = (int16_t)y;
+    event -> wheel = 0;
+    event -> kind = (uint8_t)kind;
+    event -> flags = (uint8_t)flags;
+}
+
+static void pushClick(struct Script *script, int x, int y, int flags) {
+    pushEvent(script, INPUT_LOG_DOWN, x, y, flags, 200);
+    pushEvent(script, INPUT_LOG_UP, x, y, flags, 80);
+}
+
+static void pushButton(struct Script *script, int buttonId) {
+    int row = buttonId >= BENCH_BUTTON_UNDO ? BENCH_BUTTON_UNDO : buttonId;
+    int x = buttonId == BENCH_BUTTON_REDO ? BENCH_MENU_WIDTH * 3 / 4 : BENCH_MENU_WIDTH / 4;
+    pushClick(script, x, BENCH_SCREEN_HEIGHT * (row + 2) / 10 + BENCH_SCREEN_HEIGHT / 20, INPUT_LOG_LEFT);
+}
+
+// Press at (x, y) in screen coordinates, move by (deltax, deltay) in small steps, and release
+static void pushDrag(struct Script *script, int x, int y, int deltax, int deltay) {
+    pushEvent(script, INPUT_LOG_DOWN, x, y, INPUT_LOG_LEFT, 300);
+    for (int i = 1; i <= BENCH_DRAG_MOVES; i++) {
+        pushEvent(script, INPUT_LOG_MOVE, x + deltax * i / BENCH_DRAG_MOVES, y + deltay * i / BENCH_DRAG_MOVES,
+                  INPUT_LOG_LEFT, BENCH_MOVE_MS);
+    }
+    pushEvent(script, INPUT_LOG_UP, x + deltax, y + deltay, INPUT_LOG_LEFT, BENCH_MOVE_MS);
+}
+
+// Draw a few shapes of each kind, then drag shapes of the initial drawing around, with undos, redos and reorders
+static struct InputLogEvent * makeScript(const struct LinkedList *list, int *eventNum) {
+    struct Script script = {0, 0, NULL, 0};
+    const int originx = BENCH_MENU_WIDTH + 1;
+    for (int shapeType = DATATYPE_SEGMENT; shapeType <= DATATYPE_ELLIPSE; shapeType++) {
+        pushButton(&script, shapeType - DATATYPE_SEGMENT);
+        for (int i = 0; i < 5; i++) {
+            pushDrag(&script, originx + nextRandom(getCanvasWidth() - 200), nextRandom(BENCH_SCREEN_HEIGHT - 200),
+                     nextRandom(200) - 20, nextRandom(200) - 20);
+        }
+        // Pressing the active button again goes back to selecting
+        pushButton(&script, shapeType - DATATYPE_SEGMENT);
+    }
+
+    // Shapes near the head are mostly covered, so the nodes are taken from anywhere
+    const struct LinkedNode **nodes = (const struct LinkedNode **)malloc(list -> listSize * sizeof(struct LinkedNode *));
+    int nodeNum = 0;
+    for (const struct LinkedNode *cntNode = list -> head; cntNode != NULL; cntNode = cntNode -> next) {
+        nodes[nodeNum++] = cntNode;
+    }
+    for (int i = 0; i < BENCH_DRAGS && nodeNum > 0; i++) {
+        int x = 0, y = 0;
+        getPickPoint(nodes[nextRandom(nodeNum)] -> data, &x, &y);
+        if (x < 0 || x >= getCanvasWidth() || y < 0 || y >= BENCH_SCREEN_HEIGHT) {
+            continue;
+        }
+        switch (i % 20) {
+            case 7: {
+                pushClick(&script, originx + x, y, INPUT_LOG_RIGHT);
+                break;
+            }
+            case 13: {
+                pushButton(&script, BENCH_BUTTON_UNDO);
+                pushButton(&script, BENCH_BUTTON_UNDO);
+                pushButton(&script, BENCH_BUTTON_REDO);
+                break;
+            }
+            default: {
+                pushDrag(&script, originx + x, y, nextRandom(160) - 80, nextRandom(160) - 80);
+                break;
+            }
+        }
+    }
+    free(nodes);
+
+    pushButton(&script, BENCH_BUTTON_TEXT);
+    pushClick(&script, originx + 100, 100, INPUT_LOG_LEFT);
+    pushButton(&script, BENCH_BUTTON_TEXT);
+    pushButton(&script, BENCH_BUTTON_EXIT);
+    *eventNum = script.size;
+    return script.events;
+}
+
+/* Replay */
+
+struct Replay {
+    struct LinkedList list;
+    struct RTree *tree;
+    struct UndoHistory *history;
+    struct FrameBuffer *fb;
+    struct DamagePainter painter;
+    struct RenderBackend backend;
+    struct Tracker tracker;
+
+    // DATATYPE_UNDEFINED when selecting, the shape drawn otherwise
+    int mode;
+    bool isDrawing, isDragging, isExited;
+    // Points of the drag in canvas coordinates, kept as the tracking loops keep them
+    struct Vertex startPt, endPt, cursorPt;
+    struct LinkedNode *draggedNode;
+};
+
+static bool initReplay(struct Replay *replay) {
+    initLinkedList(&replay -> list);
+    replay -> history = NULL;
+    replay -> tree = makeRTree();
+    replay -> fb = makeFrameBuffer(getCanvasWidth(), BENCH_SCREEN_HEIGHT);
+    struct GenerateOptions options;
+    initBenchOptions(&options, BENCH_SHAPES, getCanvasWidth(), BENCH_SCREEN_HEIGHT, BENCH_SHAPE_SIZE);
+    if (replay -> tree == NULL || replay -> fb == NULL || generateDrawing(&replay -> list, &options) != BENCH_SHAPES) {
+        return false;
+    }
+    buildRTree(replay -> tree, &replay -> list);
+    attachIndex(&replay -> list, &replay -> tree -> index);
+    replay -> history = makeUndoHistory(&replay -> list, destroyRule);
+    replay -> fb -> color = BENCH_SHAPE_COLOR;
+    replay -> fb -> overlayColor = BENCH_ASSIST_COLOR;
+    initFrameBufferPainter(replay -> fb, &replay -> painter);
+    initFrameBufferBackend(replay -> fb, &replay -> backend);
+
+    replay -> mode = DATATYPE_UNDEFINED;
+    replay -> isDrawing = replay -> isDragging = replay -> isExited = false;
+    replay -> draggedNode = NULL;
+    fbRedrawAll(replay -> fb, &replay -> list);
+    return true;
+}
+
+static void destroyReplay(struct Replay *replay) {
+    if (replay -> history != NULL) {
+        destroyUndoHistory(replay -> history, &replay -> list);
+    }
+    destroyLinkedList(&replay -> list, destroyRule);
+    if (replay -> tree != NULL) {
+        detachIndex(&replay -> list, &replay -> tree -> index);
+        destroyRTree(replay -> tree);
+    }
+    if (replay -> fb != NULL) {
+        destroyFrameBuffer(replay -> fb);
+    }
+}
+
+static int getButtonId(int x, int y) {
+    int row = y * 10 / BENCH_SCREEN_HEIGHT - 2;
+    if (row < 0 || row > BENCH_BUTTON_UNDO) {
+        return BENCH_BUTTON_NONE;
+    }
+    return row == BENCH_BUTTON_UNDO && x >= BENCH_MENU_WIDTH / 2 ? BENCH_BUTTON_REDO : row;
+}
+
+// Start a drag, whose frames repaint the framebuffer as the tracking loops repaint the canvas
+static void beginDraft(struct Replay *replay) {
+    struct BoundingBox canvasBox = {0, 0, replay -> fb -> width - 1, replay -> fb -> height - 1};
+    initTracker(&replay -> tracker, &replay -> list, &replay -> backend, &replay -> painter, &canvasBox);
+}
+
+// Drop the draft and draw the list anew, as redrawAll() does after every change
+static void endDraft(struct Replay *replay) {
+    replay -> fb -> overlayData = NULL;
+    setFrameBufferClip(replay -> fb, NULL);
+    fbRedrawAll(replay -> fb, &replay -> list);
+}
+
+static void pressButton(struct Replay *replay, int buttonId) {
+    switch (buttonId) {
+        case BENCH_BUTTON_NONE: {
+            return;
+        }
+        case BENCH_BUTTON_CLEAR: {
+            destroyLinkedList(&replay -> list, destroyRule);
+            replay -> mode = DATATYPE_UNDEFINED;
+            break;
+        }
+        case BENCH_BUTTON_EXIT: {
+            replay -> isExited = true;
+            return;
+        }
+        case BENCH_BUTTON_UNDO: {
+            undoChange(replay -> history, &replay -> list);
+            replay -> mode = DATATYPE_UNDEFINED;
+            break;
+        }
+        case BENCH_BUTTON_REDO: {
+            redoChange(replay -> history, &replay -> list);
+            replay -> mode = DATATYPE_UNDEFINED;
+            break;
+        }
+        default: {
+            // Pressing the button of the current mode goes back to selecting
+            int mode = buttonId + DATATYPE_SEGMENT;
+            replay -> mode = replay -> mode == mode ? DATATYPE_UNDEFINED : mode;
+            return;
+        }
+    }
+    endDraft(replay);
+}
+
+// Answer a press on the canvas at (x, y): start drawing, add a text, or pick a shape to drag or bring to the head
+static void pressCanvas(struct Replay *replay, int x, int y, bool isLeft) {
+    struct Vertex cursorPt = {x, y};
+    if (replay -> mode == DATATYPE_TEXT) {
+        if (isLeft) {
+            struct Vertex endPt = {x + 40, y + 16};
+            saveText(&replay -> list, &cursorPt, &endPt, "text", 0, 16);
+            endDraft(replay);
+        }
+    } else if (replay -> mode != DATATYPE_UNDEFINED) {
+        if (isLeft) {
+            // As trackEndPt(), the shape starts as a dot
+            replay -> startPt = replay -> endPt = cursorPt;
+            renderShape(&replay -> backend, &replay -> startPt, &replay -> endPt, replay -> mode, BENCH_SHAPE_COLOR);
+            beginDraft(replay);
+            replay -> isDrawing = true;
+        }
+    } else {
+        struct LinkedNode *node = findNode(&replay -> list, &cursorPt, findRule);
+        if (node != NULL && isLeft) {
+            // As moveItem(), the shape is dragged from the handle a move takes
+            struct Vertex assistPts[EDIT_ASSIST_MAX_NUM];
+            getEditAssistPts(node, assistPts);
+            if (getTrackedPts(node -> data, assistPts, -1, &replay -> startPt, &replay -> endPt)) {
+                replay -> cursorPt = cursorPt;
+                replay -> draggedNode = node;
+                replay -> fb -> overlayData = node -> data;
+                beginDraft(replay);
+                replay -> isDragging = true;
+            }
+        } else if (node != NULL) {
+            moveToHead(&replay -> list, node);
+            endDraft(replay);
+        }
+    }
+}
+
+// Answer one message
+// Returns the kind it is counted as
+static int replayEvent(struct Replay *replay, const struct InputLogEvent *event) {
+    int x = event -> x - BENCH_MENU_WIDTH - 1, y = event -> y;
+    bool isLeft = (event -> flags & INPUT_LOG_LEFT) != 0;
+    switch (event -> kind) {
+        case INPUT_LOG_MOVE: {
+            if (replay -> isDrawing) {
+                replay -> endPt.x = x;
+                replay -> endPt.y = y;
+                drawTrackedShape(&replay -> tracker, &replay -> startPt, &replay -> endPt, replay -> mode, BENCH_SHAPE_COLOR);
+            } else if (replay -> isDragging) {
+                moveTrackedPts(&replay -> cursorPt, x, y, &replay -> startPt, &replay -> endPt);
+                drawTrackedData(&replay -> tracker, replay -> draggedNode -> data, &replay -> startPt, &replay -> endPt,
+                                BENCH_SHAPE_COLOR);
+            }
+            return BENCH_KIND_MOVE;
+        }
+        case INPUT_LOG_DOWN: {
+            if (event -> x <= BENCH_MENU_WIDTH) {
+                if (isLeft) {
+                    pressButton(replay, getButtonId(event -> x, event -> y));
+                }
+                return BENCH_KIND_BUTTON;
+            }
+            pressCanvas(replay, x, y, isLeft);
+            return BENCH_KIND_PRESS;
+        }
+        case INPUT_LOG_UP: {
+            if (replay -> isDrawing) {
+                // The end point is that of the last move, as in trackEndPt()
+                saveShape(&replay -> list, &replay -> startPt, &replay -> endPt, replay -> mode);
+                endDraft(replay);
+            } else if (replay -> isDragging) {
+                // trackShape() follows the release too
+                moveTrackedPts(&replay -> cursorPt, x, y, &replay -> startPt, &replay -> endPt);
+                if (replay -> draggedNode -> data -> type == DATATYPE_TEXT) {
+                    editText(&replay -> list, replay -> draggedNode, &replay -> startPt, &replay -> endPt);
+                } else {
+                    editShape(&replay -> list, replay -> draggedNode, &replay -> startPt, &replay -> endPt);
+                }
+                endDraft(replay);
+            }
+            replay -> isDrawing = replay -> isDragging = false;
+            return BENCH_KIND_RELEASE;
+        }
+        default: {
+            return BENCH_KIND_MOVE;
+        }
+    }
+}
+
+static unsigned long long int hashBytes(unsigned long long int hash, const void *bytes, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= ((const unsigned char *)bytes)[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static unsigned long long int hashReplay(const struct Replay *replay) {
+    unsigned long long int hash = 14695981039346656037ull;
+    for (const struct LinkedNode *cntNode = replay -> list.head; cntNode != NULL; cntNode = cntNode -> next) {
+        hash = hashBytes(hash, &cntNode -> data -> type, sizeof(int));
+        hash = hashBytes(hash, &cntNode -> box, sizeof(struct BoundingBox));
+    }
+    return hashBytes(hash, replay -> fb -> pixels, sizeof(unsigned int) * replay -> fb -> width * replay -> fb -> height);
+}
+
+static int compareDouble(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// Replay every message, or only the last move of each frame when isCoalescing
+// Returns false if the replay could not run
+static bool runReplay(const struct InputLogEvent *events, int eventNum, bool isCoalescing, unsigned long long int *hash) {
+    struct Replay replay;
+    if (!initReplay(&replay)) {
+        destroyReplay(&replay);
+        return false;
+    }
+    double *latencies[BENCH_KIND_NUM];
+    int latencyNums[BENCH_KIND_NUM] = {0};
+    for (int i = 0; i < BENCH_KIND_NUM; i++) {
+        latencies[i] = (double *)malloc(eventNum * sizeof(double));
+    }
+
+    int answeredNum = 0;
+    clock_t start = clock();
+    for (int i = 0; i < eventNum && !replay.isExited; i++) {
+        // A move followed by another one within the same frame is stale by the time it would be drawn
+        if (isCoalescing && events[i].kind == INPUT_LOG_MOVE && i + 1 < eventNum && events[i + 1].kind == INPUT_LOG_MOVE &&
+            events[i].timeMs / BENCH_FRAME_MS == events[i + 1].timeMs / BENCH_FRAME_MS) {
+            continue;
+        }
+        double eventStart = getNowMs();
+        int kind = replayEvent(&replay, &events[i]);
+        latencies[kind][latencyNums[kind]++] = getNowMs() - eventStart;
+        answeredNum++;
+    }
+    double cpuMs = getElapsedMs(start);
+    endDraft(&replay);
+    *hash = hashReplay(&replay);
+
+    printf("%s: %d of %d messages answered, %.1f ms of processor time, %d shapes left\n",
+           isCoalescing ? "coalesced by frame" : "every message", answeredNum, eventNum, cpuMs, replay.list.listSize);
+    printf("%10s %8s %10s %10s %10s %10s\n", "kind", "count", "p50 ms", "p95 ms", "p99 ms", "max ms");
+    for (int i = 0; i < BENCH_KIND_NUM; i++) {
+        int num = latencyNums[i];
+        if (num > 0) {
+            qsort(latencies[i], num, sizeof(double), compareDouble);
+            printf("%10s %8d %10.3f %10.3f %10.3f %10.3f\n", kindNames[i], num, latencies[i][num / 2],
+                   latencies[i][num * 95 / 100], latencies[i][num * 99 / 100], latencies[i][num - 1]);
+        }
+        free(latencies[i]);
+    }
+    destroyReplay(&replay);
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = argc > 1 ? argv[1] : BENCH_PATH;
+    bool isPassed = true;
+    if (argc <= 1) {
+        struct Replay replay;
+        if (!initReplay(&replay)) {
+            return 1;
+        }
+        int scriptNum = 0;
+        struct InputLogEvent *script = makeScript(&replay.list, &scriptNum);
+        destroyReplay(&replay);
+
+        struct InputLog *log = openInputLog(path);
+        bool isWritten = log != NULL;
+        for (int i = 0; i < scriptNum && isWritten; i++) {
+            isWritten = appendInputLog(log, &script[i]);
+        }
+        isWritten = log != NULL && closeInputLog(log) && isWritten;
+
+        int loadedNum = 0;
+        struct InputLogEvent *loaded = isWritten ? loadInputLog(path, &loadedNum) : NULL;
+        isPassed = loaded != NULL && loadedNum == scriptNum && memcmp(loaded, script, scriptNum * sizeof(struct InputLogEvent)) == 0;
+        if (!isPassed) {
+            printf("the input log does not read back as written\n");
+        }
+        free(loaded);
+        free(script);
+    }
+
+    int eventNum = 0;
+    struct InputLogEvent *events = loadInputLog(path, &eventNum);
+    if (events == NULL) {
+        printf("%s holds no input log\n", path);
+        return 1;
+    }
+    printf("%s: %d messages over %.1f s\n", path, eventNum, events[eventNum - 1].timeMs / 1000.0);
+    unsigned long long int hash = 0, coalescedHash = 0;
+    isPassed = runReplay(events, eventNum, false, &hash) && isPassed;
+    isPassed = runReplay(events, eventNum, true, &coalescedHash) && isPassed;
+    if (hash != coalescedHash) {
+        printf("coalescing changed the drawing\n");
+        isPassed = false;
+    }
+    printf("drawing hash %016llx\n", hash);
+    free(events);
+    if (argc <= 1) {
+        remove(path);
+    }
+    printf(isPassed ? "all checks passed\n" : "checks FAILED\n");
+    return isPassed ? 0 : 1;
+}
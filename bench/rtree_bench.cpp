@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <chrono>
+
+#include "linkedlist.h"
+#include "datatypes.h"
+#include "rtree.h"
+#include "bench.h"
+
+// Compares the R-tree against the linear findNode() scan.
+// Exits with 1 if they pick different shapes for any query.
+// Build: g++ -O2 -std=c++11 -Iinclude bench/rtree_bench.cpp src/datatypes.cpp
+//        src/distance.cpp src/generate.cpp src/linkedlist.cpp src/misc.cpp src/pool.cpp src/rtree.cpp
+
+#define BENCH_MIN_SHAPES 1000
+#define BENCH_MAX_SHAPES 1000000
+#define BENCH_QUERY_NUM 100000
+#define BENCH_LINEAR_BUDGET 100000000LL
+// One shape in this many is a rectangle up to a quarter of the world wide
+#define BENCH_HUGE_SHARE 400
+
+// Shapes of 10-200 pixels with a few huge rectangles, density independent of n
+static bool makeDrawing(struct LinkedList *list, int shapeNum, int worldSize) {
+    struct GenerateOptions options, hugeOptions;
+    initBenchOptions(&hugeOptions, shapeNum / BENCH_HUGE_SHARE, worldSize, worldSize, worldSize / 4);
+    memset(hugeOptions.typeWeights, 0, sizeof(hugeOptions.typeWeights));
+    hugeOptions.typeWeights[DATATYPE_RECTANGLE - DATATYPE_SEGMENT] = 1;
+    hugeOptions.sizeMode = GENERATE_SIZE_LOG;
+    hugeOptions.minSize = 200;
+    hugeOptions.seed++;
+    initBenchOptions(&options, shapeNum - hugeOptions.shapeNum, worldSize, worldSize, 200);
+    options.minSize = 10;
+    return generateDrawing(list, &hugeOptions) == hugeOptions.shapeNum && generateDrawing(list, &options) == options.shapeNum;
+}
+
+int main() {
+    bool isAllMatched = true;
+    printf("%10s %12s %12s %14s %14s %10s\n", "shapes", "str_ms", "insert_ms", "linear_us/q", "rtree_us/q", "speedup");
+
+    for (int shapeNum = BENCH_MIN_SHAPES; shapeNum <= BENCH_MAX_SHAPES; shapeNum *= 10) {
+        int worldSize = 0;
+        while ((long long int)worldSize * worldSize < (long long int)shapeNum * 20000) {
+            worldSize += 100;
+        }
+
+        struct LinkedList list;
+        initLinkedList(&list);
+        if (!makeDrawing(&list, shapeNum, worldSize)) {
+            return 1;
+        }
+
+        struct Vertex *queries = (struct Vertex *)malloc(sizeof(struct Vertex) * BENCH_QUERY_NUM);
+        for (int i = 0; i < BENCH_QUERY_NUM; i++) {
+            queries[i].x = nextRandom(worldSize);
+            queries[i].y = nextRandom(worldSize);
+        }
+
+        // Linear scan, with a bounded number of queries on large lists
+        int linearQueryNum = (int)min((long long int)BENCH_QUERY_NUM, BENCH_LINEAR_BUDGET / shapeNum);
+        clock_t start = clock();
+        int linearHits = 0;
+        for (int i = 0; i < linearQueryNum; i++) {
+            linearHits += findNode(&list, &queries[i], findRule) != NULL;
+        }
+        double linearMs = getElapsedMs(start);
+
+        struct RTree *incTree = makeRTree();
+        start = clock();
+        for (struct LinkedNode *cntNode = list.head; cntNode != NULL; cntNode = cntNode -> next) {
+            insertRTree(incTree, cntNode, cntNode -> data);
+        }
+        double insertMs = getElapsedMs(start);
+        destroyRTree(incTree);
+
+        struct RTree *tree = makeRTree();
+        start = clock();
+        buildRTree(tree, &list);
+        double strMs = getElapsedMs(start);
+        attachIndex(&list, &tree -> index);
+
+        start = clock();
+        int treeHits = 0, mismatchNum = 0;
+        for (int i = 0; i < BENCH_QUERY_NUM; i++) {
+            treeHits += findNode(&list, &queries[i], findRule) != NULL;
+        }
+        double treeMs = getElapsedMs(start);
+
+        // Both paths must agree on the picked shape
+        detachIndex(&list, &tree -> index);
+        for (int i = 0; i < linearQueryNum; i += max(1, linearQueryNum / 1000)) {
+            if (findNode(&list, &queries[i], findRule) != findRTree(tree, &queries[i], findRule)) {
+                mismatchNum++;
+            }
+        }
+
+        double linearUs = linearMs * 1000.0 / max(linearQueryNum, 1);
+        double treeUs = treeMs * 1000.0 / BENCH_QUERY_NUM;
+        printf("%10d %12.1f %12.1f %14.3f %14.3f %9.0fx", shapeNum, strMs, insertMs, linearUs, treeUs,
+               treeUs > 0 ? linearUs / treeUs : 0.0);
+        printf(mismatchNum == 0 ? "\n" : " (%d mismatches)\n", mismatchNum);
+        isAllMatched = isAllMatched && mismatchNum == 0;
+        (void)linearHits;
+        (void)treeHits;
+
+        destroyRTree(tree);
+        destroyLinkedList(&list, destroyRule);
+        free(queries);
+    }
+    return isAllMatched ? 0 : 1;
+}
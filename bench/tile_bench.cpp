@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+
+#include "linkedlist.h"
+#include "datatypes.h"
+#include "framebuffer.h"
+#include "tilerender.h"
+#include "bench.h"
+
+// Compares the tiled parallel redraw with the sequential fbRedrawAll() for growing thread counts.
+// Wall clock time is measured, since CPU time adds up over threads.
+// The largest thread count is the number of hardware threads but at least BENCH_MIN_THREADS, or the first argument.
+// Threads past the hardware ones only check that tiles split between them still give the same pixels.
+// Exits with 1 if any thread count gives different pixels.
+// Build: g++ -O2 -std=c++11 -pthread -Iinclude bench/tile_bench.cpp src/datatypes.cpp src/distance.cpp
+//        src/framebuffer.cpp src/generate.cpp src/linkedlist.cpp src/misc.cpp src/pool.cpp src/render.cpp
+//        src/hittest.cpp src/ptrmap.cpp src/rtree.cpp src/shapestore.cpp src/threadpool.cpp src/tilerender.cpp
+
+#define BENCH_WIDTH 2560
+#define BENCH_HEIGHT 1600
+#define BENCH_SHAPE_SIZE 120
+#define BENCH_SHAPES 200000
+#define BENCH_FRAME_NUM 5
+// Thread counts tried even on fewer hardware threads, since races between tiles may only show with several
+#define BENCH_MIN_THREADS 8
+// One shape in this many is up to ten times as large
+#define BENCH_LARGE_SHARE 100
+
+// Some shapes stick out of the framebuffer, a few are large
+static bool makeDrawing(struct LinkedList *list) {
+    struct GenerateOptions options, largeOptions;
+    initBenchOptions(&options, BENCH_SHAPES - BENCH_SHAPES / BENCH_LARGE_SHARE, BENCH_WIDTH, BENCH_HEIGHT, BENCH_SHAPE_SIZE);
+    initBenchOptions(&largeOptions, BENCH_SHAPES / BENCH_LARGE_SHARE, BENCH_WIDTH, BENCH_HEIGHT, BENCH_SHAPE_SIZE * 10);
+    largeOptions.minSize = BENCH_SHAPE_SIZE;
+    largeOptions.seed++;
+    return generateDrawing(list, &options) == options.shapeNum && generateDrawing(list, &largeOptions) == largeOptions.shapeNum;
+}
+
+int main(int argc, char *argv[]) {
+    struct FrameBuffer *reference = makeFrameBuffer(BENCH_WIDTH, BENCH_HEIGHT);
+    struct FrameBuffer *fb = makeFrameBuffer(BENCH_WIDTH, BENCH_HEIGHT);
+    if (reference == NULL || fb == NULL) {
+        return 1;
+    }
+    fb -> bgColor = reference -> bgColor = 0x202020;
+
+    struct LinkedList list;
+    initLinkedList(&list);
+    if (!makeDrawing(&list)) {
+        return 1;
+    }
+
+    double start = getNowMs();
+    for (int frame = 0; frame < BENCH_FRAME_NUM; frame++) {
+        fbRedrawAll(reference, &list);
+    }
+    double sequentialMs = (getNowMs() - start) / BENCH_FRAME_NUM;
+
+    printf("%d shapes on %dx%d, %d hardware threads\n", BENCH_SHAPES, BENCH_WIDTH, BENCH_HEIGHT, (int)std::thread::hardware_concurrency());
+    printf("%10s %12s %10s %10s\n", "threads", "ms/frame", "speedup", "pixels");
+    printf("%10s %12.2f %9.1fx %10s\n", "sequential", sequentialMs, 1.0, "-");
+
+    bool isAllMatched = true;
+    int maxThreadNum = argc > 1 ? atoi(argv[1]) : max((int)std::thread::hardware_concurrency(), BENCH_MIN_THREADS);
+    maxThreadNum = max(maxThreadNum, 1);
+    for (int threadNum = 1; ; threadNum = min(threadNum * 2, maxThreadNum)) {
+        struct TileRenderer *renderer = makeTileRenderer(threadNum);
+        if (renderer == NULL) {
+            return 1;
+        }
+        memset(fb -> pixels, 0xFF, sizeof(unsigned int) * BENCH_WIDTH * BENCH_HEIGHT);
+
+        start = getNowMs();
+        for (int frame = 0; frame < BENCH_FRAME_NUM; frame++) {
+            fbRedrawAllTiled(renderer, fb, &list);
+        }
+        double tiledMs = (getNowMs() - start) / BENCH_FRAME_NUM;
+
+        bool isMatched = memcmp(fb -> pixels, reference -> pixels, sizeof(unsigned int) * BENCH_WIDTH * BENCH_HEIGHT) == 0;
+        isAllMatched = isAllMatched && isMatched;
+        printf("%10d %12.2f %9.1fx %10s\n", threadNum, tiledMs, tiledMs > 0 ? sequentialMs / tiledMs : 0.0,
+               isMatched ? "same" : "DIFFER");
+
+        destroyTileRenderer(renderer);
+        if (threadNum == maxThreadNum) {
+            break;
+        }
+    }
+
+    destroyLinkedList(&list, destroyRule);
+    destroyFrameBuffer(reference);
+    destroyFrameBuffer(fb);
+    return isAllMatched ? 0 : 1;
+}
@@ -0,0 +1,227 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "linkedlist.h"
+#include "datatypes.h"
+#include "rtree.h"
+#include "shapestore.h"
+#include "journal.h"
+#include "undo.h"
+#include "bench.h"
+
+// Runs random changes on drawings of growing size, with an R-tree, a ShapeStore and an undo history attached,
+// interleaving undos and redos, then measures undoing and redoing all of them, and clearing the drawing.
+// Latencies should stay flat as the drawing grows. After each undo or redo pass the list must match what it
+// was, the ShapeStore must follow its order, and the journal of the smallest drawing must recover it.
+// Exits with 1 on any mismatch.
+// Build: g++ -O2 -std=c++11 -pthread -Iinclude bench/undo_bench.cpp src/datatypes.cpp src/distance.cpp src/generate.cpp
+//        src/hittest.cpp src/journal.cpp src/linkedlist.cpp src/misc.cpp src/pool.cpp src/ptrmap.cpp src/ringbuffer.cpp
+//        src/rtree.cpp src/shapestore.cpp src/undo.cpp
+
+#define BENCH_PATH "undo_bench.journal"
+#define BENCH_OPERATIONS 4000
+// Every this many changes, a few are undone and fewer redone
+#define BENCH_BURST_PERIOD 50
+#define BENCH_WIDTH 1280
+#define BENCH_HEIGHT 960
+#define BENCH_SHAPE_SIZE 80
+
+static void hashBytes(unsigned long long int *hash, const void *bytes, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        *hash ^= ((const unsigned char *)bytes)[i];
+        *hash *= 1099511628211ull;
+    }
+}
+
+// Hash shapes and ranks in list order
+static unsigned long long int hashList(const struct LinkedList *list) {
+    unsigned long long int hash = 14695981039346656037ull;
+    for (const struct LinkedNode *cntNode = list -> head; cntNode != NULL; cntNode = cntNode -> next) {
+        hashBytes(&hash, &cntNode -> data -> type, sizeof(int));
+        hashBytes(&hash, &cntNode -> box, sizeof(struct BoundingBox));
+        hashBytes(&hash, &cntNode -> rank, sizeof(long long int));
+        if (cntNode -> data -> type == DATATYPE_TEXT) {
+            const struct Text *txt = (const struct Text *)cntNode -> data -> content;
+            hashBytes(&hash, txt -> content, strlen(txt -> content));
+        }
+    }
+    return hash;
+}
+
+// Hash shapes alone, which is what a journal keeps
+static unsigned long long int hashShapes(const struct LinkedList *list) {
+    unsigned long long int hash = 14695981039346656037ull;
+    for (const struct LinkedNode *cntNode = list -> head; cntNode != NULL; cntNode = cntNode -> next) {
+        hashBytes(&hash, &cntNode -> data -> type, sizeof(int));
+        hashBytes(&hash, &cntNode -> box, sizeof(struct BoundingBox));
+    }
+    return hash;
+}
+
+// Check that the store holds the nodes of the list in the same order
+static bool isStoreInOrder(const struct ShapeStore *store, const struct LinkedList *list) {
+    if (store -> liveNum != list -> listSize) {
+        return false;
+    }
+    const struct LinkedNode *cntNode = list -> head;
+    for (int i = store -> orderBegin; i < store -> orderEnd; i++) {
+        int slot = store -> order[i];
+        if (slot == SHAPESTORE_HOLE) {
+            continue;
+        }
+        if (cntNode == NULL || store -> node[slot] != cntNode) {
+            return false;
+        }
+        cntNode = cntNode -> next;
+    }
+    return cntNode == NULL;
+}
+
+// Live nodes, so that changes can pick one at random
+struct NodeArray {
+    int size, capacity;
+    struct LinkedNode **nodes;
+};
+
+static void pushNode(struct NodeArray *array, struct LinkedNode *node) {
+    if (array -> size == array -> capacity) {
+        array -> capacity = array -> capacity == 0 ? 1024 : array -> capacity * 2;
+        array -> nodes = (struct LinkedNode **)realloc(array -> nodes, array -> capacity * sizeof(struct LinkedNode *));
+    }
+    array -> nodes[array -> size++] = node;
+}
+
+static void collectNodes(struct NodeArray *array, const struct LinkedList *list) {
+    if (array -> capacity < list -> listSize) {
+        array -> capacity = list -> listSize * 2;
+        array -> nodes = (struct LinkedNode **)realloc(array -> nodes, array -> capacity * sizeof(struct LinkedNode *));
+    }
+    array -> size = 0;
+    for (struct LinkedNode *cntNode = list -> head; cntNode != NULL; cntNode = cntNode -> next) {
+        pushNode(array, cntNode);
+    }
+}
+
+static void changeList(struct LinkedList *list, struct NodeArray *array, const struct GenerateOptions *options) {
+    int choice = array -> size < 2 ? 0 : nextRandom(100);
+    int pick = array -> size == 0 ? 0 : nextRandom(array -> size);
+    if (choice < 30) {
+        struct NodeData *data = makeRandomData(options);
+        pushNode(array, nextRandom(2) == 0 ? addNodeAtHead(list, data) : addNodeAtTail(list, data));
+    } else if (choice < 60) {
+        editNode(list, array -> nodes[pick], makeRandomData(options), destroyRule);
+    } else if (choice < 80) {
+        if (nextRandom(2) == 0) {
+            moveToHead(list, array -> nodes[pick]);
+        } else {
+            moveToTail(list, array -> nodes[pick]);
+        }
+    } else {
+        deleteNode(list, array -> nodes[pick], destroyRule);
+        array -> nodes[pick] = array -> nodes[--array -> size];
+    }
+}
+
+static bool runSize(int shapeNum, bool isJournaled) {
+    struct GenerateOptions options;
+    initBenchOptions(&options, shapeNum, BENCH_WIDTH, BENCH_HEIGHT, BENCH_SHAPE_SIZE);
+    struct LinkedList list;
+    initLinkedList(&list);
+    if (generateDrawing(&list, &options) != shapeNum) {
+        return false;
+    }
+    // Indexes as the editor attaches them
+    struct ShapeStore *store = makeShapeStore();
+    buildShapeStore(store, &list);
+    attachIndex(&list, &store -> index);
+    struct RTree *tree = makeRTree();
+    buildRTree(tree, &list);
+    attachIndex(&list, &tree -> index);
+    store -> tree = tree;
+    struct Journal *journal = isJournaled ? openJournal(&list, BENCH_PATH) : NULL;
+    struct UndoHistory *history = makeUndoHistory(&list, destroyRule);
+
+    unsigned long long int firstHash = hashList(&list);
+    struct NodeArray array = {0, 0, NULL};
+    collectNodes(&array, &list);
+    for (int i = 0; i < BENCH_OPERATIONS; i++) {
+        changeList(&list, &array, &options);
+        if (i % BENCH_BURST_PERIOD == BENCH_BURST_PERIOD / 2) {
+            for (int j = 0; j < 3; j++) {
+                undoChange(history, &list);
+            }
+            redoChange(history, &list);
+            // Undo and redo may have brought nodes back or taken them away
+            collectNodes(&array, &list);
+        }
+    }
+    unsigned long long int lastHash = hashList(&list);
+    struct UndoStatus status;
+    getUndoStatus(history, &status);
+    int stepNum = status.undoNum;
+
+    double start = getNowMs();
+    while (undoChange(history, &list)) {
+    }
+    double undoMs = getNowMs() - start;
+    bool isPassed = hashList(&list) == firstHash && isStoreInOrder(store, &list);
+
+    start = getNowMs();
+    while (redoChange(history, &list)) {
+    }
+    double redoMs = getNowMs() - start;
+    isPassed = isPassed && hashList(&list) == lastHash && isStoreInOrder(store, &list);
+
+    start = getNowMs();
+    destroyLinkedList(&list, destroyRule);
+    double clearMs = getNowMs() - start;
+    start = getNowMs();
+    undoChange(history, &list);
+    double undoClearMs = getNowMs() - start;
+    isPassed = isPassed && hashList(&list) == lastHash && isStoreInOrder(store, &list);
+    start = getNowMs();
+    redoChange(history, &list);
+    double redoClearMs = getNowMs() - start;
+    isPassed = isPassed && list.listSize == 0 && store -> liveNum == 0;
+    undoChange(history, &list);
+    isPassed = isPassed && hashList(&list) == lastHash && isStoreInOrder(store, &list);
+    getUndoStatus(history, &status);
+
+    printf("%8d shapes: %d steps undone in %.2f us each, redone in %.2f us each; "
+           "clear %.2f ms, undone %.2f ms, redone %.2f ms; %d steps hold %.1f MB, largest %.1f MB\n",
+           shapeNum, stepNum, undoMs * 1000 / stepNum, redoMs * 1000 / stepNum, clearMs, undoClearMs, redoClearMs,
+           status.undoNum + status.redoNum, status.memorySize / 1048576.0, status.maxStepSize / 1048576.0);
+
+    if (journal != NULL) {
+        isPassed = closeJournal(journal, &list) && isPassed;
+        struct LinkedList recovered;
+        initLinkedList(&recovered);
+        isPassed = recoverJournal(&recovered, BENCH_PATH, NULL) && hashShapes(&recovered) == hashShapes(&list) && isPassed;
+        destroyLinkedList(&recovered, destroyRule);
+        remove(BENCH_PATH);
+    }
+    if (!isPassed) {
+        printf("%d shapes: undo or redo gave a different list\n", shapeNum);
+    }
+
+    destroyUndoHistory(history, &list);
+    destroyLinkedList(&list, destroyRule);
+    detachIndex(&list, &store -> index);
+    destroyShapeStore(store);
+    detachIndex(&list, &tree -> index);
+    destroyRTree(tree);
+    free(array.nodes);
+    return isPassed;
+}
+
+int main() {
+    bool isPassed = true;
+    int sizes[] = {1000, 10000, 100000, 1000000};
+    for (int i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++) {
+        isPassed = runSize(sizes[i], i == 0) && isPassed;
+    }
+    printf(isPassed ? "all checks passed\n" : "checks FAILED\n");
+    return isPassed ? 0 : 1;
+}
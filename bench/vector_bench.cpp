@@ -0,0 +1,214 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "linkedlist.h"
+#include "datatypes.h"
+#include "shapestore.h"
+#include "vectorexport.h"
+#include "bench.h"
+
+// Measures SVG and PDF export throughput on a large drawing, then checks the files:
+// one SVG element per shape, PDF cross-references and stream length pointing where they should,
+// and the same bytes whether shapes come from the list or from an attached ShapeStore.
+// The shape count defaults to 1000000, the first argument overrides it.
+// Exits with 1 if anything differs.
+// Build: g++ -O2 -std=c++11 -Iinclude bench/vector_bench.cpp src/datatypes.cpp src/distance.cpp src/generate.cpp
+//        src/hittest.cpp src/linkedlist.cpp src/misc.cpp src/pool.cpp src/ptrmap.cpp src/render.cpp
+//        src/rtree.cpp src/shapestore.cpp src/textwriter.cpp src/vectorexport.cpp
+
+#define BENCH_SVG_PATH "vector_bench.svg"
+#define BENCH_PDF_PATH "vector_bench.pdf"
+#define BENCH_STORE_SVG_PATH "vector_bench_store.svg"
+#define BENCH_STORE_PDF_PATH "vector_bench_store.pdf"
+#define BENCH_SHAPES 1000000
+#define BENCH_WIDTH 1280
+#define BENCH_HEIGHT 960
+#define BENCH_SHAPE_SIZE 80
+#define BENCH_COLOR 0xFFFFFF
+#define BENCH_BG_COLOR 0x000000
+
+// Texts draw from every character the formats have to escape
+static void escapeTexts(struct LinkedList *list) {
+    static const char textChars[] = "abcxyz <>&()\\\"'";
+    for (struct LinkedNode *cntNode = list -> head; cntNode != NULL; cntNode = cntNode -> next) {
+        if (cntNode -> data -> type == DATATYPE_TEXT) {
+            for (char *cnt = ((struct Text *)cntNode -> data -> content) -> content; *cnt != '\0'; cnt++) {
+                *cnt = textChars[nextRandom(sizeof(textChars) - 1)];
+            }
+        }
+    }
+}
+
+// Read a whole file, NUL terminated
+// Returns its content to be freed, or NULL on error
+static char * readWholeFile(const char *path, long *size) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    *size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *content = (char *)malloc(*size + 1);
+    if (content == NULL || fread(content, 1, *size, file) != (size_t)*size) {
+        free(content);
+        fclose(file);
+        return NULL;
+    }
+    content[*size] = '\0';
+    fclose(file);
+    return content;
+}
+
+static bool isSameFile(const char *path, const char *otherPath) {
+    long size = 0, otherSize = 0;
+    char *content = readWholeFile(path, &size);
+    char *otherContent = readWholeFile(otherPath, &otherSize);
+    bool isSame = content != NULL && otherContent != NULL && size == otherSize && memcmp(content, otherContent, size) == 0;
+    free(content);
+    free(otherContent);
+    return isSame;
+}
+
+// Every shape is one element on its own line, besides the background rectangle
+static bool checkSvg(const char *path, int shapeNum) {
+    static const char *elements[] = {"<line ", "<rect ", "<circle ", "<ellipse ", "<text "};
+    long size = 0;
+    char *content = readWholeFile(path, &size);
+    if (content == NULL) {
+        return false;
+    }
+    int elementNum = 0;
+    for (char *line = content; line != NULL && *line != '\0'; line = strchr(line, '\n'), line = line == NULL ? NULL : line + 1) {
+        for (int i = 0; i < 5; i++) {
+            if (strncmp(line, elements[i], strlen(elements[i])) == 0) {
+                elementNum++;
+                break;
+            }
+        }
+    }
+    const char *ending = "</g>\n</svg>\n";
+    bool isPassed = elementNum == shapeNum + 1 && size > (long)strlen(ending) && strcmp(content + size - strlen(ending), ending) == 0;
+    if (!isPassed) {
+        printf("svg: %d elements for %d shapes\n", elementNum, shapeNum);
+    }
+    free(content);
+    return isPassed;
+}
+
+// Cross-reference offsets must land on their objects, and the stream length on its end
+static bool checkPdf(const char *path) {
+    long size = 0;
+    char *content = readWholeFile(path, &size);
+    if (content == NULL) {
+        return false;
+    }
+    bool isPassed = strncmp(content, "%PDF-1.4\n", 9) == 0;
+    const char *startXref = strstr(content + size - 64, "startxref\n");
+    long xrefOffset = startXref == NULL ? -1 : atol(startXref + 10);
+    isPassed = isPassed && xrefOffset > 0 && xrefOffset < size && strncmp(content + xrefOffset, "xref\n0 7\n", 9) == 0;
+
+    long objectOffsets[7] = {0};
+    for (int i = 1; isPassed && i < 7; i++) {
+        const char *entry = content + xrefOffset + 9 + 20 * i;
+        char expected[16];
+        snprintf(expected, sizeof(expected), "%d 0 obj\n", i);
+        objectOffsets[i] = atol(entry);
+        isPassed = strncmp(entry + 10, " 00000 n \n", 10) == 0 && objectOffsets[i] < size &&
+                   strncmp(content + objectOffsets[i], expected, strlen(expected)) == 0;
+    }
+    if (isPassed) {
+        const char *streamBegin = strstr(content + objectOffsets[5], "stream\n") + 7;
+        long streamLength = atol(content + objectOffsets[6] + 8);
+        isPassed = streamBegin - content + streamLength < size &&
+                   strncmp(streamBegin + streamLength, "\nendstream\n", 11) == 0;
+    }
+    if (!isPassed) {
+        printf("pdf: structure broken\n");
+    }
+    free(content);
+    return isPassed;
+}
+
+static long getFileSize(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+int main(int argc, char *argv[]) {
+    int shapeNum = argc > 1 ? atoi(argv[1]) : BENCH_SHAPES;
+    struct GenerateOptions options;
+    initBenchOptions(&options, shapeNum, BENCH_WIDTH, BENCH_HEIGHT, BENCH_SHAPE_SIZE);
+    struct LinkedList list;
+    initLinkedList(&list);
+    if (generateDrawing(&list, &options) != shapeNum) {
+        return 1;
+    }
+    escapeTexts(&list);
+
+    double start = getNowMs();
+    if (!exportSvg(&list, BENCH_SVG_PATH, BENCH_WIDTH, BENCH_HEIGHT, BENCH_COLOR, BENCH_BG_COLOR)) {
+        return 1;
+    }
+    double svgMs = getNowMs() - start;
+    start = getNowMs();
+    if (!exportPdf(&list, BENCH_PDF_PATH, BENCH_WIDTH, BENCH_HEIGHT, BENCH_COLOR, BENCH_BG_COLOR)) {
+        return 1;
+    }
+    double pdfMs = getNowMs() - start;
+
+    // The same drawing streamed over the flat store, as redrawAll() does
+    struct ShapeStore *store = makeShapeStore();
+    if (store == NULL || !buildShapeStore(store, &list)) {
+        return 1;
+    }
+    attachIndex(&list, &store -> index);
+    start = getNowMs();
+    if (!exportSvg(&list, BENCH_STORE_SVG_PATH, BENCH_WIDTH, BENCH_HEIGHT, BENCH_COLOR, BENCH_BG_COLOR)) {
+        return 1;
+    }
+    double storeSvgMs = getNowMs() - start;
+    start = getNowMs();
+    if (!exportPdf(&list, BENCH_STORE_PDF_PATH, BENCH_WIDTH, BENCH_HEIGHT, BENCH_COLOR, BENCH_BG_COLOR)) {
+        return 1;
+    }
+    double storePdfMs = getNowMs() - start;
+
+    double svgMb = getFileSize(BENCH_SVG_PATH) / 1048576.0, pdfMb = getFileSize(BENCH_PDF_PATH) / 1048576.0;
+    printf("%d shapes\n", shapeNum);
+    printf("%16s %10s %12s %10s %14s\n", "format", "MB", "ms", "MB/s", "Mshapes/s");
+    printf("%16s %10.1f %12.1f %10.1f %14.2f\n", "svg from list", svgMb, svgMs, svgMb / svgMs * 1000, shapeNum / svgMs / 1000);
+    printf("%16s %10.1f %12.1f %10.1f %14.2f\n", "svg from store", svgMb, storeSvgMs, svgMb / storeSvgMs * 1000, shapeNum / storeSvgMs / 1000);
+    printf("%16s %10.1f %12.1f %10.1f %14.2f\n", "pdf from list", pdfMb, pdfMs, pdfMb / pdfMs * 1000, shapeNum / pdfMs / 1000);
+    printf("%16s %10.1f %12.1f %10.1f %14.2f\n", "pdf from store", pdfMb, storePdfMs, pdfMb / storePdfMs * 1000, shapeNum / storePdfMs / 1000);
+
+    bool isPassed = checkSvg(BENCH_SVG_PATH, shapeNum) && checkPdf(BENCH_PDF_PATH);
+    if (!isSameFile(BENCH_SVG_PATH, BENCH_STORE_SVG_PATH) || !isSameFile(BENCH_PDF_PATH, BENCH_STORE_PDF_PATH)) {
+        printf("store and list exports differ\n");
+        isPassed = false;
+    }
+    if (getVectorFormat("a.SVG") != VECTOR_FORMAT_SVG || getVectorFormat("dir.pdf/a.Pdf") != VECTOR_FORMAT_PDF ||
+        getVectorFormat("a.svgz") != VECTOR_FORMAT_NONE || getVectorFormat("pdf") != VECTOR_FORMAT_NONE) {
+        printf("format detection wrong\n");
+        isPassed = false;
+    }
+    remove(BENCH_SVG_PATH);
+    remove(BENCH_PDF_PATH);
+    remove(BENCH_STORE_SVG_PATH);
+    remove(BENCH_STORE_PDF_PATH);
+
+    detachIndex(&list, &store -> index);
+    destroyShapeStore(store);
+    destroyLinkedList(&list, destroyRule);
+
+    printf(isPassed ? "all checks passed\n" : "checks FAILED\n");
+    return isPassed ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include "misc.h"
+
+// Bump-pointer arena for scratch objects that all die together, at the end of an interaction or a frame.
+// Allocating only moves a pointer, nothing is freed one by one, resetArena() takes everything back at once.
+// Blocks are kept across resets, so a loop resetting its arena stops asking the system for memory
+// once the first blocks cover what one round needs.
+// Arenas are not thread-safe.
+
+#define ARENA_BLOCK_SIZE 4096
+// Every allocation is aligned for any scalar type
+#define ARENA_ALIGNMENT 16
+
+#define ARENA_INITIALIZER(arenaName, blockSize) \
+    { arenaName, blockSize, NULL, NULL, NULL, 0, NULL, false, NULL, 0, 0, 0, 0, 0, 0 }
+
+struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t size;
+};
+
+struct Arena {
+    const char *name;
+    size_t blockSize;
+
+    struct ArenaBlock *blocks;
+    // Block allocations are bumped from, NULL right after a reset
+    struct ArenaBlock *cntBlock;
+    char *bumpPtr;
+    size_t bumpLeft;
+    // Latest allocation, the only one that can grow in place
+    void *lastPtr;
+
+    // Registration in the list of all arenas
+    bool isRegistered;
+    struct Arena *nextArena;
+
+    // Counters
+    size_t usedBytes, peakBytes;
+    long long int allocNum, resetNum;
+    // Blocks taken from the system, and their bytes
+    long long int blockNum;
+    size_t reservedBytes;
+};
+
+struct ArenaStats {
+    long long int allocNum, resetNum, blockNum;
+    // Bytes handed out since the last reset, at most between two resets, and reserved from the system
+    size_t usedBytes, peakBytes, reservedBytes;
+};
+
+// Get size bytes from the arena, valid until it is reset
+// Returns their pointer, or NULL with errno set if out of memory
+void * arenaAlloc(struct Arena *arena, size_t size);
+
+// Grow ptr, allocated from the arena with oldSize bytes, to newSize bytes
+// The latest allocation grows in place when its block has room, others are copied
+// Returns the new pointer, or NULL with errno set if out of memory, ptr then stays valid
+void * arenaRealloc(struct Arena *arena, void *ptr, size_t oldSize, size_t newSize);
+
+// Take back everything allocated from the arena, keeping its blocks for what comes next
+// Returns nothing
+void resetArena(struct Arena *arena);
+
+// Release every block of the arena, all of its allocations become invalid
+// Returns nothing
+void destroyArena(struct Arena *arena);
+
+// Read the counters of an arena
+// Returns nothing
+void getArenaStats(const struct Arena *arena, struct ArenaStats *stats);
+
+// Print counters of every arena used so far
+// Returns nothing
+void printArenaStats(FILE *fp);
+
+#endif
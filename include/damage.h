@@ -0,0 +1,64 @@
+#ifndef DAMAGE_H_
+#define DAMAGE_H_
+
+#include "misc.h"
+#include "linkedlist.h"
+#include "arena.h"
+
+// Damage tracking for incremental redraws.
+// Boxes touched since the last frame are collected into a few rectangles,
+// then only the shapes crossing them are repainted, clipped to each rectangle.
+// Shapes are assumed to stay within their bounding box plus DAMAGE_MARGIN pixels.
+
+#define DAMAGE_MAX_RECTS 8
+#define DAMAGE_MARGIN 2
+// Block size for an arena serving repaints, room for the node arrays of a dense frame
+#define DAMAGE_SCRATCH_BLOCK_SIZE (16 * ARENA_BLOCK_SIZE)
+
+struct Damage {
+    int rectNum;
+    struct BoundingBox rects[DAMAGE_MAX_RECTS];
+};
+
+// Drawing callbacks used to repaint damage, so that the same code runs on screen and headless
+struct DamagePainter {
+    void *impl;
+
+    // Restrict drawing to rect, or lift the restriction when rect is NULL
+    void (*clipFunc)(void *impl, const struct BoundingBox *rect);
+    // Fill rect with the background
+    void (*clearFunc)(void *impl, const struct BoundingBox *rect);
+    // Draw a committed shape, NULL when clearFunc already restores the shapes
+    void (*drawFunc)(void *impl, const struct NodeData *data);
+    // Draw what lies above the committed shapes, optional
+    void (*overlayFunc)(void *impl);
+    // Where a repaint takes its node arrays from, the heap when NULL; the caller resets it between repaints
+    struct Arena *scratch;
+};
+
+// Initialize an empty damage
+// Returns nothing
+void initDamage(struct Damage *damage);
+
+// Mark a box and its margin as damaged
+// Returns nothing
+void addDamage(struct Damage *damage, const struct BoundingBox *box);
+
+// Drop the parts of the damage outside bounds
+// Returns nothing
+void clipDamage(struct Damage *damage, const struct BoundingBox *bounds);
+
+// Check whether a box crosses the damage
+// Returns true if it does
+bool isDamaged(const struct Damage *damage, const struct BoundingBox *box);
+
+// Collect nodes whose extent crosses box, in list order
+// Uses an attached RTree when there is one
+// Returns a malloc'd array the caller frees, or NULL if there is none or out of memory
+struct LinkedNode ** getNodesInBox(const struct LinkedList *list, const struct BoundingBox *box, int *nodeNum);
+
+// Repaint every damaged rectangle
+// Returns nothing
+void repaintDamage(const struct LinkedList *list, const struct Damage *damage, const struct DamagePainter *painter);
+
+#endif
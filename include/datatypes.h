@@ -34,6 +34,12 @@
 
 bool validateDataType(int dataType);
 
+// Hit rules on plain coordinates, shared by the find*Rule functions and columnar stores
+bool isNearSegment(int x, int y, int leftx, int lefty, int rightx, int righty);
+bool isNearRectangle(int x, int y, int minx, int miny, int maxx, int maxy);
+bool isNearCircle(int x, int y, int centerx, int centery, int radius);
+bool isNearEllipse(int x, int y, int centerx, int centery, int majorSemiAxis, int minorSemiAxis);
+
 struct Vertex {
     int x, y;
 };
@@ -76,11 +82,24 @@ struct Text {
     int fontWidth, fontHeight;
     char *content;
 };
-struct Text * makeText(struct Rectangle *newPosition, char *newContent, int newFontWidth, int newFontHeight);
+// The first DATATYPE_TEXT_MAX_LENGTH characters of newContent are copied, it stays the caller's
+struct Text * makeText(struct Rectangle *newPosition, const char *newContent, int newFontWidth, int newFontHeight);
 bool findTextRule(const struct Vertex *cursorPt, const struct Text *txt);
 void destroyText(struct Text *txt);
 
 void destroyRule(struct NodeData *data);
 bool findRule(const void *vCursorPt, const struct LinkedNode *node);
 
+// Destroy the shape held by data, leaving data itself to the caller
+// Returns nothing
+void destroyContentRule(struct NodeData *data);
+
+// Check whether the point is on the shape held by data, as findRule() does for a node
+// Returns true if it is
+bool findDataRule(const void *vCursorPt, const struct NodeData *data);
+
+// Get the extent of the shape stored in data
+// Returns nothing
+void getDataBoundingBox(const struct NodeData *data, struct BoundingBox *box);
+
 #endif
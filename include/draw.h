@@ -5,35 +5,77 @@
 
 #include "linkedlist.h"
 #include "datatypes.h"
+#include "damage.h"
+#include "render.h"
+#include "input.h"
+#include "tilerender.h"
+#include "tracking.h"
 
 #define SHAPE_DEFAULT_COLOR WHITE
+// Tracking loops redraw at most this many times per second, 0 lifts the cap
+#define TRACKING_DEFAULT_FPS 60
+
+// Frames drawn by tracking loops, and how long they took to draw
+struct FrameStats {
+    int frameNum;
+    // Mouse moves taken as a later one instead of getting a frame of their own
+    long long int coalescedNum;
+    double lastMs, maxMs, totalMs;
+};
 
 extern LOGFONT defaultFont;
 
+/* Scratch */
+// Vertex living until the next resetScratch(), for the points and cursors of one interaction
+struct Vertex * makeScratchVertex(int x, int y);
+// Take back every scratch vertex at once, when a new interaction begins
+void resetScratch();
+
 /* Position */
 void getRealPosition(struct Vertex *cntPt);
+// Points found here and by tracking are scratch vertices
 void getStartEndPts(struct NodeData *data, struct Vertex **startPt, struct Vertex **endPt, int assistId = -1);
 struct Vertex * getTextEndPt(struct Vertex *startPt, char *text, LOGFONT *font);
+void getTextBoundingBox(struct Vertex *startPt, struct Vertex *endPt, char *text, LOGFONT *font, struct BoundingBox *box);
+
+/* Backend */
+void setDrawBackend(const struct RenderBackend *backend);
 
 /* Drawing */
-// Shape
+// Shapes and text are saved and edited through tracking.h
 void drawShape(struct Vertex *startPt, struct Vertex *endPt, int shapeType, color_t fgColor);
-struct LinkedNode *saveShape(struct LinkedList *list, struct Vertex *startPt, struct Vertex *endPt, int shapeType);
-void editShape(struct LinkedNode *node, struct Vertex *startPt, struct Vertex *endPt);
-
-// Text
 void drawText(struct Vertex *startPt, struct Vertex *endPt, char *text,
               LOGFONT *font, color_t textColor, color_t fillColor);
-struct LinkedNode *saveText(struct LinkedList *list, struct Vertex *startPt, struct Vertex *endPt, char *text, int fontWidth, int fontHeight);
-void editText(struct LinkedNode *node, struct Vertex *startPt, struct Vertex *endPt,
-              char *text = NULL, int fontWidth = -1, int fontHeight = -1);
 
 // Universal
 void fillBlock(int minx, int maxy, int maxx, int miny, int fillColor);
 void drawNodeData(struct NodeData *nodeData, color_t fgColor, bool isDraft);
 void redrawAll(struct LinkedList *list, color_t fgColor, bool isDraft);
+void redrawDamage(struct LinkedList *list, struct Damage *damage, color_t fgColor, bool isDraft, struct NodeData *overlayData);
+void releaseBackgroundLayer();
+// Rasterize the background layer on the threads of renderer from now on, NULL goes back to drawing it through EGE
+void setLayerRenderer(struct TileRenderer *renderer);
+struct RenderStats getRedrawStats();
+
+/* Input */
+// Collect mouse messages through an input queue from now on, consecutive moves are then taken as the latest one.
+// EGE is only called from the UI thread, which pumps the queue whenever it takes a message
+void startInputQueue();
+void stopInputQueue();
+// Take the next mouse message, waiting for it, like getmouse()
+mouse_msg nextMouseMsg();
+// Returns false if there is no input queue
+bool getMouseStats(struct InputStats *stats);
+// Record every mouse message read into an input log at path, before the input queue starts
+// Returns false if the log could not be created
+bool startInputRecording(const char *path);
+// Returns false if nothing was recorded or the log is incomplete
+bool stopInputRecording();
 
 /* Tracking */
+// Frames are drawn by tracking.h on the canvas, through the backend and the background layer
+void setTrackingFps(int fps);
+struct FrameStats getFrameStats();
 struct Vertex * trackEndPt(struct LinkedList *list, struct Vertex *startPt,
                         int shapeType, color_t newFgColor, color_t drawnFgColor);
 void trackEditPts(struct LinkedList *list, struct NodeData *data, int assistId,
@@ -0,0 +1,90 @@
+#ifndef DRAW_FILE_H_
+#define DRAW_FILE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "misc.h"
+#include "linkedlist.h"
+#include "datatypes.h"
+
+// Versioned binary drawing document, laid out so that it can be used in place once mapped.
+//
+// A file is a header, a section directory and 8-byte aligned sections:
+//   DRAWFILE_SECTION_TYPE .. DRAWFILE_SECTION_R1   one int32 column per ShapeStore column,
+//                                                  shapeNum entries, from bottom to top
+//   DRAWFILE_SECTION_TEXT                          one DrawFileText record per text, by slot
+//   DRAWFILE_SECTION_STRINGS                       NUL terminated text contents
+// Columns have the meaning described in shapestore.h, so a ShapeStore can point straight
+// into a mapping (see mapShapeStore()) instead of parsing records.
+// Numbers are stored in native byte order, files of the other order are rejected.
+
+#define DRAWFILE_MAGIC "CADETDRW"
+#define DRAWFILE_MAGIC_LENGTH 8
+#define DRAWFILE_VERSION 1
+#define DRAWFILE_BYTE_ORDER 0x01020304u
+#define DRAWFILE_ALIGN 8
+
+#define DRAWFILE_SECTION_TYPE 1
+#define DRAWFILE_SECTION_X0 2
+#define DRAWFILE_SECTION_Y0 3
+#define DRAWFILE_SECTION_X1 4
+#define DRAWFILE_SECTION_Y1 5
+#define DRAWFILE_SECTION_R0 6
+#define DRAWFILE_SECTION_R1 7
+#define DRAWFILE_SECTION_TEXT 8
+#define DRAWFILE_SECTION_STRINGS 9
+#define DRAWFILE_SECTION_NUMBER 9
+
+struct DrawFileHeader {
+    char magic[DRAWFILE_MAGIC_LENGTH];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t shapeNum, textNum;
+    uint32_t sectionNum, reserved;
+    uint64_t fileSize;
+};
+
+struct DrawFileSection {
+    uint32_t kind;
+    uint32_t elemSize;
+    uint64_t offset, count;
+};
+
+struct DrawFileText {
+    int32_t slot;
+    int32_t fontWidth, fontHeight;
+    uint32_t contentOffset;
+};
+
+// Open drawing, every pointer refers into the mapping
+struct DrawFile {
+    // Pages are private and copy-on-write: writes through the columns never reach the file
+    void *base;
+    size_t size;
+
+    int shapeNum, textNum;
+    int *type;
+    int *x0, *y0, *x1, *y1;
+    int *r0, *r1;
+    const struct DrawFileText *texts;
+    const char *strings;
+};
+
+// Write every shape of the list into a drawing file, from head to tail
+// Returns false if the file cannot be written or out of memory
+bool saveDrawFile(const struct LinkedList *list, const char *path);
+
+// Map a drawing file and check its layout, nothing is copied
+// Returns its pointer, or NULL if the file cannot be mapped or is not a valid drawing
+struct DrawFile * openDrawFile(const char *path);
+
+// Unmap a drawing file, stores mapped from it must be destroyed first
+// Returns nothing
+void closeDrawFile(struct DrawFile *file);
+
+// Append every shape of a drawing at the tail of the list, each one rebuilt out of the columns
+// Returns false if out of memory, the shapes added so far stay in the list
+bool loadDrawFile(struct LinkedList *list, const struct DrawFile *file);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef DXF_H_
+#define DXF_H_
+
+#include "misc.h"
+#include "linkedlist.h"
+#include "datatypes.h"
+
+// Streaming DXF exchange, in bounded memory.
+// The reader walks the ENTITIES section once through a fixed buffer and hands shapes over in batches:
+//   LINE                          DATATYPE_SEGMENT
+//   LWPOLYLINE                    DATATYPE_RECTANGLE, when closed over four axis-aligned corners
+//   CIRCLE                        DATATYPE_CIRCLE
+//   ELLIPSE                       DATATYPE_ELLIPSE, when whole and axis-aligned
+//   TEXT, MTEXT                   DATATYPE_TEXT
+// Other entities, and those above that do not fit, are skipped and counted.
+// The writer emits the same entities, MTEXT aside.
+// DXF y goes up from the bottom of a page pageHeight high, while CADET y goes down from its top.
+
+#define DXF_BUFFER_SIZE 65536
+#define DXF_BATCH_SIZE 1024
+
+// Text has no font metrics here, glyphs are taken to be this many times as tall as wide
+#define DXF_TEXT_ASPECT 2
+
+// One shape read from a DXF file, with the column meaning of shapestore.h
+struct DxfShape {
+    int type;
+    int x0, y0, x1, y1;
+    int r0, r1;
+    int fontHeight;
+    char text[DATATYPE_TEXT_MAX_LENGTH];
+};
+
+// Entities turned into shapes, and entities left out
+struct DxfStats {
+    int readNum, skippedNum;
+};
+
+// Read the shapes of a DXF file, calling batchFunc with at most DXF_BATCH_SIZE of them at a time
+// stats is filled in unless it is NULL
+// Returns false if the file cannot be read, is malformed, or batchFunc returned false
+bool readDxf(const char *path, int pageHeight,
+             bool (*batchFunc)(void *arg, const struct DxfShape *shapes, int shapeNum), void *arg,
+             struct DxfStats *stats);
+
+// Append every shape of a DXF file at the tail of the list
+// Returns false on the same conditions as readDxf() or if out of memory, the shapes added so far stay in the list
+bool importDxf(struct LinkedList *list, const char *path, int pageHeight, struct DxfStats *stats);
+
+// Write every shape of the list into a DXF file, from head to tail
+// Returns false if the file cannot be written or out of memory
+bool exportDxf(const struct LinkedList *list, const char *path, int pageHeight);
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef FRAME_BUFFER_H_
+#define FRAME_BUFFER_H_
+
+#include "misc.h"
+#include "linkedlist.h"
+#include "damage.h"
+#include "render.h"
+
+// Headless 32-bit framebuffer, so that drawing can be checked without a screen.
+// Shapes are rasterized with integer algorithms and clipped pixel by pixel,
+// so a shape drawn through any clip rectangle gives the same pixels inside it.
+// Text has no glyphs here, its box is outlined instead.
+
+struct FrameBuffer {
+    int width, height;
+    unsigned int *pixels;
+    // Pixels outside clip are left untouched, bounds included
+    struct BoundingBox clip;
+    // Colors of shapes and background for fbRedrawAll() and the damage painter
+    unsigned int color, bgColor;
+    // Drawn above the shapes by the damage painter in overlayColor, may be NULL
+    const struct NodeData *overlayData;
+    unsigned int overlayColor;
+};
+
+// Create a framebuffer filled with black
+// Returns its pointer, or NULL if out of memory
+struct FrameBuffer * makeFrameBuffer(int width, int height);
+
+// Free a framebuffer
+// Returns nothing
+void destroyFrameBuffer(struct FrameBuffer *fb);
+
+// Restrict drawing to rect, or to the whole framebuffer when rect is NULL
+// Returns nothing
+void setFrameBufferClip(struct FrameBuffer *fb, const struct BoundingBox *rect);
+
+// Rasterize primitives, following EGE argument order
+// Returns nothing
+void fbPutPixel(struct FrameBuffer *fb, int x, int y, unsigned int color);
+void fbLine(struct FrameBuffer *fb, int x0, int y0, int x1, int y1, unsigned int color);
+void fbRectangle(struct FrameBuffer *fb, int left, int top, int right, int bottom, unsigned int color);
+void fbCircle(struct FrameBuffer *fb, int centerx, int centery, int radius, unsigned int color);
+void fbEllipse(struct FrameBuffer *fb, int centerx, int centery, int xRadius, int yRadius, unsigned int color);
+void fbFillRect(struct FrameBuffer *fb, int minx, int miny, int maxx, int maxy, unsigned int color);
+
+// Set up a backend rendering on fb
+// Returns nothing
+void initFrameBufferBackend(struct FrameBuffer *fb, struct RenderBackend *backend);
+
+// Clear the clip area with fb -> bgColor and draw every node of the list with fb -> color
+// Returns nothing
+void fbRedrawAll(struct FrameBuffer *fb, const struct LinkedList *list);
+
+// Write the pixels as a binary PPM image
+// Returns true on success
+bool saveFrameBufferPPM(const struct FrameBuffer *fb, const char *path);
+
+// Set up a painter repainting damage on fb
+// Returns nothing
+void initFrameBufferPainter(struct FrameBuffer *fb, struct DamagePainter *painter);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef GENERATE_H_
+#define GENERATE_H_
+
+#include "misc.h"
+#include "linkedlist.h"
+#include "datatypes.h"
+
+// Seeded generator of synthetic drawings, for scale and stress tests.
+// Shapes are built straight into the list in batches through addNodesAtTail(), nothing else is kept,
+// so generating costs about what the shapes then take. The same options always give the same drawing.
+
+// Where shapes are placed
+#define GENERATE_LAYOUT_UNIFORM 1
+// Around clusterNum centers, normally distributed with clusterSpread as standard deviation
+#define GENERATE_LAYOUT_CLUSTERS 2
+// On a grid of gridPitch, with axis-aligned segments, like parts laid out in a CAD sheet
+#define GENERATE_LAYOUT_GRID 3
+
+// How shape sizes spread between minSize and maxSize
+#define GENERATE_SIZE_UNIFORM 1
+// Log-uniform: each doubling of the size is as likely, so small shapes outnumber large ones
+#define GENERATE_SIZE_LOG 2
+
+// Shapes handed to addNodesAtTail() at once
+#define GENERATE_BATCH_SIZE 1024
+
+struct GenerateOptions {
+    unsigned int seed;
+    int shapeNum;
+    // Relative weights of segments, rectangles, circles, ellipses and texts, indexed by type - DATATYPE_SEGMENT
+    int typeWeights[DATATYPE_RANGE_MAX - DATATYPE_RANGE_MIN + 1];
+    int sizeMode, minSize, maxSize;
+    int layout;
+    // Shapes are centered within (originx, originy) and (originx + width, originy + height)
+    int originx, originy;
+    int width, height;
+    int clusterNum, clusterSpread;
+    int gridPitch;
+};
+
+// Fill options with a uniform mix of small shapes over a screen-sized drawing
+// Returns nothing
+void initGenerateOptions(struct GenerateOptions *options);
+
+// Append options -> shapeNum generated shapes at the tail of the list
+// Returns how many were added, fewer if out of memory
+int generateDrawing(struct LinkedList *list, const struct GenerateOptions *options);
+
+// Make one shape as generateDrawing() would with options, seed picking which, for edits on a generated drawing
+// Returns its data, or NULL if out of memory
+struct NodeData * generateShape(const struct GenerateOptions *options, unsigned int seed);
+
+#endif
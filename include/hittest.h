@@ -0,0 +1,48 @@
+#ifndef HIT_TEST_H_
+#define HIT_TEST_H_
+
+#include "misc.h"
+
+// Batch hit test of one point against many shapes kept in columns,
+// see ShapeStore for the meaning of each column per type.
+// Every kernel gives exactly the same answer as the find*Rule functions.
+// SIMD kernels work in 32-bit lanes with exact 64-bit products, blocks holding
+// a value beyond HITTEST_SIMD_LIMIT are handed to the scalar rules.
+
+#define HITTEST_KERNEL_AUTO -1
+#define HITTEST_KERNEL_SCALAR 0
+#define HITTEST_KERNEL_SSE41 1
+#define HITTEST_KERNEL_AVX2 2
+#define HITTEST_KERNEL_NUM 3
+
+// Bound of |coordinate| and |radius| for which no lane can overflow
+#define HITTEST_SIMD_LIMIT (1 << 13)
+
+struct HitColumns {
+    const int *type;
+    const int *x0, *y0, *x1, *y1;
+    const int *r0, *r1;
+};
+
+// Test the shape in given slot with the scalar rules
+// Returns true if the point is on it
+bool isColumnHit(const struct HitColumns *cols, int slot, int x, int y);
+
+// Find the topmost shape hit by the point, order lists slots from bottom to top
+// and negative entries are skipped
+// Returns its position in order, or -1 if there is none
+int findTopHit(const struct HitColumns *cols, const int *order, int begin, int end, int x, int y,
+               int kernel = HITTEST_KERNEL_AUTO);
+
+// Check whether the CPU can run a kernel
+// Returns true if it can
+bool isHitKernelSupported(int kernel);
+
+// Get the widest kernel the CPU can run
+// Returns one of HITTEST_KERNEL_*
+int getBestHitKernel();
+
+// Returns the name of a kernel
+const char * getHitKernelName(int kernel);
+
+#endif
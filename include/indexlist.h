@@ -0,0 +1,83 @@
+#ifndef INDEX_LIST_H_
+#define INDEX_LIST_H_
+
+#include "misc.h"
+#include "linkedlist.h"
+#include "datatypes.h"
+
+// Z-ordered list of shapes kept in flat arrays and linked by 32-bit slot numbers instead of pointers.
+// A node is a slot: its links sit in one array, its type and box in a hot array that walks and box tests
+// stream over, and the pointer to its shape in a cold array read only once the box matches.
+// No node or NodeData is allocated on its own, links cost 8 bytes a shape instead of 24.
+// Removed slots go to a free chain and are reused first, a slot keeps its number until it is removed,
+// even when the arrays grow. The list owns its shapes like LinkedList, but has no indexes nor ranks.
+// Walk it with
+//   for (int slot = list -> head; slot != INDEX_LIST_NONE; slot = list -> links[slot].next)
+
+#define INDEX_LIST_INIT_CAPACITY 64
+
+// No slot, at both ends of the list and of the free chain
+#define INDEX_LIST_NONE -1
+
+struct IndexLink {
+    int prev, next;
+};
+
+struct IndexHot {
+    int type;
+    // Extent of the shape, refreshed whenever it is set
+    struct BoundingBox box;
+};
+
+struct IndexList {
+    int listSize, capacity;
+    // Slots in use or on the free chain, and head of the free chain
+    int slotNum, freeSlot;
+    int head, tail;
+
+    // Indexed by slot, a free slot has DATATYPE_UNDEFINED as type and its next free slot as next
+    struct IndexLink *links;
+    struct IndexHot *hot;
+    // Shape of each slot, as NodeData -> content
+    void **cold;
+
+    // Bumped by every change of the nodes, as in LinkedList
+    unsigned int version;
+};
+
+// Initialize a blank list
+// Returns nothing
+void initIndexList(struct IndexList *list);
+
+// Destroy every shape of the list with destroyContentFunc, which may be NULL to leave them to the caller,
+// and free its arrays, leaving it blank
+// Returns nothing
+void destroyIndexList(struct IndexList *list, void (*destroyContentFunc)(struct NodeData *));
+
+// Add a new shape at head or at tail
+// Returns its slot, or INDEX_LIST_NONE if out of memory
+int addIndexNodeAtHead(struct IndexList *list, void *newContent, int newType);
+int addIndexNodeAtTail(struct IndexList *list, void *newContent, int newType);
+
+// Move a node to head or to tail
+// Returns nothing
+void moveIndexNodeToHead(struct IndexList *list, int slot);
+void moveIndexNodeToTail(struct IndexList *list, int slot);
+
+// Delete a node, destroying its shape with destroyContentFunc, which may be NULL
+// destroyContentFunc gets a NodeData made for the call, it must destroy the content only, as destroyContentRule() does
+// Returns nothing
+void deleteIndexNode(struct IndexList *list, int slot, void (*destroyContentFunc)(struct NodeData *));
+
+// Find a node using given function, searching from tail to head
+// When findBox is not NULL, only nodes whose box meets it are handed to checkFunc, the others are skipped
+// on their hot entry alone
+// Returns its slot, or INDEX_LIST_NONE if there is none
+int findIndexNode(const struct IndexList *list, const struct BoundingBox *findBox, const void *findData,
+                  bool (*checkFunc)(const void *, const struct NodeData *));
+
+// Read the type and shape of a node into data
+// Returns nothing
+void getIndexNodeData(const struct IndexList *list, int slot, struct NodeData *data);
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef INPUT_H_
+#define INPUT_H_
+
+#include "misc.h"
+
+// Input events collected so that a slow redraw answers them all at once instead of one by one.
+//
+// Fixed-size events are read from a source into a lock-free ring, either by a reader thread of their own
+// or pumped by the thread taking them each time it takes or looks for one, for sources such as EGE that
+// must not be called from another thread. The thread taking them runs the interaction and draws at its
+// own pace. Events it did not get to in time are coalesced as it takes them: of a run of coalescable events,
+// such as mouse moves, only the latest is taken, so one redraw answers them all. Other events are never
+// lost nor merged. When the ring is full, the reader drops a coalescable event and lets any other wait
+// for room, while pumping leaves events in the source until there is room.
+
+// Events the ring holds at most
+#define INPUT_RING_EVENTS 1024
+// How long either side sleeps when it finds nothing to do
+#define INPUT_IDLE_MS 1
+
+// Where the events come from
+struct InputSource {
+    void *impl;
+
+    // Take the next event into event if there is one, without waiting, only called on the reader thread
+    // or, without one, on the thread taking events
+    // Returns false if there was none
+    bool (*readFunc)(void *impl, void *event);
+    // Tell whether a later coalescable event makes this one useless, called on both threads
+    bool (*isCoalescableFunc)(void *impl, const void *event);
+    // Wait a moment for events while there is none, only called on the thread taking them when it pumps them,
+    // so that sources such as EGE keep their window alive meanwhile. NULL sleeps INPUT_IDLE_MS
+    void (*idleFunc)(void *impl);
+};
+
+// Counters of an input queue
+struct InputStats {
+    // Events waiting now, and the most ever found waiting when one was taken
+    int queuedNum, maxQueuedNum;
+    long long int readNum, takenNum, coalescedNum, droppedNum;
+};
+
+struct InputQueue;
+
+// Create a queue of events of eventSize bytes from source, read by a thread of its own if isThreaded,
+// or else pumped by the thread taking them
+// Returns its pointer, or NULL if out of memory
+struct InputQueue * makeInputQueue(const struct InputSource *source, int eventSize, bool isThreaded);
+
+// Stop the reader thread if any and free the queue, events still queued are lost
+// Returns nothing
+void destroyInputQueue(struct InputQueue *queue);
+
+// Take the next event into event, coalescing it with those following it, waiting until there is one
+// Returns nothing
+void takeInput(struct InputQueue *queue, void *event);
+
+// Check whether an event is waiting
+// Returns true if takeInput() would not wait
+bool hasInput(struct InputQueue *queue);
+
+// Read the counters of the queue, only from the thread taking events
+// Returns nothing
+void getInputStats(struct InputQueue *queue, struct InputStats *stats);
+
+#endif
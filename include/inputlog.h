@@ -0,0 +1,61 @@
+#ifndef INPUT_LOG_H_
+#define INPUT_LOG_H_
+
+#include <stdint.h>
+
+#include "misc.h"
+
+// Recording of the mouse messages of a session, so that it can be replayed without a window.
+//
+// A log file is an InputLogHeader followed by InputLogEvent records, in the order the messages were read,
+// each stamped with the milliseconds since recording started. Messages are stored free of EGE,
+// with kinds and flags of their own. Numbers are stored in native byte order, files of the other order are rejected.
+
+#define INPUT_LOG_MAGIC "CADETINP"
+#define INPUT_LOG_MAGIC_LENGTH 8
+#define INPUT_LOG_VERSION 1
+#define INPUT_LOG_BYTE_ORDER 0x01020304u
+
+#define INPUT_LOG_DOWN 1
+#define INPUT_LOG_UP 2
+#define INPUT_LOG_MOVE 3
+#define INPUT_LOG_WHEEL 4
+
+#define INPUT_LOG_LEFT 1
+#define INPUT_LOG_RIGHT 2
+#define INPUT_LOG_MID 4
+#define INPUT_LOG_SHIFT 8
+#define INPUT_LOG_CTRL 16
+
+struct InputLogHeader {
+    char magic[INPUT_LOG_MAGIC_LENGTH];
+    uint32_t version;
+    uint32_t byteOrder;
+};
+
+struct InputLogEvent {
+    uint32_t timeMs;
+    int16_t x, y;
+    int16_t wheel;
+    uint8_t kind, flags;
+};
+
+struct InputLog;
+
+// Create a log file, replacing any file at path
+// Returns its pointer, or NULL on failure
+struct InputLog * openInputLog(const char *path);
+
+// Append one message, buffered
+// Returns false on failure, the log then stays failed
+bool appendInputLog(struct InputLog *log, const struct InputLogEvent *event);
+
+// Flush and close the log
+// Returns false if anything could not be written
+bool closeInputLog(struct InputLog *log);
+
+// Read the messages of a log file, up to the first torn or damaged one
+// Returns a malloc'd array the caller frees, or NULL if the file is unreadable or holds no message
+struct InputLogEvent * loadInputLog(const char *path, int *eventNum);
+
+#endif
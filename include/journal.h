@@ -0,0 +1,119 @@
+#ifndef JOURNAL_H_
+#define JOURNAL_H_
+
+#include <stdint.h>
+
+#include "misc.h"
+#include "linkedlist.h"
+#include "datatypes.h"
+
+// Append-only journal of list changes, so that the work of a crashed session can be recovered.
+//
+// A journal file is a header followed by records, each a JournalRecordHeader and its payload,
+// which starts with one byte telling the operation:
+//   JOURNAL_OP_INSERT_HEAD, _TAIL    uint32 id, JournalShape, text content
+//   JOURNAL_OP_INSERT_AFTER          uint32 id, uint32 id of the shape before it, JournalShape, text content
+//   JOURNAL_OP_EDIT                  uint32 id, JournalShape, text content
+//   JOURNAL_OP_REMOVE                uint32 id
+//   JOURNAL_OP_MOVE_HEAD, _TAIL      uint32 id
+//   JOURNAL_OP_MOVE_AFTER            uint32 id, uint32 id of the shape before it
+//   JOURNAL_OP_CLEAR
+//   JOURNAL_OP_CHECKPOINT            uint32 number of shapes
+// A file always opens with a snapshot: every shape as a JOURNAL_OP_INSERT_TAIL record, from head to tail,
+// then a JOURNAL_OP_CHECKPOINT. Changes follow. A checkpoint rewrites the whole file as a fresh snapshot
+// and replaces the old one at once, so recovery loads the snapshot and replays only the tail after it.
+// Nodes are named by ids handed out on insert and never reused while the journal is open.
+// Records are checksummed, recovery stops at the first torn or damaged one.
+// Numbers are stored in native byte order, files of the other order are rejected.
+//
+// The hooks run on the thread changing the list and only encode records into a lock-free ring.
+// A background thread writes them out, flushes them to disk once per batch,
+// and keeps its own flat copy of the shapes, from which it writes checkpoints.
+
+#define JOURNAL_MAGIC "CADETJNL"
+#define JOURNAL_MAGIC_LENGTH 8
+#define JOURNAL_VERSION 1
+#define JOURNAL_BYTE_ORDER 0x01020304u
+
+#define JOURNAL_OP_INSERT_HEAD 1
+#define JOURNAL_OP_INSERT_TAIL 2
+#define JOURNAL_OP_EDIT 3
+#define JOURNAL_OP_REMOVE 4
+#define JOURNAL_OP_MOVE_HEAD 5
+#define JOURNAL_OP_MOVE_TAIL 6
+#define JOURNAL_OP_CLEAR 7
+#define JOURNAL_OP_CHECKPOINT 8
+#define JOURNAL_OP_INSERT_AFTER 9
+#define JOURNAL_OP_MOVE_AFTER 10
+
+// Bytes of records the ring holds before the thread changing the list has to wait for the writer
+#define JOURNAL_RING_SIZE (4 << 20)
+// How long the writer sleeps when it finds nothing to write
+#define JOURNAL_IDLE_MS 5
+// A checkpoint is written once the tail outgrows both this and the snapshot,
+// or when the tail is not empty and this many seconds passed since the last one
+#define JOURNAL_CHECKPOINT_MIN_SIZE (1 << 20)
+#define JOURNAL_AUTOSAVE_SECONDS 30
+
+struct JournalHeader {
+    char magic[JOURNAL_MAGIC_LENGTH];
+    uint32_t version;
+    uint32_t byteOrder;
+};
+
+// size counts the payload, checksum is its 32-bit FNV-1a hash
+struct JournalRecordHeader {
+    uint32_t size;
+    uint32_t checksum;
+};
+
+// One shape, with the column meaning of shapestore.h, textLength bytes of content follow it
+struct JournalShape {
+    int32_t type;
+    int32_t x0, y0, x1, y1;
+    int32_t r0, r1;
+    int32_t fontWidth, fontHeight;
+    int32_t textLength;
+};
+
+// What recovery found: shapes in the snapshot, records replayed after it,
+// and whether it stopped at a torn or damaged record
+struct JournalStats {
+    int snapshotNum, replayedNum;
+    bool isTorn;
+};
+
+// Counters of an open journal
+struct JournalStatus {
+    long long int recordNum;
+    int checkpointNum;
+    // Times the thread changing the list found the ring full
+    int stallNum;
+    bool isFailed;
+};
+
+struct Journal;
+
+// Start journaling the list into path, which is written with a snapshot of the current shapes first
+// The journal attaches itself to the list as a ListIndex
+// Returns its pointer, or NULL if out of memory
+struct Journal * openJournal(struct LinkedList *list, const char *path);
+
+// Write every pending record, stop the writer and detach from the list, the file is kept
+// Returns false if any record could not be written or tracked
+bool closeJournal(struct Journal *journal, struct LinkedList *list);
+
+// Ask the writer for a checkpoint as soon as it has written what is pending
+// Returns nothing
+void requestCheckpoint(struct Journal *journal);
+
+// Read the counters of a journal
+// Returns nothing
+void getJournalStatus(struct Journal *journal, struct JournalStatus *status);
+
+// Replace the shapes of the list, which must have no index attached, with those a journal file holds
+// stats is filled in unless it is NULL
+// Returns false if the file is missing, unreadable or no journal, or if out of memory; the list is then untouched
+bool recoverJournal(struct LinkedList *list, const char *path, struct JournalStats *stats);
+
+#endif
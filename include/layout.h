@@ -2,6 +2,7 @@
 #define LAYOUT_H_
 
 #include "datatypes.h"
+#include "tracking.h"
 
 /* Area */
 
@@ -27,11 +28,13 @@
 #define BUTTON_TYPE_TEXT 4
 #define BUTTON_TYPE_CLEAR 5
 #define BUTTON_TYPE_EXIT 6
-#define BUTTON_NON_ACTIVE 7
-#define BUTTON_NON_CHANGED 8
+#define BUTTON_TYPE_UNDO 7
+#define BUTTON_TYPE_REDO 8
+#define BUTTON_NON_ACTIVE 9
+#define BUTTON_NON_CHANGED 10
 
 // Number and length
-#define BUTTON_NUMBER 7
+#define BUTTON_NUMBER 9
 #define BUTTON_TEXT_LENGTH 127
 
 /* Canvas */
@@ -44,13 +47,7 @@
 // Color
 #define EDIT_ASSIST_COLOR EGERGB(169, 169, 169)
 
-// Configurations
-#define EDIT_ASSIST_DRAW_SIDE_SAME 1
-#define EDIT_ASSIST_DRAW_SIDE_NON_SAME 2
-#define EDIT_ASSIST_DRAW_MID 4
-
-// Number and radius
-#define EDIT_ASSIST_MAX_NUM 8
+// Radius, the handles themselves are placed by getEditAssistPts()
 #define EDIT_ASSIST_RADIUS 5
 
 /* Menu */
@@ -92,11 +89,12 @@ void drawButton(int buttonId, int state);
 
 /* Canvas */
 void clearCanvas();
+void setCanvasClip(const struct BoundingBox *rect);
 
 /* Edit Assist */
 bool isInAssistArea(struct Vertex *cursorPt);
 int getAssistId(struct Vertex *cursorPt);
-void drawEditAssist(struct NodeData *nodeData);
+void drawEditAssist(const struct LinkedNode *node);
 
 /* Initialization */
 void init();
@@ -2,6 +2,24 @@
 #define LINKED_LIST_H_
 
 #include "misc.h"
+#include "pool.h"
+
+// Kinds of ListIndex, to look an attached index up
+#define LIST_INDEX_UNDEFINED 0
+#define LIST_INDEX_RTREE 2
+#define LIST_INDEX_SHAPESTORE 3
+#define LIST_INDEX_JOURNAL 4
+#define LIST_INDEX_UNDO 5
+
+// Room left between the rank of a node added or moved to either end and the end it goes past,
+// so that nodes put between them later seldom have to relabel
+#define LIST_RANK_GAP (1LL << 32)
+// Ranks of a range of 2^k keys are spread again once it holds more than (2 / LIST_RANK_OVERFLOW)^k nodes,
+// between 1 and 2, the lower the sparser ranges are kept
+#define LIST_RANK_OVERFLOW 1.4
+
+// Nodes, their data and the shapes in them all come from the pools of this region
+extern struct PoolRegion documentRegion;
 
 struct NodeData {
     int type;
@@ -11,39 +29,128 @@ struct NodeData {
 struct LinkedNode {
     struct NodeData *data;
     struct LinkedNode *prev, *next;
+    // Z-order key, strictly increasing from head to tail, see isNodeAbove()
+    // Putting a node between others may relabel the nodes around it, keep nodes rather than ranks
+    long long int rank;
+    // Extent of data, refreshed whenever data is set, the one extent hit tests, culling and indexes read
+    struct BoundingBox box;
+};
+
+// Secondary structure (e.g. a spatial index) kept in sync with a list.
+// Every hook is optional and receives impl as its first argument.
+struct ListIndex {
+    int kind;
+    void *impl;
+
+    // findNode() is answered by findFunc only when called with this checkFunc
+    // An index that lost shapes, e.g. when out of memory, sets it to NULL so that findNode() asks the next one
+    // or walks the list
+    bool (*checkFunc)(const void *, const struct LinkedNode *);
+    struct LinkedNode * (*findFunc)(void *impl, const void *findData,
+                                    bool (*checkFunc)(const void *, const struct LinkedNode *));
+
+    // Called after node is linked into the list
+    void (*insertFunc)(void *impl, struct LinkedNode *node);
+    // Called before node is unlinked and its data destroyed
+    void (*removeFunc)(void *impl, struct LinkedNode *node);
+    // Called after node -> data is replaced, before oldData is destroyed
+    void (*editFunc)(void *impl, struct LinkedNode *node, struct NodeData *oldData);
+    // Called before and after node changes its position in the list
+    void (*preReorderFunc)(void *impl, struct LinkedNode *node);
+    void (*reorderFunc)(void *impl, struct LinkedNode *node);
+    // Called when the whole list is destroyed
+    void (*clearFunc)(void *impl);
+    // Called instead of insertFunc for each node when relinkNodes() fills the list back at once
+    void (*buildFunc)(void *impl, struct LinkedList *list);
+
+    // Offered what the list lets go of before it is destroyed, each returns true to take ownership of it
+    // and destroy it later with destroyDataFunc, which may be NULL as in deleteNode():
+    // a node unlinked by deleteNode(), which keeps its prev, next and rank, with its data
+    bool (*retainNodeFunc)(void *impl, struct LinkedNode *node, void (*destroyDataFunc)(struct NodeData *));
+    // the data replaced by editNode()
+    bool (*retainDataFunc)(void *impl, struct LinkedNode *node, struct NodeData *oldData,
+                           void (*destroyDataFunc)(struct NodeData *));
+    // every node of a list emptied by destroyLinkedList(), still chained from head to tail
+    bool (*retainListFunc)(void *impl, struct LinkedNode *head, struct LinkedNode *tail, int size,
+                           void (*destroyDataFunc)(struct NodeData *));
+
+    struct ListIndex *next;
 };
 
 struct LinkedList {
     int listSize;
     struct LinkedNode *head, *tail;
+    struct ListIndex *index;
+    // Bumped by every change of the nodes, so that caches built from the list can tell they are stale
+    unsigned int version;
+    // Whether the list is the only one drawing from documentRegion, see claimDocumentRegion()
+    bool ownsRegion;
 };
 
 // Initialize a blank linked list
 // Returns nothing
 void initLinkedList(struct LinkedList *list);
 
-// Destroy given linked list
+// Destroy all nodes of given linked list, leaving it empty
+// Attached indexes are cleared but stay attached
+// A list owning documentRegion, with nothing but its own nodes alive, gives the whole region back at once
+// instead of walking, destroyDataFunc must then be destroyRule() or NULL
 // Returns nothing
 void destroyLinkedList(struct LinkedList *list, void (*destroyDataFunc)(struct NodeData *));
 
+// Make the list the only one drawing from documentRegion, it must hold every node alive
+// Shapes must not outlive their node elsewhere than in the indexes of the list
+// Returns nothing
+void claimDocumentRegion(struct LinkedList *list);
+
+// Attach an index to the list, the index must already hold every node of it
+// Indexes attached earlier take precedence in findNode()
+// Returns nothing
+void attachIndex(struct LinkedList *list, struct ListIndex *index);
+
+// Detach an index from the list
+// Returns nothing
+void detachIndex(struct LinkedList *list, struct ListIndex *index);
+
+// Find the first attached index of given kind
+// Returns its pointer, or NULL if there is none
+struct ListIndex * findListIndex(const struct LinkedList *list, int kind);
+
 // Create a new NodeData in memory
 // Returns its pointer
 struct NodeData * makeData(void *newContent, int newType);
 
+// Free a NodeData, leaving its content untouched
+// Returns nothing
+void destroyData(struct NodeData *data);
+
 // Add a new segment into the database
 // Return the pointer of the added segment
 struct LinkedNode * addNodeAtHead(struct LinkedList *list, struct NodeData *newData);
 struct LinkedNode * addNodeAtTail(struct LinkedList *list, struct NodeData *newData);
 
+// Add a new node right after prevNode, or at head if prevNode is NULL
+// Returns its pointer, or NULL if out of memory
+struct LinkedNode * addNodeAfter(struct LinkedList *list, struct LinkedNode *prevNode, struct NodeData *newData);
+
+// Add a batch of new nodes at the tail, in array order
+// Returns how many were added, fewer than dataNum if out of memory
+int addNodesAtTail(struct LinkedList *list, struct NodeData **newData, int dataNum);
+
 // Edit data of a segment
 // Returns nothing
-void editNode(struct LinkedNode *node, struct NodeData *newData, void (*destroyDataFunc)(struct NodeData *));
+void editNode(struct LinkedList *list, struct LinkedNode *node, struct NodeData *newData,
+              void (*destroyDataFunc)(struct NodeData *));
 
-// Find LinkedNode using given function
+// Find LinkedNode using given function, searching from tail to head
 // Returns LinkedNode pointer
 struct LinkedNode * findNode(struct LinkedList *list, const void *findData,
                             bool (*checkFunc)(const void *, const struct LinkedNode *));
 
+// Tell whether node a is drawn above node b, both in the same list
+// Returns true if a comes after b
+bool isNodeAbove(const struct LinkedNode *a, const struct LinkedNode *b);
+
 // Move LinkedNode to list head
 // Returns nothing
 void moveToHead(struct LinkedList *list, struct LinkedNode *node);
@@ -57,4 +164,22 @@ void moveToTail(struct LinkedList *list, struct LinkedNode *node);
 void deleteNode(struct LinkedList *list, struct LinkedNode *node,
                 void (*destroyDataFunc)(struct NodeData *));
 
+// Link a node unlinked earlier back in right after prevNode, or at head if prevNode is NULL,
+// with the rank it kept if it still lies between its new neighbours, a fresh one otherwise
+// Returns nothing
+void relinkNode(struct LinkedList *list, struct LinkedNode *node, struct LinkedNode *prevNode);
+
+// Link a chain of nodes unlinked earlier by destroyLinkedList() back into the now empty list
+// Returns nothing
+void relinkNodes(struct LinkedList *list, struct LinkedNode *head);
+
+// Move LinkedNode right after prevNode, or to head if prevNode is NULL, giving it rank
+// if it lies between its new neighbours, a fresh one otherwise
+// Returns nothing
+void moveNodeAfter(struct LinkedList *list, struct LinkedNode *node, struct LinkedNode *prevNode, long long int rank);
+
+// Free a node that is in no list, with its data
+// Returns nothing
+void destroyNode(struct LinkedNode *node, void (*destroyDataFunc)(struct NodeData *));
+
 #endif
@@ -15,6 +15,22 @@
 #define max(x, y) (((x) > (y)) ? (x) : (y))
 #endif
 
+struct BoundingBox {
+    int minx, miny, maxx, maxy;
+};
+
 long long int quickPow(long long int a, long long int n);
 
+// Check whether two bounding boxes overlap (borders included)
+// Returns true if they do
+bool isBoxIntersected(const struct BoundingBox *a, const struct BoundingBox *b);
+
+// Check whether a point lies in a bounding box (borders included)
+// Returns true if it does
+bool isInBox(int x, int y, const struct BoundingBox *box);
+
+// Put the file at from in place of the one at to at once, readers see either file whole
+// Returns true on success
+bool replaceFile(const char *from, const char *to);
+
 #endif
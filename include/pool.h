@@ -0,0 +1,143 @@
+#ifndef POOL_H_
+#define POOL_H_
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include "misc.h"
+
+// Fixed-size object pool carving objects out of large slabs.
+// Freed objects go to a per-pool free list and are reused first.
+// Pools grouped in a region can also give every object back at once, or set them all aside as one
+// generation while they hand out a new one, in constant time: slabs are only relinked, never walked,
+// short of freeing the spare slabs past a bound once a generation set aside is dropped.
+// Define CADET_NO_POOL to fall back to plain malloc/free with the same counters,
+// so that both allocation strategies can be compared.
+// Pools are not thread-safe.
+
+#define POOL_SLAB_OBJECTS 1024
+// Spare slabs a pool keeps once a generation set aside is dropped, those past this are given back to the system
+#define POOL_MAX_SPARE_SLABS 64
+
+// Objects are at least pointer sized and pointer aligned, to hold free list links
+#define POOL_OBJECT_SIZE(type) ((sizeof(type) + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *))
+
+#define POOL_INITIALIZER(poolName, type) POOL_MEMBER_INITIALIZER(poolName, type, NULL)
+#define POOL_MEMBER_INITIALIZER(poolName, type, poolRegion) \
+    { poolName, POOL_OBJECT_SIZE(type), POOL_SLAB_OBJECTS, poolRegion, NULL, NULL, NULL, NULL, NULL, 0, false, NULL, 0, 0, 0, 0, 0, 0, 0 }
+
+#define POOL_REGION_MAX_POOLS 16
+
+#define POOL_REGION_INITIALIZER(regionName) { regionName, { NULL }, 0, 0, 0 }
+
+struct PoolSlab {
+    struct PoolSlab *next;
+};
+
+struct Pool {
+    const char *name;
+    size_t objectSize;
+    int slabObjectNum;
+    // Region the pool joins on its first allocation, or NULL
+    struct PoolRegion *region;
+
+    // Newest slab first, oldestSlab is the last one of that chain
+    struct PoolSlab *slabs, *oldestSlab;
+    // Slabs whose objects were all taken back, reused before asking the system for more
+    struct PoolSlab *spareSlabs;
+    void *freeList;
+
+    // Untouched part of the newest slab
+    char *bumpPtr;
+    int bumpLeft;
+
+    // Registration in the list of all pools
+    bool isRegistered;
+    struct Pool *nextPool;
+
+    // Counters
+    long long int liveNum, peakNum;
+    long long int allocNum, freeNum;
+    long long int slabNum;
+    // Slabs in the chain of slabs, and spare ones
+    long long int chainSlabNum, spareSlabNum;
+};
+
+// Every object a pool handed out, as put aside by its region
+struct PoolState {
+    struct PoolSlab *slabs, *oldestSlab;
+    void *freeList;
+    char *bumpPtr;
+    int bumpLeft;
+    long long int liveNum, chainSlabNum;
+};
+
+struct PoolRegion {
+    const char *name;
+    struct Pool *pools[POOL_REGION_MAX_POOLS];
+    int poolNum;
+    // Generation of the objects handed out now, a new one starts whenever they are set aside
+    long long int generation, generationNum;
+};
+
+// One generation of a region, set aside
+struct PoolRegionState {
+    long long int generation;
+    // In the order of region -> pools, pools that joined later have an empty state
+    struct PoolState states[POOL_REGION_MAX_POOLS];
+};
+
+struct PoolStats {
+    long long int liveNum, peakNum;
+    long long int allocNum, freeNum;
+    long long int slabNum;
+    // Bytes held by live objects, at peak, and reserved from the system
+    size_t liveBytes, peakBytes, reservedBytes;
+};
+
+// Get an object from the pool
+// Returns its pointer, or NULL with errno set if out of memory
+void * poolAlloc(struct Pool *pool);
+
+// Give an object back to the pool
+// Returns nothing
+void poolFree(struct Pool *pool, void *ptr);
+
+// Take back every object of the pool at once, keeping its slabs for what comes next
+// Returns false, taking nothing back, with CADET_NO_POOL
+bool resetPool(struct Pool *pool);
+
+// Release every slab of the pool, all of its objects become invalid
+// Returns nothing
+void destroyPool(struct Pool *pool);
+
+// Read the counters of a pool
+// Returns nothing
+void getPoolStats(const struct Pool *pool, struct PoolStats *stats);
+
+// Print counters of every pool used so far
+// Returns nothing
+void printPoolStats(FILE *fp);
+
+// Take back every object of every pool of the region at once
+// Returns false, taking nothing back, with CADET_NO_POOL
+bool resetPoolRegion(struct PoolRegion *region);
+
+// Set aside every object the region handed out so far, its pools then start a new generation empty
+// Objects set aside stay valid until their state is dropped, and must not be given back one by one
+// Returns the state, or NULL if out of memory or with CADET_NO_POOL, nothing is set aside then
+struct PoolRegionState * setAsidePoolRegion(struct PoolRegion *region);
+
+// Exchange the generation the region hands out now with one set aside earlier
+// Returns nothing
+void swapPoolRegion(struct PoolRegion *region, struct PoolRegionState *state);
+
+// Take back every object of a generation set aside, and free its state and the spare slabs past POOL_MAX_SPARE_SLABS
+// Returns nothing
+void dropPoolRegionState(struct PoolRegion *region, struct PoolRegionState *state);
+
+// Count the bytes held by live objects of the region, or of a generation of it set aside if state is not NULL
+// Returns the count
+size_t getPoolRegionBytes(const struct PoolRegion *region, const struct PoolRegionState *state);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef PTR_MAP_H_
+#define PTR_MAP_H_
+
+#include "misc.h"
+
+#define PTRMAP_INIT_CAPACITY 64
+
+// Hash map from pointers to non-negative ints, with linear probing
+struct PtrMapEntry {
+    const void *key;
+    int value;
+};
+
+struct PtrMap {
+    int size, capacity;
+    struct PtrMapEntry *entries;
+};
+
+// Initialize an empty map
+// Returns nothing
+void initPtrMap(struct PtrMap *map);
+
+// Free memory held by the map
+// Returns nothing
+void destroyPtrMap(struct PtrMap *map);
+
+// Remove every key from the map
+// Returns nothing
+void clearPtrMap(struct PtrMap *map);
+
+// Insert or update a key
+// Returns false if out of memory
+bool putPtrMap(struct PtrMap *map, const void *key, int value);
+
+// Look a key up
+// Returns its value, or -1 if it is absent
+int getPtrMap(const struct PtrMap *map, const void *key);
+
+// Remove a key if present
+// Returns nothing
+void removePtrMap(struct PtrMap *map, const void *key);
+
+#endif
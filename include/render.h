@@ -0,0 +1,61 @@
+#ifndef RENDER_H_
+#define RENDER_H_
+
+#include "misc.h"
+#include "linkedlist.h"
+#include "datatypes.h"
+#include "shapestore.h"
+
+// Shape rasterization behind a backend, free of EGE,
+// so that the same drawing code runs on screen and in a software framebuffer.
+// Colors are 0xRRGGBB like EGERGB(), coordinates are those of the current target.
+
+struct RenderBackend {
+    void *impl;
+
+    // Primitives, with the argument order of EGE
+    void (*lineFunc)(void *impl, int x0, int y0, int x1, int y1, unsigned int color);
+    void (*rectangleFunc)(void *impl, int left, int top, int right, int bottom, unsigned int color);
+    void (*circleFunc)(void *impl, int centerx, int centery, int radius, unsigned int color);
+    void (*ellipseFunc)(void *impl, int centerx, int centery, int xRadius, int yRadius, unsigned int color);
+    // Filled rectangle, bounds included
+    void (*barFunc)(void *impl, int left, int top, int right, int bottom, unsigned int color);
+    // Text starting at the upper left corner of the box of startPt and endPt, as tall as that box
+    void (*textFunc)(void *impl, const struct Vertex *startPt, const struct Vertex *endPt, const char *text,
+                     unsigned int color, bool isDraft);
+};
+
+// Shapes reaching this far out of their box still count as visible
+#define RENDER_CULL_MARGIN 2
+
+// Shapes drawn and skipped, summed up by renderList()
+struct RenderStats {
+    int drawnNum, culledNum;
+};
+
+// Draw the shape a drag from startPt to endPt describes
+// Returns nothing
+void renderShape(const struct RenderBackend *backend, const struct Vertex *startPt, const struct Vertex *endPt,
+                 int shapeType, unsigned int color);
+
+// Draw data moved by (offsetx, offsety)
+// Returns nothing
+void renderNodeData(const struct RenderBackend *backend, const struct NodeData *data, unsigned int color,
+                    bool isDraft, int offsetx, int offsety);
+
+// Draw a shape straight from the columns of a store
+// Returns nothing
+void renderStoreShape(const struct RenderBackend *backend, const struct ShapeStore *store, int slot,
+                      unsigned int color, bool isDraft);
+
+// Check whether a shape box may show in visibleBox, NULL meaning everything is visible
+// Returns true if it may
+bool isBoxVisible(const struct BoundingBox *box, const struct BoundingBox *visibleBox);
+
+// Draw every node of the list from head to tail, streaming over an attached ShapeStore if any
+// Shapes missing visibleBox are skipped, unless it is NULL, and counted into stats unless it is NULL
+// Returns nothing
+void renderList(const struct RenderBackend *backend, const struct LinkedList *list, unsigned int color, bool isDraft,
+                const struct BoundingBox *visibleBox, struct RenderStats *stats);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef RING_BUFFER_H_
+#define RING_BUFFER_H_
+
+#include "misc.h"
+
+// Lock-free byte queue between exactly one producer thread and one consumer thread.
+// A write is published whole, so a consumer never sees half of what was written at once.
+// Neither side ever waits: a full or empty ring is reported and left to the caller.
+
+struct RingBuffer;
+
+// Create a ring holding up to capacity bytes, rounded up to a power of two
+// Returns its pointer, or NULL if out of memory
+struct RingBuffer * makeRingBuffer(int capacity);
+
+// Free a ring, neither side may use it any more
+// Returns nothing
+void destroyRingBuffer(struct RingBuffer *ring);
+
+// Get the number of bytes the ring holds at most
+// Returns the number
+int getRingBufferCapacity(const struct RingBuffer *ring);
+
+// Producer side: append size bytes at once
+// Returns false, writing nothing, if there is not enough room
+bool writeRingBuffer(struct RingBuffer *ring, const void *data, int size);
+
+// Consumer side: get the number of bytes ready to be read
+// Returns the number
+int getRingBufferReadable(const struct RingBuffer *ring);
+
+// Consumer side: take exactly size bytes
+// Returns false, taking nothing, if fewer are ready
+bool readRingBuffer(struct RingBuffer *ring, void *out, int size);
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef RTREE_H_
+#define RTREE_H_
+
+#include "linkedlist.h"
+#include "datatypes.h"
+
+#define RTREE_MAX_ENTRIES 16
+#define RTREE_MIN_ENTRIES 6
+
+struct RTreeNode;
+
+// Leaf entries hold a shape, inner entries a child node
+// box is the exact extent, hit slack is added when querying
+struct RTreeEntry {
+    struct BoundingBox box;
+    struct RTreeNode *child;
+    struct LinkedNode *node;
+};
+
+struct RTreeNode {
+    bool isLeaf;
+    int size;
+    struct RTreeNode *parent;
+    struct RTreeEntry entries[RTREE_MAX_ENTRIES + 1];
+};
+
+struct RTree {
+    int itemNum;
+    struct RTreeNode *root;
+    // Set when running out of memory lost shapes or left a node overfull, the tree then stops answering
+    // findNode() and following the list until built again or cleared
+    bool isBroken;
+    struct ListIndex index;
+};
+
+// Create an empty R-tree
+// Returns its pointer
+struct RTree * makeRTree();
+
+// Destroy given R-tree, it must have been detached from its list
+// Returns nothing
+void destroyRTree(struct RTree *tree);
+
+// Remove every shape from the tree
+// Returns nothing
+void clearRTree(struct RTree *tree);
+
+// Replace tree content with every shape of list, packed with Sort-Tile-Recursive, mending a broken tree
+// Returns nothing
+void buildRTree(struct RTree *tree, struct LinkedList *list);
+
+// Index or unindex a node, using the extent of data
+// Returns nothing, a broken tree is left as it is
+void insertRTree(struct RTree *tree, struct LinkedNode *node, const struct NodeData *data);
+void removeRTree(struct RTree *tree, struct LinkedNode *node, const struct NodeData *data);
+
+// Re-index a node whose data changed from oldData, in place when possible
+// Returns nothing
+void updateRTree(struct RTree *tree, struct LinkedNode *node, const struct NodeData *oldData);
+
+// Queries below cannot be trusted while the tree is broken
+
+// Find the topmost (closest to tail) node satisfying checkFunc at cursorPt
+// Returns LinkedNode pointer, or NULL if there is none
+struct LinkedNode * findRTree(struct RTree *tree, const struct Vertex *cursorPt,
+                              bool (*checkFunc)(const void *, const struct LinkedNode *));
+
+// Find every node satisfying checkFunc at cursorPt, topmost first
+// Returns the number of nodes found, at most maxResNum of them are stored in res, or -1 if out of memory
+int findAllRTree(struct RTree *tree, const struct Vertex *cursorPt,
+                 bool (*checkFunc)(const void *, const struct LinkedNode *),
+                 struct LinkedNode **res, int maxResNum);
+
+// Visit every node whose extent intersects box, in no particular order
+// Returns the number of nodes visited
+int searchRTree(struct RTree *tree, const struct BoundingBox *box,
+                void (*visitFunc)(struct LinkedNode *, void *), void *arg);
+
+#endif
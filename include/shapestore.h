@@ -0,0 +1,148 @@
+#ifndef SHAPE_STORE_H_
+#define SHAPE_STORE_H_
+
+#include "misc.h"
+#include "linkedlist.h"
+#include "datatypes.h"
+#include "ptrmap.h"
+#include "hittest.h"
+#include "drawfile.h"
+#include "rtree.h"
+
+// Flat structure-of-arrays copy of every shape in a list.
+// Each field lives in its own contiguous column indexed by slot, so hit tests
+// and redraws stream over plain ints instead of chasing Vertex pointers.
+// Picks run the hit test kernels over the shapes an R-tree finds near the point, or over every shape without one.
+// The store is attached to the list as a ListIndex and kept in sync by its hooks,
+// the list stays the owner of shapes and the place where they are edited.
+//
+// Column meaning per type:
+//   DATATYPE_SEGMENT    (x0, y0) left point, (x1, y1) right point
+//   DATATYPE_RECTANGLE  (x0, y0) lower left point, (x1, y1) upper right point
+//   DATATYPE_TEXT       same as DATATYPE_RECTANGLE, text holds the content
+//   DATATYPE_CIRCLE     (x0, y0) center point, r0 radius
+//   DATATYPE_ELLIPSE    (x0, y0) center point, r0 major and r1 minor semi axis
+
+#define SHAPESTORE_INIT_CAPACITY 64
+
+// Columns from type to r1, the ones a DrawFile holds
+#define SHAPESTORE_FILE_COLUMNS 7
+
+// Marks a hole in the z-order array
+#define SHAPESTORE_HOLE -1
+
+// Stable reference to a shape, it is invalidated once the shape is removed
+struct ShapeHandle {
+    int slot;
+    unsigned int generation;
+};
+
+struct ShapeStore {
+    int capacity;
+    // Slots in use or on the free chain, live ones, and head of the free chain
+    int slotNum, liveNum, freeSlot;
+
+    // Columns, indexed by slot
+    int *type;
+    int *x0, *y0, *x1, *y1;
+    int *r0, *r1;
+    const char **text;
+    // Extent of each slot, the same as the box of its node
+    struct BoundingBox *box;
+    struct LinkedNode **node;
+    unsigned int *generation;
+    // Position in order of a live slot, next free slot of a free one
+    int *orderPos;
+
+    // Z-order from bottom to top, removed shapes leave holes behind
+    int *order;
+    int orderCapacity, orderBegin, orderEnd, holeNum;
+
+    struct PtrMap slotMap;
+    struct ListIndex index;
+    // While not NULL and whole, picks only test the shapes this tree of the same list finds near the point,
+    // gathered into candidates by z-order position
+    struct RTree *tree;
+    int *candidates;
+    int candidateNum, candidateCapacity;
+
+    // Set when running out of memory lost a shape or its place, the store then stops answering findNode()
+    // and renderList() follows the list until the store is built again or cleared
+    bool isBroken;
+
+    // While not NULL, columns from type to r1 point into the mapping of this file.
+    // Changes go to its private pages, they are copied to the heap once the store has to grow.
+    const struct DrawFile *mappedFile;
+};
+
+// Create an empty store
+// Returns its pointer, or NULL if out of memory
+struct ShapeStore * makeShapeStore();
+
+// Free the store and everything inside it
+// Returns nothing
+void destroyShapeStore(struct ShapeStore *store);
+
+// Remove every shape from the store
+// Returns nothing
+void clearShapeStore(struct ShapeStore *store);
+
+// Fill an empty store with every node of the list, keeping list order
+// Returns false if out of memory
+bool buildShapeStore(struct ShapeStore *store, const struct LinkedList *list);
+
+// Fill an empty store with the shapes of a drawing, pointing into its mapping instead of copying them
+// Slot i is bound to the i-th node of list, loaded from the same file, or to no node when list is NULL
+// The file must stay open until the store is destroyed
+// Returns false if out of memory, leaving the store empty
+bool mapShapeStore(struct ShapeStore *store, const struct DrawFile *file, const struct LinkedList *list);
+
+// Add a node above or below all others
+// Returns false if out of memory
+bool insertShapeStore(struct ShapeStore *store, struct LinkedNode *node, bool isTop);
+
+// Add a node right above prevNode, or above all others if prevNode is not in the store
+// Returns false if out of memory
+bool insertShapeStoreAfter(struct ShapeStore *store, struct LinkedNode *node, const struct LinkedNode *prevNode);
+
+// Drop a node from the store
+// Returns nothing
+void removeShapeStore(struct ShapeStore *store, struct LinkedNode *node);
+
+// Copy the current data of a node into its columns
+// Returns nothing
+void updateShapeStore(struct ShapeStore *store, struct LinkedNode *node);
+
+// Move a node above or below all others
+// Returns false if out of memory
+bool reorderShapeStore(struct ShapeStore *store, struct LinkedNode *node, bool isTop);
+
+// Move a node right above prevNode
+// Returns false if out of memory
+bool reorderShapeStoreAfter(struct ShapeStore *store, struct LinkedNode *node, const struct LinkedNode *prevNode);
+
+// Get the handle of a node
+// Returns false if the node is not in the store
+bool getShapeHandle(const struct ShapeStore *store, const struct LinkedNode *node, struct ShapeHandle *handle);
+
+// Check whether a handle still refers to a live shape
+// Returns true if it does
+bool isValidShapeHandle(const struct ShapeStore *store, const struct ShapeHandle *handle);
+
+// Get the node a handle refers to
+// Returns its pointer, or NULL if the handle is stale
+struct LinkedNode * getShapeNode(const struct ShapeStore *store, const struct ShapeHandle *handle);
+
+// Get the extent of a slot, same as getDataBoundingBox() on its node, as kept in the box column
+// Returns nothing
+void getSlotBoundingBox(const struct ShapeStore *store, int slot, struct BoundingBox *box);
+
+// Hit test a single slot with findRule semantics
+// Returns true if the point is on the shape
+bool isSlotHit(const struct ShapeStore *store, int slot, int x, int y);
+
+// Find the topmost shape under the point
+// Returns its slot, or -1 if there is none
+int findShapeStore(const struct ShapeStore *store, int x, int y);
+
+#endif
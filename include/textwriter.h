@@ -0,0 +1,55 @@
+#ifndef TEXT_WRITER_H_
+#define TEXT_WRITER_H_
+
+#include <stdio.h>
+
+#include "misc.h"
+
+// Buffered output of text formats, numbers are formatted by hand instead of printf().
+// Nothing is allocated once the writer exists, errors are remembered and reported on close.
+
+#define TEXT_WRITER_BUFFER_SIZE 65536
+// Longest piece a single write may need, strings aside
+#define TEXT_WRITER_MAX_NUMBER 32
+
+struct TextWriter {
+    FILE *file;
+    int length;
+    bool isFailed;
+    // Bytes written so far, buffered ones included
+    long long int offset;
+    char buffer[TEXT_WRITER_BUFFER_SIZE];
+};
+
+// Create a file and a writer for it
+// Returns its pointer, or NULL if the file cannot be created or out of memory
+struct TextWriter * makeTextWriter(const char *path);
+
+// Flush and close the file, then free the writer
+// Returns false if anything could not be written
+bool destroyTextWriter(struct TextWriter *writer);
+
+// Make room for size more bytes, size must not exceed TEXT_WRITER_BUFFER_SIZE
+// Returns where to put them, followed by commitTextWriter()
+char * reserveTextWriter(struct TextWriter *writer, int size);
+
+// Account for size bytes put where reserveTextWriter() pointed
+// Returns nothing
+void commitTextWriter(struct TextWriter *writer, int size);
+
+// Format value in decimal into out, which needs TEXT_WRITER_MAX_NUMBER bytes
+// Returns the number of characters written
+int formatInt(char *out, long long int value);
+
+// Format value rounded to given decimals, from 0 to 6, trailing zeros dropped
+// Returns the number of characters written
+int formatFixed(char *out, double value, int decimals);
+
+// Append text, a character, or a number
+// Returns nothing
+void writeString(struct TextWriter *writer, const char *text);
+void writeChar(struct TextWriter *writer, char c);
+void writeInt(struct TextWriter *writer, long long int value);
+void writeFixed(struct TextWriter *writer, double value, int decimals);
+
+#endif
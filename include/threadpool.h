@@ -0,0 +1,26 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+// Fixed set of worker threads running batches of indexed tasks.
+// The calling thread takes part in every batch, so a pool of one thread runs everything inline.
+
+struct ThreadPool;
+
+// Create a pool of threadNum threads, calling thread included
+// threadNum <= 0 picks the number of hardware threads
+// Returns its pointer, or NULL if out of memory
+struct ThreadPool * makeThreadPool(int threadNum);
+
+// Stop and join every worker, then free the pool
+// Returns nothing
+void destroyThreadPool(struct ThreadPool *pool);
+
+// Get the number of threads, calling thread included
+// Returns the number
+int getThreadPoolSize(const struct ThreadPool *pool);
+
+// Run func(arg, taskId) for every taskId in [0, taskNum), in any order and on any thread
+// Returns once all of them have finished
+void runThreadPool(struct ThreadPool *pool, int taskNum, void (*func)(void *arg, int taskId), void *arg);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef TILE_RENDER_H_
+#define TILE_RENDER_H_
+
+#include "linkedlist.h"
+#include "framebuffer.h"
+#include "threadpool.h"
+
+// Parallel full redraw of a framebuffer.
+// The clip area is cut into square tiles and every shape is binned, in list order,
+// into the tiles its outline may touch. Tiles are then rasterized on a thread pool,
+// each one clipped to itself, so the pixels are exactly those of the sequential fbRedrawAll().
+// Shapes are rasterized once per tile they touch, so tiles are kept as large as
+// TILE_RENDER_TASKS_PER_THREAD tasks per thread allow.
+
+#define TILE_RENDER_MIN_SIZE 64
+#define TILE_RENDER_TASKS_PER_THREAD 4
+
+struct TileRenderer {
+    struct ThreadPool *pool;
+
+    // Shapes of the frame in list order
+    int itemNum, itemCapacity;
+    const struct NodeData **items;
+    struct BoundingBox *itemBoxes;
+
+    // Tile t holds binItems[binBegin[t]] to binItems[binBegin[t + 1] - 1]
+    int tileSize, tileNumX, tileNumY, tileCapacity;
+    int *binBegin, *binFill;
+    int binCapacity;
+    int *binItems;
+
+    // Frame being rendered
+    struct FrameBuffer *fb;
+    struct BoundingBox area;
+    // Leave text out, for callers drawing its glyphs themselves, false by default
+    bool isTextSkipped;
+    // Shapes drawn and culled by the last frame
+    struct RenderStats stats;
+};
+
+// Create a tile renderer running on threadNum threads, or on every hardware thread when threadNum <= 0
+// Returns its pointer, or NULL if out of memory
+struct TileRenderer * makeTileRenderer(int threadNum);
+
+// Destroy a tile renderer and its threads
+// Returns nothing
+void destroyTileRenderer(struct TileRenderer *renderer);
+
+// Same as fbRedrawAll(), spread over the threads of the renderer
+// Falls back to drawing on the calling thread with a single thread, or if the bins cannot grow
+// Returns nothing
+void fbRedrawAllTiled(struct TileRenderer *renderer, struct FrameBuffer *fb, const struct LinkedList *list);
+
+#endif
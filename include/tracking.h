@@ -0,0 +1,94 @@
+#ifndef TRACKING_H_
+#define TRACKING_H_
+
+#include "misc.h"
+#include "linkedlist.h"
+#include "datatypes.h"
+#include "damage.h"
+#include "render.h"
+
+// Drawing and editing by drag, free of EGE,
+// so that the tracking loops run the same way on screen and in a software framebuffer.
+// A frame repaints the committed shapes where the draft of the last frame and the current one lie,
+// the whole canvas on the first frame, then draws the current draft above them.
+
+// Configurations of edit assist handles
+#define EDIT_ASSIST_DRAW_SIDE_SAME 1
+#define EDIT_ASSIST_DRAW_SIDE_NON_SAME 2
+#define EDIT_ASSIST_DRAW_MID 4
+
+// Number of edit assist handles, a handle id i sits on side i / 3 in x and i % 3 in y, 2 being the middle
+#define EDIT_ASSIST_MAX_NUM 8
+
+struct Tracker {
+    const struct LinkedList *list;
+    const struct RenderBackend *backend;
+    // Repaints the committed shapes, and what lies above them through its overlayFunc
+    const struct DamagePainter *painter;
+    struct BoundingBox canvasBox;
+    // Extent of text drawn from startPt to endPt by backend, the box of the two points when NULL
+    void (*textBoxFunc)(const struct Vertex *startPt, const struct Vertex *endPt, const char *text,
+                        struct BoundingBox *box);
+
+    // Where the draft of the last frame lies, unless isFirstFrame
+    struct BoundingBox draftBox;
+    bool isFirstFrame;
+};
+
+/* Tracker */
+
+// Set up a tracker for one drag over list, drawn on backend and repainted by painter within canvasBox
+// Returns nothing
+void initTracker(struct Tracker *tracker, const struct LinkedList *list, const struct RenderBackend *backend,
+                 const struct DamagePainter *painter, const struct BoundingBox *canvasBox);
+
+// Draw a frame of a shape drawn from startPt to endPt
+// Returns nothing
+void drawTrackedShape(struct Tracker *tracker, const struct Vertex *startPt, const struct Vertex *endPt,
+                      int shapeType, unsigned int color);
+
+// Draw a frame of data being edited into what lies between startPt and endPt
+// Returns nothing
+void drawTrackedData(struct Tracker *tracker, const struct NodeData *data, const struct Vertex *startPt,
+                     const struct Vertex *endPt, unsigned int color);
+
+/* Points */
+
+// Place the edit assist handles of node into assistPts, those it has none at are set to (-1, -1)
+// Returns nothing
+void getEditAssistPts(const struct LinkedNode *node, struct Vertex *assistPts);
+
+// Find the points a drag of data from handle assistId starts from, -1 standing for the handle a move takes
+// Returns false if data cannot be dragged
+bool getTrackedPts(const struct NodeData *data, const struct Vertex *assistPts, int assistId,
+                   struct Vertex *startPt, struct Vertex *endPt);
+
+// Follow the cursor at (x, y) with endPt, keeping the coordinates handle assistId does not change from origPt
+// Returns nothing
+void resizeTrackedPts(int assistId, const struct Vertex *origPt, int x, int y, struct Vertex *endPt);
+
+// Move startPt and endPt as far as the cursor goes from cursorPt to (x, y), then cursorPt itself
+// Returns nothing
+void moveTrackedPts(struct Vertex *cursorPt, int x, int y, struct Vertex *startPt, struct Vertex *endPt);
+
+// Find the box of the shape a drag from startPt to endPt describes
+// Returns nothing
+void getShapeBoundingBox(const struct Vertex *startPt, const struct Vertex *endPt, int shapeType, struct BoundingBox *box);
+
+/* Saving */
+
+// Shape, saving and editing copy startPt and endPt into the list, nothing is kept when it is too small
+// Returns the node added, or NULL if none was
+struct LinkedNode *saveShape(struct LinkedList *list, const struct Vertex *startPt, const struct Vertex *endPt, int shapeType);
+// Returns nothing
+void editShape(struct LinkedList *list, struct LinkedNode *node, const struct Vertex *startPt, const struct Vertex *endPt);
+
+// Text, points and text itself are copied as for shapes, editing keeps the text of node when text is NULL
+// Returns the node added
+struct LinkedNode *saveText(struct LinkedList *list, const struct Vertex *startPt, const struct Vertex *endPt,
+                            const char *text, int fontWidth, int fontHeight);
+// Returns nothing
+void editText(struct LinkedList *list, struct LinkedNode *node, const struct Vertex *startPt, const struct Vertex *endPt,
+              const char *text = NULL, int fontWidth = -1, int fontHeight = -1);
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef UNDO_H_
+#define UNDO_H_
+
+#include "misc.h"
+#include "linkedlist.h"
+#include "datatypes.h"
+
+// Undo and redo of list changes.
+//
+// The history attaches itself to the list as a ListIndex and records each change as a step holding
+// just what the inverse needs. Nothing is copied: the history takes over what the list lets go of,
+// a removed node, the data an edit replaced, or the whole chain of a cleared list, and hands the very
+// same memory back on undo. Nodes go back right after the node they followed, keeping their rank
+// unless nodes put in between meanwhile relabeled their neighbours.
+// Undoing a step and redoing it are one and the same swap, costing what the change itself did whatever
+// the size of the drawing, except that the nodes of an undone clear are handed to the other indexes one by one.
+// On a list owning documentRegion, a clear sets the region aside as a whole instead of weighing the chain,
+// so clearing costs the same whatever the size of the drawing, and so does forgetting the clear later.
+
+#define UNDO_STEP_INSERT 1
+#define UNDO_STEP_REMOVE 2
+#define UNDO_STEP_EDIT 3
+#define UNDO_STEP_MOVE 4
+#define UNDO_STEP_CLEAR 5
+
+#define UNDO_INIT_CAPACITY 64
+// Once a new step makes the history hold more steps or bytes than these, the oldest steps are forgotten.
+// The newest step is always kept, however large.
+#define UNDO_MAX_STEPS 4096
+#define UNDO_MEMORY_LIMIT (64 << 20)
+
+struct UndoStatus {
+    int undoNum, redoNum;
+    // Bytes of the steps and of the shapes they keep alive, in all and in the largest step
+    long long int memorySize, maxStepSize;
+};
+
+struct UndoHistory;
+
+// Start recording the changes of the list, a shape whose insertion was undone and then forgotten
+// is destroyed with destroyDataFunc
+// A list owning documentRegion must have claimed it already
+// Returns its pointer, or NULL if out of memory
+struct UndoHistory * makeUndoHistory(struct LinkedList *list, void (*destroyDataFunc)(struct NodeData *));
+
+// Detach from the list and free every step with the shapes it keeps
+// Returns nothing
+void destroyUndoHistory(struct UndoHistory *history, struct LinkedList *list);
+
+// Forget every step
+// Returns nothing
+void clearUndoHistory(struct UndoHistory *history);
+
+// Revert the latest change not undone yet
+// Returns false if there is none
+bool undoChange(struct UndoHistory *history, struct LinkedList *list);
+
+// Apply again the latest change undone
+// Returns false if there is none
+bool redoChange(struct UndoHistory *history, struct LinkedList *list);
+
+// Read the counters of the history
+// Returns nothing
+void getUndoStatus(const struct UndoHistory *history, struct UndoStatus *status);
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef VECTOR_EXPORT_H_
+#define VECTOR_EXPORT_H_
+
+#include "misc.h"
+#include "linkedlist.h"
+
+// Streaming vector export, in bounded memory.
+// Shapes go through renderList() from head to tail, in the order redrawAll() paints them,
+// and each one is formatted into a fixed buffer as soon as it is met:
+//   SVG    one element per shape, y going down as on screen, text in UTF-8
+//   PDF    one page, whose content stream is written before its length is known
+// Coordinates are canvas pixels, a PDF point per pixel.
+// Text has no font metrics here, a monospace font is stretched over the text box instead.
+
+#define VECTOR_FORMAT_NONE 0
+#define VECTOR_FORMAT_SVG 1
+#define VECTOR_FORMAT_PDF 2
+
+// Find the vector format a path extension asks for, in any letter case
+// Returns one of VECTOR_FORMAT_*
+int getVectorFormat(const char *path);
+
+// Write every shape of the list with color over a width x height page filled with bgColor
+// Colors are 0xRRGGBB like EGERGB()
+// Returns false if the file cannot be written or out of memory
+bool exportSvg(const struct LinkedList *list, const char *path, int width, int height,
+               unsigned int color, unsigned int bgColor);
+bool exportPdf(const struct LinkedList *list, const char *path, int width, int height,
+               unsigned int color, unsigned int bgColor);
+
+#endif
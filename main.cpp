@@ -10,6 +10,14 @@
 #include "distance.h"
 #include "linkedlist.h"
 #include "datatypes.h"
+#include "rtree.h"
+#include "shapestore.h"
+#include "drawfile.h"
+#include "dxf.h"
+#include "vectorexport.h"
+#include "journal.h"
+#include "undo.h"
+#include "arena.h"
 
 #include "draw.h"
 #include "layout.h"
@@ -25,18 +33,17 @@ int cntButtonId;
 
 void moveItem(struct LinkedList *list, struct LinkedNode *node, int mx, int my) {
     assert(list != NULL && node != NULL && node -> data != NULL);
-    struct Vertex *cursorPt = makeVertex(mx, my);
+    struct Vertex *cursorPt = makeScratchVertex(mx, my);
     getRealPosition(cursorPt);
 
     struct Vertex *startPt = NULL, *endPt = NULL;
     trackShape(list, node -> data, cursorPt, &startPt, &endPt);
-    destroyVertex(cursorPt);
 
     if (startPt != NULL && endPt != NULL) {
         if (node -> data -> type == DATATYPE_TEXT) {
-            editText(node, startPt, endPt);
+            editText(list, node, startPt, endPt);
         } else {
-            editShape(node, startPt, endPt);
+            editShape(list, node, startPt, endPt);
         }
     }
 
@@ -59,9 +66,9 @@ void editItem(struct LinkedList *list, struct LinkedNode *node, int assistId) {
         endPt -> x = startPt -> x + textwidth(txt -> content);
         endPt -> y = startPt -> y + cntFont.lfHeight;
 
-        editText(node, startPt, endPt);
+        editText(list, node, startPt, endPt);
     } else {
-        editShape(node, startPt, endPt);
+        editShape(list, node, startPt, endPt);
     }
 
     redrawAll(list, SHAPE_DEFAULT_COLOR, false);
@@ -79,10 +86,11 @@ int editMode(struct LinkedList *list, struct LinkedNode *node) {
 
     while (true) {
         drawNodeData(node -> data, EDIT_ASSIST_COLOR, false);
-        drawEditAssist(node -> data);
+        drawEditAssist(node);
 
         while (true) {
-            mouse_msg m = getmouse();
+            mouse_msg m = nextMouseMsg();
+            resetScratch();
 
             if (m.is_up()) {
                 isFirst = false;
@@ -110,17 +118,15 @@ int editMode(struct LinkedList *list, struct LinkedNode *node) {
                 }
             } else if (cntArea == AREA_CANVAS) {
                 if (m.is_down()) {
-                    struct Vertex *cursorPt = makeVertex(m.x, m.y);
+                    struct Vertex *cursorPt = makeScratchVertex(m.x, m.y);
                     getRealPosition(cursorPt);
                     bool isInShape = (findRule(cursorPt, node) || isInAssistArea(cursorPt));
-                    destroyVertex(cursorPt);
 
                     if (isInShape) {
                         if (m.is_left()) {
-                            struct Vertex *cursorPt = makeVertex(m.x, m.y);
+                            struct Vertex *cursorPt = makeScratchVertex(m.x, m.y);
                             getRealPosition(cursorPt);
                             int assistId = getAssistId(cursorPt);
-                            destroyVertex(cursorPt);
 
                             if (assistId < 0) {
                                 moveItem(list, node, m.x, m.y);
@@ -136,10 +142,9 @@ int editMode(struct LinkedList *list, struct LinkedNode *node) {
                         }
                     } else {
                         if (m.is_left()) {
-                            struct Vertex *cursorPt = makeVertex(m.x, m.y);
+                            struct Vertex *cursorPt = makeScratchVertex(m.x, m.y);
                             getRealPosition(cursorPt);
                             struct LinkedNode *nextNode = findNode(list, cursorPt, findRule);
-                            destroyVertex(cursorPt);
 
                             if (nextNode == NULL) {
                                 returnVal = BUTTON_NON_ACTIVE;
@@ -169,7 +174,8 @@ int editMode(struct LinkedList *list, struct LinkedNode *node) {
 int selectionMode(struct LinkedList *list) {
     assert(list != NULL);
     while (true) {
-        mouse_msg m = getmouse();
+        mouse_msg m = nextMouseMsg();
+        resetScratch();
         if (m.is_left() && m.is_down()) {
             int cntArea = whichArea(m.x);
             if (cntArea == AREA_MENU) {
@@ -182,10 +188,9 @@ int selectionMode(struct LinkedList *list) {
             } else if (cntArea == AREA_CANVAS) {
                 // When user clicked right button in canvas area,
                 // select element and edit it
-                struct Vertex *cursorPt = makeVertex(m.x, m.y);
+                struct Vertex *cursorPt = makeScratchVertex(m.x, m.y);
                 getRealPosition(cursorPt);
                 struct LinkedNode *node = findNode(list, cursorPt, findRule);
-                destroyVertex(cursorPt);
 
                 if (node != NULL) {
                     // Edit selected element
@@ -200,7 +205,8 @@ int selectionMode(struct LinkedList *list) {
 int drawMode(struct LinkedList *list, int shapeType) {
     assert(list != NULL);
     while (true) {
-        mouse_msg m = getmouse();
+        mouse_msg m = nextMouseMsg();
+        resetScratch();
 
         // Only left key clicking down matters
         if (!m.is_left() || !m.is_down()) {
@@ -218,7 +224,7 @@ int drawMode(struct LinkedList *list, int shapeType) {
         } else if (cntArea == AREA_CANVAS) {
             // When user clicked left button in canvas area,
             // start to trace cursor
-            struct Vertex *startPt = makeVertex(m.x, m.y);
+            struct Vertex *startPt = makeScratchVertex(m.x, m.y);
             getRealPosition(startPt);
             struct Vertex *endPt = trackEndPt(list, startPt, shapeType, SHAPE_DEFAULT_COLOR, SHAPE_DEFAULT_COLOR);
 
@@ -232,7 +238,8 @@ int drawMode(struct LinkedList *list, int shapeType) {
 int textMode(struct LinkedList *list) {
     assert(list != NULL);
     while (true) {
-        mouse_msg m = getmouse();
+        mouse_msg m = nextMouseMsg();
+        resetScratch();
         // Only left key clicking down matters
         if (!m.is_left() || !m.is_down()) {
             continue;
@@ -246,25 +253,25 @@ int textMode(struct LinkedList *list) {
                 return cntButtonId == nextButtonId ? BUTTON_NON_ACTIVE : nextButtonId;
             }
         } else if (cntArea == AREA_CANVAS) {
-            struct Vertex *startPt = makeVertex(m.x, m.y);
+            struct Vertex *startPt = makeScratchVertex(m.x, m.y);
             getRealPosition(startPt);
 
             // Prompt user for inputing text
-            char *content = (char *)malloc(sizeof(char) * DATATYPE_TEXT_MAX_LENGTH);
+            char content[DATATYPE_TEXT_MAX_LENGTH] = "";
+            bool isEntered = true;
             setViewPort(AREA_ALL);
             while (inputbox_getline((char *)"Add Text",
                                     (char *)"Please leave something here and press ENTER.\nLeave it blank to exit...",
                                     content, DATATYPE_TEXT_MAX_LENGTH) == 0) {
                 if (strlen(content) == 0) {
-                    free(content);
-                    content = NULL;
+                    isEntered = false;
                     break;
                 }
             }
             setViewPort(AREA_CANVAS);
 
-            // Save text
-            if (content != NULL) {
+            // Save text, the list keeps its own copy
+            if (isEntered) {
                 struct Vertex *endPt = getTextEndPt(startPt, content, &defaultFont);
                 drawText(startPt, endPt, content, &defaultFont, SHAPE_DEFAULT_COLOR, CANVAS_COLOR);
                 saveText(list, startPt, endPt, content, defaultFont.lfWidth, defaultFont.lfHeight);
@@ -275,13 +282,108 @@ int textMode(struct LinkedList *list) {
     return cntButtonId;
 }
 
-int main()
+// Returns true if there is a file at path, even one that cannot be read
+static bool isFileExisting(const char *path) {
+    errno = 0;
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return errno != ENOENT;
+    }
+    fclose(file);
+    return true;
+}
+
+int main(int argc, char *argv[])
 {
     init();
 
     struct LinkedList list;
     initLinkedList(&list);
 
+    // A drawing given on the command line is opened, and saved back on exit
+    // DXF files are exchanged with other tools, anything else is in the native format
+    // An SVG or PDF path may follow, the drawing is also exported there on exit
+    const char *path = argc > 1 ? argv[1] : NULL;
+    const char *exportPath = argc > 2 ? argv[2] : NULL;
+    size_t pathLength = path == NULL ? 0 : strlen(path);
+    bool isDxf = pathLength > 4 && (strcmp(path + pathLength - 4, ".dxf") == 0 || strcmp(path + pathLength - 4, ".DXF") == 0);
+    struct DrawFile *file = path == NULL || isDxf ? NULL : openDrawFile(path);
+    // A drawing that is there but could not be loaded is never saved over
+    bool isLoadFailed = !isDxf && path != NULL && file == NULL && isFileExisting(path);
+    if (file != NULL && !loadDrawFile(&list, file)) {
+        destroyLinkedList(&list, destroyRule);
+        isLoadFailed = true;
+    }
+    // Nor is a DXF file with entities the list cannot hold, saving would drop them
+    struct DxfStats dxfStats = {0, 0};
+    if (isDxf && !importDxf(&list, path, screenHeight, &dxfStats) && isFileExisting(path)) {
+        isLoadFailed = true;
+    }
+    if (isLoadFailed) {
+        fprintf(stderr, "main: %s could not be loaded, it will be left as it is\n", path);
+    } else if (dxfStats.skippedNum > 0) {
+        fprintf(stderr, "main: %d entities of %s were skipped, it will be left as it is\n", dxfStats.skippedNum, path);
+    }
+    bool isKept = isLoadFailed || dxfStats.skippedNum > 0;
+    // The drawing is saved on exit only if it changes from here on
+    unsigned int loadedVersion = list.version;
+
+    // A journal left behind means the last session crashed, it holds newer shapes than the drawing
+    char journalPath[FILENAME_MAX];
+    bool hasJournal = path != NULL && snprintf(journalPath, sizeof(journalPath), "%s.journal", path) < (int)sizeof(journalPath);
+    struct JournalStats journalStats;
+    bool isRecovered = hasJournal && recoverJournal(&list, journalPath, &journalStats);
+    if (isRecovered) {
+        fprintf(stderr, "main: recovered %d shapes and %d later changes from %s%s\n", journalStats.snapshotNum,
+                journalStats.replayedNum, journalPath, journalStats.isTorn ? ", its last record was torn" : "");
+    }
+    // The drawing is the only list from now on, clearing it or closing it gives all of its memory back at once
+    claimDocumentRegion(&list);
+
+    // Redraws stream over a flat copy of the shapes, taken straight from the mapped file if any.
+    // It answers picks first, running its hit test kernels over the shapes the R-tree finds near the cursor
+    struct ShapeStore *store = makeShapeStore();
+    if (store != NULL) {
+        bool isBuilt = file != NULL && !isRecovered && list.listSize > 0 ? mapShapeStore(store, file, &list)
+                                                                         : buildShapeStore(store, &list);
+        if (isBuilt) {
+            attachIndex(&list, &store -> index);
+        } else {
+            destroyShapeStore(store);
+            store = NULL;
+        }
+    }
+    // Picking goes through the R-tree instead of walking the whole list, alone while the store is missing or broken
+    struct RTree *tree = makeRTree();
+    if (tree != NULL) {
+        buildRTree(tree, &list);
+        attachIndex(&list, &tree -> index);
+        if (store != NULL) {
+            store -> tree = tree;
+        }
+    }
+    // Every change from now on is journaled in the background until the drawing is saved
+    struct Journal *journal = hasJournal ? openJournal(&list, journalPath) : NULL;
+    // Every change from now on can be undone, the history keeps what it needs instead of copying it
+    struct UndoHistory *history = makeUndoHistory(&list, destroyRule);
+    // The background layer is rasterized on every hardware thread, drawn through EGE if they cannot start
+    struct TileRenderer *tileRenderer = makeTileRenderer(0);
+    setLayerRenderer(tileRenderer);
+    redrawAll(&list, SHAPE_DEFAULT_COLOR, false);
+    // Mouse messages go to CADET_INPUT_LOG if set, so that the session can be replayed headless by bench/replay_bench.cpp
+    const char *inputLogPath = getenv("CADET_INPUT_LOG");
+    bool isRecording = inputLogPath != NULL && startInputRecording(inputLogPath);
+    if (inputLogPath != NULL && !isRecording) {
+        fprintf(stderr, "main: mouse messages cannot be recorded to %s\n", inputLogPath);
+    }
+    // Tracking loops redraw at most CADET_TRACKING_FPS times per second if set, 0 lifts the cap
+    const char *trackingFps = getenv("CADET_TRACKING_FPS");
+    if (trackingFps != NULL) {
+        setTrackingFps(max(atoi(trackingFps), 0));
+    }
+    // A slow redraw must not hold mouse messages up, moves piling up meanwhile are answered by one redraw
+    startInputQueue();
+
     cntButtonId = BUTTON_NON_ACTIVE;
 
     while (cntButtonId != BUTTON_TYPE_EXIT && cntButtonId >= 0) {
@@ -314,11 +416,23 @@ int main()
             }
             case BUTTON_TYPE_CLEAR: {
                 destroyLinkedList(&list, destroyRule);
-                initLinkedList(&list);
                 clearCanvas();
                 nextButtonId = BUTTON_NON_ACTIVE;
                 break;
             }
+            case BUTTON_TYPE_UNDO:
+            case BUTTON_TYPE_REDO: {
+                if (history != NULL) {
+                    if (cntButtonId == BUTTON_TYPE_UNDO) {
+                        undoChange(history, &list);
+                    } else {
+                        redoChange(history, &list);
+                    }
+                    redrawAll(&list, SHAPE_DEFAULT_COLOR, false);
+                }
+                nextButtonId = BUTTON_NON_ACTIVE;
+                break;
+            }
             default: {
                 nextButtonId = -1;
                 break;
@@ -334,8 +448,87 @@ int main()
         cntButtonId = nextButtonId;
     }
 
+    // Debugging aids, each behind its own variable
+    struct InputStats inputStats;
+    if (getenv("CADET_INPUT_STATS") != NULL && getMouseStats(&inputStats)) {
+        fprintf(stderr, "main: %lld mouse messages, %lld coalesced, %lld dropped, %d queued at most\n",
+                inputStats.readNum, inputStats.coalescedNum, inputStats.droppedNum, inputStats.maxQueuedNum);
+    }
+    struct FrameStats frameStats = getFrameStats();
+    if (getenv("CADET_FRAME_STATS") != NULL && frameStats.frameNum > 0) {
+        fprintf(stderr, "main: %d tracking frames for %lld coalesced moves, %.2f ms on average, %.2f ms at most\n",
+                frameStats.frameNum, frameStats.coalescedNum, frameStats.totalMs / frameStats.frameNum, frameStats.maxMs);
+    }
+    // Blocks of the scratch arenas should stop growing after the first interactions, CADET_ARENA_STATS shows them
+    if (getenv("CADET_ARENA_STATS") != NULL) {
+        printArenaStats(stderr);
+    }
+    stopInputQueue();
+    if (isRecording && !stopInputRecording()) {
+        fprintf(stderr, "main: the input log of this session is incomplete\n");
+    }
+
+    // The mapped file cannot be replaced while open, so the drawing goes to a side file first
+    bool isChanged = list.version != loadedVersion;
+    char savePath[FILENAME_MAX];
+    bool isSaved = path != NULL && isChanged && snprintf(savePath, sizeof(savePath), "%s.tmp", path) < (int)sizeof(savePath) &&
+                   (isDxf ? exportDxf(&list, savePath, screenHeight) : saveDrawFile(&list, savePath));
+    if (exportPath != NULL) {
+        switch (getVectorFormat(exportPath)) {
+            case VECTOR_FORMAT_SVG: {
+                exportSvg(&list, exportPath, screenWidth, screenHeight, SHAPE_DEFAULT_COLOR, CANVAS_COLOR);
+                break;
+            }
+            case VECTOR_FORMAT_PDF: {
+                exportPdf(&list, exportPath, screenWidth, screenHeight, SHAPE_DEFAULT_COLOR, CANVAS_COLOR);
+                break;
+            }
+            default: {
+                fprintf(stderr, "main: %s is neither .svg nor .pdf\n", exportPath);
+                break;
+            }
+        }
+    }
+
+    // Closed before the shapes are torn down, which must not be journaled nor kept for undo
+    if (journal != NULL && !closeJournal(journal, &list)) {
+        fprintf(stderr, "main: the journal of this session is incomplete\n");
+    }
+    if (history != NULL) {
+        destroyUndoHistory(history, &list);
+    }
+
     cleardevice();
+    releaseBackgroundLayer();
+    if (tileRenderer != NULL) {
+        setLayerRenderer(NULL);
+        destroyTileRenderer(tileRenderer);
+    }
     destroyLinkedList(&list, destroyRule);
+    if (tree != NULL) {
+        detachIndex(&list, &tree -> index);
+        destroyRTree(tree);
+    }
+    if (store != NULL) {
+        detachIndex(&list, &store -> index);
+        destroyShapeStore(store);
+    }
+    if (file != NULL) {
+        closeDrawFile(file);
+    }
+    // The journal goes only once the drawing is safely in place, or when there was nothing to save
+    if (isSaved && isKept) {
+        fprintf(stderr, "main: %s was left as it is, this session is in %s\n", path, savePath);
+    } else if (isSaved) {
+        errno = 0;
+        if (!replaceFile(savePath, path)) {
+            perror("main");
+        } else if (journal != NULL) {
+            remove(journalPath);
+        }
+    } else if (!isChanged && journal != NULL) {
+        remove(journalPath);
+    }
     closegraph();
     return 0;
 }
@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#include "arena.h"
+
+// Block header is rounded up so that the bytes after it stay aligned
+#define ARENA_HEADER_SIZE ((sizeof(struct ArenaBlock) + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT)
+
+static struct Arena *arenaListHead = NULL;
+
+static void registerArena(struct Arena *arena) {
+    if (!arena -> isRegistered) {
+        arena -> isRegistered = true;
+        arena -> nextArena = arenaListHead;
+        arenaListHead = arena;
+    }
+}
+
+static size_t alignSize(size_t size) {
+    return (size + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+}
+
+// Move on to the next kept block holding size bytes, or add one after the current block
+// Returns false with errno set if out of memory
+static bool nextBlock(struct Arena *arena, size_t size) {
+    struct ArenaBlock *block = arena -> cntBlock == NULL ? arena -> blocks : arena -> cntBlock -> next;
+    while (block != NULL && block -> size < size) {
+        block = block -> next;
+    }
+
+    if (block == NULL) {
+        size_t blockSize = max(arena -> blockSize, size);
+        errno = 0;
+        block = (struct ArenaBlock *)malloc(ARENA_HEADER_SIZE + blockSize);
+        if (block == NULL) {
+            return false;
+        }
+        block -> size = blockSize;
+        if (arena -> cntBlock == NULL) {
+            block -> next = arena -> blocks;
+            arena -> blocks = block;
+        } else {
+            block -> next = arena -> cntBlock -> next;
+            arena -> cntBlock -> next = block;
+        }
+        arena -> blockNum++;
+        arena -> reservedBytes += blockSize;
+    }
+
+    arena -> cntBlock = block;
+    arena -> bumpPtr = (char *)block + ARENA_HEADER_SIZE;
+    arena -> bumpLeft = block -> size;
+    return true;
+}
+
+// Complexity: O(1) amortized
+void * arenaAlloc(struct Arena *arena, size_t size) {
+    assert(arena != NULL);
+    registerArena(arena);
+    size = alignSize(max(size, (size_t)1));
+    if (size > arena -> bumpLeft && !nextBlock(arena, size)) {
+        return NULL;
+    }
+
+    void *res = arena -> bumpPtr;
+    arena -> bumpPtr += size;
+    arena -> bumpLeft -= size;
+    arena -> lastPtr = res;
+
+    arena -> allocNum++;
+    arena -> usedBytes += size;
+    arena -> peakBytes = max(arena -> peakBytes, arena -> usedBytes);
+    return res;
+}
+
+// Complexity: O(1) in place, O(oldSize) otherwise
+void * arenaRealloc(struct Arena *arena, void *ptr, size_t oldSize, size_t newSize) {
+    assert(arena != NULL);
+    if (ptr == NULL) {
+        return arenaAlloc(arena, newSize);
+    }
+    size_t oldAligned = alignSize(max(oldSize, (size_t)1)), newAligned = alignSize(max(newSize, (size_t)1));
+    if (newAligned <= oldAligned) {
+        return ptr;
+    }
+    if (ptr == arena -> lastPtr && newAligned - oldAligned <= arena -> bumpLeft) {
+        arena -> bumpPtr += newAligned - oldAligned;
+        arena -> bumpLeft -= newAligned - oldAligned;
+        arena -> usedBytes += newAligned - oldAligned;
+        arena -> peakBytes = max(arena -> peakBytes, arena -> usedBytes);
+        return ptr;
+    }
+
+    void *res = arenaAlloc(arena, newSize);
+    if (res != NULL) {
+        memcpy(res, ptr, oldSize);
+    }
+    return res;
+}
+
+// Complexity: O(1)
+void resetArena(struct Arena *arena) {
+    assert(arena != NULL);
+    arena -> cntBlock = NULL;
+    arena -> bumpPtr = NULL;
+    arena -> bumpLeft = 0;
+    arena -> lastPtr = NULL;
+    arena -> usedBytes = 0;
+    arena -> resetNum++;
+}
+
+void destroyArena(struct Arena *arena) {
+    assert(arena != NULL);
+    while (arena -> blocks != NULL) {
+        struct ArenaBlock *delBlock = arena -> blocks;
+        arena -> blocks = delBlock -> next;
+        free(delBlock);
+    }
+    arena -> cntBlock = NULL;
+    arena -> bumpPtr = NULL;
+    arena -> bumpLeft = 0;
+    arena -> lastPtr = NULL;
+    arena -> usedBytes = 0;
+    arena -> blockNum = 0;
+    arena -> reservedBytes = 0;
+}
+
+void getArenaStats(const struct Arena *arena, struct ArenaStats *stats) {
+    assert(arena != NULL && stats != NULL);
+    stats -> allocNum = arena -> allocNum;
+    stats -> resetNum = arena -> resetNum;
+    stats -> blockNum = arena -> blockNum;
+    stats -> usedBytes = arena -> usedBytes;
+    stats -> peakBytes = arena -> peakBytes;
+    stats -> reservedBytes = arena -> reservedBytes;
+}
+
+void printArenaStats(FILE *fp) {
+    assert(fp != NULL);
+    fprintf(fp, "%-12s %14s %12s %12s %12s %14s %8s\n",
+            "arena", "allocs", "resets", "used_bytes", "peak_bytes", "reserved_bytes", "blocks");
+    for (struct Arena *cntArena = arenaListHead; cntArena != NULL; cntArena = cntArena -> nextArena) {
+        struct ArenaStats stats;
+        getArenaStats(cntArena, &stats);
+        fprintf(fp, "%-12s %14lld %12lld %12lld %12lld %14lld %8lld\n",
+                cntArena -> name, stats.allocNum, stats.resetNum, (long long int)stats.usedBytes,
+                (long long int)stats.peakBytes, (long long int)stats.reservedBytes, stats.blockNum);
+    }
+}
@@ -0,0 +1,236 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <errno.h>
+
+#include "damage.h"
+#include "datatypes.h"
+#include "rtree.h"
+
+struct NodeArray {
+    int size, capacity;
+    struct LinkedNode **nodes;
+    bool isFailed;
+    // Grown in it instead of the heap when not NULL
+    struct Arena *arena;
+};
+
+static long long int getBoxArea(const struct BoundingBox *box) {
+    return ((long long int)box -> maxx - box -> minx + 1) * ((long long int)box -> maxy - box -> miny + 1);
+}
+
+static void mergeBox(struct BoundingBox *dst, const struct BoundingBox *src) {
+    dst -> minx = min(dst -> minx, src -> minx);
+    dst -> miny = min(dst -> miny, src -> miny);
+    dst -> maxx = max(dst -> maxx, src -> maxx);
+    dst -> maxy = max(dst -> maxy, src -> maxy);
+}
+
+void initDamage(struct Damage *damage) {
+    assert(damage != NULL);
+    damage -> rectNum = 0;
+}
+
+// Complexity: O(DAMAGE_MAX_RECTS ^ 2)
+static void addRect(struct Damage *damage, struct BoundingBox cntBox) {
+    while (true) {
+        // Swallow every rectangle the new one overlaps, until nothing changes
+        bool isMerged = true;
+        while (isMerged) {
+            isMerged = false;
+            for (int i = 0; i < damage -> rectNum; i++) {
+                if (isBoxIntersected(&cntBox, &damage -> rects[i])) {
+                    mergeBox(&cntBox, &damage -> rects[i]);
+                    damage -> rects[i] = damage -> rects[--damage -> rectNum];
+                    isMerged = true;
+                    break;
+                }
+            }
+        }
+
+        if (damage -> rectNum < DAMAGE_MAX_RECTS) {
+            damage -> rects[damage -> rectNum++] = cntBox;
+            return;
+        }
+
+        // Out of room, merge with the rectangle that grows least and try again
+        int bestId = 0;
+        long long int bestGrowth = -1;
+        for (int i = 0; i < damage -> rectNum; i++) {
+            struct BoundingBox unionBox = damage -> rects[i];
+            mergeBox(&unionBox, &cntBox);
+            long long int growth = getBoxArea(&unionBox) - getBoxArea(&damage -> rects[i]);
+            if (bestGrowth == -1 || growth < bestGrowth) {
+                bestId = i;
+                bestGrowth = growth;
+            }
+        }
+        mergeBox(&cntBox, &damage -> rects[bestId]);
+        damage -> rects[bestId] = damage -> rects[--damage -> rectNum];
+    }
+}
+
+void addDamage(struct Damage *damage, const struct BoundingBox *box) {
+    assert(damage != NULL && box != NULL);
+    struct BoundingBox cntBox = {
+        box -> minx - DAMAGE_MARGIN, box -> miny - DAMAGE_MARGIN,
+        box -> maxx + DAMAGE_MARGIN, box -> maxy + DAMAGE_MARGIN
+    };
+    addRect(damage, cntBox);
+}
+
+void clipDamage(struct Damage *damage, const struct BoundingBox *bounds) {
+    assert(damage != NULL && bounds != NULL);
+    int cntNum = 0;
+    for (int i = 0; i < damage -> rectNum; i++) {
+        struct BoundingBox *cntRect = &damage -> rects[i];
+        if (!isBoxIntersected(cntRect, bounds)) {
+            continue;
+        }
+        cntRect -> minx = max(cntRect -> minx, bounds -> minx);
+        cntRect -> miny = max(cntRect -> miny, bounds -> miny);
+        cntRect -> maxx = min(cntRect -> maxx, bounds -> maxx);
+        cntRect -> maxy = min(cntRect -> maxy, bounds -> maxy);
+        damage -> rects[cntNum++] = *cntRect;
+    }
+    damage -> rectNum = cntNum;
+}
+
+bool isDamaged(const struct Damage *damage, const struct BoundingBox *box) {
+    assert(damage != NULL && box != NULL);
+    for (int i = 0; i < damage -> rectNum; i++) {
+        if (isBoxIntersected(&damage -> rects[i], box)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void pushNode(struct LinkedNode *node, void *arg) {
+    struct NodeArray *arr = (struct NodeArray *)arg;
+    if (arr -> isFailed) {
+        return;
+    }
+    if (arr -> size == arr -> capacity) {
+        int newCapacity = arr -> capacity == 0 ? 64 : arr -> capacity * 2;
+        errno = 0;
+        struct LinkedNode **newNodes = (struct LinkedNode **)(arr -> arena != NULL
+            ? arenaRealloc(arr -> arena, arr -> nodes, sizeof(struct LinkedNode *) * arr -> capacity, sizeof(struct LinkedNode *) * newCapacity)
+            : realloc(arr -> nodes, sizeof(struct LinkedNode *) * newCapacity));
+        if (newNodes == NULL) {
+            perror("pushNode");
+            arr -> isFailed = true;
+            return;
+        }
+        arr -> nodes = newNodes;
+        arr -> capacity = newCapacity;
+    }
+    arr -> nodes[arr -> size++] = node;
+}
+
+// Sift nodes[root] down the heap of the first size nodes, the highest rank on top
+static void siftDown(struct LinkedNode **nodes, int root, int size) {
+    struct LinkedNode *rootNode = nodes[root];
+    while (root * 2 + 1 < size) {
+        int child = root * 2 + 1;
+        if (child + 1 < size && nodes[child + 1] -> rank > nodes[child] -> rank) {
+            child++;
+        }
+        if (nodes[child] -> rank <= rootNode -> rank) {
+            break;
+        }
+        nodes[root] = nodes[child];
+        root = child;
+    }
+    nodes[root] = rootNode;
+}
+
+// Sort nodes into list order in place, by heapsort, as qsort() may take a buffer from the heap
+// Complexity: O(n log n)
+static void sortByRank(struct LinkedNode **nodes, int size) {
+    for (int i = size / 2 - 1; i >= 0; i--) {
+        siftDown(nodes, i, size);
+    }
+    for (int i = size - 1; i > 0; i--) {
+        struct LinkedNode *topNode = nodes[0];
+        nodes[0] = nodes[i];
+        nodes[i] = topNode;
+        siftDown(nodes, 0, i);
+    }
+}
+
+// Refill arr with the nodes crossing box, keeping its room
+// Complexity: O(k log k) with an RTree, O(n) otherwise
+static void collectNodesInBox(const struct LinkedList *list, const struct BoundingBox *box, struct NodeArray *arr) {
+    arr -> size = 0;
+    arr -> isFailed = false;
+
+    // A broken tree may miss nodes, walking finds them all
+    struct ListIndex *treeIndex = findListIndex(list, LIST_INDEX_RTREE);
+    if (treeIndex != NULL && !((struct RTree *)treeIndex -> impl) -> isBroken) {
+        searchRTree((struct RTree *)treeIndex -> impl, box, pushNode, arr);
+        if (arr -> size > 1) {
+            sortByRank(arr -> nodes, arr -> size);
+        }
+    } else {
+        for (struct LinkedNode *cntNode = list -> head; cntNode != NULL; cntNode = cntNode -> next) {
+            if (cntNode -> data != NULL && isBoxIntersected(&cntNode -> box, box)) {
+                pushNode(cntNode, arr);
+            }
+        }
+    }
+}
+
+struct LinkedNode ** getNodesInBox(const struct LinkedList *list, const struct BoundingBox *box, int *nodeNum) {
+    assert(list != NULL && box != NULL && nodeNum != NULL);
+    struct NodeArray arr = {0, 0, NULL, false, NULL};
+    collectNodesInBox(list, box, &arr);
+
+    if (arr.isFailed) {
+        free(arr.nodes);
+        *nodeNum = 0;
+        return NULL;
+    }
+    *nodeNum = arr.size;
+    return arr.nodes;
+}
+
+void repaintDamage(const struct LinkedList *list, const struct Damage *damage, const struct DamagePainter *painter) {
+    assert(list != NULL && damage != NULL && painter != NULL);
+    // One array serves every rectangle
+    struct NodeArray arr = {0, 0, NULL, false, painter -> scratch};
+    for (int i = 0; i < damage -> rectNum; i++) {
+        const struct BoundingBox *cntRect = &damage -> rects[i];
+        painter -> clipFunc(painter -> impl, cntRect);
+        painter -> clearFunc(painter -> impl, cntRect);
+
+        if (painter -> drawFunc != NULL) {
+            // Shapes may spill DAMAGE_MARGIN pixels out of their box
+            struct BoundingBox queryBox = {
+                cntRect -> minx - DAMAGE_MARGIN, cntRect -> miny - DAMAGE_MARGIN,
+                cntRect -> maxx + DAMAGE_MARGIN, cntRect -> maxy + DAMAGE_MARGIN
+            };
+            collectNodesInBox(list, &queryBox, &arr);
+            if (!arr.isFailed) {
+                for (int j = 0; j < arr.size; j++) {
+                    painter -> drawFunc(painter -> impl, arr.nodes[j] -> data);
+                }
+            } else {
+                // The rectangle is cleared already, walking the list draws it whole without memory
+                for (struct LinkedNode *cntNode = list -> head; cntNode != NULL; cntNode = cntNode -> next) {
+                    if (cntNode -> data != NULL && isBoxIntersected(&cntNode -> box, &queryBox)) {
+                        painter -> drawFunc(painter -> impl, cntNode -> data);
+                    }
+                }
+            }
+        }
+
+        if (painter -> overlayFunc != NULL) {
+            painter -> overlayFunc(painter -> impl);
+        }
+        painter -> clipFunc(painter -> impl, NULL);
+    }
+    if (arr.arena == NULL) {
+        free(arr.nodes);
+    }
+}
@@ -1,11 +1,39 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <assert.h>
 #include <errno.h>
 
 #include "datatypes.h"
 #include "distance.h"
+#include "pool.h"
+
+static struct Pool vertexPool = POOL_MEMBER_INITIALIZER("Vertex", struct Vertex, &documentRegion);
+static struct Pool segmentPool = POOL_MEMBER_INITIALIZER("Segment", struct Segment, &documentRegion);
+static struct Pool rectanglePool = POOL_MEMBER_INITIALIZER("Rectangle", struct Rectangle, &documentRegion);
+static struct Pool circlePool = POOL_MEMBER_INITIALIZER("Circle", struct Circle, &documentRegion);
+static struct Pool ellipsePool = POOL_MEMBER_INITIALIZER("Ellipse", struct Ellipse, &documentRegion);
+static struct Pool textPool = POOL_MEMBER_INITIALIZER("Text", struct Text, &documentRegion);
+
+// Text contents are copied into classes of doubling sizes, the largest one holding DATATYPE_TEXT_MAX_LENGTH characters
+#define TEXT_CONTENT_CLASS_NUM 5
+#define TEXT_CONTENT_MIN_SIZE 16
+static struct Pool contentPools[TEXT_CONTENT_CLASS_NUM] = {
+    POOL_MEMBER_INITIALIZER("Content16", char[16], &documentRegion),
+    POOL_MEMBER_INITIALIZER("Content32", char[32], &documentRegion),
+    POOL_MEMBER_INITIALIZER("Content64", char[64], &documentRegion),
+    POOL_MEMBER_INITIALIZER("Content128", char[128], &documentRegion),
+    POOL_MEMBER_INITIALIZER("Content256", char[DATATYPE_TEXT_MAX_LENGTH + 1], &documentRegion)
+};
+
+static struct Pool * getContentPool(size_t size) {
+    int contentClass = 0;
+    while (contentClass < TEXT_CONTENT_CLASS_NUM - 1 && (size_t)TEXT_CONTENT_MIN_SIZE << contentClass < size) {
+        contentClass++;
+    }
+    return &contentPools[contentClass];
+}
 
 bool validateDataType(int dataType) {
     return dataType >= DATATYPE_RANGE_MIN && dataType <= DATATYPE_RANGE_MAX;
@@ -13,9 +41,8 @@ bool validateDataType(int dataType) {
 
 struct Vertex * makeVertex(int newx, int newy) {
     errno = 0;
-    struct Vertex *newVtx = (struct Vertex *)malloc(sizeof(struct Vertex));
+    struct Vertex *newVtx = (struct Vertex *)poolAlloc(&vertexPool);
     if (newVtx == NULL) {
-        free(newVtx);
         perror("makeVertex");
         return NULL;
     }
@@ -26,7 +53,7 @@ struct Vertex * makeVertex(int newx, int newy) {
 
 void destroyVertex(struct Vertex *vtx) {
     assert(vtx != NULL);
-    free(vtx);
+    poolFree(&vertexPool, vtx);
     vtx = NULL;
 }
 
@@ -38,9 +65,8 @@ bool findVertexRule(const struct Vertex *cursorPt, const struct Vertex *vtx) {
 struct Segment * makeSegment(struct Vertex *newLeftPt, struct Vertex *newRightPt) {
     assert(newLeftPt != NULL && newRightPt != NULL);
     errno = 0;
-    struct Segment *newSeg = (struct Segment *)malloc(sizeof(struct Segment));
+    struct Segment *newSeg = (struct Segment *)poolAlloc(&segmentPool);
     if (newSeg == NULL) {
-        free(newSeg);
         perror("makeSegment");
         return NULL;
     }
@@ -58,40 +84,44 @@ struct Segment * makeSegment(struct Vertex *newLeftPt, struct Vertex *newRightPt
 
 void destroySegment(struct Segment *seg) {
     assert(seg != NULL);
-    free(seg -> leftPt);
+    destroyVertex(seg -> leftPt);
     seg -> leftPt = NULL;
-    free(seg -> rightPt);
+    destroyVertex(seg -> rightPt);
     seg -> rightPt = NULL;
-    free(seg);
+    poolFree(&segmentPool, seg);
     seg = NULL;
 }
 
-bool findSegmentRule(const struct Vertex *cursorPt, const struct Segment *seg) {
-    assert(cursorPt != NULL && seg != NULL);
-
-    if (cursorPt -> x < seg -> leftPt -> x - FINDRULE_VARIATION ||
-        cursorPt -> x > seg -> rightPt -> x + FINDRULE_VARIATION ||
-        cursorPt -> y < min(seg -> leftPt -> y, seg -> rightPt-> y) - FINDRULE_VARIATION ||
-        cursorPt -> y > max(seg -> leftPt -> y, seg -> rightPt-> y) + FINDRULE_VARIATION) {
+bool isNearSegment(int x, int y, int leftx, int lefty, int rightx, int righty) {
+    if (x < leftx - FINDRULE_VARIATION ||
+        x > rightx + FINDRULE_VARIATION ||
+        y < min(lefty, righty) - FINDRULE_VARIATION ||
+        y > max(lefty, righty) + FINDRULE_VARIATION) {
             return false;
     }
 
-    long long int leftVal = ((long long int)seg -> leftPt -> y - seg -> rightPt -> y) * cursorPt -> x
-                        + ((long long int)seg -> rightPt -> x - seg -> leftPt -> x) * cursorPt -> y
-                        + ((long long int)seg -> leftPt -> x * seg -> rightPt -> y - (long long int)seg -> rightPt -> x * seg -> leftPt -> y);
+    long long int leftVal = ((long long int)lefty - righty) * x
+                        + ((long long int)rightx - leftx) * y
+                        + ((long long int)leftx * righty - (long long int)rightx * lefty);
     leftVal *= leftVal;
 
-    long long int rightVal = quickPow(FINDRULE_VARIATION, 2) * (quickPow(seg -> leftPt -> x - seg -> rightPt -> x, 2) + quickPow(seg -> leftPt -> y - seg -> rightPt -> y, 2));
+    long long int dx = (long long int)leftx - rightx, dy = (long long int)lefty - righty;
+    long long int rightVal = (long long int)FINDRULE_VARIATION * FINDRULE_VARIATION * (dx * dx + dy * dy);
 
     return leftVal <= rightVal;
 }
 
+bool findSegmentRule(const struct Vertex *cursorPt, const struct Segment *seg) {
+    assert(cursorPt != NULL && seg != NULL);
+    return isNearSegment(cursorPt -> x, cursorPt -> y, seg -> leftPt -> x, seg -> leftPt -> y,
+                         seg -> rightPt -> x, seg -> rightPt -> y);
+}
+
 struct Rectangle * makeRectangle(struct Vertex *newLowerLeftPt, struct Vertex *newUpperRightPt) {
     assert(newLowerLeftPt != NULL && newUpperRightPt != NULL);
     errno = 0;
-    struct Rectangle *newRec = (struct Rectangle *)malloc(sizeof(struct Rectangle));
+    struct Rectangle *newRec = (struct Rectangle *)poolAlloc(&rectanglePool);
     if (newRec == NULL) {
-        free(newRec);
         perror("makeRectangle");
         return NULL;
     }
@@ -113,30 +143,34 @@ struct Rectangle * makeRectangle(struct Vertex *newLowerLeftPt, struct Vertex *n
 
 void destroyRectangle(struct Rectangle *rec) {
     assert(rec != NULL);
-    free(rec -> lowerLeftPt);
+    destroyVertex(rec -> lowerLeftPt);
     rec -> lowerLeftPt = NULL;
-    free(rec -> upperRightPt);
+    destroyVertex(rec -> upperRightPt);
     rec -> upperRightPt = NULL;
-    free(rec);
+    poolFree(&rectanglePool, rec);
     rec = NULL;
 }
 
-bool findRectangleRule(const struct Vertex *cursorPt, const struct Rectangle *rec) {
-    assert(cursorPt != NULL && rec != NULL);
+bool isNearRectangle(int x, int y, int minx, int miny, int maxx, int maxy) {
     return (
-        cursorPt -> x >= rec -> lowerLeftPt -> x - FINDRULE_VARIATION &&
-        cursorPt -> x <= rec -> upperRightPt-> x + FINDRULE_VARIATION &&
-        cursorPt -> y >= rec -> lowerLeftPt -> y - FINDRULE_VARIATION &&
-        cursorPt -> y <= rec -> upperRightPt-> y + FINDRULE_VARIATION
+        x >= minx - FINDRULE_VARIATION &&
+        x <= maxx + FINDRULE_VARIATION &&
+        y >= miny - FINDRULE_VARIATION &&
+        y <= maxy + FINDRULE_VARIATION
     );
 }
 
+bool findRectangleRule(const struct Vertex *cursorPt, const struct Rectangle *rec) {
+    assert(cursorPt != NULL && rec != NULL);
+    return isNearRectangle(cursorPt -> x, cursorPt -> y, rec -> lowerLeftPt -> x, rec -> lowerLeftPt -> y,
+                           rec -> upperRightPt -> x, rec -> upperRightPt -> y);
+}
+
 struct Circle * makeCircle(struct Vertex *newCenterPt, int newRadius) {
     assert(newCenterPt != NULL);
     errno = 0;
-    struct Circle *newCir = (struct Circle *)malloc(sizeof(struct Circle));
+    struct Circle *newCir = (struct Circle *)poolAlloc(&circlePool);
     if (newCir == NULL) {
-        free(newCir);
         perror("makeCircle");
         return NULL;
     }
@@ -147,23 +181,28 @@ struct Circle * makeCircle(struct Vertex *newCenterPt, int newRadius) {
 
 void destoryCircle(struct Circle *cir) {
     assert(cir != NULL);
-    free(cir -> centerPt);
+    destroyVertex(cir -> centerPt);
     cir -> centerPt = NULL;
-    free(cir);
+    poolFree(&circlePool, cir);
     cir = NULL;
 }
 
+bool isNearCircle(int x, int y, int centerx, int centery, int radius) {
+    long long int dx = (long long int)centerx - x, dy = (long long int)centery - y;
+    long long int maxDist = (long long int)radius + FINDRULE_VARIATION;
+    return dx * dx + dy * dy <= maxDist * maxDist;
+}
+
 bool findCircleRule(const struct Vertex *cursorPt, const struct Circle *cir) {
     assert(cursorPt != NULL && cir != NULL);
-    return getSqrEuclideanDistance(cir -> centerPt, cursorPt) <= quickPow(cir -> radius + FINDRULE_VARIATION, 2);
+    return isNearCircle(cursorPt -> x, cursorPt -> y, cir -> centerPt -> x, cir -> centerPt -> y, cir -> radius);
 }
 
 struct Ellipse * makeEllipse(struct Vertex *newCenterPt, int newMajorSemiAxis, int newMinorSemiAxis) {
     assert(newCenterPt != NULL);
     errno = 0;
-    struct Ellipse *newElp = (struct Ellipse *)malloc(sizeof(struct Ellipse));
+    struct Ellipse *newElp = (struct Ellipse *)poolAlloc(&ellipsePool);
     if (newElp == NULL) {
-        free(newElp);
         perror("makeEllipse");
         return NULL;
     }
@@ -175,36 +214,50 @@ struct Ellipse * makeEllipse(struct Vertex *newCenterPt, int newMajorSemiAxis, i
 
 void destroyEllipse(struct Ellipse *elp) {
     assert(elp != NULL);
-    free(elp -> centerPt);
+    destroyVertex(elp -> centerPt);
     elp -> centerPt = NULL;
-    free(elp);
+    poolFree(&ellipsePool, elp);
     elp = NULL;
 }
 
-bool findEllipseRule(const struct Vertex *cursorPt, const struct Ellipse *elp) {
-    assert(cursorPt != NULL && elp != NULL);
+bool isNearEllipse(int x, int y, int centerx, int centery, int majorSemiAxis, int minorSemiAxis) {
+    long long int dx = (long long int)x - centerx, dy = (long long int)y - centery;
+    long long int majorVal = (long long int)majorSemiAxis + FINDRULE_VARIATION;
+    long long int minorVal = (long long int)minorSemiAxis + FINDRULE_VARIATION;
+
     // Prevent possible overflow
-    if (((long long int)elp -> minorSemiAxis + FINDRULE_VARIATION) * (cursorPt -> x - elp -> centerPt -> x) <= 1e9 &&
-        ((long long int)elp -> majorSemiAxis + FINDRULE_VARIATION) * (cursorPt -> y - elp -> centerPt -> y) <= 1e9 &&
-        ((long long int)elp -> majorSemiAxis + FINDRULE_VARIATION) * ((long long int)elp -> minorSemiAxis + FINDRULE_VARIATION) <= 1e9) {
-            return quickPow(((long long int)elp -> minorSemiAxis + FINDRULE_VARIATION) * (cursorPt -> x - elp -> centerPt -> x), 2) + quickPow(((long long int)elp -> majorSemiAxis + FINDRULE_VARIATION) * (cursorPt -> y - elp -> centerPt -> y), 2) <= quickPow(((long long int)elp -> majorSemiAxis + FINDRULE_VARIATION) *
-((long long int)elp -> minorSemiAxis + FINDRULE_VARIATION), 2);
+    if (minorVal * dx <= 1e9 && majorVal * dy <= 1e9 && majorVal * minorVal <= 1e9) {
+        long long int xVal = minorVal * dx, yVal = majorVal * dy, rightVal = majorVal * minorVal;
+        return xVal * xVal + yVal * yVal <= rightVal * rightVal;
     } else {
-        return (long double)quickPow((cursorPt -> x - elp -> centerPt -> x), 2) / quickPow(elp -> majorSemiAxis, 2) + (long double)quickPow((cursorPt -> y - elp -> centerPt -> y), 2) / quickPow(elp -> minorSemiAxis, 2) <= 1.0;
+        long double xVal = (long double)dx * dx / ((long long int)majorSemiAxis * majorSemiAxis);
+        long double yVal = (long double)dy * dy / ((long long int)minorSemiAxis * minorSemiAxis);
+        return xVal + yVal <= 1.0;
     }
 }
 
-struct Text * makeText(struct Rectangle *newPosition, char *newContent, int newFontWidth, int newFontHeight) {
+bool findEllipseRule(const struct Vertex *cursorPt, const struct Ellipse *elp) {
+    assert(cursorPt != NULL && elp != NULL);
+    return isNearEllipse(cursorPt -> x, cursorPt -> y, elp -> centerPt -> x, elp -> centerPt -> y,
+                         elp -> majorSemiAxis, elp -> minorSemiAxis);
+}
+
+struct Text * makeText(struct Rectangle *newPosition, const char *newContent, int newFontWidth, int newFontHeight) {
     assert(newPosition != NULL && newContent != NULL);
+    size_t length = min(strlen(newContent), (size_t)DATATYPE_TEXT_MAX_LENGTH);
     errno = 0;
-    struct Text *newText = (struct Text *)malloc(sizeof(struct Text));
-    if (newText == NULL) {
-        free(newText);
+    struct Text *newText = (struct Text *)poolAlloc(&textPool);
+    char *content = (char *)poolAlloc(getContentPool(length + 1));
+    if (newText == NULL || content == NULL) {
         perror("newText");
+        poolFree(&textPool, newText);
+        poolFree(getContentPool(length + 1), content);
         return NULL;
     }
+    memcpy(content, newContent, length);
+    content[length] = '\0';
     newText -> position = newPosition;
-    newText -> content = newContent;
+    newText -> content = content;
     newText -> fontWidth = newFontWidth;
     newText -> fontHeight = newFontHeight;
     return newText;
@@ -213,9 +266,9 @@ struct Text * makeText(struct Rectangle *newPosition, char *newContent, int newF
 void destoryText(struct Text *txt) {
     assert(txt != NULL);
     destroyRectangle(txt -> position);
-    free(txt -> content);
+    poolFree(getContentPool(strlen(txt -> content) + 1), txt -> content);
     txt -> content = NULL;
-    free(txt);
+    poolFree(&textPool, txt);
     txt = NULL;
 }
 
@@ -225,6 +278,13 @@ bool findTextRule(const struct Vertex *cursorPt, const struct Text *txt) {
 }
 
 void destroyRule(struct NodeData *data) {
+    assert(data != NULL);
+    destroyContentRule(data);
+    destroyData(data);
+    data = NULL;
+}
+
+void destroyContentRule(struct NodeData *data) {
     assert(data != NULL);
     switch(data -> type) {
         case DATATYPE_SEGMENT: {
@@ -248,36 +308,41 @@ void destroyRule(struct NodeData *data) {
             break;
         }
     }
-    free(data);
-    data = NULL;
+    data -> content = NULL;
 }
 
 bool findRule(const void *vCursorPt, const struct LinkedNode *node) {
     assert(vCursorPt != NULL && node != NULL);
-    if (node -> data == NULL) {
-        return false;
-    }
+    const struct Vertex *cursorPt = (const struct Vertex *)vCursorPt;
+    // No shape is hit further than FINDRULE_VARIATION off its extent, most nodes are let go
+    // on their box without reaching the shape
+    return node -> data != NULL &&
+           isNearRectangle(cursorPt -> x, cursorPt -> y, node -> box.minx, node -> box.miny, node -> box.maxx, node -> box.maxy) &&
+           findDataRule(vCursorPt, node -> data);
+}
 
+bool findDataRule(const void *vCursorPt, const struct NodeData *data) {
+    assert(vCursorPt != NULL && data != NULL);
     struct Vertex *cursorPt = (struct Vertex *)vCursorPt;
-    switch (node -> data -> type) {
+    switch (data -> type) {
         case DATATYPE_SEGMENT: {
-            struct Segment *seg = (struct Segment *)node -> data -> content;
+            struct Segment *seg = (struct Segment *)data -> content;
             return findSegmentRule(cursorPt, seg);
         }
         case DATATYPE_RECTANGLE: {
-            struct Rectangle *rec = (struct Rectangle *)node -> data -> content;
+            struct Rectangle *rec = (struct Rectangle *)data -> content;
             return findRectangleRule(cursorPt, rec);
         }
         case DATATYPE_CIRCLE: {
-            struct Circle *cir = (struct Circle *)node -> data -> content;
+            struct Circle *cir = (struct Circle *)data -> content;
             return findCircleRule(cursorPt, cir);
         }
         case DATATYPE_ELLIPSE: {
-            struct Ellipse *elp = (struct Ellipse *)node -> data -> content;
+            struct Ellipse *elp = (struct Ellipse *)data -> content;
             return findEllipseRule(cursorPt, elp);
         }
         case DATATYPE_TEXT: {
-            struct Text *txt = (struct Text *)node -> data -> content;
+            struct Text *txt = (struct Text *)data -> content;
             return findTextRule(cursorPt, txt);
         }
         default: {
@@ -285,3 +350,54 @@ bool findRule(const void *vCursorPt, const struct LinkedNode *node) {
         }
     }
 }
+
+void getDataBoundingBox(const struct NodeData *data, struct BoundingBox *box) {
+    assert(data != NULL && box != NULL);
+    switch (data -> type) {
+        case DATATYPE_SEGMENT: {
+            struct Segment *seg = (struct Segment *)data -> content;
+            box -> minx = seg -> leftPt -> x;
+            box -> maxx = seg -> rightPt -> x;
+            box -> miny = min(seg -> leftPt -> y, seg -> rightPt -> y);
+            box -> maxy = max(seg -> leftPt -> y, seg -> rightPt -> y);
+            break;
+        }
+        case DATATYPE_RECTANGLE: {
+            struct Rectangle *rec = (struct Rectangle *)data -> content;
+            box -> minx = rec -> lowerLeftPt -> x;
+            box -> miny = rec -> lowerLeftPt -> y;
+            box -> maxx = rec -> upperRightPt -> x;
+            box -> maxy = rec -> upperRightPt -> y;
+            break;
+        }
+        case DATATYPE_CIRCLE: {
+            struct Circle *cir = (struct Circle *)data -> content;
+            box -> minx = cir -> centerPt -> x - cir -> radius;
+            box -> miny = cir -> centerPt -> y - cir -> radius;
+            box -> maxx = cir -> centerPt -> x + cir -> radius;
+            box -> maxy = cir -> centerPt -> y + cir -> radius;
+            break;
+        }
+        case DATATYPE_ELLIPSE: {
+            struct Ellipse *elp = (struct Ellipse *)data -> content;
+            box -> minx = elp -> centerPt -> x - elp -> majorSemiAxis;
+            box -> miny = elp -> centerPt -> y - elp -> minorSemiAxis;
+            box -> maxx = elp -> centerPt -> x + elp -> majorSemiAxis;
+            box -> maxy = elp -> centerPt -> y + elp -> minorSemiAxis;
+            break;
+        }
+        case DATATYPE_TEXT: {
+            struct Text *txt = (struct Text *)data -> content;
+            box -> minx = txt -> position -> lowerLeftPt -> x;
+            box -> miny = txt -> position -> lowerLeftPt -> y;
+            box -> maxx = txt -> position -> upperRightPt -> x;
+            box -> maxy = txt -> position -> upperRightPt -> y;
+            break;
+        }
+        default: {
+            box -> minx = box -> miny = 0;
+            box -> maxx = box -> maxy = -1;
+            break;
+        }
+    }
+}
@@ -1,13 +1,93 @@
 #include <stdio.h>
 #include <math.h>
 #include <assert.h>
+#include <errno.h>
 
-#include "distance.h"
 #include "draw.h"
 #include "layout.h"
+#include "shapestore.h"
+#include "input.h"
+#include "inputlog.h"
+#include "arena.h"
 
 LOGFONT defaultFont;
 
+static void egeLineHook(void *impl, int x0, int y0, int x1, int y1, unsigned int color) {
+    (void)impl;
+    setcolor(color);
+    line(x0, y0, x1, y1);
+}
+
+static void egeRectangleHook(void *impl, int left, int top, int right, int bottom, unsigned int color) {
+    (void)impl;
+    setcolor(color);
+    rectangle(left, top, right, bottom);
+}
+
+static void egeCircleHook(void *impl, int centerx, int centery, int radius, unsigned int color) {
+    (void)impl;
+    setcolor(color);
+    circle(centerx, centery, radius);
+}
+
+static void egeEllipseHook(void *impl, int centerx, int centery, int xRadius, int yRadius, unsigned int color) {
+    (void)impl;
+    setcolor(color);
+    ellipse(centerx, centery, 0, 360, xRadius, yRadius);
+}
+
+static void egeBarHook(void *impl, int left, int top, int right, int bottom, unsigned int color) {
+    (void)impl;
+    color_t prevFillColor = getfillcolor();
+    setfillcolor(color);
+    bar(left, top, right, bottom);
+    setfillcolor(prevFillColor);
+}
+
+static void egeTextHook(void *impl, const struct Vertex *startPt, const struct Vertex *endPt, const char *text,
+                        unsigned int color, bool isDraft) {
+    (void)impl;
+    struct Vertex cntStartPt = *startPt, cntEndPt = *endPt;
+    LOGFONT cntFont = defaultFont;
+    if (isDraft) {
+        cntFont.lfQuality = NONANTIALIASED_QUALITY;
+    }
+    // drawText() restores the color it found
+    drawText(&cntStartPt, &cntEndPt, (char *)text, &cntFont, color, BLACK);
+}
+
+static const struct RenderBackend egeBackend = {
+    NULL, egeLineHook, egeRectangleHook, egeCircleHook, egeEllipseHook, egeBarHook, egeTextHook
+};
+
+// Every drawing function of this module goes through it
+static const struct RenderBackend *drawBackend = &egeBackend;
+
+void setDrawBackend(const struct RenderBackend *backend) {
+    drawBackend = backend == NULL ? &egeBackend : backend;
+}
+
+// Points and cursors of one interaction, taken back by resetScratch()
+static struct Arena scratchArena = ARENA_INITIALIZER("Scratch", ARENA_BLOCK_SIZE);
+// Node arrays of the damage repainted by a tracking frame, taken back when the next frame begins
+static struct Arena frameArena = ARENA_INITIALIZER("Frame", DAMAGE_SCRATCH_BLOCK_SIZE);
+
+struct Vertex * makeScratchVertex(int x, int y) {
+    errno = 0;
+    struct Vertex *newVtx = (struct Vertex *)arenaAlloc(&scratchArena, sizeof(struct Vertex));
+    if (newVtx == NULL) {
+        perror("makeScratchVertex");
+        return NULL;
+    }
+    newVtx -> x = x;
+    newVtx -> y = y;
+    return newVtx;
+}
+
+void resetScratch() {
+    resetArena(&scratchArena);
+}
+
 void getRealPosition(struct Vertex *cntPt) {
     assert(cntPt != NULL);
     int cntCanvasMinx = -1, cntCanvasMiny = -1, cntCanvasMaxx = -1, cntCanvasMaxy = -1;
@@ -20,124 +100,12 @@ void getRealPosition(struct Vertex *cntPt) {
 
 void getStartEndPts(struct NodeData *data, struct Vertex **startPt, struct Vertex **endPt, int assistId) {
     assert(data != NULL && *startPt == NULL && *endPt == NULL);
-
-    if (assistId == -1) {
-        if (data -> type == DATATYPE_CIRCLE) {
-            assistId = 2;
-        } else {
-            assistId = 0;
-        }
-    }
-
-    const int xType = assistId / 3, yType = assistId % 3;
-    int startPtx, startPty;
-    int endPtx = editAssistArr[assistId].x, endPty = editAssistArr[assistId].y;
-
-    switch (data -> type) {
-        case DATATYPE_SEGMENT: {
-            struct Segment *seg = (struct Segment *)data -> content;
-            if (xType == 0) {
-                startPtx = seg -> rightPt -> x;
-                startPty = seg -> rightPt -> y;
-            } else {
-                startPtx = seg -> leftPt -> x;
-                startPty = seg -> leftPt -> y;
-            }
-            break;
-        }
-        case DATATYPE_RECTANGLE: {
-            struct Rectangle *rec = (struct Rectangle *)data -> content;
-
-            if (xType == 0) {
-                startPtx = rec -> upperRightPt -> x;
-            } else {
-                startPtx = rec -> lowerLeftPt -> x;
-                if (xType == 2) {
-                    endPtx = rec -> upperRightPt -> x;
-                }
-            }
-            if (yType == 0) {
-                startPty = rec -> upperRightPt -> y;
-            } else {
-                startPty = rec -> lowerLeftPt -> y;
-                if (yType == 2) {
-                    endPty = rec -> upperRightPt -> y;
-                }
-            }
-            break;
-        }
-        case DATATYPE_CIRCLE: {
-            struct Circle *cir = (struct Circle *)data -> content;
-
-            if (xType == 2) {
-                startPtx = endPtx;
-                if (yType == 0) {
-                    startPty = endPty + cir -> radius * 2;
-                } else {
-                    startPty = endPty - cir -> radius * 2;
-                }
-            }
-            if (yType == 2) {
-                if (xType == 0) {
-                    startPtx = endPtx + cir -> radius * 2;
-                } else {
-                    startPtx = endPtx - cir -> radius * 2;
-                }
-                startPty = endPty;
-            }
-            break;
-        }
-        case DATATYPE_ELLIPSE: {
-            struct Ellipse *elp = (struct Ellipse *)data -> content;
-
-            if (xType == 0) {
-                startPtx = elp -> centerPt -> x + elp -> majorSemiAxis;
-            } else {
-                startPtx = elp -> centerPt -> x - elp -> majorSemiAxis;
-                if (xType == 2) {
-                    endPtx = elp -> centerPt -> x + elp -> majorSemiAxis;
-                }
-            }
-            if (yType == 0) {
-                startPty = elp -> centerPt -> y + elp -> minorSemiAxis;
-            } else {
-                startPty = elp -> centerPt -> y - elp -> minorSemiAxis;
-                if (yType == 2) {
-                    endPty = elp -> centerPt -> y + elp -> minorSemiAxis;
-                }
-            }
-
-            break;
-        }
-        case DATATYPE_TEXT: {
-            struct Text *txt = (struct Text *)data -> content;
-            struct Rectangle *pos = (struct Rectangle *)txt -> position;
-
-            if (xType == 0) {
-                startPtx = pos -> upperRightPt -> x;
-            } else {
-                startPtx = pos -> lowerLeftPt -> x;
-                if (xType == 2) {
-                    endPtx = pos -> upperRightPt -> x;
-                }
-            }
-            if (yType == 0) {
-                startPty = pos -> upperRightPt -> y;
-            } else {
-                startPty = pos -> lowerLeftPt -> y;
-                if (yType == 2) {
-                    endPty = pos -> upperRightPt -> y;
-                }
-            }
-            break;
-        }
-        default: {
-            return;
-        }
+    struct Vertex cntStartPt, cntEndPt;
+    if (!getTrackedPts(data, editAssistArr, assistId, &cntStartPt, &cntEndPt)) {
+        return;
     }
-
-    *startPt = makeVertex(startPtx, startPty);
-    *endPt = makeVertex(endPtx, endPty);
+    *startPt = makeScratchVertex(cntStartPt.x, cntStartPt.y);
+    *endPt = makeScratchVertex(cntEndPt.x, cntEndPt.y);
 }
 
 struct Vertex * getTextEndPt(struct Vertex *startPt, char *text, LOGFONT *font) {
@@ -149,147 +117,16 @@ struct Vertex * getTextEndPt(struct Vertex *startPt, char *text, LOGFONT *font)
     int cntTextWidth = textwidth(text);
     setfont(&defaultFont);
 
-    return makeVertex(startPt -> x + cntTextWidth, startPt -> y + cntTextHeight);
+    return makeScratchVertex(startPt -> x + cntTextWidth, startPt -> y + cntTextHeight);
 }
 
 void drawShape(struct Vertex *startPt, struct Vertex *endPt, int shapeType, color_t fgColor) {
     assert(startPt != NULL && endPt != NULL);
     color_t prevFgColor = getcolor();
-    setcolor(fgColor);
-
-    switch (shapeType) {
-        case DATATYPE_SEGMENT: {
-            line(startPt -> x, startPt -> y, endPt -> x, endPt -> y);
-            break;
-        }
-        case DATATYPE_RECTANGLE: {
-            rectangle(min(startPt -> x, endPt -> x), max(startPt -> y, endPt -> y),
-                    max(startPt -> x, endPt -> x), min(startPt -> y, endPt -> y));
-            break;
-        }
-        case DATATYPE_CIRCLE: {
-            struct Vertex *centerPt = makeVertex((startPt -> x + endPt -> x) / 2, (startPt -> y + endPt -> y) / 2);
-            int radius = sqrt(getSqrEuclideanDistance(centerPt, endPt));
-            circle(centerPt -> x, centerPt -> y, radius);
-            destroyVertex(centerPt);
-            break;
-        }
-        case DATATYPE_ELLIPSE: {
-            struct Vertex *centerPt = makeVertex((startPt -> x + endPt -> x) / 2, (startPt -> y + endPt -> y) / 2);
-            int majorSemiAxis = abs(endPt -> x - centerPt -> x);
-            int minorSemiAxis = abs(endPt -> y - centerPt -> y);
-            ellipse(centerPt -> x, centerPt -> y, 0, 360, majorSemiAxis, minorSemiAxis);
-            destroyVertex(centerPt);
-            break;
-        }
-        default: {
-            break;
-        }
-    }
+    renderShape(drawBackend, startPt, endPt, shapeType, fgColor);
     setcolor(prevFgColor);
 }
 
-struct LinkedNode *saveShape(struct LinkedList *list, struct Vertex *startPt, struct Vertex *endPt, int shapeType) {
-    assert(list != NULL && startPt != NULL && endPt != NULL);
-
-
-    switch (shapeType) {
-        case DATATYPE_SEGMENT: {
-            if (getManhattanDistance(startPt, endPt) <= FINDRULE_VARIATION) {
-                break;
-            }
-            struct LinkedNode *res = addNodeAtTail(list, makeData(makeSegment(startPt, endPt), DATATYPE_SEGMENT));
-            return res;
-        }
-        case DATATYPE_RECTANGLE: {
-            if (abs(startPt -> x - endPt -> x) <= FINDRULE_VARIATION || abs(startPt -> y - endPt -> y) <= FINDRULE_VARIATION) {
-                break;
-            }
-            struct LinkedNode *res = addNodeAtTail(list, makeData(makeRectangle(startPt, endPt), DATATYPE_RECTANGLE));
-            return res;
-        }
-        case DATATYPE_CIRCLE: {
-            struct Vertex *centerPt = makeVertex((startPt -> x + endPt -> x) / 2, (startPt -> y + endPt -> y) / 2);
-            int radius = sqrt(getSqrEuclideanDistance(centerPt, endPt));
-            if (radius <= FINDRULE_VARIATION) {
-                break;
-            }
-            struct LinkedNode *res = addNodeAtTail(list, makeData(makeCircle(centerPt, radius), DATATYPE_CIRCLE));
-            destroyVertex(startPt);
-            destroyVertex(endPt);
-            return res;
-        }
-        case DATATYPE_ELLIPSE: {
-            struct Vertex *centerPt = makeVertex((startPt -> x + endPt -> x) / 2, (startPt -> y + endPt -> y) / 2);
-            int majorSemiAxis = abs(endPt -> x - centerPt -> x);
-            int minorSemiAxis = abs(endPt -> y - centerPt -> y);
-            if (majorSemiAxis <= FINDRULE_VARIATION || minorSemiAxis <= FINDRULE_VARIATION) {
-                break;
-            }
-            struct LinkedNode *res = addNodeAtTail(list, makeData(makeEllipse(centerPt, majorSemiAxis, minorSemiAxis), DATATYPE_ELLIPSE));
-            destroyVertex(startPt);
-            destroyVertex(endPt);
-            return res;
-        }
-        case DATATYPE_TEXT: {
-            break;
-        }
-    }
-
-    destroyVertex(startPt);
-    destroyVertex(endPt);
-    return NULL;
-}
-
-void editShape(struct LinkedNode *node, struct Vertex *startPt, struct Vertex *endPt) {
-    assert(node != NULL && node -> data != NULL && startPt != NULL && endPt != NULL);
-
-    switch (node -> data -> type) {
-        case DATATYPE_SEGMENT: {
-            if (getManhattanDistance(startPt, endPt) <= FINDRULE_VARIATION) {
-                break;
-            }
-            editNode(node, makeData(makeSegment(startPt, endPt), DATATYPE_SEGMENT), destroyRule);
-            return;
-        }
-        case DATATYPE_RECTANGLE: {
-            if (abs(startPt -> x - endPt -> x) <= FINDRULE_VARIATION || abs(startPt -> y - endPt -> y) <= FINDRULE_VARIATION) {
-                break;
-            }
-            editNode(node, makeData(makeRectangle(startPt, endPt), DATATYPE_RECTANGLE), destroyRule);
-            return;
-        }
-        case DATATYPE_CIRCLE: {
-            struct Vertex *centerPt = makeVertex((startPt -> x + endPt -> x) / 2, (startPt -> y + endPt -> y) / 2);
-            int radius = sqrt(getSqrEuclideanDistance(centerPt, endPt));
-            if (radius <= FINDRULE_VARIATION) {
-                break;
-            }
-            editNode(node, makeData(makeCircle(centerPt, radius), DATATYPE_CIRCLE), destroyRule);
-            destroyVertex(startPt);
-            destroyVertex(endPt);
-            return;
-        }
-        case DATATYPE_ELLIPSE: {
-            struct Vertex *centerPt = makeVertex((startPt -> x + endPt -> x) / 2, (startPt -> y + endPt -> y) / 2);
-            int majorSemiAxis = abs(endPt -> x - centerPt -> x);
-            int minorSemiAxis = abs(endPt -> y - centerPt -> y);
-            if (majorSemiAxis <= FINDRULE_VARIATION || minorSemiAxis <= FINDRULE_VARIATION) {
-                break;
-            }
-            editNode(node, makeData(makeEllipse(centerPt, majorSemiAxis, minorSemiAxis), DATATYPE_ELLIPSE), destroyRule);
-            destroyVertex(startPt);
-            destroyVertex(endPt);
-            return;
-        }
-        case DATATYPE_TEXT: {
-            break;
-        }
-    }
-    destroyVertex(startPt);
-    destroyVertex(endPt);
-}
-
 void drawText(struct Vertex *startPt, struct Vertex *endPt, char *text,
               LOGFONT *font, color_t textColor, color_t fillColor) {
     assert(startPt != NULL && text != NULL && font != NULL);
@@ -312,114 +149,515 @@ void drawText(struct Vertex *startPt, struct Vertex *endPt, char *text,
     setfont(&defaultFont);
 }
 
-struct LinkedNode *saveText(struct LinkedList *list, struct Vertex *startPt, struct Vertex *endPt, char *text, int fontWidth, int fontHeight) {
-    struct LinkedNode *res = addNodeAtTail(list, makeData(makeText(makeRectangle(startPt, endPt), text, fontWidth, fontHeight), DATATYPE_TEXT));
-    return res;
-}
-
-void editText(struct LinkedNode *node, struct Vertex *startPt, struct Vertex *endPt,
-              char *text, int fontWidth, int fontHeight) {
-    assert(node != NULL && node -> data != NULL && startPt != NULL && endPt != NULL);
+void getTextBoundingBox(struct Vertex *startPt, struct Vertex *endPt, char *text, LOGFONT *font,
+                        struct BoundingBox *box) {
+    assert(startPt != NULL && endPt != NULL && text != NULL && font != NULL && box != NULL);
 
-    if (text == NULL || fontWidth < 0 || fontHeight < 0) {
-        struct Text *txt = (struct Text *)node -> data -> content;
-        text = (char *)malloc(sizeof(char) * DATATYPE_TEXT_MAX_LENGTH);
-        strncpy(text, txt -> content, DATATYPE_TEXT_MAX_LENGTH);
-        fontWidth = txt -> fontWidth;
-        fontHeight = txt -> fontHeight;
-    }
+    // Same font as drawText()
+    LOGFONT cntFont = *font;
+    cntFont.lfWidth = 0;
+    cntFont.lfHeight = abs(endPt -> y - startPt -> y);
+    setfont(&cntFont);
 
-    if (abs(startPt -> x - endPt -> x) <= FINDRULE_VARIATION || abs(startPt -> y - endPt -> y) <= FINDRULE_VARIATION) {
-        return;
-    }
+    box -> minx = min(startPt -> x, endPt -> x);
+    box -> miny = min(startPt -> y, endPt -> y);
+    box -> maxx = box -> minx + textwidth(text);
+    box -> maxy = box -> miny + max(textheight(text), cntFont.lfHeight);
 
-    editNode(node, makeData(makeText(makeRectangle(startPt, endPt), text, fontWidth, fontHeight), DATATYPE_TEXT), destroyRule);
+    setfont(&defaultFont);
 }
 
 void fillBlock(int minx, int maxy, int maxx, int miny, int fillColor) {
-    color_t prevFillColor = getfillcolor();
-    setfillcolor(fillColor);
-    bar(minx, maxy, maxx, miny);
-    setfillcolor(prevFillColor);
+    drawBackend -> barFunc(drawBackend -> impl, minx, maxy, maxx, miny, fillColor);
+}
+
+// Draw nodeData moved by (offsetx, offsety), for view ports not starting at the canvas origin
+static void drawNodeDataAt(const struct NodeData *nodeData, color_t fgColor, bool isDraft, int offsetx, int offsety) {
+    assert(nodeData != NULL);
+    color_t prevFgColor = getcolor();
+    renderNodeData(drawBackend, nodeData, fgColor, isDraft, offsetx, offsety);
+    setcolor(prevFgColor);
+}
+
+static void getCanvasBox(struct BoundingBox *box) {
+    box -> minx = 0;
+    box -> miny = 0;
+    box -> maxx = canvasWidth;
+    box -> maxy = screenHeight;
 }
 
 void drawNodeData(struct NodeData *nodeData, color_t fgColor, bool isDraft) {
     assert(nodeData != NULL);
+    struct BoundingBox box, canvasBox;
+    getDataBoundingBox(nodeData, &box);
+    getCanvasBox(&canvasBox);
+    if (isBoxVisible(&box, &canvasBox)) {
+        drawNodeDataAt(nodeData, fgColor, isDraft, 0, 0);
+    }
+}
+
+// Shapes drawn and culled by the last full redraw
+static struct RenderStats redrawStats = {0, 0};
+
+struct RenderStats getRedrawStats() {
+    return redrawStats;
+}
+
+// Draw every node of the list crossing the canvas on the current target
+// Complexity: O(n)
+static void drawAllShapes(const struct LinkedList *list, color_t fgColor, bool isDraft) {
+    struct BoundingBox canvasBox;
+    getCanvasBox(&canvasBox);
+    redrawStats.drawnNum = redrawStats.culledNum = 0;
+
     color_t prevFgColor = getcolor();
-    setcolor(fgColor);
+    renderList(drawBackend, list, fgColor, isDraft, &canvasBox, &redrawStats);
+    setcolor(prevFgColor);
+}
 
-    switch (nodeData -> type) {
-        case DATATYPE_SEGMENT: {
-            struct Segment *seg = (struct Segment *)nodeData -> content;
-            line(seg -> leftPt -> x, seg -> leftPt -> y, seg -> rightPt -> x, seg -> rightPt -> y);
-            break;
-        }
-        case DATATYPE_RECTANGLE: {
-            struct Rectangle *rec = (struct Rectangle *)nodeData -> content;
-            rectangle(rec -> lowerLeftPt -> x, rec -> upperRightPt -> y, rec -> upperRightPt -> x, rec -> lowerLeftPt -> y);
-            break;
-        }
-        case DATATYPE_CIRCLE: {
-            struct Circle *cir = (struct Circle *)nodeData -> content;
-            circle(cir -> centerPt -> x, cir -> centerPt -> y, cir -> radius);
-            break;
-        }
-        case DATATYPE_ELLIPSE: {
-            struct Ellipse * elp = (struct Ellipse *)nodeData -> content;
-            ellipse(elp -> centerPt -> x, elp -> centerPt -> y, 0, 360, elp -> majorSemiAxis, elp -> minorSemiAxis);
-            break;
-        }
-        case DATATYPE_TEXT: {
-            struct Text *txt = (struct Text *)nodeData -> content;
-            struct Rectangle *pos = (struct Rectangle *)txt -> position;
-
-            if (isDraft) {
-                LOGFONT cntFont = defaultFont;
-                cntFont.lfQuality = NONANTIALIASED_QUALITY;
-                drawText(pos -> lowerLeftPt, pos -> upperRightPt, txt -> content, &cntFont, fgColor, BLACK);
+// Committed shapes rendered off screen, blitted instead of redrawn until the list or the style changes
+struct BackgroundLayer {
+    PIMAGE image;
+    int width, height;
+    bool isValid;
+    // What the image was rendered from
+    const struct LinkedList *list;
+    unsigned int version;
+    color_t fgColor;
+    bool isDraft;
+};
+
+static struct BackgroundLayer backgroundLayer = {NULL, 0, 0, false, NULL, 0, BLACK, false};
+
+// NULL until setLayerRenderer(), the layer is drawn through EGE then
+static struct TileRenderer *layerRenderer = NULL;
+
+void setLayerRenderer(struct TileRenderer *renderer) {
+    layerRenderer = renderer;
+    backgroundLayer.isValid = false;
+}
+
+void releaseBackgroundLayer() {
+    if (backgroundLayer.image != NULL) {
+        delimage(backgroundLayer.image);
+    }
+    backgroundLayer.image = NULL;
+    backgroundLayer.isValid = false;
+}
+
+// Rasterize the shapes straight into the pixels of the layer on the tile renderer, then draw text through EGE.
+// Framebuffers have no glyphs, so the tiles leave text out. Shapes above a text and crossing the texts
+// drawn so far are rasterized again, which only writes their own pixels once more elsewhere.
+// Complexity: O(n + canvas pixels / threads), plus the shapes drawn again over text
+static void drawLayerTiled(struct BackgroundLayer *layer, const struct LinkedList *list, color_t fgColor, bool isDraft) {
+    struct FrameBuffer fb = {layer -> width, layer -> height, (unsigned int *)getbuffer(layer -> image),
+                             {0, 0, 0, 0}, fgColor, CANVAS_COLOR, NULL, 0};
+    setFrameBufferClip(&fb, NULL);
+    layerRenderer -> isTextSkipped = true;
+    fbRedrawAllTiled(layerRenderer, &fb, list);
+    redrawStats = layerRenderer -> stats;
+
+    struct RenderBackend fbBackend;
+    initFrameBufferBackend(&fb, &fbBackend);
+    struct BoundingBox textBox;
+    bool hasText = false;
+    PIMAGE prevTarget = gettarget();
+    settarget(layer -> image);
+    color_t prevFgColor = getcolor();
+    for (struct LinkedNode *cntNode = list -> head; cntNode != NULL; cntNode = cntNode -> next) {
+        if (cntNode -> data == NULL || !isBoxIntersected(&cntNode -> box, &fb.clip)) {
+            continue;
+        }
+        if (cntNode -> data -> type == DATATYPE_TEXT) {
+            renderNodeData(&egeBackend, cntNode -> data, fgColor, isDraft, 0, 0);
+            // Glyphs must be in the pixels before shapes are written over them
+            GdiFlush();
+            if (!hasText) {
+                textBox = cntNode -> box;
+                hasText = true;
             } else {
-                drawText(pos -> lowerLeftPt, pos -> upperRightPt, txt -> content, &defaultFont, fgColor, BLACK);
+                textBox.minx = min(textBox.minx, cntNode -> box.minx);
+                textBox.miny = min(textBox.miny, cntNode -> box.miny);
+                textBox.maxx = max(textBox.maxx, cntNode -> box.maxx);
+                textBox.maxy = max(textBox.maxy, cntNode -> box.maxy);
             }
-
-            break;
-        }
-        default: {
-            break;
+        } else if (hasText && isBoxIntersected(&cntNode -> box, &textBox)) {
+            renderNodeData(&fbBackend, cntNode -> data, fgColor, isDraft, 0, 0);
         }
     }
     setcolor(prevFgColor);
+    settarget(prevTarget);
+}
+
+// Render the list into the background layer, unless it is already up to date
+// Returns false if no layer could be created, the caller has to draw the shapes itself then
+// Complexity: O(1) when up to date, O(n + canvas pixels) otherwise, the pixels spread over threads with a renderer
+static bool updateBackgroundLayer(const struct LinkedList *list, color_t fgColor, bool isDraft) {
+    // The layer is an EGE image
+    if (drawBackend != &egeBackend) {
+        return false;
+    }
+    struct BackgroundLayer *layer = &backgroundLayer;
+    int width = canvasWidth + 1, height = screenHeight + 1;
+    if (layer -> image != NULL && (layer -> width != width || layer -> height != height)) {
+        releaseBackgroundLayer();
+    }
+    if (layer -> image == NULL) {
+        layer -> image = newimage(width, height);
+        if (layer -> image == NULL) {
+            return false;
+        }
+        layer -> width = width;
+        layer -> height = height;
+        layer -> isValid = false;
+    }
+
+    if (layer -> isValid && layer -> list == list && layer -> version == list -> version
+        && layer -> fgColor == fgColor && layer -> isDraft == isDraft) {
+        return true;
+    }
+
+    if (layerRenderer != NULL) {
+        drawLayerTiled(layer, list, fgColor, isDraft);
+    } else {
+        PIMAGE prevTarget = gettarget();
+        settarget(layer -> image);
+        fillBlock(0, 0, width, height, CANVAS_COLOR);
+        drawAllShapes(list, fgColor, isDraft);
+        settarget(prevTarget);
+    }
+
+    layer -> isValid = true;
+    layer -> list = list;
+    layer -> version = list -> version;
+    layer -> fgColor = fgColor;
+    layer -> isDraft = isDraft;
+    return true;
 }
 
 void redrawAll(struct LinkedList *list, color_t fgColor, bool isDraft) {
+    assert(list != NULL);
+    if (updateBackgroundLayer(list, fgColor, isDraft)) {
+        int prevViewPort = getViewPort();
+        setViewPort(AREA_CANVAS);
+        putimage(0, 0, backgroundLayer.image);
+        setViewPort(prevViewPort);
+        return;
+    }
+
     clearCanvas();
-    struct LinkedNode *cntNode = list -> head;
-    while (cntNode != NULL && cntNode -> data != NULL) {
-        drawNodeData(cntNode -> data, fgColor, isDraft);
-        cntNode = cntNode -> next;
+    drawAllShapes(list, fgColor, isDraft);
+}
+
+struct CanvasPainter {
+    color_t fgColor;
+    bool isDraft;
+    // Drawn above the committed shapes in EDIT_ASSIST_COLOR, may be NULL
+    struct NodeData *overlayData;
+    // Origin of the current clip view port in canvas coordinates
+    int originx, originy;
+};
+
+static void clipCanvasHook(void *impl, const struct BoundingBox *rect) {
+    struct CanvasPainter *painter = (struct CanvasPainter *)impl;
+    setCanvasClip(rect);
+    painter -> originx = rect == NULL ? 0 : rect -> minx;
+    painter -> originy = rect == NULL ? 0 : rect -> miny;
+}
+
+static void clearCanvasHook(void *impl, const struct BoundingBox *rect) {
+    (void)impl;
+    fillBlock(0, 0, rect -> maxx - rect -> minx + 1, rect -> maxy - rect -> miny + 1, CANVAS_COLOR);
+}
+
+// Copy the rectangle back from the background layer, shapes included
+static void blitLayerHook(void *impl, const struct BoundingBox *rect) {
+    (void)impl;
+    putimage(0, 0, rect -> maxx - rect -> minx + 1, rect -> maxy - rect -> miny + 1,
+             backgroundLayer.image, rect -> minx, rect -> miny);
+}
+
+static void drawCanvasHook(void *impl, const struct NodeData *data) {
+    struct CanvasPainter *painter = (struct CanvasPainter *)impl;
+    drawNodeDataAt(data, painter -> fgColor, painter -> isDraft, -painter -> originx, -painter -> originy);
+}
+
+static void overlayCanvasHook(void *impl) {
+    struct CanvasPainter *painter = (struct CanvasPainter *)impl;
+    if (painter -> overlayData != NULL) {
+        drawNodeDataAt(painter -> overlayData, EDIT_ASSIST_COLOR, true, -painter -> originx, -painter -> originy);
+    }
+}
+
+// Set up painter to repaint the canvas through canvasPainter, from the background layer when it can be kept
+static void initCanvasPainter(struct LinkedList *list, color_t fgColor, bool isDraft, struct NodeData *overlayData,
+                              struct CanvasPainter *canvasPainter, struct DamagePainter *painter) {
+    canvasPainter -> fgColor = fgColor;
+    canvasPainter -> isDraft = isDraft;
+    canvasPainter -> overlayData = overlayData;
+    canvasPainter -> originx = canvasPainter -> originy = 0;
+
+    painter -> impl = canvasPainter;
+    painter -> clipFunc = clipCanvasHook;
+    painter -> clearFunc = clearCanvasHook;
+    painter -> drawFunc = drawCanvasHook;
+    painter -> overlayFunc = overlayCanvasHook;
+    painter -> scratch = &frameArena;
+    if (updateBackgroundLayer(list, fgColor, isDraft)) {
+        painter -> clearFunc = blitLayerHook;
+        painter -> drawFunc = NULL;
+    }
+}
+
+void redrawDamage(struct LinkedList *list, struct Damage *damage, color_t fgColor, bool isDraft,
+                  struct NodeData *overlayData) {
+    assert(list != NULL && damage != NULL);
+    struct BoundingBox canvasBox;
+    getCanvasBox(&canvasBox);
+    clipDamage(damage, &canvasBox);
+
+    struct CanvasPainter canvasPainter;
+    struct DamagePainter painter;
+    initCanvasPainter(list, fgColor, isDraft, overlayData, &canvasPainter, &painter);
+    repaintDamage(list, damage, &painter);
+}
+
+// NULL until startInputQueue(), or when it could not be made, getmouse() is called directly then
+static struct InputQueue *inputQueue = NULL;
+// NULL unless startInputRecording() succeeded
+static struct InputLog *inputLog = NULL;
+static double inputLogStart = 0.0;
+
+// Take the next message from EGE, waiting for it, and record it if asked to
+static mouse_msg readMouseMsg() {
+    mouse_msg m = getmouse();
+    if (inputLog == NULL) {
+        return m;
+    }
+    struct InputLogEvent event;
+    event.timeMs = (uint32_t)((fclock() - inputLogStart) * 1000);
+    event.x = (int16_t)m.x;
+    event.y = (int16_t)m.y;
+    event.wheel = (int16_t)m.wheel;
+    event.kind = m.is_down() ? INPUT_LOG_DOWN : (m.is_up() ? INPUT_LOG_UP : (m.is_move() ? INPUT_LOG_MOVE : INPUT_LOG_WHEEL));
+    event.flags = (m.is_left() ? INPUT_LOG_LEFT : 0) | (m.is_right() ? INPUT_LOG_RIGHT : 0) | (m.is_mid() ? INPUT_LOG_MID : 0) |
+                  ((m.flags & mouse_flag_shift) != 0 ? INPUT_LOG_SHIFT : 0) | ((m.flags & mouse_flag_ctrl) != 0 ? INPUT_LOG_CTRL : 0);
+    appendInputLog(inputLog, &event);
+    return m;
+}
+
+bool startInputRecording(const char *path) {
+    assert(path != NULL && inputLog == NULL && inputQueue == NULL);
+    inputLog = openInputLog(path);
+    inputLogStart = fclock();
+    return inputLog != NULL;
+}
+
+bool stopInputRecording() {
+    if (inputLog == NULL) {
+        return false;
+    }
+    bool isClosed = closeInputLog(inputLog);
+    inputLog = NULL;
+    return isClosed;
+}
+
+static bool readMouseHook(void *impl, void *event) {
+    (void)impl;
+    if (!mousemsg()) {
+        return false;
+    }
+    *(mouse_msg *)event = readMouseMsg();
+    return true;
+}
+
+static bool isMouseMoveHook(void *impl, const void *event) {
+    (void)impl;
+    return ((const mouse_msg *)event) -> msg == mouse_msg_move;
+}
+
+// delay_ms() refreshes the window while waiting, a plain sleep would leave it unanswered
+static void mouseIdleHook(void *impl) {
+    (void)impl;
+    delay_ms(INPUT_IDLE_MS);
+}
+
+// The message read past the end of a run of moves, taken before any other
+static mouse_msg pendingMsg;
+static bool hasPendingMsg = false;
+// Moves taken as a later one outside of the queue
+static long long int directCoalescedNum = 0;
+
+void startInputQueue() {
+    if (inputQueue == NULL) {
+        // EGE must not be called from another thread, nor while inputbox_getline() pumps its own messages,
+        // so the UI thread pumps the queue itself instead of leaving it to a reader
+        struct InputSource source = {NULL, readMouseHook, isMouseMoveHook, mouseIdleHook};
+        inputQueue = makeInputQueue(&source, sizeof(mouse_msg), false);
+    }
+}
+
+void stopInputQueue() {
+    if (inputQueue != NULL) {
+        destroyInputQueue(inputQueue);
+        inputQueue = NULL;
+    }
+}
+
+mouse_msg nextMouseMsg() {
+    mouse_msg m;
+    if (hasPendingMsg) {
+        m = pendingMsg;
+        hasPendingMsg = false;
+    } else if (inputQueue != NULL) {
+        takeInput(inputQueue, &m);
+        return m;
+    } else {
+        m = readMouseMsg();
+    }
+    // Moves already queued behind this one make it stale, as the queue would have found
+    while (m.is_move() && mousemsg()) {
+        mouse_msg nextMsg = readMouseMsg();
+        if (!nextMsg.is_move()) {
+            pendingMsg = nextMsg;
+            hasPendingMsg = true;
+            break;
+        }
+        m = nextMsg;
+        directCoalescedNum++;
+    }
+    return m;
+}
+
+bool getMouseStats(struct InputStats *stats) {
+    if (inputQueue == NULL) {
+        return false;
+    }
+    getInputStats(inputQueue, stats);
+    return true;
+}
+
+static int trackingFps = TRACKING_DEFAULT_FPS;
+static struct FrameStats frameStats = {0, 0, 0.0, 0.0, 0.0};
+// When the latest frame of a tracking loop started, in seconds of fclock()
+static double lastFrameStart = 0.0;
+
+void setTrackingFps(int fps) {
+    assert(fps >= 0);
+    trackingFps = fps;
+}
+
+struct FrameStats getFrameStats() {
+    struct FrameStats stats = frameStats;
+    stats.coalescedNum = directCoalescedNum;
+    struct InputStats inputStats;
+    if (getMouseStats(&inputStats)) {
+        stats.coalescedNum += inputStats.coalescedNum;
+    }
+    return stats;
+}
+
+// Sleep until the next frame of a tracking loop is due, the moves coming meanwhile are then taken as one
+static void waitFrame() {
+    if (trackingFps <= 0) {
+        return;
+    }
+    long waitMs = (long)((lastFrameStart + 1.0 / trackingFps - fclock()) * 1000);
+    if (waitMs > 0) {
+        delay_ms(waitMs);
+    }
+}
+
+// Check whether nextMouseMsg() would not wait
+static bool hasMouseMsg() {
+    if (hasPendingMsg) {
+        return true;
+    }
+    return inputQueue != NULL ? hasInput(inputQueue) : mousemsg();
+}
+
+// Take the next message of a tracking loop. A move waits until its frame is due and is then taken as the latest
+// move come meanwhile, presses and releases are taken at once
+static mouse_msg nextTrackingMsg() {
+    mouse_msg m = nextMouseMsg();
+    if (!m.is_move() || trackingFps <= 0) {
+        return m;
+    }
+    waitFrame();
+    while (hasMouseMsg()) {
+        mouse_msg nextMsg = nextMouseMsg();
+        if (!nextMsg.is_move()) {
+            pendingMsg = nextMsg;
+            hasPendingMsg = true;
+            break;
+        }
+        m = nextMsg;
+        directCoalescedNum++;
     }
+    return m;
+}
+
+static double beginFrame() {
+    resetArena(&frameArena);
+    lastFrameStart = fclock();
+    return lastFrameStart;
+}
+
+static void endFrame(double frameStart) {
+    double frameMs = (fclock() - frameStart) * 1000;
+    frameStats.frameNum++;
+    frameStats.lastMs = frameMs;
+    frameStats.maxMs = max(frameStats.maxMs, frameMs);
+    frameStats.totalMs += frameMs;
+}
+
+// Extent of a text draft, drawn by egeTextHook() in the default font
+static void textBoxHook(const struct Vertex *startPt, const struct Vertex *endPt, const char *text,
+                        struct BoundingBox *box) {
+    struct Vertex cntStartPt = *startPt, cntEndPt = *endPt;
+    LOGFONT cntFont = defaultFont;
+    cntFont.lfQuality = NONANTIALIASED_QUALITY;
+    getTextBoundingBox(&cntStartPt, &cntEndPt, (char *)text, &cntFont, box);
+}
+
+// Set up tracker for a drag over list on the canvas, data drawn above the committed shapes when not NULL
+static void initCanvasTracker(struct LinkedList *list, color_t fgColor, struct NodeData *overlayData,
+                              struct CanvasPainter *canvasPainter, struct DamagePainter *painter, struct Tracker *tracker) {
+    struct BoundingBox canvasBox;
+    getCanvasBox(&canvasBox);
+    initCanvasPainter(list, fgColor, true, overlayData, canvasPainter, painter);
+    initTracker(tracker, list, drawBackend, painter, &canvasBox);
+    tracker -> textBoxFunc = textBoxHook;
 }
 
 struct Vertex * trackEndPt(struct LinkedList *list, struct Vertex *startPt,
                         int shapeType, color_t newFgColor, color_t drawnFgColor) {
     assert(list != NULL && startPt != NULL);
 
-    struct Vertex *cntEndPt = makeVertex(startPt -> x, startPt -> y);
+    struct Vertex *cntEndPt = makeScratchVertex(startPt -> x, startPt -> y);
     drawShape(startPt, cntEndPt, shapeType, newFgColor);
+    struct CanvasPainter canvasPainter;
+    struct DamagePainter painter;
+    struct Tracker tracker;
+    initCanvasTracker(list, drawnFgColor, NULL, &canvasPainter, &painter, &tracker);
+    color_t prevFgColor = getcolor();
     while (true) {
-        mouse_msg m = getmouse();
+        mouse_msg m = nextTrackingMsg();
 
         if (m.is_move()) {
-            // Clear previous segment
-            redrawAll(list, drawnFgColor, true);
-            // Draw current segment
+            double frameStart = beginFrame();
             cntEndPt -> x = m.x;
             cntEndPt -> y = m.y;
             getRealPosition(cntEndPt);
-            drawShape(startPt, cntEndPt, shapeType, newFgColor);
+
+            // Clear previous segment, repainting only where it and the current one lie, and draw current segment
+            drawTrackedShape(&tracker, startPt, cntEndPt, shapeType, newFgColor);
+            endFrame(frameStart);
         }
 
         if (m.is_left() && m.is_up()) {
             // End tracking when left button is up
+            setcolor(prevFgColor);
             return cntEndPt;
         }
     }
@@ -429,48 +667,31 @@ void trackEditPts(struct LinkedList *list, struct NodeData *data, int assistId,
                 struct Vertex **startPt, struct Vertex **endPt) {
     assert(list != NULL && data!= NULL && *startPt == NULL && *endPt == NULL);
 
-    const int xType = assistId / 3, yType = assistId % 3;
-
     getStartEndPts(data, startPt, endPt, assistId);
     assert(startPt != NULL && endPt != NULL && *startPt != NULL && *endPt != NULL);
 
-    const int origx = (*endPt) -> x, origy = (*endPt) -> y;
+    const struct Vertex origPt = **endPt;
+    struct CanvasPainter canvasPainter;
+    struct DamagePainter painter;
+    struct Tracker tracker;
+    initCanvasTracker(list, SHAPE_DEFAULT_COLOR, data, &canvasPainter, &painter, &tracker);
+    color_t prevFgColor = getcolor();
 
     while (true) {
-        mouse_msg m = getmouse();
-
-        (*endPt) -> x = m.x;
-        (*endPt) -> y = m.y;
-        getRealPosition(*endPt);
-
-        if (xType == 2) {
-            (*endPt) -> x = origx;
-        }
-        if (yType == 2) {
-            (*endPt) -> y = origy;
-        }
+        mouse_msg m = nextTrackingMsg();
 
-        redrawAll(list, SHAPE_DEFAULT_COLOR, true);
-        drawNodeData(data, EDIT_ASSIST_COLOR, true);
-
-        if (data -> type == DATATYPE_TEXT) {
-            LOGFONT cntFont = defaultFont;
-            cntFont.lfHeight += abs((*endPt) -> x - origx);
-            cntFont.lfQuality = NONANTIALIASED_QUALITY;
-
-            struct Text *txt = (struct Text *)data -> content;
-            drawText(*startPt, *endPt,  txt -> content, &cntFont, SHAPE_DEFAULT_COLOR, CANVAS_COLOR);
-        } else {
-            drawShape(*startPt, *endPt, data -> type, SHAPE_DEFAULT_COLOR);
-        }
+        double frameStart = beginFrame();
+        struct Vertex cursorPt = {m.x, m.y};
+        getRealPosition(&cursorPt);
+        resizeTrackedPts(assistId, &origPt, cursorPt.x, cursorPt.y, *endPt);
+        drawTrackedData(&tracker, data, *startPt, *endPt, SHAPE_DEFAULT_COLOR);
+        endFrame(frameStart);
 
         if (m.is_up()) {
+            setcolor(prevFgColor);
             return;
         }
     }
-
-    destroyVertex(*startPt);
-    destroyVertex(*endPt);
 }
 
 void trackShape(struct LinkedList *list, struct NodeData *data, struct Vertex *cursorPt,
@@ -480,41 +701,30 @@ void trackShape(struct LinkedList *list, struct NodeData *data, struct Vertex *c
     getStartEndPts(data, startPt, endPt);
     assert(startPt != NULL && endPt != NULL && *startPt != NULL && *endPt != NULL);
 
+    struct CanvasPainter canvasPainter;
+    struct DamagePainter painter;
+    struct Tracker tracker;
+    initCanvasTracker(list, SHAPE_DEFAULT_COLOR, data, &canvasPainter, &painter, &tracker);
+    color_t prevFgColor = getcolor();
+
     while (true) {
-        mouse_msg m = getmouse();
+        mouse_msg m = nextTrackingMsg();
 
         if (whichArea(m.x) == AREA_MENU) {
+            setcolor(prevFgColor);
             return;
         }
 
-        int prevx = cursorPt -> x, prevy = cursorPt -> y;
-        cursorPt -> x = m.x;
-        cursorPt -> y = m.y;
-        getRealPosition(cursorPt);
-        int deltax = cursorPt -> x - prevx, deltay = cursorPt -> y - prevy;
-
-        (*startPt) -> x += deltax;
-        (*startPt) -> y += deltay;
-        (*endPt) -> x += deltax;
-        (*endPt) -> y += deltay;
-
-        redrawAll(list, SHAPE_DEFAULT_COLOR, true);
-        drawNodeData(data, EDIT_ASSIST_COLOR, true);
-
-        if (data -> type == DATATYPE_TEXT) {
-            struct Text *txt = (struct Text *)data -> content;
-            LOGFONT cntFont = defaultFont;
-            cntFont.lfQuality = NONANTIALIASED_QUALITY;
-            drawText(*startPt, *endPt, txt -> content, &cntFont, SHAPE_DEFAULT_COLOR, CANVAS_COLOR);
-        } else {
-            drawShape(*startPt, *endPt, data -> type, SHAPE_DEFAULT_COLOR);
-        }
+        double frameStart = beginFrame();
+        struct Vertex cntCursorPt = {m.x, m.y};
+        getRealPosition(&cntCursorPt);
+        moveTrackedPts(cursorPt, cntCursorPt.x, cntCursorPt.y, *startPt, *endPt);
+        drawTrackedData(&tracker, data, *startPt, *endPt, SHAPE_DEFAULT_COLOR);
+        endFrame(frameStart);
 
         if (m.is_up()) {
+            setcolor(prevFgColor);
             return;
         }
     }
-
-    destroyVertex(*startPt);
-    destroyVertex(*endPt);
 }
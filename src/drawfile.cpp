@@ -0,0 +1,347 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "drawfile.h"
+#include "shapestore.h"
+
+// Shapes handed to addNodesAtTail() at once by loading
+#define DRAWFILE_LOAD_BATCH_SIZE 1024
+
+static uint64_t alignSize(uint64_t size) {
+    return (size + DRAWFILE_ALIGN - 1) / DRAWFILE_ALIGN * DRAWFILE_ALIGN;
+}
+
+// Pad a section of given size up to the alignment of the next one
+static bool writePadding(FILE *file, uint64_t size) {
+    static const char padding[DRAWFILE_ALIGN] = {0};
+    size_t paddingSize = alignSize(size) - size;
+    return fwrite(padding, 1, paddingSize, file) == paddingSize;
+}
+
+static bool writeSection(FILE *file, const void *data, size_t size) {
+    return fwrite(data, 1, size, file) == size && writePadding(file, size);
+}
+
+// The columns are written straight from a ShapeStore filled in list order, so slot i is the i-th node
+// Complexity: O(n)
+bool saveDrawFile(const struct LinkedList *list, const char *path) {
+    assert(list != NULL && path != NULL);
+    struct ShapeStore *store = makeShapeStore();
+    if (store == NULL) {
+        return false;
+    }
+    if (!buildShapeStore(store, list)) {
+        destroyShapeStore(store);
+        return false;
+    }
+
+    struct DrawFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DRAWFILE_MAGIC, DRAWFILE_MAGIC_LENGTH);
+    header.version = DRAWFILE_VERSION;
+    header.byteOrder = DRAWFILE_BYTE_ORDER;
+    header.shapeNum = store -> slotNum;
+    header.sectionNum = DRAWFILE_SECTION_NUMBER;
+
+    uint64_t stringSize = 0;
+    for (int i = 0; i < store -> slotNum; i++) {
+        if (store -> type[i] == DATATYPE_TEXT) {
+            header.textNum++;
+            stringSize += strlen(store -> text[i]) + 1;
+        }
+    }
+
+    const int *columns[DRAWFILE_SECTION_R1] = {store -> type, store -> x0, store -> y0, store -> x1, store -> y1,
+                                               store -> r0, store -> r1};
+    struct DrawFileSection sections[DRAWFILE_SECTION_NUMBER];
+    uint64_t offset = alignSize(sizeof(header)) + alignSize(sizeof(sections));
+    for (int i = 0; i < DRAWFILE_SECTION_NUMBER; i++) {
+        sections[i].kind = i + 1;
+        if (sections[i].kind == DRAWFILE_SECTION_TEXT) {
+            sections[i].elemSize = sizeof(struct DrawFileText);
+            sections[i].count = header.textNum;
+        } else if (sections[i].kind == DRAWFILE_SECTION_STRINGS) {
+            sections[i].elemSize = 1;
+            sections[i].count = stringSize;
+        } else {
+            sections[i].elemSize = sizeof(int32_t);
+            sections[i].count = header.shapeNum;
+        }
+        sections[i].offset = offset;
+        offset += alignSize(sections[i].elemSize * sections[i].count);
+    }
+    header.fileSize = offset;
+
+    errno = 0;
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        perror("saveDrawFile");
+        destroyShapeStore(store);
+        return false;
+    }
+    bool isWritten = writeSection(file, &header, sizeof(header)) && writeSection(file, sections, sizeof(sections));
+    for (int i = 0; i < DRAWFILE_SECTION_R1 && isWritten; i++) {
+        isWritten = writeSection(file, columns[i], sizeof(int32_t) * store -> slotNum);
+    }
+
+    // Text records, then the contents they point to
+    uint32_t contentOffset = 0;
+    for (int i = 0; i < store -> slotNum && isWritten; i++) {
+        if (store -> type[i] == DATATYPE_TEXT) {
+            const struct Text *txt = (const struct Text *)store -> node[i] -> data -> content;
+            struct DrawFileText record = {i, txt -> fontWidth, txt -> fontHeight, contentOffset};
+            isWritten = fwrite(&record, sizeof(record), 1, file) == 1;
+            contentOffset += strlen(store -> text[i]) + 1;
+        }
+    }
+    for (int i = 0; i < store -> slotNum && isWritten; i++) {
+        if (store -> type[i] == DATATYPE_TEXT) {
+            size_t length = strlen(store -> text[i]) + 1;
+            isWritten = fwrite(store -> text[i], 1, length, file) == length;
+        }
+    }
+    isWritten = isWritten && writePadding(file, stringSize);
+    destroyShapeStore(store);
+
+    if (fclose(file) != 0 || !isWritten) {
+        perror("saveDrawFile");
+        return false;
+    }
+    return true;
+}
+
+// Map the whole file with private copy-on-write pages
+// Returns the address of the mapping, or NULL on failure
+static void * mapFile(const char *path, size_t *size) {
+#ifdef _WIN32
+    HANDLE fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        fprintf(stderr, "openDrawFile: cannot open %s\n", path);
+        return NULL;
+    }
+    LARGE_INTEGER fileSize;
+    void *base = NULL;
+    if (GetFileSizeEx(fileHandle, &fileSize) && fileSize.QuadPart > 0 && (unsigned long long)fileSize.QuadPart <= (size_t)-1) {
+        // The view keeps the mapping alive once both handles are closed
+        HANDLE mapHandle = CreateFileMappingA(fileHandle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+        if (mapHandle != NULL) {
+            base = MapViewOfFile(mapHandle, FILE_MAP_COPY, 0, 0, 0);
+            CloseHandle(mapHandle);
+        }
+        *size = (size_t)fileSize.QuadPart;
+    }
+    CloseHandle(fileHandle);
+    if (base == NULL) {
+        fprintf(stderr, "openDrawFile: cannot map %s\n", path);
+    }
+    return base;
+#else
+    errno = 0;
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        perror("openDrawFile");
+        return NULL;
+    }
+    struct stat fileStat;
+    void *base = NULL;
+    if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0) {
+        base = mmap(NULL, fileStat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        base = base == MAP_FAILED ? NULL : base;
+        *size = fileStat.st_size;
+    }
+    if (base == NULL) {
+        perror("openDrawFile");
+    }
+    close(fd);
+    return base;
+#endif
+}
+
+static void unmapFile(void *base, size_t size) {
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(base);
+#else
+    munmap(base, size);
+#endif
+}
+
+// Find the section of given kind, checking it lies within the file
+// Returns its pointer, or NULL if it is missing or malformed
+static const struct DrawFileSection * findSection(const struct DrawFile *file, const struct DrawFileSection *sections,
+                                                  int sectionNum, uint32_t kind, uint32_t elemSize) {
+    for (int i = 0; i < sectionNum; i++) {
+        if (sections[i].kind != kind) {
+            continue;
+        }
+        const struct DrawFileSection *section = sections + i;
+        bool isValid = section -> elemSize == elemSize && section -> offset % DRAWFILE_ALIGN == 0 &&
+                       section -> offset <= file -> size && section -> count <= (file -> size - section -> offset) / elemSize;
+        return isValid ? section : NULL;
+    }
+    return NULL;
+}
+
+// Check every value the rest of the program relies on
+// Complexity: O(n)
+static bool isValidDrawFile(struct DrawFile *file) {
+    const struct DrawFileHeader *header = (const struct DrawFileHeader *)file -> base;
+    if (file -> size < sizeof(struct DrawFileHeader) ||
+        memcmp(header -> magic, DRAWFILE_MAGIC, DRAWFILE_MAGIC_LENGTH) != 0 ||
+        header -> version != DRAWFILE_VERSION || header -> byteOrder != DRAWFILE_BYTE_ORDER ||
+        header -> fileSize != file -> size || header -> shapeNum > INT32_MAX || header -> textNum > header -> shapeNum) {
+        return false;
+    }
+
+    uint64_t sectionOffset = alignSize(sizeof(struct DrawFileHeader));
+    if (header -> sectionNum > (file -> size - sectionOffset) / sizeof(struct DrawFileSection)) {
+        return false;
+    }
+    const struct DrawFileSection *sections = (const struct DrawFileSection *)((const char *)file -> base + sectionOffset);
+    int sectionNum = header -> sectionNum;
+    file -> shapeNum = header -> shapeNum;
+    file -> textNum = header -> textNum;
+
+    int **columns[DRAWFILE_SECTION_R1] = {&file -> type, &file -> x0, &file -> y0, &file -> x1, &file -> y1,
+                                          &file -> r0, &file -> r1};
+    for (uint32_t kind = DRAWFILE_SECTION_TYPE; kind <= DRAWFILE_SECTION_R1; kind++) {
+        const struct DrawFileSection *section = findSection(file, sections, sectionNum, kind, sizeof(int32_t));
+        if (section == NULL || section -> count != (uint64_t)file -> shapeNum) {
+            return false;
+        }
+        *columns[kind - 1] = (int *)((char *)file -> base + section -> offset);
+    }
+    const struct DrawFileSection *textSection = findSection(file, sections, sectionNum, DRAWFILE_SECTION_TEXT,
+                                                            sizeof(struct DrawFileText));
+    const struct DrawFileSection *stringSection = findSection(file, sections, sectionNum, DRAWFILE_SECTION_STRINGS, 1);
+    if (textSection == NULL || textSection -> count != (uint64_t)file -> textNum || stringSection == NULL) {
+        return false;
+    }
+    file -> texts = (const struct DrawFileText *)((const char *)file -> base + textSection -> offset);
+    file -> strings = (const char *)file -> base + stringSection -> offset;
+    uint64_t stringSize = stringSection -> count;
+    // Every content offset then points to a terminated string
+    if (stringSize > 0 && file -> strings[stringSize - 1] != '\0') {
+        return false;
+    }
+
+    int textNum = 0;
+    for (int i = 0; i < file -> shapeNum; i++) {
+        if (!validateDataType(file -> type[i])) {
+            return false;
+        }
+        textNum += file -> type[i] == DATATYPE_TEXT;
+    }
+    if (textNum != file -> textNum) {
+        return false;
+    }
+    // Records are sorted by slot, so they match the texts one to one
+    for (int i = 0; i < file -> textNum; i++) {
+        const struct DrawFileText *record = file -> texts + i;
+        if (record -> slot < 0 || record -> slot >= file -> shapeNum || file -> type[record -> slot] != DATATYPE_TEXT ||
+            (i > 0 && record -> slot <= file -> texts[i - 1].slot) || record -> contentOffset >= stringSize) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Complexity: O(n)
+struct DrawFile * openDrawFile(const char *path) {
+    assert(path != NULL);
+    errno = 0;
+    struct DrawFile *file = (struct DrawFile *)calloc(1, sizeof(struct DrawFile));
+    if (file == NULL) {
+        perror("openDrawFile");
+        return NULL;
+    }
+    file -> base = mapFile(path, &file -> size);
+    if (file -> base == NULL) {
+        free(file);
+        return NULL;
+    }
+    if (!isValidDrawFile(file)) {
+        fprintf(stderr, "openDrawFile: %s is not a valid drawing\n", path);
+        closeDrawFile(file);
+        return NULL;
+    }
+    return file;
+}
+
+void closeDrawFile(struct DrawFile *file) {
+    assert(file != NULL);
+    unmapFile(file -> base, file -> size);
+    free(file);
+    file = NULL;
+}
+
+// Rebuild the shape at slot out of the columns
+// Returns its pointer, or NULL if out of memory
+static struct NodeData * makeSlotData(const struct DrawFile *file, int slot, const struct DrawFileText *record) {
+    switch (file -> type[slot]) {
+        case DATATYPE_SEGMENT: {
+            return makeData(makeSegment(makeVertex(file -> x0[slot], file -> y0[slot]),
+                                        makeVertex(file -> x1[slot], file -> y1[slot])), DATATYPE_SEGMENT);
+        }
+        case DATATYPE_RECTANGLE: {
+            return makeData(makeRectangle(makeVertex(file -> x0[slot], file -> y0[slot]),
+                                          makeVertex(file -> x1[slot], file -> y1[slot])), DATATYPE_RECTANGLE);
+        }
+        case DATATYPE_CIRCLE: {
+            return makeData(makeCircle(makeVertex(file -> x0[slot], file -> y0[slot]), file -> r0[slot]), DATATYPE_CIRCLE);
+        }
+        case DATATYPE_ELLIPSE: {
+            return makeData(makeEllipse(makeVertex(file -> x0[slot], file -> y0[slot]), file -> r0[slot], file -> r1[slot]),
+                            DATATYPE_ELLIPSE);
+        }
+        case DATATYPE_TEXT: {
+            assert(record != NULL && record -> slot == slot);
+            return makeData(makeText(makeRectangle(makeVertex(file -> x0[slot], file -> y0[slot]),
+                                                   makeVertex(file -> x1[slot], file -> y1[slot])),
+                                     file -> strings + record -> contentOffset, record -> fontWidth, record -> fontHeight),
+                            DATATYPE_TEXT);
+        }
+        default: {
+            return NULL;
+        }
+    }
+}
+
+// Every shape is still rebuilt as a node, only the ShapeStore is spared its copy by mapping
+// Complexity: O(n)
+bool loadDrawFile(struct LinkedList *list, const struct DrawFile *file) {
+    assert(list != NULL && file != NULL);
+    struct NodeData *batch[DRAWFILE_LOAD_BATCH_SIZE];
+    const struct DrawFileText *record = file -> texts;
+    int slot = 0;
+    while (slot < file -> shapeNum) {
+        int dataNum = 0;
+        for (; slot < file -> shapeNum && dataNum < DRAWFILE_LOAD_BATCH_SIZE; slot++) {
+            struct NodeData *data = makeSlotData(file, slot, file -> type[slot] == DATATYPE_TEXT ? record++ : NULL);
+            if (data == NULL) {
+                break;
+            }
+            batch[dataNum++] = data;
+        }
+        int addedNum = addNodesAtTail(list, batch, dataNum);
+        for (int i = addedNum; i < dataNum; i++) {
+            destroyRule(batch[i]);
+        }
+        if (addedNum < dataNum || (slot < file -> shapeNum && dataNum < DRAWFILE_LOAD_BATCH_SIZE)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,664 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+
+#include "dxf.h"
+#include "textwriter.h"
+
+// Entities the reader knows about
+#define DXF_ENTITY_NONE 0
+#define DXF_ENTITY_LINE 1
+#define DXF_ENTITY_LWPOLYLINE 2
+#define DXF_ENTITY_CIRCLE 3
+#define DXF_ENTITY_ELLIPSE 4
+#define DXF_ENTITY_TEXT 5
+#define DXF_ENTITY_MTEXT 6
+#define DXF_ENTITY_OTHER 7
+
+// Enough corners to recognize a rectangle closed by repeating its first corner
+#define DXF_MAX_VERTICES 5
+
+// Entities reaching further out are skipped, keeping later arithmetic clear of overflows
+#define DXF_COORDINATE_LIMIT 1e9
+
+#define DXF_PI 3.14159265358979323846
+
+// Group values of the entity being read
+struct DxfEntity {
+    int kind;
+    double x[DXF_MAX_VERTICES], y[DXF_MAX_VERTICES];
+    int vertexNum;
+    bool isTooManyVertices, hasBulge;
+    double x1, y1;
+    double value40, value41, value42;
+    int flags;
+    int textLength;
+    char text[DATATYPE_TEXT_MAX_LENGTH];
+};
+
+struct DxfReader {
+    FILE *file;
+    // Unread bytes are buffer[begin] to buffer[end - 1], one more byte is kept for a terminator
+    int begin, end;
+    bool isEnd, isFailed, isStopped;
+    char buffer[DXF_BUFFER_SIZE + 1];
+
+    int pageHeight;
+    struct DxfEntity entity;
+    bool (*batchFunc)(void *arg, const struct DxfShape *shapes, int shapeNum);
+    void *arg;
+    int shapeNum;
+    struct DxfShape shapes[DXF_BATCH_SIZE];
+    struct DxfStats stats;
+};
+
+// Get the next line, without its line break
+// Returns its pointer into the buffer, valid until the next call, or NULL at the end of the file or on error
+static char * readLine(struct DxfReader *reader) {
+    while (true) {
+        char *start = reader -> buffer + reader -> begin;
+        char *lineEnd = (char *)memchr(start, '\n', reader -> end - reader -> begin);
+        if (lineEnd == NULL && reader -> isEnd) {
+            if (reader -> begin == reader -> end) {
+                return NULL;
+            }
+            // Last line without a line break
+            lineEnd = reader -> buffer + reader -> end;
+        }
+        if (lineEnd != NULL) {
+            reader -> begin = min((int)(lineEnd - reader -> buffer) + 1, reader -> end);
+            *lineEnd = '\0';
+            if (lineEnd > start && lineEnd[-1] == '\r') {
+                lineEnd[-1] = '\0';
+            }
+            return start;
+        }
+        if (reader -> begin == 0 && reader -> end == DXF_BUFFER_SIZE) {
+            // No line is that long in a sane file
+            reader -> isFailed = true;
+            return NULL;
+        }
+
+        memmove(reader -> buffer, start, reader -> end - reader -> begin);
+        reader -> end -= reader -> begin;
+        reader -> begin = 0;
+        size_t readSize = fread(reader -> buffer + reader -> end, 1, DXF_BUFFER_SIZE - reader -> end, reader -> file);
+        reader -> end += readSize;
+        if (readSize == 0) {
+            reader -> isEnd = true;
+            reader -> isFailed = ferror(reader -> file) != 0;
+        }
+    }
+}
+
+// Parse a whole line as an integer, surrounding blanks allowed
+// Returns false if it is not one
+static bool parseInt(const char *text, int *value) {
+    while (*text == ' ' || *text == '\t') {
+        text++;
+    }
+    bool isNegative = *text == '-';
+    if (*text == '-' || *text == '+') {
+        text++;
+    }
+    if (*text < '0' || *text > '9') {
+        return false;
+    }
+    long long int result = 0;
+    for (; *text >= '0' && *text <= '9' && result <= INT32_MAX; text++) {
+        result = result * 10 + (*text - '0');
+    }
+    while (*text == ' ' || *text == '\t') {
+        text++;
+    }
+    if (*text != '\0' || result > INT32_MAX) {
+        return false;
+    }
+    *value = isNegative ? -result : result;
+    return true;
+}
+
+// Parse a number, plain decimals take a fast path and anything else goes through strtod()
+// Returns the number, 0 if there is none
+static double parseNumber(const char *text) {
+    static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+                                    1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18};
+    const char *cntChar = text;
+    while (*cntChar == ' ' || *cntChar == '\t') {
+        cntChar++;
+    }
+    bool isNegative = *cntChar == '-';
+    if (*cntChar == '-' || *cntChar == '+') {
+        cntChar++;
+    }
+    long long int mantissa = 0;
+    int digitNum = 0, scale = 0;
+    for (; *cntChar >= '0' && *cntChar <= '9' && digitNum < 18; cntChar++, digitNum++) {
+        mantissa = mantissa * 10 + (*cntChar - '0');
+    }
+    if (*cntChar == '.') {
+        for (cntChar++; *cntChar >= '0' && *cntChar <= '9' && digitNum < 18; cntChar++, digitNum++, scale++) {
+            mantissa = mantissa * 10 + (*cntChar - '0');
+        }
+    }
+    // Longer mantissas stop short of the end and take the slow path too
+    if (*cntChar != '\0' || digitNum == 0) {
+        return strtod(text, NULL);
+    }
+    double value = mantissa / powers[scale];
+    return isNegative ? -value : value;
+}
+
+// Read a group code and its value
+// Returns false at the end of the file or on error
+static bool readGroup(struct DxfReader *reader, int *code, char **value) {
+    char *codeLine = readLine(reader);
+    if (codeLine == NULL) {
+        return false;
+    }
+    if (!parseInt(codeLine, code) || (*value = readLine(reader)) == NULL) {
+        reader -> isFailed = true;
+        return false;
+    }
+    return true;
+}
+
+static void beginEntity(struct DxfEntity *entity, const char *name) {
+    if (strcmp(name, "LINE") == 0) {
+        entity -> kind = DXF_ENTITY_LINE;
+    } else if (strcmp(name, "LWPOLYLINE") == 0) {
+        entity -> kind = DXF_ENTITY_LWPOLYLINE;
+    } else if (strcmp(name, "CIRCLE") == 0) {
+        entity -> kind = DXF_ENTITY_CIRCLE;
+    } else if (strcmp(name, "ELLIPSE") == 0) {
+        entity -> kind = DXF_ENTITY_ELLIPSE;
+    } else if (strcmp(name, "TEXT") == 0) {
+        entity -> kind = DXF_ENTITY_TEXT;
+    } else if (strcmp(name, "MTEXT") == 0) {
+        entity -> kind = DXF_ENTITY_MTEXT;
+    } else if (strcmp(name, "VERTEX") == 0 || strcmp(name, "SEQEND") == 0) {
+        // Parts of a POLYLINE, which is counted once
+        entity -> kind = DXF_ENTITY_NONE;
+    } else {
+        entity -> kind = DXF_ENTITY_OTHER;
+    }
+
+    entity -> x[0] = entity -> y[0] = 0;
+    entity -> vertexNum = 0;
+    entity -> isTooManyVertices = entity -> hasBulge = false;
+    entity -> x1 = entity -> y1 = 0;
+    // Defaults: natural width for text, a whole turn for ellipses
+    entity -> value40 = 0;
+    entity -> value41 = entity -> kind == DXF_ENTITY_TEXT ? 1 : 0;
+    entity -> value42 = entity -> kind == DXF_ENTITY_ELLIPSE ? 2 * DXF_PI : 0;
+    entity -> flags = 0;
+    entity -> textLength = 0;
+    entity -> text[0] = '\0';
+}
+
+static void appendText(struct DxfEntity *entity, const char *text) {
+    while (*text != '\0' && entity -> textLength < DATATYPE_TEXT_MAX_LENGTH - 1) {
+        entity -> text[entity -> textLength++] = *text++;
+    }
+    entity -> text[entity -> textLength] = '\0';
+}
+
+// Complexity: O(1), O(length) for text
+static void setGroup(struct DxfEntity *entity, int code, const char *value) {
+    switch (code) {
+        case 10: {
+            if (entity -> vertexNum < DXF_MAX_VERTICES) {
+                entity -> x[entity -> vertexNum] = parseNumber(value);
+                entity -> y[entity -> vertexNum] = 0;
+                entity -> vertexNum++;
+            } else {
+                entity -> isTooManyVertices = true;
+            }
+            break;
+        }
+        case 20: {
+            if (entity -> vertexNum > 0 && !entity -> isTooManyVertices) {
+                entity -> y[entity -> vertexNum - 1] = parseNumber(value);
+            }
+            break;
+        }
+        case 11: {
+            entity -> x1 = parseNumber(value);
+            break;
+        }
+        case 21: {
+            entity -> y1 = parseNumber(value);
+            break;
+        }
+        case 40: {
+            entity -> value40 = parseNumber(value);
+            break;
+        }
+        case 41: {
+            entity -> value41 = parseNumber(value);
+            break;
+        }
+        case 42: {
+            // Bulges of polyline vertices turn edges into arcs
+            double number = parseNumber(value);
+            entity -> hasBulge = entity -> hasBulge || (entity -> kind == DXF_ENTITY_LWPOLYLINE && number != 0);
+            entity -> value42 = number;
+            break;
+        }
+        case 70: {
+            if (!parseInt(value, &entity -> flags)) {
+                entity -> flags = 0;
+            }
+            break;
+        }
+        case 1: {
+            appendText(entity, value);
+            break;
+        }
+        case 3: {
+            // Leading chunks of a long MTEXT, code 1 holds the last one
+            if (entity -> kind == DXF_ENTITY_MTEXT) {
+                appendText(entity, value);
+            }
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+// Round a DXF number to a CADET coordinate
+static int roundCoordinate(double value, bool *isFit) {
+    if (!(value >= -DXF_COORDINATE_LIMIT && value <= DXF_COORDINATE_LIMIT)) {
+        *isFit = false;
+        return 0;
+    }
+    return (int)floor(value + 0.5);
+}
+
+// Recognize four distinct corners of an axis-aligned rectangle, in drawing order
+static bool isRectangleCorners(const int *x, const int *y, int *minx, int *miny, int *maxx, int *maxy) {
+    *minx = *maxx = x[0];
+    *miny = *maxy = y[0];
+    for (int i = 1; i < 4; i++) {
+        *minx = min(*minx, x[i]);
+        *maxx = max(*maxx, x[i]);
+        *miny = min(*miny, y[i]);
+        *maxy = max(*maxy, y[i]);
+    }
+    if (*minx == *maxx || *miny == *maxy) {
+        return false;
+    }
+    int cornerMask = 0;
+    for (int i = 0; i < 4; i++) {
+        int next = (i + 1) % 4;
+        if ((x[i] != *minx && x[i] != *maxx) || (y[i] != *miny && y[i] != *maxy) ||
+            (x[i] != x[next] && y[i] != y[next])) {
+            return false;
+        }
+        cornerMask |= 1 << ((x[i] == *maxx) * 2 + (y[i] == *maxy));
+    }
+    return cornerMask == 15;
+}
+
+// Turn the entity just read into a shape
+// Returns false if it has no CADET counterpart
+static bool makeShape(const struct DxfEntity *entity, int pageHeight, struct DxfShape *shape) {
+    bool isFit = true;
+    shape -> x0 = shape -> y0 = shape -> x1 = shape -> y1 = 0;
+    shape -> r0 = shape -> r1 = 0;
+    shape -> fontHeight = 0;
+    shape -> text[0] = '\0';
+
+    switch (entity -> kind) {
+        case DXF_ENTITY_LINE: {
+            shape -> type = DATATYPE_SEGMENT;
+            shape -> x0 = roundCoordinate(entity -> x[0], &isFit);
+            shape -> y0 = roundCoordinate(pageHeight - entity -> y[0], &isFit);
+            shape -> x1 = roundCoordinate(entity -> x1, &isFit);
+            shape -> y1 = roundCoordinate(pageHeight - entity -> y1, &isFit);
+            return isFit;
+        }
+        case DXF_ENTITY_LWPOLYLINE: {
+            int vertexNum = entity -> vertexNum;
+            bool isClosed = (entity -> flags & 1) != 0;
+            int x[DXF_MAX_VERTICES], y[DXF_MAX_VERTICES];
+            for (int i = 0; i < vertexNum; i++) {
+                x[i] = roundCoordinate(entity -> x[i], &isFit);
+                y[i] = roundCoordinate(pageHeight - entity -> y[i], &isFit);
+            }
+            // A fifth corner may close the outline instead of the flag
+            if (vertexNum == 5 && x[4] == x[0] && y[4] == y[0]) {
+                vertexNum = 4;
+                isClosed = true;
+            }
+            shape -> type = DATATYPE_RECTANGLE;
+            return isFit && !entity -> isTooManyVertices && !entity -> hasBulge && vertexNum == 4 && isClosed &&
+                   isRectangleCorners(x, y, &shape -> x0, &shape -> y0, &shape -> x1, &shape -> y1);
+        }
+        case DXF_ENTITY_CIRCLE: {
+            shape -> type = DATATYPE_CIRCLE;
+            shape -> x0 = roundCoordinate(entity -> x[0], &isFit);
+            shape -> y0 = roundCoordinate(pageHeight - entity -> y[0], &isFit);
+            shape -> r0 = roundCoordinate(entity -> value40, &isFit);
+            return isFit && shape -> r0 >= 0;
+        }
+        case DXF_ENTITY_ELLIPSE: {
+            // The major axis endpoint is relative to the center, 40 is the axis ratio, 41 and 42 the parameter range
+            double majorx = fabs(entity -> x1), majory = fabs(entity -> y1), ratio = entity -> value40;
+            bool isWhole = fabs(entity -> value41) < 1e-6 && fabs(entity -> value42 - 2 * DXF_PI) < 1e-6;
+            shape -> type = DATATYPE_ELLIPSE;
+            shape -> x0 = roundCoordinate(entity -> x[0], &isFit);
+            shape -> y0 = roundCoordinate(pageHeight - entity -> y[0], &isFit);
+            if (majory <= majorx * 1e-9) {
+                shape -> r0 = roundCoordinate(majorx, &isFit);
+                shape -> r1 = roundCoordinate(majorx * ratio, &isFit);
+            } else if (majorx <= majory * 1e-9) {
+                shape -> r0 = roundCoordinate(majory * ratio, &isFit);
+                shape -> r1 = roundCoordinate(majory, &isFit);
+            } else {
+                return false;
+            }
+            return isFit && isWhole && ratio >= 0;
+        }
+        case DXF_ENTITY_TEXT:
+        case DXF_ENTITY_MTEXT: {
+            // TEXT is placed by its baseline start, MTEXT by its upper left corner
+            double height = entity -> value40;
+            shape -> type = DATATYPE_TEXT;
+            shape -> fontHeight = roundCoordinate(height, &isFit);
+            shape -> x0 = roundCoordinate(entity -> x[0], &isFit);
+            double width = entity -> textLength * height / DXF_TEXT_ASPECT;
+            if (entity -> kind == DXF_ENTITY_TEXT) {
+                shape -> y1 = roundCoordinate(pageHeight - entity -> y[0], &isFit);
+                shape -> y0 = shape -> y1 - shape -> fontHeight;
+                width *= entity -> value41;
+            } else {
+                shape -> y0 = roundCoordinate(pageHeight - entity -> y[0], &isFit);
+                shape -> y1 = shape -> y0 + shape -> fontHeight;
+                width = entity -> value41 > 0 ? entity -> value41 : width;
+            }
+            shape -> x1 = shape -> x0 + roundCoordinate(width, &isFit);
+            memcpy(shape -> text, entity -> text, entity -> textLength + 1);
+            return isFit && entity -> textLength > 0 && shape -> fontHeight >= 0 && shape -> x1 >= shape -> x0;
+        }
+        default: {
+            return false;
+        }
+    }
+}
+
+static void flushShapes(struct DxfReader *reader) {
+    if (reader -> shapeNum > 0 && !reader -> isStopped) {
+        reader -> isStopped = !reader -> batchFunc(reader -> arg, reader -> shapes, reader -> shapeNum);
+    }
+    reader -> shapeNum = 0;
+}
+
+static void finishEntity(struct DxfReader *reader) {
+    if (reader -> entity.kind == DXF_ENTITY_NONE) {
+        return;
+    }
+    if (makeShape(&reader -> entity, reader -> pageHeight, reader -> shapes + reader -> shapeNum)) {
+        reader -> stats.readNum++;
+        if (++reader -> shapeNum == DXF_BATCH_SIZE) {
+            flushShapes(reader);
+        }
+    } else {
+        reader -> stats.skippedNum++;
+    }
+    reader -> entity.kind = DXF_ENTITY_NONE;
+}
+
+// Complexity: O(file size)
+bool readDxf(const char *path, int pageHeight,
+             bool (*batchFunc)(void *arg, const struct DxfShape *shapes, int shapeNum), void *arg,
+             struct DxfStats *stats) {
+    assert(path != NULL && batchFunc != NULL);
+    errno = 0;
+    struct DxfReader *reader = (struct DxfReader *)malloc(sizeof(struct DxfReader));
+    if (reader == NULL) {
+        perror("readDxf");
+        return false;
+    }
+    reader -> file = fopen(path, "rb");
+    if (reader -> file == NULL) {
+        perror("readDxf");
+        free(reader);
+        return false;
+    }
+    reader -> begin = reader -> end = 0;
+    reader -> isEnd = reader -> isFailed = reader -> isStopped = false;
+    reader -> pageHeight = pageHeight;
+    reader -> entity.kind = DXF_ENTITY_NONE;
+    reader -> batchFunc = batchFunc;
+    reader -> arg = arg;
+    reader -> shapeNum = 0;
+    reader -> stats.readNum = reader -> stats.skippedNum = 0;
+
+    // Only entities of the ENTITIES section are drawn, those inside BLOCKS are not referenced
+    bool isSectionName = false, isInEntities = false, isEof = false;
+    int code;
+    char *value;
+    while (!reader -> isStopped && readGroup(reader, &code, &value)) {
+        if (code == 0) {
+            finishEntity(reader);
+            isSectionName = strcmp(value, "SECTION") == 0;
+            if (isSectionName || strcmp(value, "ENDSEC") == 0) {
+                isInEntities = false;
+            } else if (strcmp(value, "EOF") == 0) {
+                isEof = true;
+                break;
+            } else if (isInEntities) {
+                beginEntity(&reader -> entity, value);
+            }
+        } else if (code == 2 && isSectionName) {
+            isInEntities = strcmp(value, "ENTITIES") == 0;
+            isSectionName = false;
+        } else if (reader -> entity.kind != DXF_ENTITY_NONE && reader -> entity.kind != DXF_ENTITY_OTHER) {
+            setGroup(&reader -> entity, code, value);
+        }
+    }
+    // An entity cut short by an error is left out
+    if (!reader -> isFailed) {
+        finishEntity(reader);
+    }
+    flushShapes(reader);
+
+    bool isRead = !reader -> isFailed && !reader -> isStopped && (isEof || reader -> isEnd);
+    if (reader -> isFailed) {
+        fprintf(stderr, "readDxf: %s is not a readable DXF file\n", path);
+    }
+    if (stats != NULL) {
+        *stats = reader -> stats;
+    }
+    fclose(reader -> file);
+    free(reader);
+    return isRead;
+}
+
+// Build the node data of a shape
+// Returns its pointer, or NULL if out of memory
+static struct NodeData * makeShapeData(const struct DxfShape *shape) {
+    switch (shape -> type) {
+        case DATATYPE_SEGMENT: {
+            return makeData(makeSegment(makeVertex(shape -> x0, shape -> y0), makeVertex(shape -> x1, shape -> y1)),
+                            DATATYPE_SEGMENT);
+        }
+        case DATATYPE_RECTANGLE: {
+            return makeData(makeRectangle(makeVertex(shape -> x0, shape -> y0), makeVertex(shape -> x1, shape -> y1)),
+                            DATATYPE_RECTANGLE);
+        }
+        case DATATYPE_CIRCLE: {
+            return makeData(makeCircle(makeVertex(shape -> x0, shape -> y0), shape -> r0), DATATYPE_CIRCLE);
+        }
+        case DATATYPE_ELLIPSE: {
+            return makeData(makeEllipse(makeVertex(shape -> x0, shape -> y0), shape -> r0, shape -> r1), DATATYPE_ELLIPSE);
+        }
+        case DATATYPE_TEXT: {
+            return makeData(makeText(makeRectangle(makeVertex(shape -> x0, shape -> y0), makeVertex(shape -> x1, shape -> y1)),
+                                     shape -> text, 0, shape -> fontHeight), DATATYPE_TEXT);
+        }
+        default: {
+            return NULL;
+        }
+    }
+}
+
+static bool addBatchHook(void *arg, const struct DxfShape *shapes, int shapeNum) {
+    struct LinkedList *list = (struct LinkedList *)arg;
+    struct NodeData *batch[DXF_BATCH_SIZE];
+    int dataNum = 0;
+    while (dataNum < shapeNum && (batch[dataNum] = makeShapeData(shapes + dataNum)) != NULL) {
+        dataNum++;
+    }
+    int addedNum = addNodesAtTail(list, batch, dataNum);
+    for (int i = addedNum; i < dataNum; i++) {
+        destroyRule(batch[i]);
+    }
+    return addedNum == shapeNum;
+}
+
+bool importDxf(struct LinkedList *list, const char *path, int pageHeight, struct DxfStats *stats) {
+    assert(list != NULL && path != NULL);
+    return readDxf(path, pageHeight, addBatchHook, list, stats);
+}
+
+static void writeIntGroup(struct TextWriter *writer, int code, long long int value) {
+    char *out = reserveTextWriter(writer, 2 * TEXT_WRITER_MAX_NUMBER);
+    int length = formatInt(out, code);
+    out[length++] = '\n';
+    length += formatInt(out + length, value);
+    out[length++] = '\n';
+    commitTextWriter(writer, length);
+}
+
+static void writeRealGroup(struct TextWriter *writer, int code, double value) {
+    char *out = reserveTextWriter(writer, 2 * TEXT_WRITER_MAX_NUMBER);
+    int length = formatInt(out, code);
+    out[length++] = '\n';
+    length += snprintf(out + length, TEXT_WRITER_MAX_NUMBER, "%.10g", value);
+    out[length++] = '\n';
+    commitTextWriter(writer, length);
+}
+
+// Line breaks inside value would split it into bogus groups, they become spaces
+static void writeStringGroup(struct TextWriter *writer, int code, const char *value) {
+    int valueLength = strlen(value);
+    char *out = reserveTextWriter(writer, valueLength + TEXT_WRITER_MAX_NUMBER);
+    int length = formatInt(out, code);
+    out[length++] = '\n';
+    for (int i = 0; i < valueLength; i++) {
+        out[length++] = value[i] == '\n' || value[i] == '\r' ? ' ' : value[i];
+    }
+    out[length++] = '\n';
+    commitTextWriter(writer, length);
+}
+
+static void writeEntityStart(struct TextWriter *writer, const char *name, const char *subclass) {
+    writeStringGroup(writer, 0, name);
+    writeStringGroup(writer, 100, "AcDbEntity");
+    writeStringGroup(writer, 8, "0");
+    writeStringGroup(writer, 100, subclass);
+}
+
+static void writePoint(struct TextWriter *writer, int code, int x, int y, int pageHeight) {
+    writeIntGroup(writer, code, x);
+    writeIntGroup(writer, code + 10, (long long int)pageHeight - y);
+    writeIntGroup(writer, code + 20, 0);
+}
+
+static void writeData(struct TextWriter *writer, const struct NodeData *data, int pageHeight) {
+    switch (data -> type) {
+        case DATATYPE_SEGMENT: {
+            const struct Segment *seg = (const struct Segment *)data -> content;
+            writeEntityStart(writer, "LINE", "AcDbLine");
+            writePoint(writer, 10, seg -> leftPt -> x, seg -> leftPt -> y, pageHeight);
+            writePoint(writer, 11, seg -> rightPt -> x, seg -> rightPt -> y, pageHeight);
+            break;
+        }
+        case DATATYPE_RECTANGLE: {
+            const struct Rectangle *rec = (const struct Rectangle *)data -> content;
+            writeEntityStart(writer, "LWPOLYLINE", "AcDbPolyline");
+            writeIntGroup(writer, 90, 4);
+            writeIntGroup(writer, 70, 1);
+            const int cornerx[4] = {rec -> lowerLeftPt -> x, rec -> upperRightPt -> x, rec -> upperRightPt -> x, rec -> lowerLeftPt -> x};
+            const int cornery[4] = {rec -> lowerLeftPt -> y, rec -> lowerLeftPt -> y, rec -> upperRightPt -> y, rec -> upperRightPt -> y};
+            for (int i = 0; i < 4; i++) {
+                writeIntGroup(writer, 10, cornerx[i]);
+                writeIntGroup(writer, 20, (long long int)pageHeight - cornery[i]);
+            }
+            break;
+        }
+        case DATATYPE_CIRCLE: {
+            const struct Circle *cir = (const struct Circle *)data -> content;
+            writeEntityStart(writer, "CIRCLE", "AcDbCircle");
+            writePoint(writer, 10, cir -> centerPt -> x, cir -> centerPt -> y, pageHeight);
+            writeIntGroup(writer, 40, cir -> radius);
+            break;
+        }
+        case DATATYPE_ELLIPSE: {
+            // The longer of the two semi axes is the DXF major axis
+            const struct Ellipse *elp = (const struct Ellipse *)data -> content;
+            bool isMajorX = elp -> majorSemiAxis >= elp -> minorSemiAxis;
+            int majorAxis = isMajorX ? elp -> majorSemiAxis : elp -> minorSemiAxis;
+            int minorAxis = isMajorX ? elp -> minorSemiAxis : elp -> majorSemiAxis;
+            writeEntityStart(writer, "ELLIPSE", "AcDbEllipse");
+            writePoint(writer, 10, elp -> centerPt -> x, elp -> centerPt -> y, pageHeight);
+            writeIntGroup(writer, 11, isMajorX ? majorAxis : 0);
+            writeIntGroup(writer, 21, isMajorX ? 0 : majorAxis);
+            writeIntGroup(writer, 31, 0);
+            writeRealGroup(writer, 40, majorAxis == 0 ? 1.0 : (double)minorAxis / majorAxis);
+            writeIntGroup(writer, 41, 0);
+            writeRealGroup(writer, 42, 2 * DXF_PI);
+            break;
+        }
+        case DATATYPE_TEXT: {
+            // Placed by the baseline start, the width factor keeps the box width
+            const struct Text *txt = (const struct Text *)data -> content;
+            const struct Rectangle *pos = txt -> position;
+            int height = pos -> upperRightPt -> y - pos -> lowerLeftPt -> y;
+            int width = pos -> upperRightPt -> x - pos -> lowerLeftPt -> x;
+            double naturalWidth = (double)strlen(txt -> content) * height / DXF_TEXT_ASPECT;
+            writeEntityStart(writer, "TEXT", "AcDbText");
+            writePoint(writer, 10, pos -> lowerLeftPt -> x, pos -> upperRightPt -> y, pageHeight);
+            writeIntGroup(writer, 40, height);
+            writeStringGroup(writer, 1, txt -> content);
+            writeRealGroup(writer, 41, naturalWidth > 0 ? width / naturalWidth : 1.0);
+            writeStringGroup(writer, 100, "AcDbText");
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+// Complexity: O(n)
+bool exportDxf(const struct LinkedList *list, const char *path, int pageHeight) {
+    assert(list != NULL && path != NULL);
+    struct TextWriter *writer = makeTextWriter(path);
+    if (writer == NULL) {
+        return false;
+    }
+
+    // LWPOLYLINE and ELLIPSE need AutoCAD 2000 (AC1015) at least
+    writeStringGroup(writer, 0, "SECTION");
+    writeStringGroup(writer, 2, "HEADER");
+    writeStringGroup(writer, 9, "$ACADVER");
+    writeStringGroup(writer, 1, "AC1015");
+    writeStringGroup(writer, 0, "ENDSEC");
+    writeStringGroup(writer, 0, "SECTION");
+    writeStringGroup(writer, 2, "ENTITIES");
+    for (const struct LinkedNode *cntNode = list -> head; cntNode != NULL; cntNode = cntNode -> next) {
+        writeData(writer, cntNode -> data, pageHeight);
+    }
+    writeStringGroup(writer, 0, "ENDSEC");
+    writeStringGroup(writer, 0, "EOF");
+    return destroyTextWriter(writer);
+}
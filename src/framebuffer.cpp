@@ -0,0 +1,294 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <errno.h>
+
+#include "framebuffer.h"
+#include "datatypes.h"
+#include "render.h"
+
+struct FrameBuffer * makeFrameBuffer(int width, int height) {
+    assert(width > 0 && height > 0);
+    errno = 0;
+    struct FrameBuffer *fb = (struct FrameBuffer *)malloc(sizeof(struct FrameBuffer));
+    if (fb == NULL) {
+        perror("makeFrameBuffer");
+        return NULL;
+    }
+    errno = 0;
+    fb -> pixels = (unsigned int *)calloc((size_t)width * height, sizeof(unsigned int));
+    if (fb -> pixels == NULL) {
+        perror("makeFrameBuffer");
+        free(fb);
+        return NULL;
+    }
+    fb -> width = width;
+    fb -> height = height;
+    fb -> color = 0xFFFFFF;
+    fb -> bgColor = 0;
+    fb -> overlayData = NULL;
+    fb -> overlayColor = 0xFFFFFF;
+    setFrameBufferClip(fb, NULL);
+    return fb;
+}
+
+void destroyFrameBuffer(struct FrameBuffer *fb) {
+    assert(fb != NULL);
+    free(fb -> pixels);
+    free(fb);
+    fb = NULL;
+}
+
+void setFrameBufferClip(struct FrameBuffer *fb, const struct BoundingBox *rect) {
+    assert(fb != NULL);
+    fb -> clip.minx = 0;
+    fb -> clip.miny = 0;
+    fb -> clip.maxx = fb -> width - 1;
+    fb -> clip.maxy = fb -> height - 1;
+    if (rect != NULL) {
+        fb -> clip.minx = max(fb -> clip.minx, rect -> minx);
+        fb -> clip.miny = max(fb -> clip.miny, rect -> miny);
+        fb -> clip.maxx = min(fb -> clip.maxx, rect -> maxx);
+        fb -> clip.maxy = min(fb -> clip.maxy, rect -> maxy);
+    }
+}
+
+void fbPutPixel(struct FrameBuffer *fb, int x, int y, unsigned int color) {
+    if (isInBox(x, y, &fb -> clip)) {
+        fb -> pixels[(size_t)y * fb -> width + x] = color;
+    }
+}
+
+// Bresenham, every octant walks from (x0, y0) to (x1, y1)
+// Complexity: O(length)
+void fbLine(struct FrameBuffer *fb, int x0, int y0, int x1, int y1, unsigned int color) {
+    assert(fb != NULL);
+    long long int dx = llabs((long long int)x1 - x0), dy = -llabs((long long int)y1 - y0);
+    int stepx = x0 < x1 ? 1 : -1, stepy = y0 < y1 ? 1 : -1;
+    long long int err = dx + dy;
+    int x = x0, y = y0;
+    while (true) {
+        fbPutPixel(fb, x, y, color);
+        if (x == x1 && y == y1) {
+            break;
+        }
+        long long int err2 = err * 2;
+        if (err2 >= dy) {
+            err += dy;
+            x += stepx;
+        }
+        if (err2 <= dx) {
+            err += dx;
+            y += stepy;
+        }
+    }
+}
+
+void fbRectangle(struct FrameBuffer *fb, int left, int top, int right, int bottom, unsigned int color) {
+    fbLine(fb, left, top, right, top, color);
+    fbLine(fb, right, top, right, bottom, color);
+    fbLine(fb, right, bottom, left, bottom, color);
+    fbLine(fb, left, bottom, left, top, color);
+}
+
+static void putSymmetricPixels(struct FrameBuffer *fb, int centerx, int centery, int x, int y, unsigned int color) {
+    fbPutPixel(fb, centerx + x, centery + y, color);
+    fbPutPixel(fb, centerx - x, centery + y, color);
+    fbPutPixel(fb, centerx + x, centery - y, color);
+    fbPutPixel(fb, centerx - x, centery - y, color);
+}
+
+// Midpoint circle
+// Complexity: O(radius)
+void fbCircle(struct FrameBuffer *fb, int centerx, int centery, int radius, unsigned int color) {
+    assert(fb != NULL);
+    radius = abs(radius);
+    int x = radius, y = 0;
+    long long int err = 1 - (long long int)radius;
+    while (x >= y) {
+        putSymmetricPixels(fb, centerx, centery, x, y, color);
+        putSymmetricPixels(fb, centerx, centery, y, x, color);
+        y++;
+        if (err < 0) {
+            err += 2LL * y + 1;
+        } else {
+            x--;
+            err += 2LL * (y - x) + 1;
+        }
+    }
+}
+
+// Midpoint ellipse, region 1 steps along x and region 2 along y
+// Complexity: O(xRadius + yRadius)
+void fbEllipse(struct FrameBuffer *fb, int centerx, int centery, int xRadius, int yRadius, unsigned int color) {
+    assert(fb != NULL);
+    long long int a = abs(xRadius), b = abs(yRadius);
+    if (a == 0 || b == 0) {
+        fbLine(fb, centerx - (int)a, centery - (int)b, centerx + (int)a, centery + (int)b, color);
+        return;
+    }
+
+    long long int a2 = a * a, b2 = b * b;
+    long long int x = 0, y = b;
+    long long int dx = 0, dy = 2 * a2 * y;
+    // Decision values are kept 4 times larger to stay integral
+    long long int err = 4 * b2 - 4 * a2 * b + a2;
+    while (dx < dy) {
+        putSymmetricPixels(fb, centerx, centery, (int)x, (int)y, color);
+        x++;
+        dx += 2 * b2;
+        if (err < 0) {
+            err += 4 * (dx + b2);
+        } else {
+            y--;
+            dy -= 2 * a2;
+            err += 4 * (dx - dy + b2);
+        }
+    }
+
+    err = b2 * (2 * x + 1) * (2 * x + 1) + 4 * a2 * (y - 1) * (y - 1) - 4 * a2 * b2;
+    while (y >= 0) {
+        putSymmetricPixels(fb, centerx, centery, (int)x, (int)y, color);
+        y--;
+        dy -= 2 * a2;
+        if (err > 0) {
+            err += 4 * (a2 - dy);
+        } else {
+            x++;
+            dx += 2 * b2;
+            err += 4 * (dx - dy + a2);
+        }
+    }
+}
+
+// Complexity: O(area)
+void fbFillRect(struct FrameBuffer *fb, int minx, int miny, int maxx, int maxy, unsigned int color) {
+    assert(fb != NULL);
+    // EGE accepts the corners in any order
+    int left = max(min(minx, maxx), fb -> clip.minx), right = min(max(minx, maxx), fb -> clip.maxx);
+    int top = max(min(miny, maxy), fb -> clip.miny), bottom = min(max(miny, maxy), fb -> clip.maxy);
+    for (int y = top; y <= bottom; y++) {
+        unsigned int *span = fb -> pixels + (size_t)y * fb -> width;
+        for (int x = left; x <= right; x++) {
+            span[x] = color;
+        }
+    }
+}
+
+static void lineHook(void *impl, int x0, int y0, int x1, int y1, unsigned int color) {
+    fbLine((struct FrameBuffer *)impl, x0, y0, x1, y1, color);
+}
+
+static void rectangleHook(void *impl, int left, int top, int right, int bottom, unsigned int color) {
+    fbRectangle((struct FrameBuffer *)impl, left, top, right, bottom, color);
+}
+
+static void circleHook(void *impl, int centerx, int centery, int radius, unsigned int color) {
+    fbCircle((struct FrameBuffer *)impl, centerx, centery, radius, color);
+}
+
+static void ellipseHook(void *impl, int centerx, int centery, int xRadius, int yRadius, unsigned int color) {
+    fbEllipse((struct FrameBuffer *)impl, centerx, centery, xRadius, yRadius, color);
+}
+
+static void barHook(void *impl, int left, int top, int right, int bottom, unsigned int color) {
+    fbFillRect((struct FrameBuffer *)impl, left, top, right, bottom, color);
+}
+
+// There are no glyphs, the box of the text is outlined instead
+static void textHook(void *impl, const struct Vertex *startPt, const struct Vertex *endPt, const char *text,
+                     unsigned int color, bool isDraft) {
+    (void)text;
+    (void)isDraft;
+    fbRectangle((struct FrameBuffer *)impl, startPt -> x, endPt -> y, endPt -> x, startPt -> y, color);
+}
+
+void initFrameBufferBackend(struct FrameBuffer *fb, struct RenderBackend *backend) {
+    assert(fb != NULL && backend != NULL);
+    backend -> impl = fb;
+    backend -> lineFunc = lineHook;
+    backend -> rectangleFunc = rectangleHook;
+    backend -> circleFunc = circleHook;
+    backend -> ellipseFunc = ellipseHook;
+    backend -> barFunc = barHook;
+    backend -> textFunc = textHook;
+}
+
+// Complexity: O(n + pixels)
+void fbRedrawAll(struct FrameBuffer *fb, const struct LinkedList *list) {
+    assert(fb != NULL && list != NULL);
+    fbFillRect(fb, fb -> clip.minx, fb -> clip.miny, fb -> clip.maxx, fb -> clip.maxy, fb -> bgColor);
+    struct RenderBackend backend;
+    initFrameBufferBackend(fb, &backend);
+    renderList(&backend, list, fb -> color, false, &fb -> clip, NULL);
+}
+
+bool saveFrameBufferPPM(const struct FrameBuffer *fb, const char *path) {
+    assert(fb != NULL && path != NULL);
+    errno = 0;
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        perror("saveFrameBufferPPM");
+        return false;
+    }
+
+    fprintf(file, "P6\n%d %d\n255\n", fb -> width, fb -> height);
+    unsigned char *row = (unsigned char *)malloc((size_t)fb -> width * 3);
+    if (row == NULL) {
+        perror("saveFrameBufferPPM");
+        fclose(file);
+        return false;
+    }
+    bool isWritten = true;
+    for (int y = 0; y < fb -> height && isWritten; y++) {
+        const unsigned int *span = fb -> pixels + (size_t)y * fb -> width;
+        for (int x = 0; x < fb -> width; x++) {
+            row[x * 3] = (span[x] >> 16) & 0xFF;
+            row[x * 3 + 1] = (span[x] >> 8) & 0xFF;
+            row[x * 3 + 2] = span[x] & 0xFF;
+        }
+        isWritten = fwrite(row, 3, fb -> width, file) == (size_t)fb -> width;
+    }
+    free(row);
+
+    if (fclose(file) != 0 || !isWritten) {
+        perror("saveFrameBufferPPM");
+        return false;
+    }
+    return true;
+}
+
+static void clipHook(void *impl, const struct BoundingBox *rect) {
+    setFrameBufferClip((struct FrameBuffer *)impl, rect);
+}
+
+static void clearHook(void *impl, const struct BoundingBox *rect) {
+    struct FrameBuffer *fb = (struct FrameBuffer *)impl;
+    fbFillRect(fb, rect -> minx, rect -> miny, rect -> maxx, rect -> maxy, fb -> bgColor);
+}
+
+static void drawHook(void *impl, const struct NodeData *data) {
+    struct FrameBuffer *fb = (struct FrameBuffer *)impl;
+    struct RenderBackend backend;
+    initFrameBufferBackend(fb, &backend);
+    renderNodeData(&backend, data, fb -> color, false, 0, 0);
+}
+
+static void overlayHook(void *impl) {
+    struct FrameBuffer *fb = (struct FrameBuffer *)impl;
+    if (fb -> overlayData != NULL) {
+        struct RenderBackend backend;
+        initFrameBufferBackend(fb, &backend);
+        renderNodeData(&backend, fb -> overlayData, fb -> overlayColor, true, 0, 0);
+    }
+}
+
+void initFrameBufferPainter(struct FrameBuffer *fb, struct DamagePainter *painter) {
+    assert(fb != NULL && painter != NULL);
+    painter -> impl = fb;
+    painter -> clipFunc = clipHook;
+    painter -> clearFunc = clearHook;
+    painter -> drawFunc = drawHook;
+    painter -> overlayFunc = overlayHook;
+    painter -> scratch = NULL;
+}
@@ -0,0 +1,250 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+
+#include "generate.h"
+
+#define GENERATE_TYPE_NUM (DATATYPE_RANGE_MAX - DATATYPE_RANGE_MIN + 1)
+#define GENERATE_TEXT_MAX_LENGTH 8
+#define GENERATE_PI 3.14159265358979323846
+
+// xorshift64*, cheap and good enough to place shapes
+struct Generator {
+    unsigned long long int state;
+    const struct GenerateOptions *options;
+    int typeWeightSum;
+    // Cluster centers, in pairs of x and y
+    int *centers;
+};
+
+static unsigned long long int nextBits(struct Generator *gen) {
+    gen -> state ^= gen -> state >> 12;
+    gen -> state ^= gen -> state << 25;
+    gen -> state ^= gen -> state >> 27;
+    return gen -> state * 2685821657736338717ull;
+}
+
+// Returns an integer in [0, range)
+static int nextInt(struct Generator *gen, int range) {
+    return range <= 1 ? 0 : (int)((nextBits(gen) >> 33) % (unsigned long long int)range);
+}
+
+// Returns a double in [0, 1)
+static double nextUnit(struct Generator *gen) {
+    return (nextBits(gen) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Box-Muller, one of the pair is enough here
+static double nextGaussian(struct Generator *gen) {
+    double u = 1.0 - nextUnit(gen), v = nextUnit(gen);
+    return sqrt(-2.0 * log(u)) * cos(2.0 * GENERATE_PI * v);
+}
+
+void initGenerateOptions(struct GenerateOptions *options) {
+    assert(options != NULL);
+    memset(options, 0, sizeof(struct GenerateOptions));
+    options -> seed = 2463534242u;
+    options -> shapeNum = 10000;
+    for (int i = 0; i < GENERATE_TYPE_NUM; i++) {
+        options -> typeWeights[i] = 1;
+    }
+    options -> sizeMode = GENERATE_SIZE_UNIFORM;
+    options -> minSize = 8;
+    options -> maxSize = 80;
+    options -> layout = GENERATE_LAYOUT_UNIFORM;
+    options -> width = 1280;
+    options -> height = 960;
+    options -> clusterNum = 16;
+    options -> clusterSpread = 60;
+    options -> gridPitch = 64;
+}
+
+static int pickType(struct Generator *gen) {
+    int pick = nextInt(gen, gen -> typeWeightSum);
+    for (int i = 0; i < GENERATE_TYPE_NUM; i++) {
+        pick -= gen -> options -> typeWeights[i];
+        if (pick < 0) {
+            return DATATYPE_SEGMENT + i;
+        }
+    }
+    return DATATYPE_SEGMENT;
+}
+
+static int pickSize(struct Generator *gen) {
+    const struct GenerateOptions *options = gen -> options;
+    int size = options -> minSize;
+    if (options -> sizeMode == GENERATE_SIZE_LOG) {
+        size = (int)(options -> minSize * pow((double)options -> maxSize / options -> minSize, nextUnit(gen)));
+    } else {
+        size += nextInt(gen, options -> maxSize - options -> minSize + 1);
+    }
+    // On a grid, sizes are whole eighths of the pitch
+    if (options -> layout == GENERATE_LAYOUT_GRID) {
+        int step = max(options -> gridPitch / 8, 1);
+        size = max(size / step, 1) * step;
+    }
+    return max(size, 2);
+}
+
+static void pickCenter(struct Generator *gen, int *x, int *y) {
+    const struct GenerateOptions *options = gen -> options;
+    switch (options -> layout) {
+        case GENERATE_LAYOUT_CLUSTERS: {
+            int cluster = nextInt(gen, options -> clusterNum);
+            *x = gen -> centers[cluster * 2] + (int)(nextGaussian(gen) * options -> clusterSpread);
+            *y = gen -> centers[cluster * 2 + 1] + (int)(nextGaussian(gen) * options -> clusterSpread);
+            break;
+        }
+        case GENERATE_LAYOUT_GRID: {
+            int pitch = options -> gridPitch, step = max(pitch / 8, 1);
+            int colNum = max(options -> width / pitch, 1), rowNum = max(options -> height / pitch, 1);
+            *x = nextInt(gen, colNum) * pitch + pitch / 2 + (nextInt(gen, 5) - 2) * step;
+            *y = nextInt(gen, rowNum) * pitch + pitch / 2 + (nextInt(gen, 5) - 2) * step;
+            break;
+        }
+        default: {
+            *x = nextInt(gen, options -> width);
+            *y = nextInt(gen, options -> height);
+            break;
+        }
+    }
+    *x += options -> originx;
+    *y += options -> originy;
+}
+
+// Build one shape of the given type and size around (x, y)
+// Returns its data, or NULL if out of memory
+static struct NodeData * makeShape(struct Generator *gen, int type, int size, int x, int y) {
+    int half = size / 2;
+    switch (type) {
+        case DATATYPE_SEGMENT: {
+            int dx = half, dy = 0;
+            if (gen -> options -> layout == GENERATE_LAYOUT_GRID) {
+                if (nextInt(gen, 2) == 0) {
+                    dx = 0;
+                    dy = half;
+                }
+            } else {
+                double angle = nextUnit(gen) * GENERATE_PI;
+                dx = (int)(cos(angle) * half);
+                dy = (int)(sin(angle) * half);
+            }
+            return makeData(makeSegment(makeVertex(x - dx, y - dy), makeVertex(x + dx, y + dy)), DATATYPE_SEGMENT);
+        }
+        case DATATYPE_RECTANGLE: {
+            int halfHeight = max(half * (3 + nextInt(gen, 8)) / 10, 1);
+            return makeData(makeRectangle(makeVertex(x - half, y - halfHeight), makeVertex(x + half, y + halfHeight)),
+                            DATATYPE_RECTANGLE);
+        }
+        case DATATYPE_CIRCLE: {
+            return makeData(makeCircle(makeVertex(x, y), max(half, 1)), DATATYPE_CIRCLE);
+        }
+        case DATATYPE_ELLIPSE: {
+            int majorSemiAxis = max(half, 1);
+            int minorSemiAxis = max(majorSemiAxis * (3 + nextInt(gen, 8)) / 10, 1);
+            return makeData(makeEllipse(makeVertex(x, y), majorSemiAxis, minorSemiAxis), DATATYPE_ELLIPSE);
+        }
+        default: {
+            int length = 1 + nextInt(gen, GENERATE_TEXT_MAX_LENGTH);
+            char content[GENERATE_TEXT_MAX_LENGTH + 1];
+            for (int i = 0; i < length; i++) {
+                content[i] = 'A' + nextInt(gen, 26);
+            }
+            content[length] = '\0';
+            int fontHeight = min(max(half, 8), 64);
+            int textWidth = length * fontHeight / 2;
+            return makeData(makeText(makeRectangle(makeVertex(x - textWidth / 2, y - fontHeight / 2),
+                                                   makeVertex(x - textWidth / 2 + textWidth, y - fontHeight / 2 + fontHeight)),
+                                     content, fontHeight / 2, fontHeight), DATATYPE_TEXT);
+        }
+    }
+}
+
+// A zero state would stay zero
+static unsigned long long int getSeedState(unsigned int seed) {
+    return ((unsigned long long int)seed << 32) ^ 0x9E3779B97F4A7C15ull;
+}
+
+// Set up a generator for options, cluster centers included
+// Returns false if out of memory
+static bool initGenerator(struct Generator *gen, const struct GenerateOptions *options) {
+    assert(options -> minSize > 0 && options -> maxSize >= options -> minSize && options -> width > 0 && options -> height > 0);
+    assert(options -> layout != GENERATE_LAYOUT_CLUSTERS || options -> clusterNum > 0);
+    assert(options -> layout != GENERATE_LAYOUT_GRID || options -> gridPitch > 0);
+    gen -> state = getSeedState(options -> seed);
+    gen -> options = options;
+    gen -> typeWeightSum = 0;
+    for (int i = 0; i < GENERATE_TYPE_NUM; i++) {
+        assert(options -> typeWeights[i] >= 0);
+        gen -> typeWeightSum += options -> typeWeights[i];
+    }
+    assert(gen -> typeWeightSum > 0);
+    gen -> centers = NULL;
+    if (options -> layout == GENERATE_LAYOUT_CLUSTERS) {
+        errno = 0;
+        gen -> centers = (int *)malloc(sizeof(int) * 2 * options -> clusterNum);
+        if (gen -> centers == NULL) {
+            perror("initGenerator");
+            return false;
+        }
+        for (int i = 0; i < options -> clusterNum; i++) {
+            gen -> centers[i * 2] = nextInt(gen, options -> width);
+            gen -> centers[i * 2 + 1] = nextInt(gen, options -> height);
+        }
+    }
+    return true;
+}
+
+static struct NodeData * makeNextShape(struct Generator *gen) {
+    int type = pickType(gen), size = pickSize(gen), x = 0, y = 0;
+    pickCenter(gen, &x, &y);
+    return makeShape(gen, type, size, x, y);
+}
+
+// Complexity: O(1), O(clusterNum) with clusters
+struct NodeData * generateShape(const struct GenerateOptions *options, unsigned int seed) {
+    assert(options != NULL);
+    struct Generator gen;
+    if (!initGenerator(&gen, options)) {
+        return NULL;
+    }
+    gen.state = getSeedState(seed);
+    struct NodeData *data = makeNextShape(&gen);
+    free(gen.centers);
+    return data;
+}
+
+// Complexity: O(n)
+int generateDrawing(struct LinkedList *list, const struct GenerateOptions *options) {
+    assert(list != NULL && options != NULL && options -> shapeNum >= 0);
+    struct Generator gen;
+    if (!initGenerator(&gen, options)) {
+        return 0;
+    }
+
+    struct NodeData *batch[GENERATE_BATCH_SIZE];
+    int addedNum = 0;
+    bool isFailed = false;
+    while (addedNum < options -> shapeNum && !isFailed) {
+        int batchNum = min(GENERATE_BATCH_SIZE, options -> shapeNum - addedNum);
+        for (int i = 0; i < batchNum; i++) {
+            batch[i] = makeNextShape(&gen);
+            if (batch[i] == NULL) {
+                batchNum = i;
+                isFailed = true;
+                break;
+            }
+        }
+        int batchAddedNum = addNodesAtTail(list, batch, batchNum);
+        for (int i = batchAddedNum; i < batchNum; i++) {
+            destroyRule(batch[i]);
+        }
+        isFailed = isFailed || batchAddedNum < batchNum;
+        addedNum += batchAddedNum;
+    }
+    free(gen.centers);
+    return addedNum;
+}
@@ -0,0 +1,397 @@
+#include <stdio.h>
+#include <assert.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HITTEST_X86
+#include <immintrin.h>
+#endif
+
+#include "hittest.h"
+#include "datatypes.h"
+
+bool isColumnHit(const struct HitColumns *cols, int slot, int x, int y) {
+    assert(cols != NULL && slot >= 0);
+    switch (cols -> type[slot]) {
+        case DATATYPE_SEGMENT: {
+            return isNearSegment(x, y, cols -> x0[slot], cols -> y0[slot], cols -> x1[slot], cols -> y1[slot]);
+        }
+        case DATATYPE_RECTANGLE:
+        case DATATYPE_TEXT: {
+            return isNearRectangle(x, y, cols -> x0[slot], cols -> y0[slot], cols -> x1[slot], cols -> y1[slot]);
+        }
+        case DATATYPE_CIRCLE: {
+            return isNearCircle(x, y, cols -> x0[slot], cols -> y0[slot], cols -> r0[slot]);
+        }
+        case DATATYPE_ELLIPSE: {
+            return isNearEllipse(x, y, cols -> x0[slot], cols -> y0[slot], cols -> r0[slot], cols -> r1[slot]);
+        }
+        default: {
+            return false;
+        }
+    }
+}
+
+// Check the point against a box around the shape in given slot, widened by FINDRULE_VARIATION,
+// which holds every point isColumnHit() accepts
+// Takes no branch on the type, since types come mixed and mispredicting them costs more than the test
+// Returns false if the shape cannot be hit
+static inline bool isColumnNear(const struct HitColumns *cols, int slot, int x, int y) {
+    int type = cols -> type[slot];
+    int x0 = cols -> x0[slot], y0 = cols -> y0[slot], x1 = cols -> x1[slot], y1 = cols -> y1[slot];
+    int rx = cols -> r0[slot], ry = cols -> r1[slot];
+    // Round shapes leave the far corner at 0, and a circle leaves its second radius at 0,
+    // both are filled in through masks as compilers turn plain selects back into branches
+    int roundMask = -(int)(type == DATATYPE_CIRCLE || type == DATATYPE_ELLIPSE);
+    int circleMask = -(int)(type == DATATYPE_CIRCLE);
+    x1 = (x0 & roundMask) | (x1 & ~roundMask);
+    y1 = (y0 & roundMask) | (y1 & ~roundMask);
+    ry = (rx & circleMask) | (ry & ~circleMask);
+    return x >= min(x0, x1) - rx - FINDRULE_VARIATION && x <= max(x0, x1) + rx + FINDRULE_VARIATION &&
+           y >= min(y0, y1) - ry - FINDRULE_VARIATION && y <= max(y0, y1) + ry + FINDRULE_VARIATION;
+}
+
+// Most shapes are far from the point and only cost the inlined box test
+// Complexity: O(n)
+static int findTopHitScalar(const struct HitColumns *cols, const int *order, int begin, int end, int x, int y) {
+    for (int i = end - 1; i >= begin; i--) {
+        if (order[i] >= 0 && isColumnNear(cols, order[i], x, y) && isColumnHit(cols, order[i], x, y)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+#ifdef HITTEST_X86
+
+// Redo lanes in outMask with the scalar rules
+static unsigned int fixOutLanes(const struct HitColumns *cols, const int *slots, unsigned int hitMask,
+                                unsigned int outMask, int x, int y) {
+    while (outMask != 0) {
+        int lane = __builtin_ctz(outMask);
+        outMask &= outMask - 1;
+        if (isColumnHit(cols, slots[lane], x, y)) {
+            hitMask |= 1u << lane;
+        } else {
+            hitMask &= ~(1u << lane);
+        }
+    }
+    return hitMask;
+}
+
+// Blocks are tested from the top, so the last lane hit is the topmost shape
+static int scanBlocks(const struct HitColumns *cols, const int *order, int begin, int end, int x, int y,
+                      int laneNum, unsigned int (*testBlock)(const struct HitColumns *, const int *, int, int)) {
+    int slots[8];
+    for (int hi = end; hi > begin; hi -= laneNum) {
+        int lo = max(begin, hi - laneNum);
+        const int *cntSlots = order + lo;
+        if (hi - lo < laneNum) {
+            for (int i = 0; i < laneNum; i++) {
+                slots[i] = lo + i < hi ? order[lo + i] : -1;
+            }
+            cntSlots = slots;
+        }
+        unsigned int hitMask = testBlock(cols, cntSlots, x, y);
+        if (hitMask != 0) {
+            return lo + 31 - __builtin_clz(hitMask);
+        }
+    }
+    return -1;
+}
+
+/* SSE4.1, 4 lanes */
+
+// Runs of consecutive slots, the usual case, are loaded straight from the columns
+__attribute__((target("sse4.1")))
+static inline __m128i gatherSse41(const int *column, const int *slots, bool isRun) {
+    if (isRun) {
+        return _mm_loadu_si128((const __m128i *)(column + slots[0]));
+    }
+    int val[4];
+    for (int i = 0; i < 4; i++) {
+        val[i] = slots[i] >= 0 ? column[slots[i]] : 0;
+    }
+    return _mm_loadu_si128((const __m128i *)val);
+}
+
+__attribute__((target("sse4.1")))
+static inline unsigned int maskBitsSse41(__m128i mask) {
+    return (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(mask));
+}
+
+__attribute__((target("sse4.1")))
+static inline __m128i outOfLimitSse41(__m128i val) {
+    return _mm_or_si128(_mm_cmpgt_epi32(val, _mm_set1_epi32(HITTEST_SIMD_LIMIT)),
+                        _mm_cmplt_epi32(val, _mm_set1_epi32(-HITTEST_SIMD_LIMIT)));
+}
+
+// Lanes where a * b + c * d <= e * f, products taken in 64 bits
+__attribute__((target("sse4.1")))
+static inline unsigned int mulAddLeSse41(__m128i a, __m128i b, __m128i c, __m128i d, __m128i e, __m128i f) {
+    // _mm_mul_epi32 multiplies lanes 0 and 2, shifting brings lanes 1 and 3 down
+    __m128i diffEven = _mm_sub_epi64(_mm_mul_epi32(e, f), _mm_add_epi64(_mm_mul_epi32(a, b), _mm_mul_epi32(c, d)));
+    __m128i diffOdd = _mm_sub_epi64(
+        _mm_mul_epi32(_mm_srli_epi64(e, 32), _mm_srli_epi64(f, 32)),
+        _mm_add_epi64(_mm_mul_epi32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32)),
+                      _mm_mul_epi32(_mm_srli_epi64(c, 32), _mm_srli_epi64(d, 32))));
+    unsigned int evenMiss = (unsigned int)_mm_movemask_pd(_mm_castsi128_pd(diffEven));
+    unsigned int oddMiss = (unsigned int)_mm_movemask_pd(_mm_castsi128_pd(diffOdd));
+    unsigned int miss = (evenMiss & 1) | ((oddMiss & 1) << 1) | ((evenMiss & 2) << 1) | ((oddMiss & 2) << 2);
+    return ~miss & 0xF;
+}
+
+__attribute__((target("sse4.1")))
+static unsigned int testBlockSse41(const struct HitColumns *cols, const int *slots, int x, int y) {
+    __m128i index = _mm_loadu_si128((const __m128i *)slots);
+    bool isRun = slots[0] >= 0 &&
+                 _mm_movemask_epi8(_mm_cmpeq_epi32(index, _mm_add_epi32(_mm_set1_epi32(slots[0]), _mm_setr_epi32(0, 1, 2, 3)))) == 0xFFFF;
+    __m128i type = gatherSse41(cols -> type, slots, isRun);
+    __m128i x0 = gatherSse41(cols -> x0, slots, isRun), y0 = gatherSse41(cols -> y0, slots, isRun);
+    __m128i x1 = gatherSse41(cols -> x1, slots, isRun), y1 = gatherSse41(cols -> y1, slots, isRun);
+    __m128i r0 = gatherSse41(cols -> r0, slots, isRun), r1 = gatherSse41(cols -> r1, slots, isRun);
+    __m128i px = _mm_set1_epi32(x), py = _mm_set1_epi32(y);
+    __m128i var = _mm_set1_epi32(FINDRULE_VARIATION), zero = _mm_setzero_si128();
+
+    __m128i out = _mm_or_si128(_mm_or_si128(outOfLimitSse41(x0), outOfLimitSse41(y0)),
+                               _mm_or_si128(outOfLimitSse41(x1), outOfLimitSse41(y1)));
+    out = _mm_or_si128(out, _mm_or_si128(outOfLimitSse41(r0), outOfLimitSse41(r1)));
+
+    __m128i isSeg = _mm_cmpeq_epi32(type, _mm_set1_epi32(DATATYPE_SEGMENT));
+    __m128i isRec = _mm_or_si128(_mm_cmpeq_epi32(type, _mm_set1_epi32(DATATYPE_RECTANGLE)),
+                                 _mm_cmpeq_epi32(type, _mm_set1_epi32(DATATYPE_TEXT)));
+    __m128i isCir = _mm_cmpeq_epi32(type, _mm_set1_epi32(DATATYPE_CIRCLE));
+    __m128i isElp = _mm_cmpeq_epi32(type, _mm_set1_epi32(DATATYPE_ELLIPSE));
+
+    // Rectangle and text
+    __m128i minx = _mm_sub_epi32(x0, var), maxx = _mm_add_epi32(x1, var);
+    __m128i recMiss = _mm_or_si128(_mm_or_si128(_mm_cmpgt_epi32(minx, px), _mm_cmpgt_epi32(px, maxx)),
+                                   _mm_or_si128(_mm_cmpgt_epi32(_mm_sub_epi32(y0, var), py),
+                                                _mm_cmpgt_epi32(py, _mm_add_epi32(y1, var))));
+
+    // Segment box
+    __m128i miny = _mm_sub_epi32(_mm_min_epi32(y0, y1), var), maxy = _mm_add_epi32(_mm_max_epi32(y0, y1), var);
+    __m128i segMiss = _mm_or_si128(_mm_or_si128(_mm_cmpgt_epi32(minx, px), _mm_cmpgt_epi32(px, maxx)),
+                                   _mm_or_si128(_mm_cmpgt_epi32(miny, py), _mm_cmpgt_epi32(py, maxy)));
+
+    // Circle and ellipse boxes, an ellipse with a zero axis term is unbounded along the other one
+    __m128i dx = _mm_sub_epi32(px, x0), dy = _mm_sub_epi32(py, y0);
+    __m128i major = _mm_add_epi32(r0, var), minor = _mm_add_epi32(r1, var);
+    __m128i extx = _mm_abs_epi32(major), exty = _mm_blendv_epi8(_mm_abs_epi32(minor), extx, isCir);
+    __m128i roundMiss = _mm_or_si128(_mm_cmpgt_epi32(_mm_abs_epi32(dx), extx), _mm_cmpgt_epi32(_mm_abs_epi32(dy), exty));
+    __m128i isFlat = _mm_and_si128(isElp, _mm_or_si128(_mm_cmpeq_epi32(major, zero), _mm_cmpeq_epi32(minor, zero)));
+
+    // Most blocks have no shape near the point, skip the exact tests for them
+    __m128i candidate = _mm_or_si128(_mm_or_si128(_mm_andnot_si128(segMiss, isSeg), _mm_andnot_si128(recMiss, isRec)),
+                                     _mm_andnot_si128(roundMiss, _mm_or_si128(isCir, isElp)));
+    unsigned int outMask = maskBitsSse41(out);
+    if ((maskBitsSse41(_mm_or_si128(candidate, isFlat)) | outMask) == 0) {
+        return 0;
+    }
+
+    // Segment, squared distance to the line
+    __m128i segdx = _mm_sub_epi32(x1, x0), segdy = _mm_sub_epi32(y1, y0);
+    __m128i cross = _mm_sub_epi32(_mm_mullo_epi32(dx, segdy), _mm_mullo_epi32(dy, segdx));
+    __m128i segLen = _mm_add_epi32(_mm_mullo_epi32(segdx, segdx), _mm_mullo_epi32(segdy, segdy));
+    unsigned int segHit = ~maskBitsSse41(segMiss) &
+                          mulAddLeSse41(cross, cross, zero, zero, segLen, _mm_set1_epi32(FINDRULE_VARIATION * FINDRULE_VARIATION));
+
+    // Circle
+    unsigned int cirHit = mulAddLeSse41(dx, dx, dy, dy, major, major);
+
+    // Ellipse
+    __m128i elpx = _mm_mullo_epi32(minor, dx), elpy = _mm_mullo_epi32(major, dy);
+    __m128i elpAxis = _mm_mullo_epi32(major, minor);
+    unsigned int elpHit = mulAddLeSse41(elpx, elpx, elpy, elpy, elpAxis, elpAxis);
+
+    unsigned int hitMask = (maskBitsSse41(isSeg) & segHit) | (maskBitsSse41(_mm_andnot_si128(recMiss, isRec))) |
+                           (maskBitsSse41(isCir) & cirHit) | (maskBitsSse41(isElp) & elpHit);
+    return outMask == 0 ? hitMask : fixOutLanes(cols, slots, hitMask, outMask, x, y);
+}
+
+/* AVX2, 8 lanes */
+
+__attribute__((target("avx2")))
+static inline __m256i gatherAvx2(const int *column, __m256i index, __m256i valid, int firstSlot, bool isRun) {
+    if (isRun) {
+        return _mm256_loadu_si256((const __m256i *)(column + firstSlot));
+    }
+    return _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), column, index, valid, 4);
+}
+
+__attribute__((target("avx2")))
+static inline unsigned int maskBitsAvx2(__m256i mask) {
+    return (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(mask));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i outOfLimitAvx2(__m256i val) {
+    return _mm256_or_si256(_mm256_cmpgt_epi32(val, _mm256_set1_epi32(HITTEST_SIMD_LIMIT)),
+                           _mm256_cmpgt_epi32(_mm256_set1_epi32(-HITTEST_SIMD_LIMIT), val));
+}
+
+// Spread 4 bits to the even positions of 8
+static inline unsigned int spreadBits(unsigned int bits) {
+    return (bits & 1) | ((bits & 2) << 1) | ((bits & 4) << 2) | ((bits & 8) << 3);
+}
+
+// Lanes where a * b + c * d <= e * f, products taken in 64 bits
+__attribute__((target("avx2")))
+static inline unsigned int mulAddLeAvx2(__m256i a, __m256i b, __m256i c, __m256i d, __m256i e, __m256i f) {
+    __m256i diffEven = _mm256_sub_epi64(_mm256_mul_epi32(e, f),
+                                        _mm256_add_epi64(_mm256_mul_epi32(a, b), _mm256_mul_epi32(c, d)));
+    __m256i diffOdd = _mm256_sub_epi64(
+        _mm256_mul_epi32(_mm256_srli_epi64(e, 32), _mm256_srli_epi64(f, 32)),
+        _mm256_add_epi64(_mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32)),
+                         _mm256_mul_epi32(_mm256_srli_epi64(c, 32), _mm256_srli_epi64(d, 32))));
+    unsigned int evenMiss = (unsigned int)_mm256_movemask_pd(_mm256_castsi256_pd(diffEven));
+    unsigned int oddMiss = (unsigned int)_mm256_movemask_pd(_mm256_castsi256_pd(diffOdd));
+    return ~(spreadBits(evenMiss) | (spreadBits(oddMiss) << 1)) & 0xFF;
+}
+
+__attribute__((target("avx2")))
+static unsigned int testBlockAvx2(const struct HitColumns *cols, const int *slots, int x, int y) {
+    __m256i index = _mm256_loadu_si256((const __m256i *)slots);
+    __m256i valid = _mm256_cmpgt_epi32(index, _mm256_set1_epi32(-1));
+    int first = slots[0];
+    bool isRun = first >= 0 &&
+                 _mm256_movemask_epi8(_mm256_cmpeq_epi32(index, _mm256_add_epi32(_mm256_set1_epi32(first),
+                                                         _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)))) == -1;
+    __m256i type = gatherAvx2(cols -> type, index, valid, first, isRun);
+    __m256i x0 = gatherAvx2(cols -> x0, index, valid, first, isRun), y0 = gatherAvx2(cols -> y0, index, valid, first, isRun);
+    __m256i x1 = gatherAvx2(cols -> x1, index, valid, first, isRun), y1 = gatherAvx2(cols -> y1, index, valid, first, isRun);
+    __m256i r0 = gatherAvx2(cols -> r0, index, valid, first, isRun), r1 = gatherAvx2(cols -> r1, index, valid, first, isRun);
+    __m256i px = _mm256_set1_epi32(x), py = _mm256_set1_epi32(y);
+    __m256i var = _mm256_set1_epi32(FINDRULE_VARIATION), zero = _mm256_setzero_si256();
+
+    __m256i out = _mm256_or_si256(_mm256_or_si256(outOfLimitAvx2(x0), outOfLimitAvx2(y0)),
+                                  _mm256_or_si256(outOfLimitAvx2(x1), outOfLimitAvx2(y1)));
+    out = _mm256_or_si256(out, _mm256_or_si256(outOfLimitAvx2(r0), outOfLimitAvx2(r1)));
+
+    __m256i isSeg = _mm256_cmpeq_epi32(type, _mm256_set1_epi32(DATATYPE_SEGMENT));
+    __m256i isRec = _mm256_or_si256(_mm256_cmpeq_epi32(type, _mm256_set1_epi32(DATATYPE_RECTANGLE)),
+                                    _mm256_cmpeq_epi32(type, _mm256_set1_epi32(DATATYPE_TEXT)));
+    __m256i isCir = _mm256_cmpeq_epi32(type, _mm256_set1_epi32(DATATYPE_CIRCLE));
+    __m256i isElp = _mm256_cmpeq_epi32(type, _mm256_set1_epi32(DATATYPE_ELLIPSE));
+
+    // Rectangle and text
+    __m256i minx = _mm256_sub_epi32(x0, var), maxx = _mm256_add_epi32(x1, var);
+    __m256i recMiss = _mm256_or_si256(_mm256_or_si256(_mm256_cmpgt_epi32(minx, px), _mm256_cmpgt_epi32(px, maxx)),
+                                      _mm256_or_si256(_mm256_cmpgt_epi32(_mm256_sub_epi32(y0, var), py),
+                                                      _mm256_cmpgt_epi32(py, _mm256_add_epi32(y1, var))));
+
+    // Segment box
+    __m256i miny = _mm256_sub_epi32(_mm256_min_epi32(y0, y1), var);
+    __m256i maxy = _mm256_add_epi32(_mm256_max_epi32(y0, y1), var);
+    __m256i segMiss = _mm256_or_si256(_mm256_or_si256(_mm256_cmpgt_epi32(minx, px), _mm256_cmpgt_epi32(px, maxx)),
+                                      _mm256_or_si256(_mm256_cmpgt_epi32(miny, py), _mm256_cmpgt_epi32(py, maxy)));
+
+    // Circle and ellipse boxes, an ellipse with a zero axis term is unbounded along the other one
+    __m256i dx = _mm256_sub_epi32(px, x0), dy = _mm256_sub_epi32(py, y0);
+    __m256i major = _mm256_add_epi32(r0, var), minor = _mm256_add_epi32(r1, var);
+    __m256i extx = _mm256_abs_epi32(major), exty = _mm256_blendv_epi8(_mm256_abs_epi32(minor), extx, isCir);
+    __m256i roundMiss = _mm256_or_si256(_mm256_cmpgt_epi32(_mm256_abs_epi32(dx), extx),
+                                        _mm256_cmpgt_epi32(_mm256_abs_epi32(dy), exty));
+    __m256i isFlat = _mm256_and_si256(isElp, _mm256_or_si256(_mm256_cmpeq_epi32(major, zero), _mm256_cmpeq_epi32(minor, zero)));
+
+    // Most blocks have no shape near the point, skip the exact tests for them
+    __m256i candidate = _mm256_or_si256(_mm256_or_si256(_mm256_andnot_si256(segMiss, isSeg), _mm256_andnot_si256(recMiss, isRec)),
+                                        _mm256_andnot_si256(roundMiss, _mm256_or_si256(isCir, isElp)));
+    unsigned int outMask = maskBitsAvx2(out) & maskBitsAvx2(valid);
+    if ((maskBitsAvx2(_mm256_or_si256(candidate, isFlat)) | outMask) == 0) {
+        return 0;
+    }
+
+    // Segment, squared distance to the line
+    __m256i segdx = _mm256_sub_epi32(x1, x0), segdy = _mm256_sub_epi32(y1, y0);
+    __m256i cross = _mm256_sub_epi32(_mm256_mullo_epi32(dx, segdy), _mm256_mullo_epi32(dy, segdx));
+    __m256i segLen = _mm256_add_epi32(_mm256_mullo_epi32(segdx, segdx), _mm256_mullo_epi32(segdy, segdy));
+    unsigned int segHit = ~maskBitsAvx2(segMiss) &
+                          mulAddLeAvx2(cross, cross, zero, zero, segLen, _mm256_set1_epi32(FINDRULE_VARIATION * FINDRULE_VARIATION));
+
+    // Circle
+    unsigned int cirHit = mulAddLeAvx2(dx, dx, dy, dy, major, major);
+
+    // Ellipse
+    __m256i elpx = _mm256_mullo_epi32(minor, dx), elpy = _mm256_mullo_epi32(major, dy);
+    __m256i elpAxis = _mm256_mullo_epi32(major, minor);
+    unsigned int elpHit = mulAddLeAvx2(elpx, elpx, elpy, elpy, elpAxis, elpAxis);
+
+    unsigned int hitMask = (maskBitsAvx2(isSeg) & segHit) | (maskBitsAvx2(_mm256_andnot_si256(recMiss, isRec))) |
+                           (maskBitsAvx2(isCir) & cirHit) | (maskBitsAvx2(isElp) & elpHit);
+    return outMask == 0 ? hitMask : fixOutLanes(cols, slots, hitMask, outMask, x, y);
+}
+
+#endif
+
+bool isHitKernelSupported(int kernel) {
+    switch (kernel) {
+        case HITTEST_KERNEL_SCALAR: {
+            return true;
+        }
+#ifdef HITTEST_X86
+        case HITTEST_KERNEL_SSE41: {
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse4.1");
+        }
+        case HITTEST_KERNEL_AVX2: {
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+        }
+#endif
+        default: {
+            return false;
+        }
+    }
+}
+
+int getBestHitKernel() {
+    // Probed once, every thread finds the same answer
+    static int bestKernel = -1;
+    if (bestKernel == -1) {
+        int cntKernel = HITTEST_KERNEL_NUM - 1;
+        while (!isHitKernelSupported(cntKernel)) {
+            cntKernel--;
+        }
+        bestKernel = cntKernel;
+    }
+    return bestKernel;
+}
+
+const char * getHitKernelName(int kernel) {
+    switch (kernel) {
+        case HITTEST_KERNEL_SCALAR: {
+            return "scalar";
+        }
+        case HITTEST_KERNEL_SSE41: {
+            return "sse4.1";
+        }
+        case HITTEST_KERNEL_AVX2: {
+            return "avx2";
+        }
+        default: {
+            return "unknown";
+        }
+    }
+}
+
+// Complexity: O(n)
+int findTopHit(const struct HitColumns *cols, const int *order, int begin, int end, int x, int y, int kernel) {
+    assert(cols != NULL && order != NULL && begin <= end);
+    if (kernel == HITTEST_KERNEL_AUTO) {
+        kernel = getBestHitKernel();
+    }
+    assert(isHitKernelSupported(kernel));
+
+#ifdef HITTEST_X86
+    // Cursor beyond the limit would overflow every lane
+    bool isCursorInLimit = x >= -HITTEST_SIMD_LIMIT && x <= HITTEST_SIMD_LIMIT &&
+                           y >= -HITTEST_SIMD_LIMIT && y <= HITTEST_SIMD_LIMIT;
+    if (isCursorInLimit && kernel == HITTEST_KERNEL_AVX2) {
+        return scanBlocks(cols, order, begin, end, x, y, 8, testBlockAvx2);
+    }
+    if (isCursorInLimit && kernel == HITTEST_KERNEL_SSE41) {
+        return scanBlocks(cols, order, begin, end, x, y, 4, testBlockSse41);
+    }
+#endif
+    return findTopHitScalar(cols, order, begin, end, x, y);
+}
@@ -0,0 +1,201 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#include "indexlist.h"
+
+static bool growArray(void *arrayPtr, size_t elemSize, int newCapacity) {
+    void *array = NULL;
+    memcpy(&array, arrayPtr, sizeof(array));
+    errno = 0;
+    void *res = realloc(array, elemSize * newCapacity);
+    if (res == NULL) {
+        perror("growArray");
+        return false;
+    }
+    memcpy(arrayPtr, &res, sizeof(res));
+    return true;
+}
+
+void initIndexList(struct IndexList *list) {
+    assert(list != NULL);
+    memset(list, 0, sizeof(struct IndexList));
+    list -> freeSlot = INDEX_LIST_NONE;
+    list -> head = list -> tail = INDEX_LIST_NONE;
+}
+
+// Complexity: O(n)
+void destroyIndexList(struct IndexList *list, void (*destroyContentFunc)(struct NodeData *)) {
+    assert(list != NULL);
+    if (destroyContentFunc != NULL) {
+        for (int slot = list -> head; slot != INDEX_LIST_NONE; slot = list -> links[slot].next) {
+            struct NodeData data;
+            getIndexNodeData(list, slot, &data);
+            destroyContentFunc(&data);
+        }
+    }
+    free(list -> links);
+    free(list -> hot);
+    free(list -> cold);
+    unsigned int version = list -> version;
+    initIndexList(list);
+    list -> version = version + 1;
+}
+
+// Take a slot off the free chain, or a fresh one, growing the arrays if needed
+// Returns it, or INDEX_LIST_NONE if out of memory
+// Complexity: O(1) amortized
+static int takeSlot(struct IndexList *list) {
+    if (list -> freeSlot != INDEX_LIST_NONE) {
+        int slot = list -> freeSlot;
+        list -> freeSlot = list -> links[slot].next;
+        return slot;
+    }
+    if (list -> slotNum == list -> capacity) {
+        int newCapacity = list -> capacity == 0 ? INDEX_LIST_INIT_CAPACITY : list -> capacity * 2;
+        // Arrays already grown just stay larger when a later one fails
+        if (!growArray(&list -> links, sizeof(struct IndexLink), newCapacity) ||
+            !growArray(&list -> hot, sizeof(struct IndexHot), newCapacity) ||
+            !growArray(&list -> cold, sizeof(void *), newCapacity)) {
+            return INDEX_LIST_NONE;
+        }
+        list -> capacity = newCapacity;
+    }
+    return list -> slotNum++;
+}
+
+static int makeIndexNode(struct IndexList *list, void *newContent, int newType) {
+    assert(list != NULL && newContent != NULL);
+    int slot = takeSlot(list);
+    if (slot == INDEX_LIST_NONE) {
+        return INDEX_LIST_NONE;
+    }
+    struct NodeData data;
+    data.type = newType;
+    data.content = newContent;
+    list -> hot[slot].type = newType;
+    getDataBoundingBox(&data, &list -> hot[slot].box);
+    list -> cold[slot] = newContent;
+    list -> listSize++;
+    list -> version++;
+    return slot;
+}
+
+static void linkAtHead(struct IndexList *list, int slot) {
+    list -> links[slot].prev = INDEX_LIST_NONE;
+    list -> links[slot].next = list -> head;
+    if (list -> head == INDEX_LIST_NONE) {
+        list -> tail = slot;
+    } else {
+        list -> links[list -> head].prev = slot;
+    }
+    list -> head = slot;
+}
+
+static void linkAtTail(struct IndexList *list, int slot) {
+    list -> links[slot].next = INDEX_LIST_NONE;
+    list -> links[slot].prev = list -> tail;
+    if (list -> tail == INDEX_LIST_NONE) {
+        list -> head = slot;
+    } else {
+        list -> links[list -> tail].next = slot;
+    }
+    list -> tail = slot;
+}
+
+static void unlinkSlot(struct IndexList *list, int slot) {
+    struct IndexLink *link = &list -> links[slot];
+    if (link -> prev == INDEX_LIST_NONE) {
+        list -> head = link -> next;
+    } else {
+        list -> links[link -> prev].next = link -> next;
+    }
+    if (link -> next == INDEX_LIST_NONE) {
+        list -> tail = link -> prev;
+    } else {
+        list -> links[link -> next].prev = link -> prev;
+    }
+}
+
+// Complexity: O(1) amortized
+int addIndexNodeAtHead(struct IndexList *list, void *newContent, int newType) {
+    int slot = makeIndexNode(list, newContent, newType);
+    if (slot != INDEX_LIST_NONE) {
+        linkAtHead(list, slot);
+    }
+    return slot;
+}
+
+// Complexity: O(1) amortized
+int addIndexNodeAtTail(struct IndexList *list, void *newContent, int newType) {
+    int slot = makeIndexNode(list, newContent, newType);
+    if (slot != INDEX_LIST_NONE) {
+        linkAtTail(list, slot);
+    }
+    return slot;
+}
+
+// Complexity: O(1)
+void moveIndexNodeToHead(struct IndexList *list, int slot) {
+    assert(list != NULL && slot >= 0 && slot < list -> slotNum && list -> hot[slot].type != DATATYPE_UNDEFINED);
+    if (list -> head == slot) {
+        return;
+    }
+    unlinkSlot(list, slot);
+    linkAtHead(list, slot);
+    list -> version++;
+}
+
+// Complexity: O(1)
+void moveIndexNodeToTail(struct IndexList *list, int slot) {
+    assert(list != NULL && slot >= 0 && slot < list -> slotNum && list -> hot[slot].type != DATATYPE_UNDEFINED);
+    if (list -> tail == slot) {
+        return;
+    }
+    unlinkSlot(list, slot);
+    linkAtTail(list, slot);
+    list -> version++;
+}
+
+// Complexity: O(1)
+void deleteIndexNode(struct IndexList *list, int slot, void (*destroyContentFunc)(struct NodeData *)) {
+    assert(list != NULL && slot >= 0 && slot < list -> slotNum && list -> hot[slot].type != DATATYPE_UNDEFINED);
+    unlinkSlot(list, slot);
+    if (destroyContentFunc != NULL) {
+        struct NodeData data;
+        getIndexNodeData(list, slot, &data);
+        destroyContentFunc(&data);
+    }
+    list -> hot[slot].type = DATATYPE_UNDEFINED;
+    list -> cold[slot] = NULL;
+    list -> links[slot].prev = INDEX_LIST_NONE;
+    list -> links[slot].next = list -> freeSlot;
+    list -> freeSlot = slot;
+    list -> listSize--;
+    list -> version++;
+}
+
+// Complexity: O(n), reading only the hot entry of nodes away from findBox
+int findIndexNode(const struct IndexList *list, const struct BoundingBox *findBox, const void *findData,
+                  bool (*checkFunc)(const void *, const struct NodeData *)) {
+    assert(list != NULL && checkFunc != NULL);
+    for (int slot = list -> tail; slot != INDEX_LIST_NONE; slot = list -> links[slot].prev) {
+        if (findBox != NULL && !isBoxIntersected(&list -> hot[slot].box, findBox)) {
+            continue;
+        }
+        struct NodeData data;
+        getIndexNodeData(list, slot, &data);
+        if (checkFunc(findData, &data)) {
+            return slot;
+        }
+    }
+    return INDEX_LIST_NONE;
+}
+
+void getIndexNodeData(const struct IndexList *list, int slot, struct NodeData *data) {
+    assert(list != NULL && data != NULL && slot >= 0 && slot < list -> slotNum);
+    data -> type = list -> hot[slot].type;
+    data -> content = list -> cold[slot];
+}
@@ -0,0 +1,211 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <new>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "input.h"
+#include "ringbuffer.h"
+
+struct InputQueue {
+    struct InputSource source;
+    int eventSize;
+    struct RingBuffer *ring;
+    // Without it, the thread taking events pumps them from the source
+    bool isThreaded;
+    std::thread reader;
+
+    // Owned by the thread taking events: the event read past the end of a coalesced run, if any
+    unsigned char *pending;
+    bool hasPending;
+    int maxQueuedNum;
+    long long int takenNum, coalescedNum;
+
+    // The reader wakes the taker through these only when it is asleep
+    std::mutex lock;
+    std::condition_variable readyCond;
+    std::atomic<bool> isWaiting, isStopping;
+    std::atomic<long long int> readNum, droppedNum;
+};
+
+static void wakeTaker(struct InputQueue *queue) {
+    // Pairs with the fence in waitInput(), either the taker sees the event or the reader sees it waiting
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (queue -> isWaiting.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> guard(queue -> lock);
+        queue -> readyCond.notify_one();
+    }
+}
+
+static void runReader(struct InputQueue *queue) {
+    unsigned char *event = (unsigned char *)malloc(queue -> eventSize);
+    if (event == NULL) {
+        fprintf(stderr, "runReader: out of memory\n");
+        return;
+    }
+    while (!queue -> isStopping) {
+        if (!queue -> source.readFunc(queue -> source.impl, event)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(INPUT_IDLE_MS));
+            continue;
+        }
+        queue -> readNum++;
+        bool isWritten = writeRingBuffer(queue -> ring, event, queue -> eventSize);
+        if (!isWritten && queue -> source.isCoalescableFunc(queue -> source.impl, event)) {
+            // A later one will tell the same, better than holding up the clicks behind it
+            queue -> droppedNum++;
+            continue;
+        }
+        while (!isWritten && !queue -> isStopping) {
+            wakeTaker(queue);
+            std::this_thread::yield();
+            isWritten = writeRingBuffer(queue -> ring, event, queue -> eventSize);
+        }
+        wakeTaker(queue);
+    }
+    free(event);
+}
+
+// Move what the source has into the ring, as long as it has room, on the thread taking events,
+// which is then both sides of the ring
+// Complexity: O(k), k for the events moved
+static void pumpInput(struct InputQueue *queue) {
+    unsigned char *event = queue -> pending + queue -> eventSize;
+    int capacity = getRingBufferCapacity(queue -> ring);
+    while (capacity - getRingBufferReadable(queue -> ring) >= queue -> eventSize &&
+           queue -> source.readFunc(queue -> source.impl, event)) {
+        queue -> readNum++;
+        bool isWritten = writeRingBuffer(queue -> ring, event, queue -> eventSize);
+        assert(isWritten);
+        (void)isWritten;
+    }
+}
+
+static void freeInputQueue(struct InputQueue *queue) {
+    if (queue -> ring != NULL) {
+        destroyRingBuffer(queue -> ring);
+    }
+    free(queue -> pending);
+    delete queue;
+}
+
+struct InputQueue * makeInputQueue(const struct InputSource *source, int eventSize, bool isThreaded) {
+    assert(source != NULL && source -> readFunc != NULL && source -> isCoalescableFunc != NULL && eventSize > 0);
+    struct InputQueue *queue = new (std::nothrow) InputQueue;
+    if (queue == NULL) {
+        fprintf(stderr, "makeInputQueue: out of memory\n");
+        return NULL;
+    }
+    queue -> source = *source;
+    queue -> eventSize = eventSize;
+    queue -> ring = makeRingBuffer(eventSize * INPUT_RING_EVENTS);
+    // The second half takes events being pumped
+    queue -> pending = (unsigned char *)malloc(2 * eventSize);
+    if (queue -> ring == NULL || queue -> pending == NULL) {
+        fprintf(stderr, "makeInputQueue: out of memory\n");
+        freeInputQueue(queue);
+        return NULL;
+    }
+    queue -> hasPending = false;
+    queue -> maxQueuedNum = 0;
+    queue -> takenNum = queue -> coalescedNum = 0;
+    queue -> isWaiting = false;
+    queue -> isStopping = false;
+    queue -> readNum = queue -> droppedNum = 0;
+    queue -> isThreaded = isThreaded;
+    if (isThreaded) {
+        queue -> reader = std::thread(runReader, queue);
+    }
+    return queue;
+}
+
+void destroyInputQueue(struct InputQueue *queue) {
+    assert(queue != NULL);
+    queue -> isStopping = true;
+    if (queue -> isThreaded) {
+        queue -> reader.join();
+    }
+    freeInputQueue(queue);
+}
+
+static int getQueuedNum(struct InputQueue *queue) {
+    return getRingBufferReadable(queue -> ring) / queue -> eventSize + (queue -> hasPending ? 1 : 0);
+}
+
+bool hasInput(struct InputQueue *queue) {
+    assert(queue != NULL);
+    if (!queue -> isThreaded) {
+        pumpInput(queue);
+    }
+    return getQueuedNum(queue) > 0;
+}
+
+static void waitInput(struct InputQueue *queue) {
+    if (!queue -> isThreaded) {
+        pumpInput(queue);
+        while (getRingBufferReadable(queue -> ring) < queue -> eventSize) {
+            if (queue -> source.idleFunc != NULL) {
+                queue -> source.idleFunc(queue -> source.impl);
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(INPUT_IDLE_MS));
+            }
+            pumpInput(queue);
+        }
+        return;
+    }
+    if (getRingBufferReadable(queue -> ring) >= queue -> eventSize) {
+        return;
+    }
+    std::unique_lock<std::mutex> guard(queue -> lock);
+    queue -> isWaiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // Timed, so that a wake-up missed for whatever reason costs a moment instead of a hang
+    while (getRingBufferReadable(queue -> ring) < queue -> eventSize) {
+        queue -> readyCond.wait_for(guard, std::chrono::milliseconds(INPUT_IDLE_MS));
+    }
+    queue -> isWaiting.store(false, std::memory_order_relaxed);
+}
+
+// Complexity: O(k), k for the events coalesced
+void takeInput(struct InputQueue *queue, void *event) {
+    assert(queue != NULL && event != NULL);
+    if (queue -> hasPending) {
+        memcpy(event, queue -> pending, queue -> eventSize);
+        queue -> hasPending = false;
+    } else {
+        waitInput(queue);
+        bool isRead = readRingBuffer(queue -> ring, event, queue -> eventSize);
+        assert(isRead);
+        (void)isRead;
+    }
+    int queuedNum = getQueuedNum(queue) + 1;
+    queue -> maxQueuedNum = max(queue -> maxQueuedNum, queuedNum);
+    queue -> takenNum++;
+
+    if (!queue -> source.isCoalescableFunc(queue -> source.impl, event)) {
+        return;
+    }
+    // Stops at the first event of another kind, kept for the next call
+    while (readRingBuffer(queue -> ring, queue -> pending, queue -> eventSize)) {
+        if (!queue -> source.isCoalescableFunc(queue -> source.impl, queue -> pending)) {
+            queue -> hasPending = true;
+            return;
+        }
+        memcpy(event, queue -> pending, queue -> eventSize);
+        queue -> coalescedNum++;
+    }
+}
+
+void getInputStats(struct InputQueue *queue, struct InputStats *stats) {
+    assert(queue != NULL && stats != NULL);
+    stats -> queuedNum = getQueuedNum(queue);
+    stats -> maxQueuedNum = queue -> maxQueuedNum;
+    stats -> readNum = queue -> readNum;
+    stats -> takenNum = queue -> takenNum;
+    stats -> coalescedNum = queue -> coalescedNum;
+    stats -> droppedNum = queue -> droppedNum;
+}
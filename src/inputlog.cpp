@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#include "inputlog.h"
+
+struct InputLog {
+    FILE *file;
+    bool isFailed;
+};
+
+struct InputLog * openInputLog(const char *path) {
+    assert(path != NULL);
+    errno = 0;
+    struct InputLog *log = (struct InputLog *)malloc(sizeof(struct InputLog));
+    if (log == NULL) {
+        perror("openInputLog");
+        return NULL;
+    }
+    log -> file = fopen(path, "wb");
+    if (log -> file == NULL) {
+        perror("openInputLog");
+        free(log);
+        return NULL;
+    }
+    log -> isFailed = false;
+
+    struct InputLogHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, INPUT_LOG_MAGIC, INPUT_LOG_MAGIC_LENGTH);
+    header.version = INPUT_LOG_VERSION;
+    header.byteOrder = INPUT_LOG_BYTE_ORDER;
+    if (fwrite(&header, sizeof(header), 1, log -> file) != 1) {
+        perror("openInputLog");
+        fclose(log -> file);
+        free(log);
+        return NULL;
+    }
+    return log;
+}
+
+bool appendInputLog(struct InputLog *log, const struct InputLogEvent *event) {
+    assert(log != NULL && event != NULL);
+    if (!log -> isFailed && fwrite(event, sizeof(struct InputLogEvent), 1, log -> file) != 1) {
+        log -> isFailed = true;
+    }
+    return !log -> isFailed;
+}
+
+bool closeInputLog(struct InputLog *log) {
+    assert(log != NULL);
+    bool isClosed = fclose(log -> file) == 0 && !log -> isFailed;
+    free(log);
+    return isClosed;
+}
+
+// A torn last record is dropped, like the tail of a session that crashed while recording,
+// and reading stops at the first record of an unknown kind
+// Complexity: O(n)
+struct InputLogEvent * loadInputLog(const char *path, int *eventNum) {
+    assert(path != NULL && eventNum != NULL);
+    *eventNum = 0;
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    struct InputLogHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, INPUT_LOG_MAGIC, INPUT_LOG_MAGIC_LENGTH) != 0 ||
+        header.version != INPUT_LOG_VERSION || header.byteOrder != INPUT_LOG_BYTE_ORDER) {
+        fprintf(stderr, "loadInputLog: %s is not an input log\n", path);
+        fclose(file);
+        return NULL;
+    }
+    long headerSize = ftell(file);
+    fseek(file, 0, SEEK_END);
+    long count = (ftell(file) - headerSize) / (long)sizeof(struct InputLogEvent);
+    fseek(file, headerSize, SEEK_SET);
+    if (count <= 0) {
+        fclose(file);
+        return NULL;
+    }
+
+    errno = 0;
+    struct InputLogEvent *events = (struct InputLogEvent *)malloc(count * sizeof(struct InputLogEvent));
+    if (events == NULL) {
+        perror("loadInputLog");
+        fclose(file);
+        return NULL;
+    }
+    if (fread(events, sizeof(struct InputLogEvent), count, file) != (size_t)count) {
+        fprintf(stderr, "loadInputLog: %s could not be read\n", path);
+        free(events);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+    for (long i = 0; i < count; i++) {
+        if (events[i].kind < INPUT_LOG_DOWN || events[i].kind > INPUT_LOG_WHEEL) {
+            count = i;
+            break;
+        }
+    }
+    if (count == 0) {
+        free(events);
+        return NULL;
+    }
+    *eventNum = (int)count;
+    return events;
+}
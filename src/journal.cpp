@@ -0,0 +1,888 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <new>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "journal.h"
+#include "ptrmap.h"
+#include "ringbuffer.h"
+
+// Longest payload: operation, id, id of the previous shape, shape and the longest content
+#define JOURNAL_MAX_PAYLOAD (1 + 4 + 4 + (int)sizeof(struct JournalShape) + DATATYPE_TEXT_MAX_LENGTH)
+#define JOURNAL_MAX_RECORD ((int)sizeof(struct JournalRecordHeader) + JOURNAL_MAX_PAYLOAD)
+
+#define JOURNAL_SHADOW_INIT_CAPACITY 64
+// Shapes handed to addNodesAtTail() at once by recovery
+#define JOURNAL_BATCH_SIZE 1024
+#define JOURNAL_NONE -1
+
+// Flat copy of the shapes indexed by id, chained in z-order through prev and next.
+// Dead ids have type DATATYPE_UNDEFINED.
+struct JournalShadow {
+    int capacity;
+    struct JournalShape *shapes;
+    char **texts;
+    int *prev, *next;
+    int head, tail, liveNum;
+};
+
+// Decoded record, text points into the payload and is not terminated
+struct JournalRecord {
+    int op;
+    // Shape count for JOURNAL_OP_CHECKPOINT
+    int id;
+    // Only for JOURNAL_OP_INSERT_AFTER and JOURNAL_OP_MOVE_AFTER
+    int prevId;
+    struct JournalShape shape;
+    const char *text;
+};
+
+struct Journal {
+    struct ListIndex index;
+
+    // Owned by the thread changing the list
+    struct PtrMap ids;
+    int nextId;
+    // Set once a change could not be tracked, nothing is recorded any more
+    bool isBroken;
+    struct RingBuffer *ring;
+
+    // Owned by the writer once it runs
+    std::thread writer;
+    char path[FILENAME_MAX], tmpPath[FILENAME_MAX];
+    FILE *file;
+    struct JournalShadow shadow;
+    long long int snapshotSize, tailSize;
+    std::chrono::steady_clock::time_point lastCheckpoint;
+
+    std::atomic<bool> isStopping, isCheckpointRequested, isFailed;
+    std::atomic<long long int> recordNum;
+    std::atomic<int> checkpointNum, stallNum;
+};
+
+static uint32_t hashPayload(const unsigned char *payload, int size) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < size; i++) {
+        hash ^= payload[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void encodeShape(const struct NodeData *data, struct JournalShape *shape, const char **text) {
+    memset(shape, 0, sizeof(struct JournalShape));
+    shape -> type = data -> type;
+    *text = NULL;
+    switch (data -> type) {
+        case DATATYPE_SEGMENT: {
+            const struct Segment *seg = (const struct Segment *)data -> content;
+            shape -> x0 = seg -> leftPt -> x;
+            shape -> y0 = seg -> leftPt -> y;
+            shape -> x1 = seg -> rightPt -> x;
+            shape -> y1 = seg -> rightPt -> y;
+            break;
+        }
+        case DATATYPE_RECTANGLE: {
+            const struct Rectangle *rec = (const struct Rectangle *)data -> content;
+            shape -> x0 = rec -> lowerLeftPt -> x;
+            shape -> y0 = rec -> lowerLeftPt -> y;
+            shape -> x1 = rec -> upperRightPt -> x;
+            shape -> y1 = rec -> upperRightPt -> y;
+            break;
+        }
+        case DATATYPE_CIRCLE: {
+            const struct Circle *cir = (const struct Circle *)data -> content;
+            shape -> x0 = cir -> centerPt -> x;
+            shape -> y0 = cir -> centerPt -> y;
+            shape -> r0 = cir -> radius;
+            break;
+        }
+        case DATATYPE_ELLIPSE: {
+            const struct Ellipse *elp = (const struct Ellipse *)data -> content;
+            shape -> x0 = elp -> centerPt -> x;
+            shape -> y0 = elp -> centerPt -> y;
+            shape -> r0 = elp -> majorSemiAxis;
+            shape -> r1 = elp -> minorSemiAxis;
+            break;
+        }
+        case DATATYPE_TEXT: {
+            const struct Text *txt = (const struct Text *)data -> content;
+            shape -> x0 = txt -> position -> lowerLeftPt -> x;
+            shape -> y0 = txt -> position -> lowerLeftPt -> y;
+            shape -> x1 = txt -> position -> upperRightPt -> x;
+            shape -> y1 = txt -> position -> upperRightPt -> y;
+            shape -> fontWidth = txt -> fontWidth;
+            shape -> fontHeight = txt -> fontHeight;
+            shape -> textLength = min((int)strlen(txt -> content), DATATYPE_TEXT_MAX_LENGTH - 1);
+            *text = txt -> content;
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+static bool hasPrevId(int op) {
+    return op == JOURNAL_OP_INSERT_AFTER || op == JOURNAL_OP_MOVE_AFTER;
+}
+
+static bool hasShape(int op) {
+    return op == JOURNAL_OP_INSERT_HEAD || op == JOURNAL_OP_INSERT_TAIL || op == JOURNAL_OP_INSERT_AFTER ||
+           op == JOURNAL_OP_EDIT;
+}
+
+// Write header and payload into record, prevId is left out unless op needs it, shape and text when shape is NULL
+// Returns the size of the whole record
+static int encodeRecord(unsigned char *record, int op, int id, int prevId, const struct JournalShape *shape, const char *text) {
+    unsigned char *payload = record + sizeof(struct JournalRecordHeader);
+    int size = 0;
+    payload[size++] = (unsigned char)op;
+    if (op != JOURNAL_OP_CLEAR) {
+        uint32_t value = (uint32_t)id;
+        memcpy(payload + size, &value, sizeof(value));
+        size += sizeof(value);
+    }
+    if (hasPrevId(op)) {
+        uint32_t value = (uint32_t)prevId;
+        memcpy(payload + size, &value, sizeof(value));
+        size += sizeof(value);
+    }
+    if (shape != NULL) {
+        memcpy(payload + size, shape, sizeof(struct JournalShape));
+        size += sizeof(struct JournalShape);
+        if (shape -> textLength > 0) {
+            memcpy(payload + size, text, shape -> textLength);
+            size += shape -> textLength;
+        }
+    }
+
+    struct JournalRecordHeader header = {(uint32_t)size, hashPayload(payload, size)};
+    memcpy(record, &header, sizeof(header));
+    return sizeof(header) + size;
+}
+
+// Check the layout of a payload and take it apart
+// Returns false if it is malformed
+static bool decodeRecord(const unsigned char *payload, int size, struct JournalRecord *record) {
+    if (size < 1) {
+        return false;
+    }
+    record -> op = payload[0];
+    record -> id = 0;
+    record -> prevId = JOURNAL_NONE;
+    record -> text = NULL;
+    if (record -> op == JOURNAL_OP_CLEAR) {
+        return size == 1;
+    }
+    if (record -> op < JOURNAL_OP_INSERT_HEAD || record -> op > JOURNAL_OP_MOVE_AFTER) {
+        return false;
+    }
+
+    int idNum = hasPrevId(record -> op) ? 2 : 1;
+    if (size < 1 + 4 * idNum) {
+        return false;
+    }
+    uint32_t values[2];
+    memcpy(values, payload + 1, 4 * idNum);
+    for (int i = 0; i < idNum; i++) {
+        if (values[i] > INT_MAX) {
+            return false;
+        }
+    }
+    record -> id = (int)values[0];
+    record -> prevId = idNum == 2 ? (int)values[1] : JOURNAL_NONE;
+
+    int shapeBegin = 1 + 4 * idNum;
+    if (!hasShape(record -> op)) {
+        return size == shapeBegin;
+    }
+    if (size < shapeBegin + (int)sizeof(struct JournalShape)) {
+        return false;
+    }
+    memcpy(&record -> shape, payload + shapeBegin, sizeof(struct JournalShape));
+    record -> text = (const char *)payload + shapeBegin + sizeof(struct JournalShape);
+    return validateDataType(record -> shape.type) && record -> shape.textLength >= 0 &&
+           record -> shape.textLength < DATATYPE_TEXT_MAX_LENGTH &&
+           size == shapeBegin + (int)sizeof(struct JournalShape) + record -> shape.textLength;
+}
+
+static void initShadow(struct JournalShadow *shadow) {
+    shadow -> capacity = 0;
+    shadow -> shapes = NULL;
+    shadow -> texts = NULL;
+    shadow -> prev = shadow -> next = NULL;
+    shadow -> head = shadow -> tail = JOURNAL_NONE;
+    shadow -> liveNum = 0;
+}
+
+static void destroyShadow(struct JournalShadow *shadow) {
+    for (int i = 0; i < shadow -> capacity; i++) {
+        free(shadow -> texts[i]);
+    }
+    free(shadow -> shapes);
+    free(shadow -> texts);
+    free(shadow -> prev);
+    free(shadow -> next);
+    initShadow(shadow);
+}
+
+// Grow an array to capacity elements of given size, leaving it as it was on failure
+static bool growArray(void **array, int capacity, size_t size) {
+    void *newArray = realloc(*array, capacity * size);
+    if (newArray == NULL) {
+        return false;
+    }
+    *array = newArray;
+    return true;
+}
+
+// Make id a valid index of the shadow
+// Complexity: O(1) amortized
+static bool reserveShadow(struct JournalShadow *shadow, int id) {
+    if (id < shadow -> capacity) {
+        return true;
+    }
+    int newCapacity = max(shadow -> capacity, JOURNAL_SHADOW_INIT_CAPACITY);
+    while (newCapacity <= id) {
+        newCapacity = newCapacity > INT_MAX / 2 ? INT_MAX : newCapacity * 2;
+    }
+
+    errno = 0;
+    if (!growArray((void **)&shadow -> shapes, newCapacity, sizeof(struct JournalShape)) ||
+        !growArray((void **)&shadow -> texts, newCapacity, sizeof(char *)) ||
+        !growArray((void **)&shadow -> prev, newCapacity, sizeof(int)) ||
+        !growArray((void **)&shadow -> next, newCapacity, sizeof(int))) {
+        perror("reserveShadow");
+        return false;
+    }
+    for (int i = shadow -> capacity; i < newCapacity; i++) {
+        shadow -> shapes[i].type = DATATYPE_UNDEFINED;
+        shadow -> texts[i] = NULL;
+    }
+    shadow -> capacity = newCapacity;
+    return true;
+}
+
+static bool isLiveShadow(const struct JournalShadow *shadow, int id) {
+    return id < shadow -> capacity && shadow -> shapes[id].type != DATATYPE_UNDEFINED;
+}
+
+static bool setShadowShape(struct JournalShadow *shadow, int id, const struct JournalShape *shape, const char *text) {
+    char *newText = NULL;
+    if (shape -> type == DATATYPE_TEXT) {
+        errno = 0;
+        newText = (char *)malloc(shape -> textLength + 1);
+        if (newText == NULL) {
+            perror("setShadowShape");
+            return false;
+        }
+        memcpy(newText, text, shape -> textLength);
+        newText[shape -> textLength] = '\0';
+    }
+    free(shadow -> texts[id]);
+    shadow -> texts[id] = newText;
+    shadow -> shapes[id] = *shape;
+    return true;
+}
+
+static void linkShadow(struct JournalShadow *shadow, int id, bool isHead) {
+    if (isHead) {
+        shadow -> prev[id] = JOURNAL_NONE;
+        shadow -> next[id] = shadow -> head;
+        if (shadow -> head != JOURNAL_NONE) {
+            shadow -> prev[shadow -> head] = id;
+        } else {
+            shadow -> tail = id;
+        }
+        shadow -> head = id;
+    } else {
+        shadow -> next[id] = JOURNAL_NONE;
+        shadow -> prev[id] = shadow -> tail;
+        if (shadow -> tail != JOURNAL_NONE) {
+            shadow -> next[shadow -> tail] = id;
+        } else {
+            shadow -> head = id;
+        }
+        shadow -> tail = id;
+    }
+}
+
+static void linkShadowAfter(struct JournalShadow *shadow, int id, int prevId) {
+    int nextId = shadow -> next[prevId];
+    shadow -> prev[id] = prevId;
+    shadow -> next[id] = nextId;
+    shadow -> next[prevId] = id;
+    if (nextId != JOURNAL_NONE) {
+        shadow -> prev[nextId] = id;
+    } else {
+        shadow -> tail = id;
+    }
+}
+
+static void unlinkShadow(struct JournalShadow *shadow, int id) {
+    if (shadow -> prev[id] != JOURNAL_NONE) {
+        shadow -> next[shadow -> prev[id]] = shadow -> next[id];
+    } else {
+        shadow -> head = shadow -> next[id];
+    }
+    if (shadow -> next[id] != JOURNAL_NONE) {
+        shadow -> prev[shadow -> next[id]] = shadow -> prev[id];
+    } else {
+        shadow -> tail = shadow -> prev[id];
+    }
+}
+
+static void killShadow(struct JournalShadow *shadow, int id) {
+    free(shadow -> texts[id]);
+    shadow -> texts[id] = NULL;
+    shadow -> shapes[id].type = DATATYPE_UNDEFINED;
+}
+
+// Replay a record on the shadow
+// Returns false if it does not fit the shapes, or if out of memory
+// Complexity: O(1) amortized, O(n) for JOURNAL_OP_CLEAR
+static bool applyShadow(struct JournalShadow *shadow, const struct JournalRecord *record) {
+    int id = record -> id;
+    switch (record -> op) {
+        case JOURNAL_OP_INSERT_HEAD:
+        case JOURNAL_OP_INSERT_TAIL: {
+            if (!reserveShadow(shadow, id) || isLiveShadow(shadow, id) ||
+                !setShadowShape(shadow, id, &record -> shape, record -> text)) {
+                return false;
+            }
+            linkShadow(shadow, id, record -> op == JOURNAL_OP_INSERT_HEAD);
+            shadow -> liveNum++;
+            return true;
+        }
+        case JOURNAL_OP_INSERT_AFTER: {
+            int prevId = record -> prevId;
+            if (!isLiveShadow(shadow, prevId) || !reserveShadow(shadow, id) || isLiveShadow(shadow, id) ||
+                !setShadowShape(shadow, id, &record -> shape, record -> text)) {
+                return false;
+            }
+            linkShadowAfter(shadow, id, prevId);
+            shadow -> liveNum++;
+            return true;
+        }
+        case JOURNAL_OP_EDIT: {
+            return isLiveShadow(shadow, id) && setShadowShape(shadow, id, &record -> shape, record -> text);
+        }
+        case JOURNAL_OP_REMOVE: {
+            if (!isLiveShadow(shadow, id)) {
+                return false;
+            }
+            unlinkShadow(shadow, id);
+            killShadow(shadow, id);
+            shadow -> liveNum--;
+            return true;
+        }
+        case JOURNAL_OP_MOVE_HEAD:
+        case JOURNAL_OP_MOVE_TAIL: {
+            if (!isLiveShadow(shadow, id)) {
+                return false;
+            }
+            unlinkShadow(shadow, id);
+            linkShadow(shadow, id, record -> op == JOURNAL_OP_MOVE_HEAD);
+            return true;
+        }
+        case JOURNAL_OP_MOVE_AFTER: {
+            if (!isLiveShadow(shadow, id) || !isLiveShadow(shadow, record -> prevId) || id == record -> prevId) {
+                return false;
+            }
+            unlinkShadow(shadow, id);
+            linkShadowAfter(shadow, id, record -> prevId);
+            return true;
+        }
+        case JOURNAL_OP_CLEAR: {
+            for (int cntId = shadow -> head; cntId != JOURNAL_NONE; cntId = shadow -> next[cntId]) {
+                killShadow(shadow, cntId);
+            }
+            shadow -> head = shadow -> tail = JOURNAL_NONE;
+            shadow -> liveNum = 0;
+            return true;
+        }
+        case JOURNAL_OP_CHECKPOINT: {
+            return id == shadow -> liveNum;
+        }
+        default: {
+            return false;
+        }
+    }
+}
+
+// The writer never stops draining the ring, so waiting for room ends as soon as it catches up
+static void pushRecord(struct Journal *journal, int op, int id, int prevId, const struct NodeData *data) {
+    struct JournalShape shape;
+    const char *text = NULL;
+    if (data != NULL) {
+        encodeShape(data, &shape, &text);
+    }
+    unsigned char record[JOURNAL_MAX_RECORD];
+    int size = encodeRecord(record, op, id, prevId, data == NULL ? NULL : &shape, text);
+    if (!writeRingBuffer(journal -> ring, record, size)) {
+        journal -> stallNum++;
+        while (!writeRingBuffer(journal -> ring, record, size)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+// Pick the operation putting node where it now is: at either end, or after the shape before it
+static int getPlaceOp(struct Journal *journal, const struct LinkedNode *node, int headOp, int tailOp, int afterOp, int *prevId) {
+    *prevId = JOURNAL_NONE;
+    if (node -> prev == NULL) {
+        return headOp;
+    }
+    if (node -> next == NULL) {
+        return tailOp;
+    }
+    *prevId = getPtrMap(&journal -> ids, node -> prev);
+    assert(*prevId >= 0);
+    return afterOp;
+}
+
+static void insertHook(void *impl, struct LinkedNode *node) {
+    struct Journal *journal = (struct Journal *)impl;
+    if (journal -> isBroken) {
+        return;
+    }
+    int id = journal -> nextId++;
+    if (!putPtrMap(&journal -> ids, node, id)) {
+        journal -> isBroken = true;
+        return;
+    }
+    int prevId = JOURNAL_NONE;
+    int op = getPlaceOp(journal, node, JOURNAL_OP_INSERT_HEAD, JOURNAL_OP_INSERT_TAIL, JOURNAL_OP_INSERT_AFTER, &prevId);
+    pushRecord(journal, op, id, prevId, node -> data);
+}
+
+static void removeHook(void *impl, struct LinkedNode *node) {
+    struct Journal *journal = (struct Journal *)impl;
+    if (journal -> isBroken) {
+        return;
+    }
+    int id = getPtrMap(&journal -> ids, node);
+    assert(id >= 0);
+    removePtrMap(&journal -> ids, node);
+    pushRecord(journal, JOURNAL_OP_REMOVE, id, JOURNAL_NONE, NULL);
+}
+
+static void editHook(void *impl, struct LinkedNode *node, struct NodeData *oldData) {
+    (void)oldData;
+    struct Journal *journal = (struct Journal *)impl;
+    if (journal -> isBroken) {
+        return;
+    }
+    int id = getPtrMap(&journal -> ids, node);
+    assert(id >= 0);
+    pushRecord(journal, JOURNAL_OP_EDIT, id, JOURNAL_NONE, node -> data);
+}
+
+static void reorderHook(void *impl, struct LinkedNode *node) {
+    struct Journal *journal = (struct Journal *)impl;
+    if (journal -> isBroken) {
+        return;
+    }
+    int id = getPtrMap(&journal -> ids, node);
+    assert(id >= 0);
+    int prevId = JOURNAL_NONE;
+    int op = getPlaceOp(journal, node, JOURNAL_OP_MOVE_HEAD, JOURNAL_OP_MOVE_TAIL, JOURNAL_OP_MOVE_AFTER, &prevId);
+    pushRecord(journal, op, id, prevId, NULL);
+}
+
+static void clearHook(void *impl) {
+    struct Journal *journal = (struct Journal *)impl;
+    if (journal -> isBroken) {
+        return;
+    }
+    clearPtrMap(&journal -> ids);
+    pushRecord(journal, JOURNAL_OP_CLEAR, 0, JOURNAL_NONE, NULL);
+}
+
+// Push buffered bytes of file down to the disk
+static bool syncFile(FILE *file) {
+    if (fflush(file) != 0) {
+        return false;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Stop writing, the shapes stay tracked so that closeJournal() can tell
+static void failJournal(struct Journal *journal) {
+    journal -> isFailed = true;
+    if (journal -> file != NULL) {
+        fclose(journal -> file);
+        journal -> file = NULL;
+    }
+}
+
+// Write the shadow as a snapshot into a side file, then swap it in for the journal and append to it from now on
+// Complexity: O(n)
+static void writeCheckpoint(struct Journal *journal) {
+    const struct JournalShadow *shadow = &journal -> shadow;
+    errno = 0;
+    FILE *file = fopen(journal -> tmpPath, "wb");
+    bool isWritten = file != NULL;
+    long long int size = 0;
+    if (isWritten) {
+        struct JournalHeader header;
+        memcpy(header.magic, JOURNAL_MAGIC, JOURNAL_MAGIC_LENGTH);
+        header.version = JOURNAL_VERSION;
+        header.byteOrder = JOURNAL_BYTE_ORDER;
+        isWritten = fwrite(&header, sizeof(header), 1, file) == 1;
+        size += sizeof(header);
+    }
+
+    unsigned char record[JOURNAL_MAX_RECORD];
+    for (int id = shadow -> head; isWritten && id != JOURNAL_NONE; id = shadow -> next[id]) {
+        int recordSize = encodeRecord(record, JOURNAL_OP_INSERT_TAIL, id, JOURNAL_NONE, &shadow -> shapes[id], shadow -> texts[id]);
+        isWritten = fwrite(record, 1, recordSize, file) == (size_t)recordSize;
+        size += recordSize;
+    }
+    if (isWritten) {
+        int recordSize = encodeRecord(record, JOURNAL_OP_CHECKPOINT, shadow -> liveNum, JOURNAL_NONE, NULL, NULL);
+        isWritten = fwrite(record, 1, recordSize, file) == (size_t)recordSize && syncFile(file);
+        size += recordSize;
+    }
+    if (file != NULL && fclose(file) != 0) {
+        isWritten = false;
+    }
+    if (!isWritten) {
+        perror("writeCheckpoint");
+        remove(journal -> tmpPath);
+        failJournal(journal);
+        return;
+    }
+
+    // An open file cannot be replaced everywhere
+    if (journal -> file != NULL) {
+        fclose(journal -> file);
+        journal -> file = NULL;
+    }
+    errno = 0;
+    if (!replaceFile(journal -> tmpPath, journal -> path) || (journal -> file = fopen(journal -> path, "ab")) == NULL) {
+        perror("writeCheckpoint");
+        failJournal(journal);
+        return;
+    }
+    journal -> snapshotSize = size;
+    journal -> tailSize = 0;
+    journal -> lastCheckpoint = std::chrono::steady_clock::now();
+    journal -> checkpointNum++;
+}
+
+// Append every record in the ring to the file and replay it on the shadow
+// Returns the number of records taken
+static int drainRecords(struct Journal *journal) {
+    unsigned char record[JOURNAL_MAX_RECORD];
+    struct JournalRecordHeader header;
+    int drainedNum = 0;
+    while (readRingBuffer(journal -> ring, &header, sizeof(header))) {
+        // Records are written to the ring whole, so the payload is there already
+        assert((int)header.size <= JOURNAL_MAX_PAYLOAD);
+        bool isWhole = readRingBuffer(journal -> ring, record + sizeof(header), header.size);
+        assert(isWhole);
+        (void)isWhole;
+        memcpy(record, &header, sizeof(header));
+        int size = sizeof(header) + header.size;
+
+        // A shadow out of step would write wrong checkpoints, the journal stops instead
+        struct JournalRecord decoded;
+        if (!decodeRecord(record + sizeof(header), header.size, &decoded) || !applyShadow(&journal -> shadow, &decoded)) {
+            if (!journal -> isFailed) {
+                fprintf(stderr, "drainRecords: shapes out of step\n");
+            }
+            failJournal(journal);
+        }
+        if (journal -> file != NULL) {
+            errno = 0;
+            if (fwrite(record, 1, size, journal -> file) != (size_t)size) {
+                perror("drainRecords");
+                failJournal(journal);
+            }
+            journal -> tailSize += size;
+        }
+        drainedNum++;
+        journal -> recordNum++;
+    }
+    return drainedNum;
+}
+
+static bool isCheckpointDue(struct Journal *journal) {
+    if (journal -> file == NULL) {
+        return false;
+    }
+    if (journal -> isCheckpointRequested.exchange(false)) {
+        return true;
+    }
+    if (journal -> tailSize > max(JOURNAL_CHECKPOINT_MIN_SIZE, journal -> snapshotSize)) {
+        return true;
+    }
+    return journal -> tailSize > 0 &&
+           std::chrono::steady_clock::now() - journal -> lastCheckpoint >= std::chrono::seconds(JOURNAL_AUTOSAVE_SECONDS);
+}
+
+// Records taken in one pass are flushed to disk together, so bursts of changes cost one sync
+static void runWriter(struct Journal *journal) {
+    writeCheckpoint(journal);
+    while (true) {
+        // Checked first, anything pushed before the stop is then drained below
+        bool isStopping = journal -> isStopping;
+        int drainedNum = drainRecords(journal);
+        if (drainedNum > 0 && journal -> file != NULL) {
+            errno = 0;
+            if (!syncFile(journal -> file)) {
+                perror("runWriter");
+                failJournal(journal);
+            }
+        }
+        if (isCheckpointDue(journal)) {
+            writeCheckpoint(journal);
+        }
+        if (isStopping) {
+            break;
+        }
+        if (drainedNum == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(JOURNAL_IDLE_MS));
+        }
+    }
+    if (journal -> file != NULL) {
+        fclose(journal -> file);
+        journal -> file = NULL;
+    }
+}
+
+static void freeJournal(struct Journal *journal) {
+    destroyShadow(&journal -> shadow);
+    destroyPtrMap(&journal -> ids);
+    if (journal -> ring != NULL) {
+        destroyRingBuffer(journal -> ring);
+    }
+    delete journal;
+}
+
+// Complexity: O(n)
+struct Journal * openJournal(struct LinkedList *list, const char *path) {
+    assert(list != NULL && path != NULL);
+    struct Journal *journal = new (std::nothrow) Journal;
+    if (journal == NULL) {
+        fprintf(stderr, "openJournal: out of memory\n");
+        return NULL;
+    }
+    initPtrMap(&journal -> ids);
+    initShadow(&journal -> shadow);
+    journal -> nextId = 0;
+    journal -> isBroken = false;
+    journal -> file = NULL;
+    journal -> snapshotSize = journal -> tailSize = 0;
+    journal -> isStopping = false;
+    journal -> isCheckpointRequested = false;
+    journal -> isFailed = false;
+    journal -> recordNum = 0;
+    journal -> checkpointNum = 0;
+    journal -> stallNum = 0;
+    journal -> ring = makeRingBuffer(JOURNAL_RING_SIZE);
+    if (journal -> ring == NULL) {
+        freeJournal(journal);
+        return NULL;
+    }
+    if (snprintf(journal -> path, sizeof(journal -> path), "%s", path) >= (int)sizeof(journal -> path) ||
+        snprintf(journal -> tmpPath, sizeof(journal -> tmpPath), "%s.tmp", path) >= (int)sizeof(journal -> tmpPath)) {
+        fprintf(stderr, "openJournal: path too long\n");
+        freeJournal(journal);
+        return NULL;
+    }
+
+    // The writer starts from a copy of the shapes as they are now
+    for (struct LinkedNode *cntNode = list -> head; cntNode != NULL; cntNode = cntNode -> next) {
+        struct JournalRecord record;
+        record.op = JOURNAL_OP_INSERT_TAIL;
+        record.id = journal -> nextId++;
+        record.prevId = JOURNAL_NONE;
+        encodeShape(cntNode -> data, &record.shape, &record.text);
+        if (!putPtrMap(&journal -> ids, cntNode, record.id) || !applyShadow(&journal -> shadow, &record)) {
+            freeJournal(journal);
+            return NULL;
+        }
+    }
+
+    memset(&journal -> index, 0, sizeof(journal -> index));
+    journal -> index.kind = LIST_INDEX_JOURNAL;
+    journal -> index.impl = journal;
+    journal -> index.insertFunc = insertHook;
+    journal -> index.removeFunc = removeHook;
+    journal -> index.editFunc = editHook;
+    journal -> index.reorderFunc = reorderHook;
+    journal -> index.clearFunc = clearHook;
+    attachIndex(list, &journal -> index);
+
+    journal -> lastCheckpoint = std::chrono::steady_clock::now();
+    journal -> writer = std::thread(runWriter, journal);
+    return journal;
+}
+
+bool closeJournal(struct Journal *journal, struct LinkedList *list) {
+    assert(journal != NULL && list != NULL);
+    detachIndex(list, &journal -> index);
+    journal -> isStopping = true;
+    journal -> writer.join();
+
+    bool isClosed = !journal -> isFailed && !journal -> isBroken;
+    freeJournal(journal);
+    return isClosed;
+}
+
+void requestCheckpoint(struct Journal *journal) {
+    assert(journal != NULL);
+    journal -> isCheckpointRequested = true;
+}
+
+void getJournalStatus(struct Journal *journal, struct JournalStatus *status) {
+    assert(journal != NULL && status != NULL);
+    status -> recordNum = journal -> recordNum;
+    status -> checkpointNum = journal -> checkpointNum;
+    status -> stallNum = journal -> stallNum;
+    status -> isFailed = journal -> isFailed || journal -> isBroken;
+}
+
+// Build the data of a shadow shape
+// Returns its pointer, or NULL if out of memory
+static struct NodeData * makeShadowData(const struct JournalShape *shape, const char *text) {
+    switch (shape -> type) {
+        case DATATYPE_SEGMENT: {
+            return makeData(makeSegment(makeVertex(shape -> x0, shape -> y0), makeVertex(shape -> x1, shape -> y1)),
+                            DATATYPE_SEGMENT);
+        }
+        case DATATYPE_RECTANGLE: {
+            return makeData(makeRectangle(makeVertex(shape -> x0, shape -> y0), makeVertex(shape -> x1, shape -> y1)),
+                            DATATYPE_RECTANGLE);
+        }
+        case DATATYPE_CIRCLE: {
+            return makeData(makeCircle(makeVertex(shape -> x0, shape -> y0), shape -> r0), DATATYPE_CIRCLE);
+        }
+        case DATATYPE_ELLIPSE: {
+            return makeData(makeEllipse(makeVertex(shape -> x0, shape -> y0), shape -> r0, shape -> r1), DATATYPE_ELLIPSE);
+        }
+        case DATATYPE_TEXT: {
+            return makeData(makeText(makeRectangle(makeVertex(shape -> x0, shape -> y0), makeVertex(shape -> x1, shape -> y1)),
+                                     text, shape -> fontWidth, shape -> fontHeight), DATATYPE_TEXT);
+        }
+        default: {
+            return NULL;
+        }
+    }
+}
+
+// Build list nodes for every shadow shape, from head to tail
+// Returns false if out of memory
+static bool buildShadowList(const struct JournalShadow *shadow, struct LinkedList *list) {
+    struct NodeData *batch[JOURNAL_BATCH_SIZE];
+    int id = shadow -> head;
+    while (id != JOURNAL_NONE) {
+        int dataNum = 0;
+        for (; id != JOURNAL_NONE && dataNum < JOURNAL_BATCH_SIZE; id = shadow -> next[id]) {
+            const char *text = shadow -> texts[id] == NULL ? "" : shadow -> texts[id];
+            if ((batch[dataNum] = makeShadowData(&shadow -> shapes[id], text)) == NULL) {
+                break;
+            }
+            dataNum++;
+        }
+        int addedNum = addNodesAtTail(list, batch, dataNum);
+        for (int i = addedNum; i < dataNum; i++) {
+            destroyRule(batch[i]);
+        }
+        if (addedNum < dataNum || (id != JOURNAL_NONE && dataNum < JOURNAL_BATCH_SIZE)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Replaying goes through the shadow, the list is only built once at the end
+// Complexity: O(n + r), r the number of records
+bool recoverJournal(struct LinkedList *list, const char *path, struct JournalStats *stats) {
+    assert(list != NULL && path != NULL && list -> index == NULL);
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    struct JournalHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, JOURNAL_MAGIC, JOURNAL_MAGIC_LENGTH) != 0 ||
+        header.version != JOURNAL_VERSION || header.byteOrder != JOURNAL_BYTE_ORDER) {
+        fprintf(stderr, "recoverJournal: %s is not a journal\n", path);
+        fclose(file);
+        return false;
+    }
+
+    struct JournalShadow shadow;
+    initShadow(&shadow);
+    struct JournalStats cntStats = {0, 0, false};
+    bool hasSnapshot = false;
+    unsigned char payload[JOURNAL_MAX_PAYLOAD];
+    while (true) {
+        struct JournalRecordHeader recordHeader;
+        size_t readSize = fread(&recordHeader, 1, sizeof(recordHeader), file);
+        if (readSize == 0) {
+            break;
+        }
+        struct JournalRecord record;
+        if (readSize != sizeof(recordHeader) || recordHeader.size > (uint32_t)JOURNAL_MAX_PAYLOAD ||
+            fread(payload, 1, recordHeader.size, file) != recordHeader.size ||
+            hashPayload(payload, recordHeader.size) != recordHeader.checksum ||
+            !decodeRecord(payload, recordHeader.size, &record) || !applyShadow(&shadow, &record)) {
+            cntStats.isTorn = true;
+            break;
+        }
+        if (hasSnapshot) {
+            cntStats.replayedNum++;
+        } else if (record.op == JOURNAL_OP_CHECKPOINT) {
+            hasSnapshot = true;
+            cntStats.snapshotNum = shadow.liveNum;
+        }
+    }
+    fclose(file);
+    if (!hasSnapshot) {
+        fprintf(stderr, "recoverJournal: %s holds no whole snapshot\n", path);
+        destroyShadow(&shadow);
+        return false;
+    }
+
+    struct LinkedList recovered;
+    initLinkedList(&recovered);
+    bool isBuilt = buildShadowList(&shadow, &recovered);
+    destroyShadow(&shadow);
+    if (!isBuilt) {
+        destroyLinkedList(&recovered, destroyRule);
+        return false;
+    }
+
+    // Walked node by node even on a list owning the region, the recovered nodes come from it too
+    destroyLinkedList(list, destroyRule);
+    unsigned int version = list -> version;
+    bool ownsRegion = list -> ownsRegion;
+    *list = recovered;
+    list -> version = version + 1;
+    list -> ownsRegion = ownsRegion;
+    if (stats != NULL) {
+        *stats = cntStats;
+    }
+    return true;
+}
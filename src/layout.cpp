@@ -130,9 +130,11 @@ bool isInAssistArea(struct Vertex *cursorPt) {
     assert(cursorPt != NULL);
     for (int i = 0; i < EDIT_ASSIST_MAX_NUM; i++) {
         if (editAssistArr[i].x >= 0 && editAssistArr[i].y >= 0) {
-            struct Circle *cir = makeCircle(&editAssistArr[i], EDIT_ASSIST_RADIUS);
-            bool res = findCircleRule(cursorPt, cir);
-            destoryCircle(cir);
+            // editAssistArr is static, it must not be freed with a Circle
+            struct Circle cir;
+            cir.centerPt = &editAssistArr[i];
+            cir.radius = EDIT_ASSIST_RADIUS;
+            bool res = findCircleRule(cursorPt, &cir);
             if (res) {
                 return res;
             }
@@ -155,104 +157,15 @@ int getAssistId(struct Vertex *cursorPt) {
     return assistId;
 }
 
-void drawEditAssist(struct NodeData *nodeData) {
-    assert(nodeData != NULL);
+void drawEditAssist(const struct LinkedNode *node) {
+    assert(node != NULL && node -> data != NULL);
     color_t prevFillColor = getfillcolor();
     setfillcolor(EDIT_ASSIST_COLOR);
 
-    int minx, miny, maxx, maxy;
-    int drawConf = 0;
-
-    switch (nodeData -> type) {
-        case DATATYPE_SEGMENT: {
-            struct Segment *seg = (struct Segment *)nodeData -> content;
-            minx = seg -> leftPt -> x, miny = seg -> leftPt -> y;
-            maxx = seg -> rightPt -> x, maxy = seg -> rightPt -> y;
-            drawConf = EDIT_ASSIST_DRAW_SIDE_SAME;
-            break;
-        }
-        case DATATYPE_RECTANGLE: {
-            struct Rectangle *rec = (struct Rectangle *)nodeData -> content;
-            minx = rec -> lowerLeftPt -> x, miny = rec -> lowerLeftPt -> y;
-            maxx = rec -> upperRightPt -> x, maxy = rec -> upperRightPt -> y;
-            drawConf = EDIT_ASSIST_DRAW_SIDE_SAME + EDIT_ASSIST_DRAW_SIDE_NON_SAME + EDIT_ASSIST_DRAW_MID;
-            break;
-        }
-        case DATATYPE_CIRCLE: {
-            struct Circle *cir = (struct Circle *)nodeData -> content;
-            minx = cir -> centerPt -> x - cir -> radius, miny = cir -> centerPt -> y - cir -> radius;
-            maxx = cir -> centerPt -> x + cir -> radius, maxy = cir -> centerPt -> y + cir -> radius;
-            drawConf = EDIT_ASSIST_DRAW_MID;
-            break;
-        }
-        case DATATYPE_ELLIPSE: {
-            struct Ellipse * elp = (struct Ellipse *)nodeData -> content;
-            minx = elp -> centerPt -> x - elp -> majorSemiAxis, miny = elp -> centerPt -> y - elp -> minorSemiAxis;
-            maxx = elp -> centerPt -> x + elp -> majorSemiAxis, maxy = elp -> centerPt -> y + elp -> minorSemiAxis;
-            drawConf = EDIT_ASSIST_DRAW_SIDE_SAME + EDIT_ASSIST_DRAW_SIDE_NON_SAME + EDIT_ASSIST_DRAW_MID;
-            break;
-        }
-        case DATATYPE_TEXT: {
-            struct Text *txt = (struct Text *)nodeData -> content;
-            struct Rectangle *pos = (struct Rectangle *)txt -> position;
-            minx = pos -> lowerLeftPt -> x, miny = pos -> lowerLeftPt -> y;
-            maxx = pos -> upperRightPt -> x, maxy = pos -> upperRightPt -> y;
-            drawConf = EDIT_ASSIST_DRAW_SIDE_SAME + EDIT_ASSIST_DRAW_SIDE_NON_SAME;
-            break;
-        }
-        default: {
-            break;
-        }
-    }
-
-    // Initialize
+    getEditAssistPts(node, editAssistArr);
     for (int i = 0; i < EDIT_ASSIST_MAX_NUM; i++) {
-        editAssistArr[i].x = -1;
-        editAssistArr[i].y = -1;
-    }
-
-    for (int i = 0; i < EDIT_ASSIST_MAX_NUM; i++) {
-        const int xType = i / 3, yType = i % 3;
-        int cntx, cnty;
-
-        // Validate
-        if (!(drawConf & EDIT_ASSIST_DRAW_SIDE_SAME)) {
-            if (xType != 2 && yType != 2 && xType == yType) {
-                continue;
-            }
-        }
-        if (!(drawConf & EDIT_ASSIST_DRAW_SIDE_NON_SAME)) {
-            if (xType != 2 && yType != 2 && xType != yType) {
-                continue;
-            }
-        }
-        if (!(drawConf & EDIT_ASSIST_DRAW_MID)) {
-            if (xType == 2 || yType == 2) {
-                continue;
-            }
-        }
-
-        if (xType == 0) {
-            cntx = minx;
-        } else if (xType == 1) {
-            cntx = maxx;
-        } else {
-            cntx = (minx + maxx) / 2;
-        }
-
-        if (yType == 0) {
-            cnty = miny;
-        } else if (yType == 1) {
-            cnty = maxy;
-        } else {
-            cnty = (miny + maxy) / 2;
-        }
-
-        editAssistArr[i].x = cntx;
-        editAssistArr[i].y = cnty;
-
-        if (cntx >= 0 && cnty >= 0) {
-            fillellipse(cntx, cnty, EDIT_ASSIST_RADIUS, EDIT_ASSIST_RADIUS);
+        if (editAssistArr[i].x >= 0 && editAssistArr[i].y >= 0) {
+            fillellipse(editAssistArr[i].x, editAssistArr[i].y, EDIT_ASSIST_RADIUS, EDIT_ASSIST_RADIUS);
         }
     }
 
@@ -266,6 +179,16 @@ void clearCanvas() {
     setViewPort(prevViewPort);
 }
 
+// Narrow the canvas view port to rect, given in canvas coordinates, or restore the whole canvas when rect is NULL
+// The origin moves to the corner of rect, so drawing must be offset by (-minx, -miny) meanwhile
+void setCanvasClip(const struct BoundingBox *rect) {
+    if (rect == NULL) {
+        setviewport(menuWidth + 1, 0, screenWidth, screenHeight, true);
+        return;
+    }
+    setviewport(menuWidth + 1 + rect -> minx, rect -> miny, menuWidth + 1 + rect -> maxx + 1, rect -> maxy + 1, true);
+}
+
 void drawLogo(int minx, int miny, color_t fillColor, color_t textColor) {
     int prevViewPort = getViewPort();
     setViewPort(AREA_MENU);
@@ -329,6 +252,8 @@ void drawMenu() {
     snprintf(btnArr[4].text, sizeof(btnArr[4].text), "TEXT");
     snprintf(btnArr[5].text, sizeof(btnArr[5].text), "CLEAR");
     snprintf(btnArr[6].text, sizeof(btnArr[6].text), "EXIT");
+    snprintf(btnArr[7].text, sizeof(btnArr[7].text), "UNDO");
+    snprintf(btnArr[8].text, sizeof(btnArr[8].text), "REDO");
 
     for (int i = 0; i < BUTTON_NUMBER; i++) {
         btnArr[i].isAvailable = true;
@@ -337,6 +262,13 @@ void drawMenu() {
         btnArr[i].width = buttonWidth;
         btnArr[i].height = buttonHeight;
 
+        // Undo and redo share the last row
+        if (i >= BUTTON_TYPE_UNDO) {
+            btnArr[i].width = (buttonWidth - paddingWidth) / 2;
+            btnArr[i].minx = paddingWidth + (i - BUTTON_TYPE_UNDO) * (btnArr[i].width + paddingWidth);
+            btnArr[i].miny = screenHeight * (BUTTON_TYPE_UNDO + 2) / 10 + paddingHeight;
+        }
+
         if (btnArr[i].isAvailable) {
             drawButton(i, BUTTON_STATE_AVAILABLE);
         }
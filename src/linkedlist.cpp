@@ -4,42 +4,237 @@
 #include <errno.h>
 
 #include "linkedlist.h"
+#include "datatypes.h"
+#include "pool.h"
+
+struct PoolRegion documentRegion = POOL_REGION_INITIALIZER("Document");
+
+static struct Pool dataPool = POOL_MEMBER_INITIALIZER("NodeData", struct NodeData, &documentRegion);
+static struct Pool nodePool = POOL_MEMBER_INITIALIZER("LinkedNode", struct LinkedNode, &documentRegion);
 
 void initLinkedList(struct LinkedList *list) {
     assert(list != NULL);
     list -> listSize = 0;
     list -> head = NULL;
     list -> tail = NULL;
+    list -> index = NULL;
+    list -> version = 0;
+    list -> ownsRegion = false;
 }
 
+// Complexity: O(n), O(1) when an index retains the chain or the region is given back
 void destroyLinkedList(struct LinkedList *list, void (*destroyDataFunc)(struct NodeData *)) {
     assert(list != NULL);
-    struct LinkedNode *cntNode = list -> head;
-    while (cntNode != NULL) {
-        struct LinkedNode *delNode = cntNode;
-        cntNode = cntNode -> next;
-        deleteNode(list, delNode, destroyDataFunc);
+
+    bool isRetained = false;
+    for (struct ListIndex *cntIndex = list -> index; cntIndex != NULL && list -> head != NULL && !isRetained; cntIndex = cntIndex -> next) {
+        if (cntIndex -> retainListFunc != NULL) {
+            isRetained = cntIndex -> retainListFunc(cntIndex -> impl, list -> head, list -> tail, list -> listSize, destroyDataFunc);
+        }
+    }
+
+    // Every node and shape alive is in the list when no other node is, the region then takes them all back
+    bool isOnlyList = list -> ownsRegion && destroyDataFunc != NULL &&
+                      nodePool.liveNum == list -> listSize && dataPool.liveNum == list -> listSize;
+    if (isRetained || (isOnlyList && resetPoolRegion(&documentRegion))) {
+        // The chain is handed over whole, nothing to walk
+        list -> head = list -> tail = NULL;
+        list -> listSize = 0;
+    } else {
+        // Indexes are cleared at once instead of node by node
+        struct ListIndex *index = list -> index;
+        list -> index = NULL;
+
+        struct LinkedNode *cntNode = list -> head;
+        while (cntNode != NULL) {
+            struct LinkedNode *delNode = cntNode;
+            cntNode = cntNode -> next;
+            deleteNode(list, delNode, destroyDataFunc);
+        }
+        list -> index = index;
+    }
+
+    list -> version++;
+    for (struct ListIndex *cntIndex = list -> index; cntIndex != NULL; cntIndex = cntIndex -> next) {
+        if (cntIndex -> clearFunc != NULL) {
+            cntIndex -> clearFunc(cntIndex -> impl);
+        }
+    }
+}
+
+void claimDocumentRegion(struct LinkedList *list) {
+    assert(list != NULL && nodePool.liveNum == list -> listSize);
+    list -> ownsRegion = true;
+}
+
+void attachIndex(struct LinkedList *list, struct ListIndex *index) {
+    assert(list != NULL && index != NULL);
+    index -> next = NULL;
+    if (list -> index == NULL) {
+        list -> index = index;
+        return;
+    }
+    struct ListIndex *cntIndex = list -> index;
+    while (cntIndex -> next != NULL) {
+        cntIndex = cntIndex -> next;
+    }
+    cntIndex -> next = index;
+}
+
+void detachIndex(struct LinkedList *list, struct ListIndex *index) {
+    assert(list != NULL && index != NULL);
+    struct ListIndex **cntIndex = &list -> index;
+    while (*cntIndex != NULL) {
+        if (*cntIndex == index) {
+            *cntIndex = index -> next;
+            index -> next = NULL;
+            return;
+        }
+        cntIndex = &(*cntIndex) -> next;
+    }
+}
+
+struct ListIndex * findListIndex(const struct LinkedList *list, int kind) {
+    assert(list != NULL);
+    for (struct ListIndex *cntIndex = list -> index; cntIndex != NULL; cntIndex = cntIndex -> next) {
+        if (cntIndex -> kind == kind) {
+            return cntIndex;
+        }
+    }
+    return NULL;
+}
+
+static void notifyInsert(struct LinkedList *list, struct LinkedNode *node) {
+    for (struct ListIndex *cntIndex = list -> index; cntIndex != NULL; cntIndex = cntIndex -> next) {
+        if (cntIndex -> insertFunc != NULL) {
+            cntIndex -> insertFunc(cntIndex -> impl, node);
+        }
+    }
+}
+
+static void notifyPreReorder(struct LinkedList *list, struct LinkedNode *node) {
+    for (struct ListIndex *cntIndex = list -> index; cntIndex != NULL; cntIndex = cntIndex -> next) {
+        if (cntIndex -> preReorderFunc != NULL) {
+            cntIndex -> preReorderFunc(cntIndex -> impl, node);
+        }
     }
-    free(list);
-    list = NULL;
+}
+
+static void notifyReorder(struct LinkedList *list, struct LinkedNode *node) {
+    for (struct ListIndex *cntIndex = list -> index; cntIndex != NULL; cntIndex = cntIndex -> next) {
+        if (cntIndex -> reorderFunc != NULL) {
+            cntIndex -> reorderFunc(cntIndex -> impl, node);
+        }
+    }
+}
+
+// Ranks as unsigned keys, in the same order, so that ranges of keys split evenly
+static unsigned long long int getRankKey(long long int rank) {
+    return (unsigned long long int)rank ^ (1ull << 63);
+}
+
+static long long int getKeyRank(unsigned long long int key) {
+    return (long long int)(key ^ (1ull << 63));
+}
+
+// Spread the ranks around the gap between prevNode and nextNode, either of which may be NULL at an end,
+// making room for one node more, as in the order maintenance of Dietz and Sleator: the range of keys
+// around the gap is doubled until it is sparse enough by LIST_RANK_OVERFLOW, then its nodes are spread evenly
+// over it. A range is left much sparser than the threshold of the range twice its size, so relabeling
+// costs amortized O(log n) for each node put in between
+// Returns the rank left free between prevNode and nextNode
+// Complexity: O(nodes relabeled)
+static long long int relabelAround(struct LinkedNode *prevNode, struct LinkedNode *nextNode) {
+    struct LinkedNode *anchorNode = prevNode != NULL ? prevNode : nextNode;
+    unsigned long long int anchorKey = getRankKey(anchorNode -> rank);
+    struct LinkedNode *firstNode = anchorNode, *lastNode = anchorNode;
+    int nodeNum = 1;
+    double maxNodeNum = 1;
+    unsigned long long int mask = 0;
+    for (int level = 1; level <= 64; level++) {
+        mask = level == 64 ? ~0ull : (1ull << level) - 1;
+        maxNodeNum *= 2 / LIST_RANK_OVERFLOW;
+        // Nodes of the range are the ones around the anchor whose key shares its high bits
+        while (firstNode -> prev != NULL && (getRankKey(firstNode -> prev -> rank) & ~mask) == (anchorKey & ~mask)) {
+            firstNode = firstNode -> prev;
+            nodeNum++;
+        }
+        while (lastNode -> next != NULL && (getRankKey(lastNode -> next -> rank) & ~mask) == (anchorKey & ~mask)) {
+            lastNode = lastNode -> next;
+            nodeNum++;
+        }
+        // The first and last keys of the range stay free, they are the bounds of the list at both ends
+        if (nodeNum + 1 <= maxNodeNum && (unsigned long long int)nodeNum + 2 <= mask) {
+            break;
+        }
+    }
+
+    unsigned long long int key = anchorKey & ~mask;
+    unsigned long long int step = mask / ((unsigned long long int)nodeNum + 2);
+    long long int freeRank = 0;
+    if (prevNode == NULL) {
+        key += step;
+        freeRank = getKeyRank(key);
+    }
+    for (struct LinkedNode *cntNode = firstNode; cntNode != lastNode -> next; cntNode = cntNode -> next) {
+        key += step;
+        cntNode -> rank = getKeyRank(key);
+        if (cntNode == prevNode) {
+            key += step;
+            freeRank = getKeyRank(key);
+        }
+    }
+    return freeRank;
+}
+
+// Pick the rank of a node going right after prevNode, or at head if prevNode is NULL
+// Returns a rank between its neighbours to be, relabeling around them when they leave no room
+// Complexity: O(1), amortized O(log n) when relabeling
+static long long int makeRankAfter(struct LinkedList *list, struct LinkedNode *prevNode) {
+    struct LinkedNode *nextNode = prevNode == NULL ? list -> head : prevNode -> next;
+    if (prevNode == NULL && nextNode == NULL) {
+        return 0;
+    }
+    // The lowest and the highest keys are never given, they bound the list
+    unsigned long long int lowKey = prevNode == NULL ? 0 : getRankKey(prevNode -> rank);
+    unsigned long long int highKey = nextNode == NULL ? ~0ull : getRankKey(nextNode -> rank);
+    unsigned long long int gap = highKey - lowKey;
+    if (nextNode == NULL && gap > LIST_RANK_GAP) {
+        return getKeyRank(lowKey + LIST_RANK_GAP);
+    }
+    if (prevNode == NULL && gap > LIST_RANK_GAP) {
+        return getKeyRank(highKey - LIST_RANK_GAP);
+    }
+    if (gap >= 2) {
+        return getKeyRank(lowKey + gap / 2);
+    }
+    return relabelAround(prevNode, nextNode);
 }
 
 struct NodeData * makeData(void *newContent, int newType) {
     assert(newContent != NULL);
-    struct NodeData *data = (struct NodeData *)malloc(sizeof(struct NodeData));
+    errno = 0;
+    struct NodeData *data = (struct NodeData *)poolAlloc(&dataPool);
+    if (data == NULL) {
+        perror("makeData");
+        return NULL;
+    }
     data -> content = newContent;
     data -> type = newType;
     return data;
 }
 
+void destroyData(struct NodeData *data) {
+    poolFree(&dataPool, data);
+}
+
 // Complexity: O(1)
 struct LinkedNode * addNodeAtHead(struct LinkedList *list, struct NodeData *newData) {
     assert(list != NULL && newData != NULL);
     errno = 0;
     // Create new segment
-    struct LinkedNode *newNode = (struct LinkedNode *)malloc(sizeof(struct LinkedNode));
+    struct LinkedNode *newNode = (struct LinkedNode *)poolAlloc(&nodePool);
     if (newNode == NULL) {
-        free(newNode);
         perror("addNode");
         return NULL;
     }
@@ -47,6 +242,8 @@ struct LinkedNode * addNodeAtHead(struct LinkedList *list, struct NodeData *newD
     newNode -> data = newData;
     newNode -> prev = NULL;
     newNode -> next = list -> head;
+    newNode -> rank = makeRankAfter(list, NULL);
+    getDataBoundingBox(newData, &newNode -> box);
 
     // Maintain list
     if (list -> tail == NULL) {
@@ -58,7 +255,9 @@ struct LinkedNode * addNodeAtHead(struct LinkedList *list, struct NodeData *newD
 
     list -> head = newNode;
     list -> listSize++;
+    list -> version++;
 
+    notifyInsert(list, newNode);
     return newNode;
 }
 
@@ -66,9 +265,8 @@ struct LinkedNode * addNodeAtTail(struct LinkedList *list, struct NodeData *newD
     assert(list != NULL && newData != NULL);
     errno = 0;
     // Create new segment
-    struct LinkedNode *newNode = (struct LinkedNode *)malloc(sizeof(struct LinkedNode));
+    struct LinkedNode *newNode = (struct LinkedNode *)poolAlloc(&nodePool);
     if (newNode == NULL) {
-        free(newNode);
         perror("addNode");
         return NULL;
     }
@@ -76,6 +274,8 @@ struct LinkedNode * addNodeAtTail(struct LinkedList *list, struct NodeData *newD
     newNode -> data = newData;
     newNode -> prev = list -> tail;
     newNode -> next = NULL;
+    newNode -> rank = makeRankAfter(list, list -> tail);
+    getDataBoundingBox(newData, &newNode -> box);
 
     // Maintain list
     if (list -> head == NULL) {
@@ -87,20 +287,78 @@ struct LinkedNode * addNodeAtTail(struct LinkedList *list, struct NodeData *newD
 
     list -> tail = newNode;
     list -> listSize++;
+    list -> version++;
 
+    notifyInsert(list, newNode);
     return newNode;
 }
 
+// Complexity: O(dataNum)
+int addNodesAtTail(struct LinkedList *list, struct NodeData **newData, int dataNum) {
+    assert(list != NULL && (newData != NULL || dataNum == 0));
+    int addedNum = 0;
+    for (; addedNum < dataNum; addedNum++) {
+        assert(newData[addedNum] != NULL);
+        errno = 0;
+        struct LinkedNode *newNode = (struct LinkedNode *)poolAlloc(&nodePool);
+        if (newNode == NULL) {
+            perror("addNodesAtTail");
+            break;
+        }
+
+        newNode -> data = newData[addedNum];
+        newNode -> prev = list -> tail;
+        newNode -> next = NULL;
+        newNode -> rank = makeRankAfter(list, list -> tail);
+        getDataBoundingBox(newNode -> data, &newNode -> box);
+        if (list -> tail != NULL) {
+            list -> tail -> next = newNode;
+        } else {
+            list -> head = newNode;
+        }
+        list -> tail = newNode;
+        list -> listSize++;
+
+        // Indexes expect the node to be the tail when they hear of it
+        notifyInsert(list, newNode);
+    }
+    list -> version++;
+    return addedNum;
+}
+
 // Complexity: O(1)
-void editNode(struct LinkedNode *node, struct NodeData *newData, void (*destroyDataFunc)(struct NodeData *)) {
-    assert(node != NULL && newData != NULL);
-    destroyDataFunc(node -> data);
+void editNode(struct LinkedList *list, struct LinkedNode *node, struct NodeData *newData,
+              void (*destroyDataFunc)(struct NodeData *)) {
+    assert(list != NULL && node != NULL && newData != NULL);
+    struct NodeData *oldData = node -> data;
     node -> data = newData;
+    getDataBoundingBox(newData, &node -> box);
+    list -> version++;
+
+    for (struct ListIndex *cntIndex = list -> index; cntIndex != NULL; cntIndex = cntIndex -> next) {
+        if (cntIndex -> editFunc != NULL) {
+            cntIndex -> editFunc(cntIndex -> impl, node, oldData);
+        }
+    }
+
+    for (struct ListIndex *cntIndex = list -> index; cntIndex != NULL; cntIndex = cntIndex -> next) {
+        if (cntIndex -> retainDataFunc != NULL && cntIndex -> retainDataFunc(cntIndex -> impl, node, oldData, destroyDataFunc)) {
+            return;
+        }
+    }
+    destroyDataFunc(oldData);
 }
 
+// Complexity: O(n), or whatever the first matching index offers
 struct LinkedNode * findNode(struct LinkedList *list, const void *findData,
                             bool (*checkFunc)(const void *, const struct LinkedNode *)) {
     assert(list != NULL && findData != NULL && checkFunc != NULL);
+    for (struct ListIndex *cntIndex = list -> index; cntIndex != NULL; cntIndex = cntIndex -> next) {
+        if (cntIndex -> findFunc != NULL && cntIndex -> checkFunc == checkFunc) {
+            return cntIndex -> findFunc(cntIndex -> impl, findData, checkFunc);
+        }
+    }
+
     struct LinkedNode *cntNode = list -> tail;
     while (cntNode != NULL) {
         if (checkFunc(findData, cntNode)) {
@@ -111,6 +369,12 @@ struct LinkedNode * findNode(struct LinkedList *list, const void *findData,
     return NULL;
 }
 
+// Complexity: O(1)
+bool isNodeAbove(const struct LinkedNode *a, const struct LinkedNode *b) {
+    assert(a != NULL && b != NULL);
+    return a -> rank > b -> rank;
+}
+
 void moveToHead(struct LinkedList *list, struct LinkedNode *node) {
     assert(list != NULL && node != NULL);
     errno = 0;
@@ -118,6 +382,7 @@ void moveToHead(struct LinkedList *list, struct LinkedNode *node) {
     if (node -> prev == NULL) {
         return;
     }
+    notifyPreReorder(list, node);
 
     // Remove node form its current position
     node -> prev -> next = node -> next;
@@ -128,10 +393,14 @@ void moveToHead(struct LinkedList *list, struct LinkedNode *node) {
     }
 
     // Insert node to head
+    node -> rank = makeRankAfter(list, NULL);
     node -> next = list -> head;
     node -> prev = NULL;
     list -> head -> prev = node;
     list -> head = node;
+
+    list -> version++;
+    notifyReorder(list, node);
 }
 
 void moveToTail(struct LinkedList *list, struct LinkedNode *node) {
@@ -141,6 +410,7 @@ void moveToTail(struct LinkedList *list, struct LinkedNode *node) {
     if (node -> next == NULL) {
         return;
     }
+    notifyPreReorder(list, node);
 
      // Remove node form its current position
     node -> next -> prev = node -> prev;
@@ -151,10 +421,51 @@ void moveToTail(struct LinkedList *list, struct LinkedNode *node) {
     }
 
     // Insert node to tail
+    node -> rank = makeRankAfter(list, list -> tail);
     node -> prev = list -> tail;
     node -> next = NULL;
     list -> tail -> next = node;
     list -> tail = node;
+
+    list -> version++;
+    notifyReorder(list, node);
+}
+
+// Take node out of the chain, leaving its own prev and next as they were
+static void unlinkNode(struct LinkedList *list, struct LinkedNode *node) {
+    if (node -> prev == NULL) {
+        list -> head = node -> next;
+    } else {
+        node -> prev -> next = node -> next;
+    }
+    if (node -> next == NULL) {
+        list -> tail = node -> prev;
+    } else {
+        node -> next -> prev = node -> prev;
+    }
+}
+
+// Put node into the chain right after prevNode, or at head if prevNode is NULL, with a fresh rank
+// unless the one it has still lies between its new neighbours
+static void linkNodeAfter(struct LinkedList *list, struct LinkedNode *node, struct LinkedNode *prevNode) {
+    struct LinkedNode *nextNode = prevNode == NULL ? list -> head : prevNode -> next;
+    if ((prevNode != NULL && prevNode -> rank >= node -> rank) || (nextNode != NULL && node -> rank >= nextNode -> rank)) {
+        // Relabeling leaves the links alone, nextNode is still the one to come after
+        node -> rank = makeRankAfter(list, prevNode);
+    }
+
+    node -> prev = prevNode;
+    node -> next = nextNode;
+    if (prevNode == NULL) {
+        list -> head = node;
+    } else {
+        prevNode -> next = node;
+    }
+    if (nextNode == NULL) {
+        list -> tail = node;
+    } else {
+        nextNode -> prev = node;
+    }
 }
 
 // Complexity: O(1)
@@ -168,27 +479,102 @@ void deleteNode(struct LinkedList *list, struct LinkedNode *node,
         return;
     }
 
+    for (struct ListIndex *cntIndex = list -> index; cntIndex != NULL; cntIndex = cntIndex -> next) {
+        if (cntIndex -> removeFunc != NULL) {
+            cntIndex -> removeFunc(cntIndex -> impl, node);
+        }
+    }
+
     // Maintain list
-    if (node -> prev == NULL) {
-        list -> head = node -> next;
-    } else {
-        node -> prev -> next = node -> next;
+    unlinkNode(list, node);
+    list -> listSize--;
+    list -> version++;
+
+    // Free node, unless an index keeps it
+    for (struct ListIndex *cntIndex = list -> index; cntIndex != NULL; cntIndex = cntIndex -> next) {
+        if (cntIndex -> retainNodeFunc != NULL && cntIndex -> retainNodeFunc(cntIndex -> impl, node, destroyDataFunc)) {
+            return;
+        }
     }
-    if (node -> next == NULL) {
-        list -> tail = node -> prev;
-    } else {
-        node -> next -> prev = node -> prev;
+    destroyNode(node, destroyDataFunc);
+    node = NULL;
+}
+
+// Complexity: O(1), amortized O(log n) when neighbours are relabeled
+void relinkNode(struct LinkedList *list, struct LinkedNode *node, struct LinkedNode *prevNode) {
+    assert(list != NULL && node != NULL && node != prevNode);
+    linkNodeAfter(list, node, prevNode);
+    list -> listSize++;
+    list -> version++;
+    notifyInsert(list, node);
+}
+
+// Complexity: O(1), amortized O(log n) when neighbours are relabeled
+struct LinkedNode * addNodeAfter(struct LinkedList *list, struct LinkedNode *prevNode, struct NodeData *newData) {
+    assert(list != NULL && newData != NULL);
+    errno = 0;
+    struct LinkedNode *newNode = (struct LinkedNode *)poolAlloc(&nodePool);
+    if (newNode == NULL) {
+        perror("addNodeAfter");
+        return NULL;
     }
 
-    list -> listSize--;
+    newNode -> data = newData;
+    newNode -> rank = makeRankAfter(list, prevNode);
+    getDataBoundingBox(newData, &newNode -> box);
+    linkNodeAfter(list, newNode, prevNode);
+    list -> listSize++;
+    list -> version++;
+
+    notifyInsert(list, newNode);
+    return newNode;
+}
+
+// Complexity: O(n)
+void relinkNodes(struct LinkedList *list, struct LinkedNode *head) {
+    assert(list != NULL && list -> listSize == 0 && head != NULL && head -> prev == NULL);
+    struct LinkedNode *cntNode = head;
+    while (cntNode != NULL) {
+        struct LinkedNode *nextNode = cntNode -> next;
+        // Indexes expect the node to be the tail when they hear of it, as with addNodesAtTail()
+        linkNodeAfter(list, cntNode, list -> tail);
+        list -> listSize++;
+        for (struct ListIndex *cntIndex = list -> index; cntIndex != NULL; cntIndex = cntIndex -> next) {
+            if (cntIndex -> insertFunc != NULL && cntIndex -> buildFunc == NULL) {
+                cntIndex -> insertFunc(cntIndex -> impl, cntNode);
+            }
+        }
+        cntNode = nextNode;
+    }
+    list -> version++;
+
+    // The others take the whole list at once
+    for (struct ListIndex *cntIndex = list -> index; cntIndex != NULL; cntIndex = cntIndex -> next) {
+        if (cntIndex -> buildFunc != NULL) {
+            cntIndex -> buildFunc(cntIndex -> impl, list);
+        }
+    }
+}
+
+// Complexity: O(1), amortized O(log n) when neighbours are relabeled
+void moveNodeAfter(struct LinkedList *list, struct LinkedNode *node, struct LinkedNode *prevNode, long long int rank) {
+    assert(list != NULL && node != NULL && node != prevNode);
+    notifyPreReorder(list, node);
+    unlinkNode(list, node);
+    node -> rank = rank;
+    linkNodeAfter(list, node, prevNode);
+    list -> version++;
+    notifyReorder(list, node);
+}
 
-    // Free node
+void destroyNode(struct LinkedNode *node, void (*destroyDataFunc)(struct NodeData *)) {
+    assert(node != NULL);
     if (destroyDataFunc != NULL) {
         destroyDataFunc(node -> data);
     } else {
-        free(node -> data);
+        destroyData(node -> data);
         node -> data = NULL;
     }
-    free(node);
+    poolFree(&nodePool, node);
     node = NULL;
 }
@@ -1,3 +1,9 @@
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
 #include "misc.h"
 
 long long int quickPow(long long int a, long long int n) {
@@ -10,3 +16,20 @@ long long int quickPow(long long int a, long long int n) {
     }
     return ans;
 }
+
+bool isBoxIntersected(const struct BoundingBox *a, const struct BoundingBox *b) {
+    return a -> minx <= b -> maxx && b -> minx <= a -> maxx &&
+           a -> miny <= b -> maxy && b -> miny <= a -> maxy;
+}
+
+bool isInBox(int x, int y, const struct BoundingBox *box) {
+    return x >= box -> minx && x <= box -> maxx && y >= box -> miny && y <= box -> maxy;
+}
+
+bool replaceFile(const char *from, const char *to) {
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename(from, to) == 0;
+#endif
+}
@@ -0,0 +1,273 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#include "pool.h"
+
+static struct Pool *poolListHead = NULL;
+
+static void registerPool(struct Pool *pool) {
+    if (!pool -> isRegistered) {
+        pool -> isRegistered = true;
+        pool -> nextPool = poolListHead;
+        poolListHead = pool;
+        if (pool -> region != NULL) {
+            assert(pool -> region -> poolNum < POOL_REGION_MAX_POOLS);
+            pool -> region -> pools[pool -> region -> poolNum++] = pool;
+        }
+    }
+}
+
+// Complexity: O(1)
+void * poolAlloc(struct Pool *pool) {
+    assert(pool != NULL);
+    registerPool(pool);
+    void *res = NULL;
+
+#ifdef CADET_NO_POOL
+    errno = 0;
+    res = malloc(pool -> objectSize);
+    if (res == NULL) {
+        return NULL;
+    }
+#else
+    if (pool -> freeList != NULL) {
+        res = pool -> freeList;
+        pool -> freeList = *(void **)res;
+    } else {
+        if (pool -> bumpLeft == 0) {
+            struct PoolSlab *slab = pool -> spareSlabs;
+            if (slab != NULL) {
+                pool -> spareSlabs = slab -> next;
+                pool -> spareSlabNum--;
+            } else {
+                // Slab header is pointer sized, objects stay pointer aligned
+                errno = 0;
+                slab = (struct PoolSlab *)malloc(sizeof(struct PoolSlab) + pool -> objectSize * pool -> slabObjectNum);
+                if (slab == NULL) {
+                    return NULL;
+                }
+                pool -> slabNum++;
+            }
+            if (pool -> slabs == NULL) {
+                pool -> oldestSlab = slab;
+            }
+            slab -> next = pool -> slabs;
+            pool -> slabs = slab;
+            pool -> chainSlabNum++;
+            pool -> bumpPtr = (char *)(slab + 1);
+            pool -> bumpLeft = pool -> slabObjectNum;
+        }
+        res = pool -> bumpPtr;
+        pool -> bumpPtr += pool -> objectSize;
+        pool -> bumpLeft--;
+    }
+#endif
+
+    pool -> allocNum++;
+    pool -> liveNum++;
+    pool -> peakNum = max(pool -> peakNum, pool -> liveNum);
+    return res;
+}
+
+// Complexity: O(1)
+void poolFree(struct Pool *pool, void *ptr) {
+    assert(pool != NULL);
+    if (ptr == NULL) {
+        return;
+    }
+    assert(pool -> liveNum > 0);
+
+#ifdef CADET_NO_POOL
+    free(ptr);
+#else
+    *(void **)ptr = pool -> freeList;
+    pool -> freeList = ptr;
+#endif
+
+    pool -> freeNum++;
+    pool -> liveNum--;
+}
+
+static void saveState(const struct Pool *pool, struct PoolState *state) {
+    state -> slabs = pool -> slabs;
+    state -> oldestSlab = pool -> oldestSlab;
+    state -> freeList = pool -> freeList;
+    state -> bumpPtr = pool -> bumpPtr;
+    state -> bumpLeft = pool -> bumpLeft;
+    state -> liveNum = pool -> liveNum;
+    state -> chainSlabNum = pool -> chainSlabNum;
+}
+
+static void loadState(struct Pool *pool, const struct PoolState *state) {
+    pool -> slabs = state -> slabs;
+    pool -> oldestSlab = state -> oldestSlab;
+    pool -> freeList = state -> freeList;
+    pool -> bumpPtr = state -> bumpPtr;
+    pool -> bumpLeft = state -> bumpLeft;
+    pool -> liveNum = state -> liveNum;
+    pool -> chainSlabNum = state -> chainSlabNum;
+    pool -> peakNum = max(pool -> peakNum, pool -> liveNum);
+}
+
+// Move the slabs of a state to the spare ones of the pool, counting its objects as freed
+// Complexity: O(1)
+static void spareState(struct Pool *pool, const struct PoolState *state) {
+    if (state -> slabs != NULL) {
+        state -> oldestSlab -> next = pool -> spareSlabs;
+        pool -> spareSlabs = state -> slabs;
+        pool -> spareSlabNum += state -> chainSlabNum;
+    }
+    pool -> freeNum += state -> liveNum;
+}
+
+// Free the spare slabs past POOL_MAX_SPARE_SLABS
+// Complexity: O(s) for the s slabs freed
+static void trimSpareSlabs(struct Pool *pool) {
+    while (pool -> spareSlabNum > POOL_MAX_SPARE_SLABS) {
+        struct PoolSlab *delSlab = pool -> spareSlabs;
+        pool -> spareSlabs = delSlab -> next;
+        free(delSlab);
+        pool -> spareSlabNum--;
+        pool -> slabNum--;
+    }
+}
+
+// Complexity: O(1)
+bool resetPool(struct Pool *pool) {
+    assert(pool != NULL);
+#ifdef CADET_NO_POOL
+    return false;
+#else
+    struct PoolState state;
+    saveState(pool, &state);
+    spareState(pool, &state);
+    memset(&state, 0, sizeof(struct PoolState));
+    loadState(pool, &state);
+    return true;
+#endif
+}
+
+static void freeSlabs(struct PoolSlab *slabs) {
+    while (slabs != NULL) {
+        struct PoolSlab *delSlab = slabs;
+        slabs = delSlab -> next;
+        free(delSlab);
+    }
+}
+
+void destroyPool(struct Pool *pool) {
+    assert(pool != NULL);
+    freeSlabs(pool -> slabs);
+    freeSlabs(pool -> spareSlabs);
+    pool -> slabs = pool -> oldestSlab = pool -> spareSlabs = NULL;
+    pool -> freeList = NULL;
+    pool -> bumpPtr = NULL;
+    pool -> bumpLeft = 0;
+    pool -> slabNum = pool -> chainSlabNum = pool -> spareSlabNum = 0;
+    pool -> liveNum = 0;
+}
+
+void getPoolStats(const struct Pool *pool, struct PoolStats *stats) {
+    assert(pool != NULL && stats != NULL);
+    stats -> liveNum = pool -> liveNum;
+    stats -> peakNum = pool -> peakNum;
+    stats -> allocNum = pool -> allocNum;
+    stats -> freeNum = pool -> freeNum;
+    stats -> slabNum = pool -> slabNum;
+    stats -> liveBytes = pool -> objectSize * pool -> liveNum;
+    stats -> peakBytes = pool -> objectSize * pool -> peakNum;
+#ifdef CADET_NO_POOL
+    stats -> reservedBytes = stats -> liveBytes;
+#else
+    stats -> reservedBytes = (sizeof(struct PoolSlab) + pool -> objectSize * pool -> slabObjectNum) * pool -> slabNum;
+#endif
+}
+
+void printPoolStats(FILE *fp) {
+    assert(fp != NULL);
+    fprintf(fp, "%-12s %6s %12s %12s %14s %12s %14s %8s\n",
+            "pool", "size", "live", "peak", "allocs", "live_bytes", "reserved_bytes", "slabs");
+    for (struct Pool *cntPool = poolListHead; cntPool != NULL; cntPool = cntPool -> nextPool) {
+        struct PoolStats stats;
+        getPoolStats(cntPool, &stats);
+        fprintf(fp, "%-12s %6d %12lld %12lld %14lld %12lld %14lld %8lld\n",
+                cntPool -> name, (int)cntPool -> objectSize, stats.liveNum, stats.peakNum, stats.allocNum,
+                (long long int)stats.liveBytes, (long long int)stats.reservedBytes, stats.slabNum);
+    }
+}
+
+// Complexity: O(1), for the few pools of a region
+bool resetPoolRegion(struct PoolRegion *region) {
+    assert(region != NULL);
+#ifdef CADET_NO_POOL
+    return false;
+#else
+    for (int i = 0; i < region -> poolNum; i++) {
+        resetPool(region -> pools[i]);
+    }
+    return true;
+#endif
+}
+
+// Complexity: O(1)
+struct PoolRegionState * setAsidePoolRegion(struct PoolRegion *region) {
+    assert(region != NULL);
+#ifdef CADET_NO_POOL
+    return NULL;
+#else
+    errno = 0;
+    struct PoolRegionState *state = (struct PoolRegionState *)calloc(1, sizeof(struct PoolRegionState));
+    if (state == NULL) {
+        perror("setAsidePoolRegion");
+        return NULL;
+    }
+    struct PoolState emptyState;
+    memset(&emptyState, 0, sizeof(struct PoolState));
+    for (int i = 0; i < region -> poolNum; i++) {
+        saveState(region -> pools[i], &state -> states[i]);
+        loadState(region -> pools[i], &emptyState);
+    }
+    state -> generation = region -> generation;
+    region -> generation = ++region -> generationNum;
+    return state;
+#endif
+}
+
+// Complexity: O(1)
+void swapPoolRegion(struct PoolRegion *region, struct PoolRegionState *state) {
+    assert(region != NULL && state != NULL);
+    for (int i = 0; i < region -> poolNum; i++) {
+        struct PoolState cntState;
+        saveState(region -> pools[i], &cntState);
+        loadState(region -> pools[i], &state -> states[i]);
+        state -> states[i] = cntState;
+    }
+    long long int generation = region -> generation;
+    region -> generation = state -> generation;
+    state -> generation = generation;
+}
+
+// Complexity: O(1), plus O(s) for the s spare slabs freed
+void dropPoolRegionState(struct PoolRegion *region, struct PoolRegionState *state) {
+    assert(region != NULL && state != NULL);
+    for (int i = 0; i < region -> poolNum; i++) {
+        spareState(region -> pools[i], &state -> states[i]);
+        // Nothing may come back to reuse what a generation held, unlike after a reset
+        trimSpareSlabs(region -> pools[i]);
+    }
+    free(state);
+    state = NULL;
+}
+
+size_t getPoolRegionBytes(const struct PoolRegion *region, const struct PoolRegionState *state) {
+    assert(region != NULL);
+    size_t bytes = 0;
+    for (int i = 0; i < region -> poolNum; i++) {
+        long long int liveNum = state == NULL ? region -> pools[i] -> liveNum : state -> states[i].liveNum;
+        bytes += region -> pools[i] -> objectSize * liveNum;
+    }
+    return bytes;
+}
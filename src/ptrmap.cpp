@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <errno.h>
+
+#include "ptrmap.h"
+
+static unsigned int hashPtr(const void *key, int capacity) {
+    // Fibonacci hashing, objects are at least 8-byte aligned
+    unsigned long long int val = (unsigned long long int)(uintptr_t)key >> 3;
+    return (unsigned int)((val * 0x9E3779B97F4A7C15ULL) >> 32) & (capacity - 1);
+}
+
+static bool allocEntries(struct PtrMap *map, int capacity) {
+    errno = 0;
+    struct PtrMapEntry *entries = (struct PtrMapEntry *)calloc(capacity, sizeof(struct PtrMapEntry));
+    if (entries == NULL) {
+        perror("allocEntries");
+        return false;
+    }
+    map -> entries = entries;
+    map -> capacity = capacity;
+    return true;
+}
+
+void initPtrMap(struct PtrMap *map) {
+    assert(map != NULL);
+    map -> size = 0;
+    map -> capacity = 0;
+    map -> entries = NULL;
+}
+
+void destroyPtrMap(struct PtrMap *map) {
+    assert(map != NULL);
+    free(map -> entries);
+    initPtrMap(map);
+}
+
+void clearPtrMap(struct PtrMap *map) {
+    assert(map != NULL);
+    if (map -> entries != NULL) {
+        memset(map -> entries, 0, sizeof(struct PtrMapEntry) * map -> capacity);
+    }
+    map -> size = 0;
+}
+
+// Complexity: O(1) amortized
+bool putPtrMap(struct PtrMap *map, const void *key, int value) {
+    assert(map != NULL && key != NULL && value >= 0);
+
+    // Keep load factor under 1/2
+    if ((map -> size + 1) * 2 > map -> capacity) {
+        struct PtrMapEntry *oldEntries = map -> entries;
+        int oldCapacity = map -> capacity;
+        if (!allocEntries(map, oldCapacity == 0 ? PTRMAP_INIT_CAPACITY : oldCapacity * 2)) {
+            map -> entries = oldEntries;
+            map -> capacity = oldCapacity;
+            return false;
+        }
+        for (int i = 0; i < oldCapacity; i++) {
+            if (oldEntries[i].key != NULL) {
+                unsigned int pos = hashPtr(oldEntries[i].key, map -> capacity);
+                while (map -> entries[pos].key != NULL) {
+                    pos = (pos + 1) & (map -> capacity - 1);
+                }
+                map -> entries[pos] = oldEntries[i];
+            }
+        }
+        free(oldEntries);
+    }
+
+    unsigned int pos = hashPtr(key, map -> capacity);
+    while (map -> entries[pos].key != NULL && map -> entries[pos].key != key) {
+        pos = (pos + 1) & (map -> capacity - 1);
+    }
+    if (map -> entries[pos].key == NULL) {
+        map -> entries[pos].key = key;
+        map -> size++;
+    }
+    map -> entries[pos].value = value;
+    return true;
+}
+
+// Complexity: O(1) expected
+int getPtrMap(const struct PtrMap *map, const void *key) {
+    assert(map != NULL);
+    if (map -> size == 0) {
+        return -1;
+    }
+    unsigned int pos = hashPtr(key, map -> capacity);
+    while (map -> entries[pos].key != NULL) {
+        if (map -> entries[pos].key == key) {
+            return map -> entries[pos].value;
+        }
+        pos = (pos + 1) & (map -> capacity - 1);
+    }
+    return -1;
+}
+
+// Complexity: O(1) expected
+void removePtrMap(struct PtrMap *map, const void *key) {
+    assert(map != NULL);
+    if (map -> size == 0) {
+        return;
+    }
+    unsigned int mask = map -> capacity - 1;
+    unsigned int pos = hashPtr(key, map -> capacity);
+    while (map -> entries[pos].key != key) {
+        if (map -> entries[pos].key == NULL) {
+            return;
+        }
+        pos = (pos + 1) & mask;
+    }
+
+    // Shift following entries back instead of leaving a tombstone
+    unsigned int hole = pos;
+    unsigned int cntPos = (pos + 1) & mask;
+    while (map -> entries[cntPos].key != NULL) {
+        unsigned int home = hashPtr(map -> entries[cntPos].key, map -> capacity);
+        if (((cntPos - home) & mask) >= ((cntPos - hole) & mask)) {
+            map -> entries[hole] = map -> entries[cntPos];
+            hole = cntPos;
+        }
+        cntPos = (cntPos + 1) & mask;
+    }
+    map -> entries[hole].key = NULL;
+    map -> entries[hole].value = 0;
+    map -> size--;
+}
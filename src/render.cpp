@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <math.h>
+#include <assert.h>
+
+#include "render.h"
+#include "distance.h"
+
+void renderShape(const struct RenderBackend *backend, const struct Vertex *startPt, const struct Vertex *endPt,
+                 int shapeType, unsigned int color) {
+    assert(backend != NULL && startPt != NULL && endPt != NULL);
+    switch (shapeType) {
+        case DATATYPE_SEGMENT: {
+            backend -> lineFunc(backend -> impl, startPt -> x, startPt -> y, endPt -> x, endPt -> y, color);
+            break;
+        }
+        case DATATYPE_RECTANGLE: {
+            backend -> rectangleFunc(backend -> impl, min(startPt -> x, endPt -> x), max(startPt -> y, endPt -> y),
+                                     max(startPt -> x, endPt -> x), min(startPt -> y, endPt -> y), color);
+            break;
+        }
+        case DATATYPE_CIRCLE: {
+            struct Vertex centerPt = {(startPt -> x + endPt -> x) / 2, (startPt -> y + endPt -> y) / 2};
+            int radius = sqrt(getSqrEuclideanDistance(&centerPt, endPt));
+            backend -> circleFunc(backend -> impl, centerPt.x, centerPt.y, radius, color);
+            break;
+        }
+        case DATATYPE_ELLIPSE: {
+            struct Vertex centerPt = {(startPt -> x + endPt -> x) / 2, (startPt -> y + endPt -> y) / 2};
+            int majorSemiAxis = abs(endPt -> x - centerPt.x);
+            int minorSemiAxis = abs(endPt -> y - centerPt.y);
+            backend -> ellipseFunc(backend -> impl, centerPt.x, centerPt.y, majorSemiAxis, minorSemiAxis, color);
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+void renderNodeData(const struct RenderBackend *backend, const struct NodeData *data, unsigned int color,
+                    bool isDraft, int offsetx, int offsety) {
+    assert(backend != NULL && data != NULL);
+    switch (data -> type) {
+        case DATATYPE_SEGMENT: {
+            struct Segment *seg = (struct Segment *)data -> content;
+            backend -> lineFunc(backend -> impl, seg -> leftPt -> x + offsetx, seg -> leftPt -> y + offsety,
+                                seg -> rightPt -> x + offsetx, seg -> rightPt -> y + offsety, color);
+            break;
+        }
+        case DATATYPE_RECTANGLE: {
+            struct Rectangle *rec = (struct Rectangle *)data -> content;
+            backend -> rectangleFunc(backend -> impl, rec -> lowerLeftPt -> x + offsetx, rec -> upperRightPt -> y + offsety,
+                                     rec -> upperRightPt -> x + offsetx, rec -> lowerLeftPt -> y + offsety, color);
+            break;
+        }
+        case DATATYPE_CIRCLE: {
+            struct Circle *cir = (struct Circle *)data -> content;
+            backend -> circleFunc(backend -> impl, cir -> centerPt -> x + offsetx, cir -> centerPt -> y + offsety,
+                                  cir -> radius, color);
+            break;
+        }
+        case DATATYPE_ELLIPSE: {
+            struct Ellipse *elp = (struct Ellipse *)data -> content;
+            backend -> ellipseFunc(backend -> impl, elp -> centerPt -> x + offsetx, elp -> centerPt -> y + offsety,
+                                   elp -> majorSemiAxis, elp -> minorSemiAxis, color);
+            break;
+        }
+        case DATATYPE_TEXT: {
+            struct Text *txt = (struct Text *)data -> content;
+            struct Rectangle *pos = txt -> position;
+            struct Vertex lowerLeftPt = {pos -> lowerLeftPt -> x + offsetx, pos -> lowerLeftPt -> y + offsety};
+            struct Vertex upperRightPt = {pos -> upperRightPt -> x + offsetx, pos -> upperRightPt -> y + offsety};
+            backend -> textFunc(backend -> impl, &lowerLeftPt, &upperRightPt, txt -> content, color, isDraft);
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+void renderStoreShape(const struct RenderBackend *backend, const struct ShapeStore *store, int slot,
+                      unsigned int color, bool isDraft) {
+    assert(backend != NULL && store != NULL && slot >= 0 && slot < store -> slotNum);
+    switch (store -> type[slot]) {
+        case DATATYPE_SEGMENT: {
+            backend -> lineFunc(backend -> impl, store -> x0[slot], store -> y0[slot], store -> x1[slot], store -> y1[slot], color);
+            break;
+        }
+        case DATATYPE_RECTANGLE: {
+            backend -> rectangleFunc(backend -> impl, store -> x0[slot], store -> y1[slot], store -> x1[slot], store -> y0[slot], color);
+            break;
+        }
+        case DATATYPE_CIRCLE: {
+            backend -> circleFunc(backend -> impl, store -> x0[slot], store -> y0[slot], store -> r0[slot], color);
+            break;
+        }
+        case DATATYPE_ELLIPSE: {
+            backend -> ellipseFunc(backend -> impl, store -> x0[slot], store -> y0[slot], store -> r0[slot], store -> r1[slot], color);
+            break;
+        }
+        case DATATYPE_TEXT: {
+            struct Vertex lowerLeftPt = {store -> x0[slot], store -> y0[slot]};
+            struct Vertex upperRightPt = {store -> x1[slot], store -> y1[slot]};
+            backend -> textFunc(backend -> impl, &lowerLeftPt, &upperRightPt, store -> text[slot], color, isDraft);
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+bool isBoxVisible(const struct BoundingBox *box, const struct BoundingBox *visibleBox) {
+    assert(box != NULL);
+    if (visibleBox == NULL) {
+        return true;
+    }
+    return box -> maxx + RENDER_CULL_MARGIN >= visibleBox -> minx && box -> minx - RENDER_CULL_MARGIN <= visibleBox -> maxx
+        && box -> maxy + RENDER_CULL_MARGIN >= visibleBox -> miny && box -> miny - RENDER_CULL_MARGIN <= visibleBox -> maxy;
+}
+
+// Complexity: O(n)
+void renderList(const struct RenderBackend *backend, const struct LinkedList *list, unsigned int color, bool isDraft,
+                const struct BoundingBox *visibleBox, struct RenderStats *stats) {
+    assert(backend != NULL && list != NULL);
+    int drawnNum = 0, culledNum = 0;
+
+    // Stream over the flat store when one is attached, a broken one may miss shapes
+    struct ListIndex *storeIndex = findListIndex(list, LIST_INDEX_SHAPESTORE);
+    const struct ShapeStore *store = storeIndex != NULL ? (const struct ShapeStore *)storeIndex -> impl : NULL;
+    if (store != NULL && !store -> isBroken) {
+        for (int i = store -> orderBegin; i < store -> orderEnd; i++) {
+            int slot = store -> order[i];
+            if (slot == SHAPESTORE_HOLE) {
+                continue;
+            }
+            if (!isBoxVisible(&store -> box[slot], visibleBox)) {
+                culledNum++;
+                continue;
+            }
+            renderStoreShape(backend, store, slot, color, isDraft);
+            drawnNum++;
+        }
+    } else {
+        for (struct LinkedNode *cntNode = list -> head; cntNode != NULL; cntNode = cntNode -> next) {
+            if (cntNode -> data == NULL) {
+                continue;
+            }
+            if (!isBoxVisible(&cntNode -> box, visibleBox)) {
+                culledNum++;
+                continue;
+            }
+            renderNodeData(backend, cntNode -> data, color, isDraft, 0, 0);
+            drawnNum++;
+        }
+    }
+
+    if (stats != NULL) {
+        stats -> drawnNum += drawnNum;
+        stats -> culledNum += culledNum;
+    }
+}
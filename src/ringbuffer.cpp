@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <new>
+#include <atomic>
+
+#include "ringbuffer.h"
+
+// Positions only ever grow and are masked into the buffer, so that a full ring and an empty one differ.
+// Each side owns one position and publishes it with release, the other side reads it with acquire.
+struct RingBuffer {
+    int capacity;
+    unsigned char *buffer;
+    // Kept apart by a cache line, the two sides write them constantly
+    std::atomic<unsigned long long int> writePos;
+    char padding[64];
+    std::atomic<unsigned long long int> readPos;
+};
+
+struct RingBuffer * makeRingBuffer(int capacity) {
+    assert(capacity > 0 && capacity <= (1 << 30));
+    int roundedCapacity = 1;
+    while (roundedCapacity < capacity) {
+        roundedCapacity *= 2;
+    }
+
+    struct RingBuffer *ring = new (std::nothrow) RingBuffer;
+    unsigned char *buffer = (unsigned char *)malloc(roundedCapacity);
+    if (ring == NULL || buffer == NULL) {
+        fprintf(stderr, "makeRingBuffer: out of memory\n");
+        delete ring;
+        free(buffer);
+        return NULL;
+    }
+    ring -> capacity = roundedCapacity;
+    ring -> buffer = buffer;
+    ring -> writePos = 0;
+    ring -> readPos = 0;
+    return ring;
+}
+
+void destroyRingBuffer(struct RingBuffer *ring) {
+    assert(ring != NULL);
+    free(ring -> buffer);
+    delete ring;
+}
+
+int getRingBufferCapacity(const struct RingBuffer *ring) {
+    assert(ring != NULL);
+    return ring -> capacity;
+}
+
+// Complexity: O(size)
+bool writeRingBuffer(struct RingBuffer *ring, const void *data, int size) {
+    assert(ring != NULL && data != NULL && size >= 0);
+    unsigned long long int writePos = ring -> writePos.load(std::memory_order_relaxed);
+    unsigned long long int readPos = ring -> readPos.load(std::memory_order_acquire);
+    if ((unsigned long long int)size > ring -> capacity - (writePos - readPos)) {
+        return false;
+    }
+
+    // The free space may wrap around the end of the buffer
+    int begin = (int)(writePos & (ring -> capacity - 1));
+    int firstSize = min(size, ring -> capacity - begin);
+    memcpy(ring -> buffer + begin, data, firstSize);
+    memcpy(ring -> buffer, (const unsigned char *)data + firstSize, size - firstSize);
+    ring -> writePos.store(writePos + size, std::memory_order_release);
+    return true;
+}
+
+int getRingBufferReadable(const struct RingBuffer *ring) {
+    assert(ring != NULL);
+    unsigned long long int writePos = ring -> writePos.load(std::memory_order_acquire);
+    unsigned long long int readPos = ring -> readPos.load(std::memory_order_relaxed);
+    return (int)(writePos - readPos);
+}
+
+// Complexity: O(size)
+bool readRingBuffer(struct RingBuffer *ring, void *out, int size) {
+    assert(ring != NULL && out != NULL && size >= 0);
+    unsigned long long int readPos = ring -> readPos.load(std::memory_order_relaxed);
+    unsigned long long int writePos = ring -> writePos.load(std::memory_order_acquire);
+    if ((unsigned long long int)size > writePos - readPos) {
+        return false;
+    }
+
+    int begin = (int)(readPos & (ring -> capacity - 1));
+    int firstSize = min(size, ring -> capacity - begin);
+    memcpy(out, ring -> buffer + begin, firstSize);
+    memcpy((unsigned char *)out + firstSize, ring -> buffer, size - firstSize);
+    ring -> readPos.store(readPos + size, std::memory_order_release);
+    return true;
+}
@@ -0,0 +1,719 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include <errno.h>
+
+#include "rtree.h"
+
+static long long int getBoxArea(const struct BoundingBox *box) {
+    return ((long long int)box -> maxx - box -> minx) * ((long long int)box -> maxy - box -> miny);
+}
+
+static void unionBox(const struct BoundingBox *a, const struct BoundingBox *b, struct BoundingBox *res) {
+    res -> minx = min(a -> minx, b -> minx);
+    res -> miny = min(a -> miny, b -> miny);
+    res -> maxx = max(a -> maxx, b -> maxx);
+    res -> maxy = max(a -> maxy, b -> maxy);
+}
+
+static long long int getEnlargement(const struct BoundingBox *box, const struct BoundingBox *added) {
+    struct BoundingBox merged;
+    unionBox(box, added, &merged);
+    return getBoxArea(&merged) - getBoxArea(box);
+}
+
+static bool isBoxContained(const struct BoundingBox *outer, const struct BoundingBox *inner) {
+    return inner -> minx >= outer -> minx && inner -> maxx <= outer -> maxx &&
+           inner -> miny >= outer -> miny && inner -> maxy <= outer -> maxy;
+}
+
+// Same as findRule's slack: a shape can be hit FINDRULE_VARIATION away from its extent
+static bool isNearBox(const struct Vertex *pt, const struct BoundingBox *box) {
+    return pt -> x >= box -> minx - FINDRULE_VARIATION && pt -> x <= box -> maxx + FINDRULE_VARIATION &&
+           pt -> y >= box -> miny - FINDRULE_VARIATION && pt -> y <= box -> maxy + FINDRULE_VARIATION;
+}
+
+static void getNodeBox(const struct RTreeNode *node, struct BoundingBox *box) {
+    assert(node -> size > 0);
+    *box = node -> entries[0].box;
+    for (int i = 1; i < node -> size; i++) {
+        unionBox(box, &node -> entries[i].box, box);
+    }
+}
+
+static struct RTreeNode * makeRTreeNode(bool isLeaf) {
+    errno = 0;
+    struct RTreeNode *newNode = (struct RTreeNode *)malloc(sizeof(struct RTreeNode));
+    if (newNode == NULL) {
+        perror("makeRTreeNode");
+        return NULL;
+    }
+    newNode -> isLeaf = isLeaf;
+    newNode -> size = 0;
+    newNode -> parent = NULL;
+    return newNode;
+}
+
+static void addEntry(struct RTreeNode *node, const struct RTreeEntry *entry) {
+    assert(node -> size <= RTREE_MAX_ENTRIES);
+    node -> entries[node -> size] = *entry;
+    if (entry -> child != NULL) {
+        entry -> child -> parent = node;
+    }
+    node -> size++;
+}
+
+static void removeEntry(struct RTreeNode *node, int pos) {
+    node -> entries[pos] = node -> entries[--node -> size];
+}
+
+static int findChildPos(const struct RTreeNode *parent, const struct RTreeNode *child) {
+    for (int i = 0; i < parent -> size; i++) {
+        if (parent -> entries[i].child == child) {
+            return i;
+        }
+    }
+    assert(false);
+    return -1;
+}
+
+static void destroySubtree(struct RTreeNode *node) {
+    if (node == NULL) {
+        return;
+    }
+    if (!node -> isLeaf) {
+        for (int i = 0; i < node -> size; i++) {
+            destroySubtree(node -> entries[i].child);
+        }
+    }
+    free(node);
+}
+
+// Guttman's quadratic split, moving about half of the entries of node into a new sibling
+// Returns the sibling
+static struct RTreeNode * splitNode(struct RTreeNode *node) {
+    struct RTreeNode *sibling = makeRTreeNode(node -> isLeaf);
+    if (sibling == NULL) {
+        return NULL;
+    }
+
+    struct RTreeEntry pending[RTREE_MAX_ENTRIES + 1];
+    int pendingNum = node -> size;
+    memcpy(pending, node -> entries, sizeof(struct RTreeEntry) * pendingNum);
+    node -> size = 0;
+
+    // Pick the two entries wasting the most area when put together
+    int seedA = 0, seedB = 1;
+    long long int maxWaste = -1;
+    for (int i = 0; i < pendingNum; i++) {
+        for (int j = i + 1; j < pendingNum; j++) {
+            struct BoundingBox merged;
+            unionBox(&pending[i].box, &pending[j].box, &merged);
+            long long int waste = getBoxArea(&merged) - getBoxArea(&pending[i].box) - getBoxArea(&pending[j].box);
+            if (waste > maxWaste) {
+                maxWaste = waste;
+                seedA = i;
+                seedB = j;
+            }
+        }
+    }
+
+    struct BoundingBox boxA = pending[seedA].box, boxB = pending[seedB].box;
+    addEntry(node, &pending[seedA]);
+    addEntry(sibling, &pending[seedB]);
+    pending[seedB] = pending[--pendingNum];
+    pending[seedA] = pending[--pendingNum];
+
+    while (pendingNum > 0) {
+        // Give everything left to a group which would stay underfull otherwise
+        if (node -> size + pendingNum <= RTREE_MIN_ENTRIES || sibling -> size + pendingNum <= RTREE_MIN_ENTRIES) {
+            struct RTreeNode *target = node -> size + pendingNum <= RTREE_MIN_ENTRIES ? node : sibling;
+            for (int i = 0; i < pendingNum; i++) {
+                addEntry(target, &pending[i]);
+            }
+            break;
+        }
+
+        // Assign the entry with the strongest preference first
+        int next = 0;
+        long long int maxDiff = -1, growA = 0, growB = 0;
+        for (int i = 0; i < pendingNum; i++) {
+            long long int cntGrowA = getEnlargement(&boxA, &pending[i].box);
+            long long int cntGrowB = getEnlargement(&boxB, &pending[i].box);
+            long long int diff = cntGrowA > cntGrowB ? cntGrowA - cntGrowB : cntGrowB - cntGrowA;
+            if (diff > maxDiff) {
+                maxDiff = diff;
+                next = i;
+                growA = cntGrowA;
+                growB = cntGrowB;
+            }
+        }
+
+        bool toA;
+        if (growA != growB) {
+            toA = growA < growB;
+        } else if (getBoxArea(&boxA) != getBoxArea(&boxB)) {
+            toA = getBoxArea(&boxA) < getBoxArea(&boxB);
+        } else {
+            toA = node -> size <= sibling -> size;
+        }
+
+        if (toA) {
+            unionBox(&boxA, &pending[next].box, &boxA);
+            addEntry(node, &pending[next]);
+        } else {
+            unionBox(&boxB, &pending[next].box, &boxB);
+            addEntry(sibling, &pending[next]);
+        }
+        pending[next] = pending[--pendingNum];
+    }
+
+    return sibling;
+}
+
+// A shape missing from the tree could never be picked again, findNode() walks the list instead
+static void breakRTree(struct RTree *tree) {
+    tree -> isBroken = true;
+    tree -> index.checkFunc = NULL;
+}
+
+static void mendRTree(struct RTree *tree) {
+    tree -> isBroken = false;
+    tree -> index.checkFunc = findRule;
+}
+
+// Refresh boxes from node up to the root, splitting overflowing nodes on the way
+// Returns nothing
+static void adjustTree(struct RTree *tree, struct RTreeNode *node) {
+    while (node != NULL) {
+        struct RTreeNode *sibling = NULL;
+        if (node -> size > RTREE_MAX_ENTRIES) {
+            sibling = splitNode(node);
+            if (sibling == NULL) {
+                // The node stays overfull, nothing may be added to the tree anymore
+                breakRTree(tree);
+                return;
+            }
+        }
+
+        struct RTreeNode *parent = node -> parent;
+        if (parent == NULL) {
+            if (sibling != NULL) {
+                struct RTreeNode *newRoot = makeRTreeNode(false);
+                if (newRoot == NULL) {
+                    destroySubtree(sibling);
+                    breakRTree(tree);
+                    return;
+                }
+                struct RTreeEntry entry;
+                entry.node = NULL;
+                entry.child = node;
+                getNodeBox(node, &entry.box);
+                addEntry(newRoot, &entry);
+                entry.child = sibling;
+                getNodeBox(sibling, &entry.box);
+                addEntry(newRoot, &entry);
+                tree -> root = newRoot;
+            }
+            return;
+        }
+
+        getNodeBox(node, &parent -> entries[findChildPos(parent, node)].box);
+        if (sibling != NULL) {
+            struct RTreeEntry entry;
+            entry.node = NULL;
+            entry.child = sibling;
+            getNodeBox(sibling, &entry.box);
+            addEntry(parent, &entry);
+        }
+        node = parent;
+    }
+}
+
+static void insertEntry(struct RTree *tree, const struct RTreeEntry *entry) {
+    if (tree -> isBroken) {
+        return;
+    }
+
+    // Descend into the child needing least enlargement, then the smallest one
+    struct RTreeNode *cntNode = tree -> root;
+    while (!cntNode -> isLeaf) {
+        int best = 0;
+        long long int bestGrow = -1, bestArea = -1;
+        for (int i = 0; i < cntNode -> size; i++) {
+            long long int grow = getEnlargement(&cntNode -> entries[i].box, &entry -> box);
+            long long int area = getBoxArea(&cntNode -> entries[i].box);
+            if (bestGrow < 0 || grow < bestGrow || (grow == bestGrow && area < bestArea)) {
+                best = i;
+                bestGrow = grow;
+                bestArea = area;
+            }
+        }
+        cntNode = cntNode -> entries[best].child;
+    }
+
+    addEntry(cntNode, entry);
+    adjustTree(tree, cntNode);
+}
+
+// Find the leaf entry holding node, whose extent is box
+// Returns the leaf, *pos is set to the entry position
+static struct RTreeNode * findLeaf(struct RTreeNode *cntNode, const struct BoundingBox *box,
+                                   const struct LinkedNode *node, int *pos) {
+    for (int i = 0; i < cntNode -> size; i++) {
+        if (cntNode -> isLeaf) {
+            if (cntNode -> entries[i].node == node) {
+                *pos = i;
+                return cntNode;
+            }
+        } else if (isBoxContained(&cntNode -> entries[i].box, box)) {
+            struct RTreeNode *res = findLeaf(cntNode -> entries[i].child, box, node, pos);
+            if (res != NULL) {
+                return res;
+            }
+        }
+    }
+    return NULL;
+}
+
+// Move the shapes of a subtree into entries, freeing its nodes
+// Returns false if out of memory, shapes of the leaves that did not fit are lost
+static bool collectEntries(struct RTreeNode *node, struct RTreeEntry **entries, int *size, int *capacity) {
+    if (!node -> isLeaf) {
+        bool isCollected = true;
+        for (int i = 0; i < node -> size; i++) {
+            isCollected = collectEntries(node -> entries[i].child, entries, size, capacity) && isCollected;
+        }
+        free(node);
+        return isCollected;
+    }
+
+    if (*size + node -> size > *capacity) {
+        int newCapacity = max(*capacity * 2, *size + node -> size);
+        errno = 0;
+        struct RTreeEntry *newEntries = (struct RTreeEntry *)realloc(*entries, sizeof(struct RTreeEntry) * newCapacity);
+        if (newEntries == NULL) {
+            perror("collectEntries");
+            free(node);
+            return false;
+        }
+        *entries = newEntries;
+        *capacity = newCapacity;
+    }
+    memcpy(*entries + *size, node -> entries, sizeof(struct RTreeEntry) * node -> size);
+    *size += node -> size;
+    free(node);
+    return true;
+}
+
+// Dissolve underfull nodes from leaf up to the root and reinsert their shapes
+// Returns nothing
+static void condenseTree(struct RTree *tree, struct RTreeNode *leaf) {
+    struct RTreeEntry *orphans = NULL;
+    int orphanNum = 0, orphanCapacity = 0;
+
+    struct RTreeNode *cntNode = leaf;
+    while (cntNode -> parent != NULL) {
+        struct RTreeNode *parent = cntNode -> parent;
+        int pos = findChildPos(parent, cntNode);
+        if (cntNode -> size < RTREE_MIN_ENTRIES) {
+            removeEntry(parent, pos);
+            if (!collectEntries(cntNode, &orphans, &orphanNum, &orphanCapacity)) {
+                breakRTree(tree);
+            }
+        } else {
+            getNodeBox(cntNode, &parent -> entries[pos].box);
+        }
+        cntNode = parent;
+    }
+
+    // Shorten the tree while the root has a single child
+    while (!tree -> root -> isLeaf && tree -> root -> size <= 1) {
+        struct RTreeNode *oldRoot = tree -> root;
+        if (oldRoot -> size == 0) {
+            oldRoot -> isLeaf = true;
+            break;
+        }
+        tree -> root = oldRoot -> entries[0].child;
+        tree -> root -> parent = NULL;
+        free(oldRoot);
+    }
+
+    for (int i = 0; i < orphanNum && !tree -> isBroken; i++) {
+        insertEntry(tree, &orphans[i]);
+    }
+    free(orphans);
+}
+
+static void insertHook(void *impl, struct LinkedNode *node) {
+    insertRTree((struct RTree *)impl, node, node -> data);
+}
+
+static void removeHook(void *impl, struct LinkedNode *node) {
+    removeRTree((struct RTree *)impl, node, node -> data);
+}
+
+static void editHook(void *impl, struct LinkedNode *node, struct NodeData *oldData) {
+    updateRTree((struct RTree *)impl, node, oldData);
+}
+
+static void clearHook(void *impl) {
+    clearRTree((struct RTree *)impl);
+}
+
+// Packing the whole list beats inserting its shapes one by one
+static void buildHook(void *impl, struct LinkedList *list) {
+    buildRTree((struct RTree *)impl, list);
+}
+
+static struct LinkedNode * findHook(void *impl, const void *findData,
+                                    bool (*checkFunc)(const void *, const struct LinkedNode *)) {
+    return findRTree((struct RTree *)impl, (const struct Vertex *)findData, checkFunc);
+}
+
+struct RTree * makeRTree() {
+    errno = 0;
+    struct RTree *tree = (struct RTree *)malloc(sizeof(struct RTree));
+    if (tree == NULL) {
+        perror("makeRTree");
+        return NULL;
+    }
+    tree -> itemNum = 0;
+    tree -> isBroken = false;
+    tree -> root = makeRTreeNode(true);
+    if (tree -> root == NULL) {
+        free(tree);
+        return NULL;
+    }
+
+    // Z-order lives in LinkedNode rank, so moving nodes needs no reorder hook
+    memset(&tree -> index, 0, sizeof(tree -> index));
+    tree -> index.kind = LIST_INDEX_RTREE;
+    tree -> index.impl = tree;
+    tree -> index.checkFunc = findRule;
+    tree -> index.findFunc = findHook;
+    tree -> index.insertFunc = insertHook;
+    tree -> index.removeFunc = removeHook;
+    tree -> index.editFunc = editHook;
+    tree -> index.clearFunc = clearHook;
+    tree -> index.buildFunc = buildHook;
+    return tree;
+}
+
+void destroyRTree(struct RTree *tree) {
+    assert(tree != NULL);
+    destroySubtree(tree -> root);
+    tree -> root = NULL;
+    free(tree);
+    tree = NULL;
+}
+
+void clearRTree(struct RTree *tree) {
+    assert(tree != NULL);
+    destroySubtree(tree -> root);
+    tree -> root = makeRTreeNode(true);
+    tree -> itemNum = 0;
+    if (tree -> root == NULL) {
+        breakRTree(tree);
+    } else {
+        mendRTree(tree);
+    }
+}
+
+static int compareCenterX(const void *a, const void *b) {
+    const struct BoundingBox *boxA = &((const struct RTreeEntry *)a) -> box;
+    const struct BoundingBox *boxB = &((const struct RTreeEntry *)b) -> box;
+    long long int centerA = (long long int)boxA -> minx + boxA -> maxx;
+    long long int centerB = (long long int)boxB -> minx + boxB -> maxx;
+    return (centerA > centerB) - (centerA < centerB);
+}
+
+static int compareCenterY(const void *a, const void *b) {
+    const struct BoundingBox *boxA = &((const struct RTreeEntry *)a) -> box;
+    const struct BoundingBox *boxB = &((const struct RTreeEntry *)b) -> box;
+    long long int centerA = (long long int)boxA -> miny + boxA -> maxy;
+    long long int centerB = (long long int)boxB -> miny + boxB -> maxy;
+    return (centerA > centerB) - (centerA < centerB);
+}
+
+// Pack entries into nodes of one tree level with Sort-Tile-Recursive
+// Returns the entries of the level above, *resNum is set to their number,
+// or NULL if out of memory, entries then still own their children
+static struct RTreeEntry * packLevel(struct RTreeEntry *entries, int entryNum, bool isLeaf, int *resNum) {
+    int nodeNum = (entryNum + RTREE_MAX_ENTRIES - 1) / RTREE_MAX_ENTRIES;
+    int sliceNum = (int)ceil(sqrt((double)nodeNum));
+    int sliceSize = sliceNum * RTREE_MAX_ENTRIES;
+
+    errno = 0;
+    struct RTreeEntry *res = (struct RTreeEntry *)malloc(sizeof(struct RTreeEntry) * nodeNum);
+    if (res == NULL) {
+        perror("packLevel");
+        return NULL;
+    }
+
+    // Vertical slices of sliceNum nodes, each sorted bottom to top
+    qsort(entries, entryNum, sizeof(struct RTreeEntry), compareCenterX);
+    *resNum = 0;
+    for (int sliceStart = 0; sliceStart < entryNum; sliceStart += sliceSize) {
+        int sliceLen = min(sliceSize, entryNum - sliceStart);
+        qsort(entries + sliceStart, sliceLen, sizeof(struct RTreeEntry), compareCenterY);
+
+        for (int nodeStart = 0; nodeStart < sliceLen; nodeStart += RTREE_MAX_ENTRIES) {
+            struct RTreeNode *newNode = makeRTreeNode(isLeaf);
+            if (newNode == NULL) {
+                for (int i = 0; i < *resNum; i++) {
+                    free(res[i].child);
+                }
+                free(res);
+                return NULL;
+            }
+            int nodeLen = min(RTREE_MAX_ENTRIES, sliceLen - nodeStart);
+            for (int i = 0; i < nodeLen; i++) {
+                addEntry(newNode, &entries[sliceStart + nodeStart + i]);
+            }
+
+            res[*resNum].node = NULL;
+            res[*resNum].child = newNode;
+            getNodeBox(newNode, &res[*resNum].box);
+            (*resNum)++;
+        }
+    }
+    return res;
+}
+
+// Complexity: O(n log n)
+void buildRTree(struct RTree *tree, struct LinkedList *list) {
+    assert(tree != NULL && list != NULL);
+    clearRTree(tree);
+    if (list -> listSize == 0 || tree -> isBroken) {
+        return;
+    }
+
+    errno = 0;
+    struct RTreeEntry *entries = (struct RTreeEntry *)malloc(sizeof(struct RTreeEntry) * list -> listSize);
+    if (entries == NULL) {
+        perror("buildRTree");
+        breakRTree(tree);
+        return;
+    }
+    int entryNum = 0;
+    for (struct LinkedNode *cntNode = list -> head; cntNode != NULL; cntNode = cntNode -> next) {
+        if (cntNode -> data == NULL) {
+            continue;
+        }
+        entries[entryNum].child = NULL;
+        entries[entryNum].node = cntNode;
+        entries[entryNum].box = cntNode -> box;
+        entryNum++;
+    }
+    tree -> itemNum = entryNum;
+
+    bool isLeaf = true;
+    while (entryNum > RTREE_MAX_ENTRIES) {
+        int upperNum = 0;
+        struct RTreeEntry *upper = packLevel(entries, entryNum, isLeaf, &upperNum);
+        if (upper == NULL) {
+            for (int i = 0; i < entryNum; i++) {
+                destroySubtree(entries[i].child);
+            }
+            free(entries);
+            tree -> itemNum = 0;
+            breakRTree(tree);
+            return;
+        }
+        free(entries);
+        entries = upper;
+        entryNum = upperNum;
+        isLeaf = false;
+    }
+
+    tree -> root -> isLeaf = isLeaf;
+    for (int i = 0; i < entryNum; i++) {
+        addEntry(tree -> root, &entries[i]);
+    }
+    free(entries);
+}
+
+// Complexity: O(log n)
+void insertRTree(struct RTree *tree, struct LinkedNode *node, const struct NodeData *data) {
+    assert(tree != NULL && node != NULL && data != NULL);
+    if (tree -> isBroken) {
+        return;
+    }
+    struct RTreeEntry entry;
+    entry.child = NULL;
+    entry.node = node;
+    getDataBoundingBox(data, &entry.box);
+    insertEntry(tree, &entry);
+    tree -> itemNum++;
+}
+
+// Complexity: O(log n) for well separated shapes
+void removeRTree(struct RTree *tree, struct LinkedNode *node, const struct NodeData *data) {
+    assert(tree != NULL && node != NULL && data != NULL);
+    if (tree -> isBroken) {
+        return;
+    }
+    struct BoundingBox box;
+    getDataBoundingBox(data, &box);
+
+    int pos = -1;
+    struct RTreeNode *leaf = findLeaf(tree -> root, &box, node, &pos);
+    if (leaf == NULL) {
+        return;
+    }
+    removeEntry(leaf, pos);
+    tree -> itemNum--;
+    condenseTree(tree, leaf);
+}
+
+void updateRTree(struct RTree *tree, struct LinkedNode *node, const struct NodeData *oldData) {
+    assert(tree != NULL && node != NULL && node -> data != NULL && oldData != NULL);
+    if (tree -> isBroken) {
+        return;
+    }
+    struct BoundingBox oldBox, newBox = node -> box;
+    getDataBoundingBox(oldData, &oldBox);
+
+    int pos = -1;
+    struct RTreeNode *leaf = findLeaf(tree -> root, &oldBox, node, &pos);
+    if (leaf == NULL) {
+        insertRTree(tree, node, node -> data);
+        return;
+    }
+
+    // Small edits stay inside their leaf and only tighten the boxes above
+    struct RTreeNode *parent = leaf -> parent;
+    if (parent == NULL || isBoxContained(&parent -> entries[findChildPos(parent, leaf)].box, &newBox)) {
+        leaf -> entries[pos].box = newBox;
+        adjustTree(tree, leaf);
+        return;
+    }
+
+    removeEntry(leaf, pos);
+    condenseTree(tree, leaf);
+    struct RTreeEntry entry;
+    entry.child = NULL;
+    entry.node = node;
+    entry.box = newBox;
+    insertEntry(tree, &entry);
+}
+
+static void findInNode(const struct RTreeNode *cntNode, const struct Vertex *cursorPt,
+                       bool (*checkFunc)(const void *, const struct LinkedNode *), struct LinkedNode **res) {
+    for (int i = 0; i < cntNode -> size; i++) {
+        const struct RTreeEntry *entry = &cntNode -> entries[i];
+        if (!isNearBox(cursorPt, &entry -> box)) {
+            continue;
+        }
+        if (!cntNode -> isLeaf) {
+            findInNode(entry -> child, cursorPt, checkFunc, res);
+        } else if ((*res == NULL || entry -> node -> rank > (*res) -> rank) && checkFunc(cursorPt, entry -> node)) {
+            *res = entry -> node;
+        }
+    }
+}
+
+// Complexity: O(log n + shapes around cursorPt)
+struct LinkedNode * findRTree(struct RTree *tree, const struct Vertex *cursorPt,
+                              bool (*checkFunc)(const void *, const struct LinkedNode *)) {
+    assert(tree != NULL && cursorPt != NULL && checkFunc != NULL);
+    struct LinkedNode *res = NULL;
+    if (tree -> root != NULL) {
+        findInNode(tree -> root, cursorPt, checkFunc, &res);
+    }
+    return res;
+}
+
+struct FoundNodes {
+    int size, capacity;
+    struct LinkedNode **nodes;
+};
+
+// Returns false if out of memory, found then misses nodes
+static bool findAllInNode(const struct RTreeNode *cntNode, const struct Vertex *cursorPt,
+                          bool (*checkFunc)(const void *, const struct LinkedNode *), struct FoundNodes *found) {
+    for (int i = 0; i < cntNode -> size; i++) {
+        const struct RTreeEntry *entry = &cntNode -> entries[i];
+        if (!isNearBox(cursorPt, &entry -> box)) {
+            continue;
+        }
+        if (!cntNode -> isLeaf) {
+            if (!findAllInNode(entry -> child, cursorPt, checkFunc, found)) {
+                return false;
+            }
+            continue;
+        }
+        if (!checkFunc(cursorPt, entry -> node)) {
+            continue;
+        }
+        if (found -> size == found -> capacity) {
+            int newCapacity = found -> capacity == 0 ? 16 : found -> capacity * 2;
+            errno = 0;
+            struct LinkedNode **newNodes = (struct LinkedNode **)realloc(found -> nodes, sizeof(struct LinkedNode *) * newCapacity);
+            if (newNodes == NULL) {
+                perror("findAllRTree");
+                return false;
+            }
+            found -> nodes = newNodes;
+            found -> capacity = newCapacity;
+        }
+        found -> nodes[found -> size++] = entry -> node;
+    }
+    return true;
+}
+
+static int compareRankDesc(const void *a, const void *b) {
+    long long int rankA = (*(struct LinkedNode * const *)a) -> rank;
+    long long int rankB = (*(struct LinkedNode * const *)b) -> rank;
+    return (rankA < rankB) - (rankA > rankB);
+}
+
+int findAllRTree(struct RTree *tree, const struct Vertex *cursorPt,
+                 bool (*checkFunc)(const void *, const struct LinkedNode *),
+                 struct LinkedNode **res, int maxResNum) {
+    assert(tree != NULL && cursorPt != NULL && checkFunc != NULL && (res != NULL || maxResNum == 0));
+    struct FoundNodes found = {0, 0, NULL};
+    if (tree -> root != NULL && !findAllInNode(tree -> root, cursorPt, checkFunc, &found)) {
+        free(found.nodes);
+        return -1;
+    }
+
+    if (found.size > 1) {
+        qsort(found.nodes, found.size, sizeof(struct LinkedNode *), compareRankDesc);
+    }
+    for (int i = 0; i < found.size && i < maxResNum; i++) {
+        res[i] = found.nodes[i];
+    }
+    free(found.nodes);
+    return found.size;
+}
+
+static int searchNode(const struct RTreeNode *cntNode, const struct BoundingBox *box,
+                      void (*visitFunc)(struct LinkedNode *, void *), void *arg) {
+    int visitNum = 0;
+    for (int i = 0; i < cntNode -> size; i++) {
+        const struct RTreeEntry *entry = &cntNode -> entries[i];
+        if (!isBoxIntersected(&entry -> box, box)) {
+            continue;
+        }
+        if (cntNode -> isLeaf) {
+            if (visitFunc != NULL) {
+                visitFunc(entry -> node, arg);
+            }
+            visitNum++;
+        } else {
+            visitNum += searchNode(entry -> child, box, visitFunc, arg);
+        }
+    }
+    return visitNum;
+}
+
+// Complexity: O(log n + shapes found)
+int searchRTree(struct RTree *tree, const struct BoundingBox *box,
+                void (*visitFunc)(struct LinkedNode *, void *), void *arg) {
+    assert(tree != NULL && box != NULL);
+    return tree -> root == NULL ? 0 : searchNode(tree -> root, box, visitFunc, arg);
+}
@@ -0,0 +1,730 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#include "shapestore.h"
+
+// Grow the column at columnPtr (a pointer to the column pointer) to newCapacity elements
+static bool growColumn(void *columnPtr, size_t elemSize, int newCapacity) {
+    void *column = NULL;
+    memcpy(&column, columnPtr, sizeof(column));
+    errno = 0;
+    void *res = realloc(column, elemSize * newCapacity);
+    if (res == NULL) {
+        perror("growColumn");
+        return false;
+    }
+    memcpy(columnPtr, &res, sizeof(res));
+    return true;
+}
+
+// Columns from type to r1, in the order of the DrawFile sections
+static void getFileColumns(struct ShapeStore *store, int **columns[SHAPESTORE_FILE_COLUMNS]) {
+    columns[0] = &store -> type;
+    columns[1] = &store -> x0;
+    columns[2] = &store -> y0;
+    columns[3] = &store -> x1;
+    columns[4] = &store -> y1;
+    columns[5] = &store -> r0;
+    columns[6] = &store -> r1;
+}
+
+// Copy the columns pointing into a mapped file to the heap, with room for newCapacity slots
+// Complexity: O(n)
+static bool unmapColumns(struct ShapeStore *store, int newCapacity) {
+    int **columns[SHAPESTORE_FILE_COLUMNS];
+    getFileColumns(store, columns);
+    int *copies[SHAPESTORE_FILE_COLUMNS];
+    for (int i = 0; i < SHAPESTORE_FILE_COLUMNS; i++) {
+        errno = 0;
+        copies[i] = (int *)malloc(sizeof(int) * newCapacity);
+        if (copies[i] == NULL) {
+            perror("unmapColumns");
+            while (i > 0) {
+                free(copies[--i]);
+            }
+            return false;
+        }
+        memcpy(copies[i], *columns[i], sizeof(int) * store -> slotNum);
+    }
+    for (int i = 0; i < SHAPESTORE_FILE_COLUMNS; i++) {
+        *columns[i] = copies[i];
+    }
+    store -> mappedFile = NULL;
+    return true;
+}
+
+static bool growColumns(struct ShapeStore *store) {
+    int newCapacity = store -> capacity == 0 ? SHAPESTORE_INIT_CAPACITY : store -> capacity * 2;
+    if (store -> mappedFile != NULL && !unmapColumns(store, newCapacity)) {
+        return false;
+    }
+    // Columns already grown just stay larger when a later one fails
+    if (!growColumn(&store -> type, sizeof(int), newCapacity) ||
+        !growColumn(&store -> x0, sizeof(int), newCapacity) ||
+        !growColumn(&store -> y0, sizeof(int), newCapacity) ||
+        !growColumn(&store -> x1, sizeof(int), newCapacity) ||
+        !growColumn(&store -> y1, sizeof(int), newCapacity) ||
+        !growColumn(&store -> r0, sizeof(int), newCapacity) ||
+        !growColumn(&store -> r1, sizeof(int), newCapacity) ||
+        !growColumn(&store -> text, sizeof(const char *), newCapacity) ||
+        !growColumn(&store -> box, sizeof(struct BoundingBox), newCapacity) ||
+        !growColumn(&store -> node, sizeof(struct LinkedNode *), newCapacity) ||
+        !growColumn(&store -> generation, sizeof(unsigned int), newCapacity) ||
+        !growColumn(&store -> orderPos, sizeof(int), newCapacity)) {
+            return false;
+    }
+    memset(store -> generation + store -> capacity, 0, sizeof(unsigned int) * (newCapacity - store -> capacity));
+    store -> capacity = newCapacity;
+    return true;
+}
+
+// Complexity: O(1) amortized
+static int allocSlot(struct ShapeStore *store) {
+    if (store -> freeSlot != -1) {
+        int slot = store -> freeSlot;
+        store -> freeSlot = store -> orderPos[slot];
+        return slot;
+    }
+    if (store -> slotNum == store -> capacity && !growColumns(store)) {
+        return -1;
+    }
+    return store -> slotNum++;
+}
+
+static void computeSlotBox(const struct ShapeStore *store, int slot, struct BoundingBox *box) {
+    switch (store -> type[slot]) {
+        case DATATYPE_CIRCLE: {
+            box -> minx = store -> x0[slot] - store -> r0[slot];
+            box -> miny = store -> y0[slot] - store -> r0[slot];
+            box -> maxx = store -> x0[slot] + store -> r0[slot];
+            box -> maxy = store -> y0[slot] + store -> r0[slot];
+            break;
+        }
+        case DATATYPE_ELLIPSE: {
+            box -> minx = store -> x0[slot] - store -> r0[slot];
+            box -> miny = store -> y0[slot] - store -> r1[slot];
+            box -> maxx = store -> x0[slot] + store -> r0[slot];
+            box -> maxy = store -> y0[slot] + store -> r1[slot];
+            break;
+        }
+        default: {
+            box -> minx = min(store -> x0[slot], store -> x1[slot]);
+            box -> miny = min(store -> y0[slot], store -> y1[slot]);
+            box -> maxx = max(store -> x0[slot], store -> x1[slot]);
+            box -> maxy = max(store -> y0[slot], store -> y1[slot]);
+            break;
+        }
+    }
+}
+
+static void setSlotData(struct ShapeStore *store, int slot, const struct NodeData *data) {
+    store -> type[slot] = data == NULL ? DATATYPE_UNDEFINED : data -> type;
+    store -> x0[slot] = store -> y0[slot] = store -> x1[slot] = store -> y1[slot] = 0;
+    store -> r0[slot] = store -> r1[slot] = 0;
+    store -> text[slot] = NULL;
+
+    switch (store -> type[slot]) {
+        case DATATYPE_SEGMENT: {
+            struct Segment *seg = (struct Segment *)data -> content;
+            store -> x0[slot] = seg -> leftPt -> x;
+            store -> y0[slot] = seg -> leftPt -> y;
+            store -> x1[slot] = seg -> rightPt -> x;
+            store -> y1[slot] = seg -> rightPt -> y;
+            break;
+        }
+        case DATATYPE_RECTANGLE: {
+            struct Rectangle *rec = (struct Rectangle *)data -> content;
+            store -> x0[slot] = rec -> lowerLeftPt -> x;
+            store -> y0[slot] = rec -> lowerLeftPt -> y;
+            store -> x1[slot] = rec -> upperRightPt -> x;
+            store -> y1[slot] = rec -> upperRightPt -> y;
+            break;
+        }
+        case DATATYPE_CIRCLE: {
+            struct Circle *cir = (struct Circle *)data -> content;
+            store -> x0[slot] = cir -> centerPt -> x;
+            store -> y0[slot] = cir -> centerPt -> y;
+            store -> r0[slot] = cir -> radius;
+            break;
+        }
+        case DATATYPE_ELLIPSE: {
+            struct Ellipse *elp = (struct Ellipse *)data -> content;
+            store -> x0[slot] = elp -> centerPt -> x;
+            store -> y0[slot] = elp -> centerPt -> y;
+            store -> r0[slot] = elp -> majorSemiAxis;
+            store -> r1[slot] = elp -> minorSemiAxis;
+            break;
+        }
+        case DATATYPE_TEXT: {
+            struct Text *txt = (struct Text *)data -> content;
+            store -> x0[slot] = txt -> position -> lowerLeftPt -> x;
+            store -> y0[slot] = txt -> position -> lowerLeftPt -> y;
+            store -> x1[slot] = txt -> position -> upperRightPt -> x;
+            store -> y1[slot] = txt -> position -> upperRightPt -> y;
+            store -> text[slot] = txt -> content;
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+    computeSlotBox(store, slot, &store -> box[slot]);
+}
+
+// Squeeze holes out of the z-order array and leave free room at both ends
+// Complexity: O(n)
+static bool rebuildOrder(struct ShapeStore *store) {
+    int cntNum = store -> orderEnd - store -> orderBegin - store -> holeNum;
+    int newCapacity = max(SHAPESTORE_INIT_CAPACITY, (cntNum + 1) * 2);
+
+    errno = 0;
+    int *newOrder = (int *)malloc(sizeof(int) * newCapacity);
+    if (newOrder == NULL) {
+        perror("rebuildOrder");
+        return false;
+    }
+
+    int newBegin = (newCapacity - cntNum) / 2, newEnd = newBegin;
+    for (int i = store -> orderBegin; i < store -> orderEnd; i++) {
+        int slot = store -> order[i];
+        if (slot != SHAPESTORE_HOLE) {
+            newOrder[newEnd] = slot;
+            store -> orderPos[slot] = newEnd;
+            newEnd++;
+        }
+    }
+    assert(newEnd - newBegin == cntNum);
+
+    free(store -> order);
+    store -> order = newOrder;
+    store -> orderCapacity = newCapacity;
+    store -> orderBegin = newBegin;
+    store -> orderEnd = newEnd;
+    store -> holeNum = 0;
+    return true;
+}
+
+static bool reserveOrder(struct ShapeStore *store, bool isTop) {
+    if (isTop ? store -> orderEnd == store -> orderCapacity : store -> orderBegin == 0) {
+        return rebuildOrder(store);
+    }
+    return true;
+}
+
+// Room must have been reserved
+static void pushOrder(struct ShapeStore *store, int slot, bool isTop) {
+    if (isTop) {
+        assert(store -> orderEnd < store -> orderCapacity);
+        store -> orderPos[slot] = store -> orderEnd;
+        store -> order[store -> orderEnd++] = slot;
+    } else {
+        assert(store -> orderBegin > 0);
+        store -> orderPos[slot] = --store -> orderBegin;
+        store -> order[store -> orderBegin] = slot;
+    }
+}
+
+// Put slot right above prevSlot, into the hole there if any, or else shifting up the slots up to the next hole
+// Complexity: O(1) when the position is a hole, O(n) at worst
+static bool placeOrder(struct ShapeStore *store, int slot, int prevSlot) {
+    int pos = store -> orderPos[prevSlot] + 1;
+    if (pos == store -> orderEnd) {
+        if (!reserveOrder(store, true)) {
+            return false;
+        }
+        pushOrder(store, slot, true);
+        return true;
+    }
+    if (store -> order[pos] == SHAPESTORE_HOLE) {
+        store -> order[pos] = slot;
+        store -> orderPos[slot] = pos;
+        store -> holeNum--;
+        return true;
+    }
+
+    int holePos = pos + 1;
+    while (holePos < store -> orderEnd && store -> order[holePos] != SHAPESTORE_HOLE) {
+        holePos++;
+    }
+    if (holePos == store -> orderEnd) {
+        if (!reserveOrder(store, true)) {
+            return false;
+        }
+        // Rebuilding moves everything
+        pos = store -> orderPos[prevSlot] + 1;
+        holePos = store -> orderEnd++;
+    } else {
+        store -> holeNum--;
+    }
+    for (int i = holePos; i > pos; i--) {
+        store -> order[i] = store -> order[i - 1];
+        store -> orderPos[store -> order[i]] = i;
+    }
+    store -> order[pos] = slot;
+    store -> orderPos[slot] = pos;
+    return true;
+}
+
+static void popOrder(struct ShapeStore *store, int slot) {
+    int pos = store -> orderPos[slot];
+    assert(pos >= store -> orderBegin && pos < store -> orderEnd && store -> order[pos] == slot);
+
+    if (pos == store -> orderEnd - 1) {
+        store -> orderEnd--;
+    } else if (pos == store -> orderBegin) {
+        store -> orderBegin++;
+    } else {
+        store -> order[pos] = SHAPESTORE_HOLE;
+        store -> holeNum++;
+    }
+}
+
+// A shape missing from the store or out of place would be drawn or picked wrong,
+// renderList() and findNode() follow the list instead
+static void breakShapeStore(struct ShapeStore *store) {
+    store -> isBroken = true;
+    store -> index.checkFunc = NULL;
+}
+
+static void mendShapeStore(struct ShapeStore *store) {
+    store -> isBroken = false;
+    store -> index.checkFunc = findRule;
+}
+
+// Nothing is kept up to date once broken, building or clearing the store starts over
+static void insertHook(void *impl, struct LinkedNode *node) {
+    struct ShapeStore *store = (struct ShapeStore *)impl;
+    if (store -> isBroken) {
+        return;
+    }
+    bool isInserted = node -> prev != NULL && node -> next != NULL ? insertShapeStoreAfter(store, node, node -> prev)
+                                                                   : insertShapeStore(store, node, node -> next == NULL);
+    if (!isInserted) {
+        breakShapeStore(store);
+    }
+}
+
+static void removeHook(void *impl, struct LinkedNode *node) {
+    struct ShapeStore *store = (struct ShapeStore *)impl;
+    if (!store -> isBroken) {
+        removeShapeStore(store, node);
+    }
+}
+
+static void editHook(void *impl, struct LinkedNode *node, struct NodeData *oldData) {
+    (void)oldData;
+    struct ShapeStore *store = (struct ShapeStore *)impl;
+    if (!store -> isBroken) {
+        updateShapeStore(store, node);
+    }
+}
+
+static void reorderHook(void *impl, struct LinkedNode *node) {
+    struct ShapeStore *store = (struct ShapeStore *)impl;
+    if (store -> isBroken) {
+        return;
+    }
+    bool isMoved = node -> prev != NULL && node -> next != NULL ? reorderShapeStoreAfter(store, node, node -> prev)
+                                                                : reorderShapeStore(store, node, node -> next == NULL);
+    if (!isMoved) {
+        breakShapeStore(store);
+    }
+}
+
+static void clearHook(void *impl) {
+    clearShapeStore((struct ShapeStore *)impl);
+}
+
+// Filling the list back at once mends a broken store
+static void buildHook(void *impl, struct LinkedList *list) {
+    struct ShapeStore *store = (struct ShapeStore *)impl;
+    clearShapeStore(store);
+    if (!buildShapeStore(store, list)) {
+        breakShapeStore(store);
+    }
+}
+
+// Candidates stop being gathered once out of memory, candidateNum is then -1
+static void pushCandidate(struct LinkedNode *node, void *arg) {
+    struct ShapeStore *store = (struct ShapeStore *)arg;
+    int slot = getPtrMap(&store -> slotMap, node);
+    if (store -> candidateNum == -1 || slot == -1) {
+        return;
+    }
+    if (store -> candidateNum == store -> candidateCapacity) {
+        int newCapacity = store -> candidateCapacity == 0 ? SHAPESTORE_INIT_CAPACITY : store -> candidateCapacity * 2;
+        if (!growColumn(&store -> candidates, sizeof(int), newCapacity)) {
+            store -> candidateNum = -1;
+            return;
+        }
+        store -> candidateCapacity = newCapacity;
+    }
+    store -> candidates[store -> candidateNum++] = store -> orderPos[slot];
+}
+
+static int compareInt(const void *a, const void *b) {
+    int intA = *(const int *)a, intB = *(const int *)b;
+    return (intA > intB) - (intA < intB);
+}
+
+// Find the topmost shape under the point among those the tree finds near it
+// Returns false if out of memory, slot is then left as it is
+// Complexity: O(log n + k log k), k for the shapes near the point
+static bool findNearShapes(struct ShapeStore *store, int x, int y, int *slot) {
+    struct BoundingBox box = {x - FINDRULE_VARIATION, y - FINDRULE_VARIATION, x + FINDRULE_VARIATION, y + FINDRULE_VARIATION};
+    store -> candidateNum = 0;
+    searchRTree(store -> tree, &box, pushCandidate, store);
+    if (store -> candidateNum == -1) {
+        return false;
+    }
+
+    // Kernels take slots from bottom to top
+    qsort(store -> candidates, store -> candidateNum, sizeof(int), compareInt);
+    for (int i = 0; i < store -> candidateNum; i++) {
+        store -> candidates[i] = store -> order[store -> candidates[i]];
+    }
+    struct HitColumns cols = {store -> type, store -> x0, store -> y0, store -> x1, store -> y1, store -> r0, store -> r1};
+    int pos = findTopHit(&cols, store -> candidates, 0, store -> candidateNum, x, y);
+    *slot = pos == -1 ? -1 : store -> candidates[pos];
+    return true;
+}
+
+static struct LinkedNode * findHook(void *impl, const void *findData,
+                                    bool (*checkFunc)(const void *, const struct LinkedNode *)) {
+    assert(checkFunc == findRule);
+    (void)checkFunc;
+    struct ShapeStore *store = (struct ShapeStore *)impl;
+    const struct Vertex *cursorPt = (const struct Vertex *)findData;
+    // A broken tree may miss shapes, testing them all finds every one
+    int slot = -1;
+    if (store -> tree == NULL || store -> tree -> isBroken || !findNearShapes(store, cursorPt -> x, cursorPt -> y, &slot)) {
+        slot = findShapeStore(store, cursorPt -> x, cursorPt -> y);
+    }
+    return slot == -1 ? NULL : store -> node[slot];
+}
+
+struct ShapeStore * makeShapeStore() {
+    errno = 0;
+    struct ShapeStore *store = (struct ShapeStore *)calloc(1, sizeof(struct ShapeStore));
+    if (store == NULL) {
+        perror("makeShapeStore");
+        return NULL;
+    }
+    store -> freeSlot = -1;
+    initPtrMap(&store -> slotMap);
+
+    if (!growColumns(store) || !rebuildOrder(store)) {
+        destroyShapeStore(store);
+        return NULL;
+    }
+
+    store -> index.kind = LIST_INDEX_SHAPESTORE;
+    store -> index.impl = store;
+    store -> index.checkFunc = findRule;
+    store -> index.findFunc = findHook;
+    store -> index.insertFunc = insertHook;
+    store -> index.removeFunc = removeHook;
+    store -> index.editFunc = editHook;
+    store -> index.reorderFunc = reorderHook;
+    store -> index.clearFunc = clearHook;
+    store -> index.buildFunc = buildHook;
+    return store;
+}
+
+void destroyShapeStore(struct ShapeStore *store) {
+    assert(store != NULL);
+    if (store -> mappedFile == NULL) {
+        free(store -> type);
+        free(store -> x0);
+        free(store -> y0);
+        free(store -> x1);
+        free(store -> y1);
+        free(store -> r0);
+        free(store -> r1);
+    }
+    free(store -> text);
+    free(store -> box);
+    free(store -> node);
+    free(store -> generation);
+    free(store -> orderPos);
+    free(store -> order);
+    free(store -> candidates);
+    destroyPtrMap(&store -> slotMap);
+    free(store);
+    store = NULL;
+}
+
+void clearShapeStore(struct ShapeStore *store) {
+    assert(store != NULL);
+    // Outstanding handles must not match the reused slots
+    for (int i = 0; i < store -> slotNum; i++) {
+        store -> generation[i]++;
+    }
+    store -> slotNum = 0;
+    store -> liveNum = 0;
+    store -> freeSlot = -1;
+    store -> orderBegin = store -> orderEnd = store -> orderCapacity / 2;
+    store -> holeNum = 0;
+    clearPtrMap(&store -> slotMap);
+    mendShapeStore(store);
+}
+
+// Complexity: O(n)
+bool buildShapeStore(struct ShapeStore *store, const struct LinkedList *list) {
+    assert(store != NULL && list != NULL && store -> liveNum == 0);
+    for (struct LinkedNode *cntNode = list -> head; cntNode != NULL; cntNode = cntNode -> next) {
+        if (!insertShapeStore(store, cntNode, true)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Only the columns missing from the file are filled in
+// Complexity: O(n)
+bool mapShapeStore(struct ShapeStore *store, const struct DrawFile *file, const struct LinkedList *list) {
+    assert(store != NULL && file != NULL && store -> slotNum == 0 && store -> mappedFile == NULL);
+    assert(list == NULL || list -> listSize == file -> shapeNum);
+    int slotNum = file -> shapeNum;
+    if (slotNum == 0) {
+        return true;
+    }
+
+    // The z-order is the slot order, with free room at both ends like rebuildOrder() leaves
+    int orderCapacity = max(SHAPESTORE_INIT_CAPACITY, (slotNum + 1) * 2);
+    errno = 0;
+    int *newOrder = (int *)malloc(sizeof(int) * orderCapacity);
+    if (newOrder == NULL) {
+        perror("mapShapeStore");
+        return false;
+    }
+    if (!growColumn(&store -> text, sizeof(const char *), slotNum) ||
+        !growColumn(&store -> box, sizeof(struct BoundingBox), slotNum) ||
+        !growColumn(&store -> node, sizeof(struct LinkedNode *), slotNum) ||
+        !growColumn(&store -> generation, sizeof(unsigned int), slotNum) ||
+        !growColumn(&store -> orderPos, sizeof(int), slotNum)) {
+        free(newOrder);
+        return false;
+    }
+    free(store -> order);
+    store -> order = newOrder;
+    store -> orderCapacity = orderCapacity;
+    store -> orderBegin = (orderCapacity - slotNum) / 2;
+    store -> orderEnd = store -> orderBegin + slotNum;
+    store -> holeNum = 0;
+
+    int **columns[SHAPESTORE_FILE_COLUMNS];
+    getFileColumns(store, columns);
+    int *fileColumns[SHAPESTORE_FILE_COLUMNS] = {file -> type, file -> x0, file -> y0, file -> x1, file -> y1,
+                                                 file -> r0, file -> r1};
+    for (int i = 0; i < SHAPESTORE_FILE_COLUMNS; i++) {
+        free(*columns[i]);
+        *columns[i] = fileColumns[i];
+    }
+    store -> mappedFile = file;
+    store -> capacity = store -> slotNum = store -> liveNum = slotNum;
+    store -> freeSlot = -1;
+
+    memset(store -> text, 0, sizeof(const char *) * slotNum);
+    memset(store -> node, 0, sizeof(struct LinkedNode *) * slotNum);
+    memset(store -> generation, 0, sizeof(unsigned int) * slotNum);
+    for (int i = 0; i < file -> textNum; i++) {
+        store -> text[file -> texts[i].slot] = file -> strings + file -> texts[i].contentOffset;
+    }
+    for (int i = 0; i < slotNum; i++) {
+        store -> order[store -> orderBegin + i] = i;
+        store -> orderPos[i] = store -> orderBegin + i;
+        computeSlotBox(store, i, &store -> box[i]);
+    }
+
+    if (list != NULL) {
+        int slot = 0;
+        for (struct LinkedNode *cntNode = list -> head; cntNode != NULL; cntNode = cntNode -> next, slot++) {
+            assert(cntNode -> data != NULL && cntNode -> data -> type == store -> type[slot]);
+            store -> node[slot] = cntNode;
+            if (!putPtrMap(&store -> slotMap, cntNode, slot)) {
+                clearShapeStore(store);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Complexity: O(1) amortized
+bool insertShapeStore(struct ShapeStore *store, struct LinkedNode *node, bool isTop) {
+    assert(store != NULL && node != NULL);
+    assert(getPtrMap(&store -> slotMap, node) == -1);
+
+    if (!reserveOrder(store, isTop)) {
+        return false;
+    }
+    int slot = allocSlot(store);
+    if (slot == -1) {
+        return false;
+    }
+    if (!putPtrMap(&store -> slotMap, node, slot)) {
+        store -> orderPos[slot] = store -> freeSlot;
+        store -> freeSlot = slot;
+        return false;
+    }
+
+    store -> node[slot] = node;
+    setSlotData(store, slot, node -> data);
+    pushOrder(store, slot, isTop);
+    store -> liveNum++;
+    return true;
+}
+
+// Complexity: O(1) amortized when prevNode is right below a hole, O(n) at worst
+bool insertShapeStoreAfter(struct ShapeStore *store, struct LinkedNode *node, const struct LinkedNode *prevNode) {
+    assert(store != NULL && node != NULL && prevNode != NULL);
+    assert(getPtrMap(&store -> slotMap, node) == -1);
+    int prevSlot = getPtrMap(&store -> slotMap, prevNode);
+    if (prevSlot == -1) {
+        return insertShapeStore(store, node, true);
+    }
+
+    int slot = allocSlot(store);
+    if (slot == -1) {
+        return false;
+    }
+    if (!putPtrMap(&store -> slotMap, node, slot)) {
+        store -> orderPos[slot] = store -> freeSlot;
+        store -> freeSlot = slot;
+        return false;
+    }
+    if (!placeOrder(store, slot, prevSlot)) {
+        removePtrMap(&store -> slotMap, node);
+        store -> orderPos[slot] = store -> freeSlot;
+        store -> freeSlot = slot;
+        return false;
+    }
+
+    store -> node[slot] = node;
+    setSlotData(store, slot, node -> data);
+    store -> liveNum++;
+    return true;
+}
+
+// Complexity: O(1) amortized
+void removeShapeStore(struct ShapeStore *store, struct LinkedNode *node) {
+    assert(store != NULL && node != NULL);
+    int slot = getPtrMap(&store -> slotMap, node);
+    if (slot == -1) {
+        return;
+    }
+
+    popOrder(store, slot);
+    removePtrMap(&store -> slotMap, node);
+    store -> generation[slot]++;
+    store -> node[slot] = NULL;
+    store -> text[slot] = NULL;
+    store -> type[slot] = DATATYPE_UNDEFINED;
+    store -> orderPos[slot] = store -> freeSlot;
+    store -> freeSlot = slot;
+    store -> liveNum--;
+
+    // Keep streaming over the z-order array proportional to live shapes
+    if (store -> holeNum > SHAPESTORE_INIT_CAPACITY && store -> holeNum > store -> liveNum) {
+        rebuildOrder(store);
+    }
+}
+
+void updateShapeStore(struct ShapeStore *store, struct LinkedNode *node) {
+    assert(store != NULL && node != NULL);
+    int slot = getPtrMap(&store -> slotMap, node);
+    if (slot != -1) {
+        setSlotData(store, slot, node -> data);
+    }
+}
+
+// Complexity: O(1) amortized
+bool reorderShapeStore(struct ShapeStore *store, struct LinkedNode *node, bool isTop) {
+    assert(store != NULL && node != NULL);
+    int slot = getPtrMap(&store -> slotMap, node);
+    if (slot == -1) {
+        return true;
+    }
+    if (!reserveOrder(store, isTop)) {
+        return false;
+    }
+    popOrder(store, slot);
+    pushOrder(store, slot, isTop);
+    return true;
+}
+
+// Complexity: O(1) amortized when prevNode is right below a hole, O(n) at worst
+bool reorderShapeStoreAfter(struct ShapeStore *store, struct LinkedNode *node, const struct LinkedNode *prevNode) {
+    assert(store != NULL && node != NULL && prevNode != NULL && node != prevNode);
+    int slot = getPtrMap(&store -> slotMap, node);
+    int prevSlot = getPtrMap(&store -> slotMap, prevNode);
+    if (slot == -1 || prevSlot == -1) {
+        return true;
+    }
+    // With room at the top reserved, placing cannot fail once the slot is out of the way
+    if (!reserveOrder(store, true)) {
+        return false;
+    }
+    popOrder(store, slot);
+    bool isPlaced = placeOrder(store, slot, prevSlot);
+    assert(isPlaced);
+    (void)isPlaced;
+    return true;
+}
+
+bool getShapeHandle(const struct ShapeStore *store, const struct LinkedNode *node, struct ShapeHandle *handle) {
+    assert(store != NULL && node != NULL && handle != NULL);
+    int slot = getPtrMap(&store -> slotMap, node);
+    if (slot == -1) {
+        return false;
+    }
+    handle -> slot = slot;
+    handle -> generation = store -> generation[slot];
+    return true;
+}
+
+bool isValidShapeHandle(const struct ShapeStore *store, const struct ShapeHandle *handle) {
+    assert(store != NULL && handle != NULL);
+    return handle -> slot >= 0 && handle -> slot < store -> slotNum &&
+           store -> node[handle -> slot] != NULL &&
+           store -> generation[handle -> slot] == handle -> generation;
+}
+
+struct LinkedNode * getShapeNode(const struct ShapeStore *store, const struct ShapeHandle *handle) {
+    return isValidShapeHandle(store, handle) ? store -> node[handle -> slot] : NULL;
+}
+
+static void getHitColumns(const struct ShapeStore *store, struct HitColumns *cols) {
+    cols -> type = store -> type;
+    cols -> x0 = store -> x0;
+    cols -> y0 = store -> y0;
+    cols -> x1 = store -> x1;
+    cols -> y1 = store -> y1;
+    cols -> r0 = store -> r0;
+    cols -> r1 = store -> r1;
+}
+
+void getSlotBoundingBox(const struct ShapeStore *store, int slot, struct BoundingBox *box) {
+    assert(store != NULL && slot >= 0 && slot < store -> slotNum && box != NULL);
+    *box = store -> box[slot];
+}
+
+bool isSlotHit(const struct ShapeStore *store, int slot, int x, int y) {
+    assert(store != NULL && slot >= 0 && slot < store -> slotNum);
+    struct HitColumns cols;
+    getHitColumns(store, &cols);
+    return isColumnHit(&cols, slot, x, y);
+}
+
+// Complexity: O(n)
+int findShapeStore(const struct ShapeStore *store, int x, int y) {
+    assert(store != NULL);
+    struct HitColumns cols;
+    getHitColumns(store, &cols);
+    int pos = findTopHit(&cols, store -> order, store -> orderBegin, store -> orderEnd, x, y);
+    return pos == -1 ? -1 : store -> order[pos];
+}
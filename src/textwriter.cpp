@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include <errno.h>
+
+#include "textwriter.h"
+
+struct TextWriter * makeTextWriter(const char *path) {
+    assert(path != NULL);
+    errno = 0;
+    struct TextWriter *writer = (struct TextWriter *)malloc(sizeof(struct TextWriter));
+    if (writer == NULL) {
+        perror("makeTextWriter");
+        return NULL;
+    }
+    writer -> file = fopen(path, "wb");
+    if (writer -> file == NULL) {
+        perror("makeTextWriter");
+        free(writer);
+        return NULL;
+    }
+    writer -> length = 0;
+    writer -> isFailed = false;
+    writer -> offset = 0;
+    return writer;
+}
+
+static void flushTextWriter(struct TextWriter *writer) {
+    if (writer -> length > 0 && !writer -> isFailed) {
+        writer -> isFailed = fwrite(writer -> buffer, 1, writer -> length, writer -> file) != (size_t)writer -> length;
+    }
+    writer -> length = 0;
+}
+
+bool destroyTextWriter(struct TextWriter *writer) {
+    assert(writer != NULL);
+    flushTextWriter(writer);
+    bool isWritten = !writer -> isFailed;
+    errno = 0;
+    if (fclose(writer -> file) != 0 || !isWritten) {
+        perror("destroyTextWriter");
+        isWritten = false;
+    }
+    free(writer);
+    return isWritten;
+}
+
+char * reserveTextWriter(struct TextWriter *writer, int size) {
+    assert(writer != NULL && size >= 0 && size <= TEXT_WRITER_BUFFER_SIZE);
+    if (writer -> length + size > TEXT_WRITER_BUFFER_SIZE) {
+        flushTextWriter(writer);
+    }
+    return writer -> buffer + writer -> length;
+}
+
+void commitTextWriter(struct TextWriter *writer, int size) {
+    assert(writer != NULL && size >= 0 && writer -> length + size <= TEXT_WRITER_BUFFER_SIZE);
+    writer -> length += size;
+    writer -> offset += size;
+}
+
+// Complexity: O(d), d the number of digits
+int formatInt(char *out, long long int value) {
+    char digits[24];
+    int digitNum = 0, length = 0;
+    unsigned long long int magnitude = value < 0 ? 0ull - (unsigned long long int)value : (unsigned long long int)value;
+    do {
+        digits[digitNum++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+        out[length++] = '-';
+    }
+    while (digitNum > 0) {
+        out[length++] = digits[--digitNum];
+    }
+    return length;
+}
+
+// Values too large for the scaled integer, or not numbers at all, fall back to printf()
+int formatFixed(char *out, double value, int decimals) {
+    assert(decimals >= 0 && decimals <= 6);
+    long long int scale = 1;
+    for (int i = 0; i < decimals; i++) {
+        scale *= 10;
+    }
+    double scaled = value * scale;
+    if (!(fabs(scaled) < 1e17)) {
+        return snprintf(out, TEXT_WRITER_MAX_NUMBER, "%.17g", value);
+    }
+    long long int rounded = llround(scaled);
+    if (rounded == 0) {
+        out[0] = '0';
+        return 1;
+    }
+
+    int length = 0;
+    unsigned long long int magnitude = rounded < 0 ? 0ull - (unsigned long long int)rounded : (unsigned long long int)rounded;
+    if (rounded < 0) {
+        out[length++] = '-';
+    }
+    length += formatInt(out + length, magnitude / scale);
+    unsigned long long int fraction = magnitude % scale;
+    if (fraction > 0) {
+        out[length++] = '.';
+        for (long long int digit = scale / 10; fraction > 0; digit /= 10) {
+            out[length++] = '0' + fraction / digit;
+            fraction %= digit;
+        }
+    }
+    return length;
+}
+
+// Long strings go through in buffer sized pieces
+void writeString(struct TextWriter *writer, const char *text) {
+    assert(text != NULL);
+    int textLength = strlen(text);
+    while (textLength > 0) {
+        int pieceLength = min(textLength, TEXT_WRITER_BUFFER_SIZE);
+        memcpy(reserveTextWriter(writer, pieceLength), text, pieceLength);
+        commitTextWriter(writer, pieceLength);
+        text += pieceLength;
+        textLength -= pieceLength;
+    }
+}
+
+void writeChar(struct TextWriter *writer, char c) {
+    *reserveTextWriter(writer, 1) = c;
+    commitTextWriter(writer, 1);
+}
+
+void writeInt(struct TextWriter *writer, long long int value) {
+    char *out = reserveTextWriter(writer, TEXT_WRITER_MAX_NUMBER);
+    commitTextWriter(writer, formatInt(out, value));
+}
+
+void writeFixed(struct TextWriter *writer, double value, int decimals) {
+    char *out = reserveTextWriter(writer, TEXT_WRITER_MAX_NUMBER);
+    commitTextWriter(writer, formatFixed(out, value, decimals));
+}
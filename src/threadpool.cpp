@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <assert.h>
+#include <new>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "threadpool.h"
+
+struct ThreadPool {
+    int threadNum;
+    std::thread *workers;
+
+    std::mutex lock;
+    std::condition_variable workCond, doneCond;
+    bool isStopping;
+
+    // Current batch, a new one bumps batchId
+    unsigned int batchId;
+    void (*func)(void *arg, int taskId);
+    void *arg;
+    int taskNum;
+    std::atomic<int> nextTask;
+    // Workers still inside the current batch
+    int busyNum;
+};
+
+// Take tasks of the current batch until none is left
+static void runTasks(struct ThreadPool *pool) {
+    while (true) {
+        int taskId = pool -> nextTask.fetch_add(1);
+        if (taskId >= pool -> taskNum) {
+            return;
+        }
+        pool -> func(pool -> arg, taskId);
+    }
+}
+
+static void runWorker(struct ThreadPool *pool) {
+    unsigned int doneBatchId = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> guard(pool -> lock);
+            pool -> workCond.wait(guard, [&] { return pool -> isStopping || pool -> batchId != doneBatchId; });
+            if (pool -> isStopping) {
+                return;
+            }
+            doneBatchId = pool -> batchId;
+        }
+
+        runTasks(pool);
+
+        std::lock_guard<std::mutex> guard(pool -> lock);
+        if (--pool -> busyNum == 0) {
+            pool -> doneCond.notify_one();
+        }
+    }
+}
+
+struct ThreadPool * makeThreadPool(int threadNum) {
+    if (threadNum <= 0) {
+        threadNum = (int)std::thread::hardware_concurrency();
+    }
+    threadNum = threadNum <= 0 ? 1 : threadNum;
+
+    struct ThreadPool *pool = new (std::nothrow) ThreadPool;
+    std::thread *workers = new (std::nothrow) std::thread[threadNum - 1];
+    if (pool == NULL || workers == NULL) {
+        fprintf(stderr, "makeThreadPool: out of memory\n");
+        delete pool;
+        delete[] workers;
+        return NULL;
+    }
+
+    pool -> threadNum = threadNum;
+    pool -> workers = workers;
+    pool -> isStopping = false;
+    pool -> batchId = 0;
+    pool -> func = NULL;
+    pool -> arg = NULL;
+    pool -> taskNum = 0;
+    pool -> nextTask = 0;
+    pool -> busyNum = 0;
+    for (int i = 0; i < threadNum - 1; i++) {
+        pool -> workers[i] = std::thread(runWorker, pool);
+    }
+    return pool;
+}
+
+void destroyThreadPool(struct ThreadPool *pool) {
+    assert(pool != NULL);
+    {
+        std::lock_guard<std::mutex> guard(pool -> lock);
+        pool -> isStopping = true;
+    }
+    pool -> workCond.notify_all();
+    for (int i = 0; i < pool -> threadNum - 1; i++) {
+        pool -> workers[i].join();
+    }
+    delete[] pool -> workers;
+    delete pool;
+}
+
+int getThreadPoolSize(const struct ThreadPool *pool) {
+    assert(pool != NULL);
+    return pool -> threadNum;
+}
+
+void runThreadPool(struct ThreadPool *pool, int taskNum, void (*func)(void *arg, int taskId), void *arg) {
+    assert(pool != NULL && func != NULL && taskNum >= 0);
+    if (taskNum == 0) {
+        return;
+    }
+    if (pool -> threadNum == 1 || taskNum == 1) {
+        for (int taskId = 0; taskId < taskNum; taskId++) {
+            func(arg, taskId);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(pool -> lock);
+        pool -> func = func;
+        pool -> arg = arg;
+        pool -> taskNum = taskNum;
+        pool -> nextTask = 0;
+        pool -> busyNum = pool -> threadNum - 1;
+        pool -> batchId++;
+    }
+    pool -> workCond.notify_all();
+
+    runTasks(pool);
+
+    // Every worker has to leave the batch before the next one may overwrite it
+    std::unique_lock<std::mutex> guard(pool -> lock);
+    pool -> doneCond.wait(guard, [&] { return pool -> busyNum == 0; });
+}
@@ -0,0 +1,326 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+
+#include "tilerender.h"
+#include "datatypes.h"
+#include "render.h"
+
+// Rasterized pixels may stray this far out of a shape box
+#define TILE_RENDER_MARGIN 1
+
+struct TileRenderer * makeTileRenderer(int threadNum) {
+    errno = 0;
+    struct TileRenderer *renderer = (struct TileRenderer *)calloc(1, sizeof(struct TileRenderer));
+    if (renderer == NULL) {
+        perror("makeTileRenderer");
+        return NULL;
+    }
+    renderer -> pool = makeThreadPool(threadNum);
+    if (renderer -> pool == NULL) {
+        free(renderer);
+        return NULL;
+    }
+    return renderer;
+}
+
+void destroyTileRenderer(struct TileRenderer *renderer) {
+    assert(renderer != NULL);
+    destroyThreadPool(renderer -> pool);
+    free(renderer -> items);
+    free(renderer -> itemBoxes);
+    free(renderer -> binBegin);
+    free(renderer -> binFill);
+    free(renderer -> binItems);
+    free(renderer);
+    renderer = NULL;
+}
+
+// Grow an array to hold at least size elements, doubling its capacity
+// Returns false if out of memory, leaving the array untouched
+static bool reserveArray(void **arr, int *capacity, int size, size_t elementSize) {
+    if (size <= *capacity) {
+        return true;
+    }
+    int newCapacity = *capacity == 0 ? 64 : *capacity;
+    while (newCapacity < size) {
+        newCapacity *= 2;
+    }
+    errno = 0;
+    void *newArr = realloc(*arr, elementSize * newCapacity);
+    if (newArr == NULL) {
+        perror("reserveArray");
+        return false;
+    }
+    *arr = newArr;
+    *capacity = newCapacity;
+    return true;
+}
+
+static bool reserveItems(struct TileRenderer *renderer, int size) {
+    int boxCapacity = renderer -> itemCapacity;
+    if (!reserveArray((void **)&renderer -> itemBoxes, &boxCapacity, size, sizeof(struct BoundingBox))) {
+        return false;
+    }
+    if (!reserveArray((void **)&renderer -> items, &renderer -> itemCapacity, size, sizeof(const struct NodeData *))) {
+        return false;
+    }
+    // Both arrays grew alike
+    assert(boxCapacity == renderer -> itemCapacity);
+    return true;
+}
+
+static bool reserveTiles(struct TileRenderer *renderer, int size) {
+    // One more begin closes the last bin
+    int beginCapacity = renderer -> tileCapacity;
+    if (!reserveArray((void **)&renderer -> binBegin, &beginCapacity, size + 1, sizeof(int))) {
+        return false;
+    }
+    return reserveArray((void **)&renderer -> binFill, &renderer -> tileCapacity, size + 1, sizeof(int));
+}
+
+// Get the range of tiles box crosses, clamped to the frame area
+// Returns false if it crosses none
+static bool getTileRange(const struct TileRenderer *renderer, const struct BoundingBox *box,
+                         int *minTileX, int *minTileY, int *maxTileX, int *maxTileY) {
+    const struct BoundingBox *area = &renderer -> area;
+    if (!isBoxIntersected(box, area)) {
+        return false;
+    }
+    *minTileX = (max(box -> minx, area -> minx) - area -> minx) / renderer -> tileSize;
+    *minTileY = (max(box -> miny, area -> miny) - area -> miny) / renderer -> tileSize;
+    *maxTileX = (min(box -> maxx, area -> maxx) - area -> minx) / renderer -> tileSize;
+    *maxTileY = (min(box -> maxy, area -> maxy) - area -> miny) / renderer -> tileSize;
+    return true;
+}
+
+static long long int getSqrDistanceToBox(long long int x, long long int y, const struct BoundingBox *box) {
+    long long int dx = x < box -> minx ? box -> minx - x : (x > box -> maxx ? x - box -> maxx : 0);
+    long long int dy = y < box -> miny ? box -> miny - y : (y > box -> maxy ? y - box -> maxy : 0);
+    return dx * dx + dy * dy;
+}
+
+static long long int getSqrFarthestInBox(long long int x, long long int y, const struct BoundingBox *box) {
+    long long int dx = max(llabs(x - box -> minx), llabs(x - box -> maxx));
+    long long int dy = max(llabs(y - box -> miny), llabs(y - box -> maxy));
+    return dx * dx + dy * dy;
+}
+
+static bool isInsideBox(const struct BoundingBox *inner, long long int minx, long long int miny,
+                        long long int maxx, long long int maxy) {
+    return inner -> minx > minx && inner -> maxx < maxx && inner -> miny > miny && inner -> maxy < maxy;
+}
+
+// Check whether the outline of data may touch tileBox, whose box it already crosses
+// Only tiles lying clear of the outline are rejected, with a pixel to spare
+// Returns false if the outline cannot touch it
+static bool isOutlineNear(const struct NodeData *data, const struct BoundingBox *tileBox) {
+    switch (data -> type) {
+        case DATATYPE_SEGMENT: {
+            // Every corner of the widened tile strictly on the same side of the line
+            struct Segment *seg = (struct Segment *)data -> content;
+            long long int dx = seg -> rightPt -> x - seg -> leftPt -> x, dy = seg -> rightPt -> y - seg -> leftPt -> y;
+            long long int xs[2] = {tileBox -> minx - 1LL, tileBox -> maxx + 1LL};
+            long long int ys[2] = {tileBox -> miny - 1LL, tileBox -> maxy + 1LL};
+            int positiveNum = 0, negativeNum = 0;
+            for (int i = 0; i < 4; i++) {
+                long long int cross = dx * (ys[i / 2] - seg -> leftPt -> y) - dy * (xs[i % 2] - seg -> leftPt -> x);
+                positiveNum += cross > 0;
+                negativeNum += cross < 0;
+            }
+            return positiveNum != 4 && negativeNum != 4;
+        }
+        case DATATYPE_RECTANGLE: {
+            struct Rectangle *rec = (struct Rectangle *)data -> content;
+            return !isInsideBox(tileBox, rec -> lowerLeftPt -> x + 1LL, rec -> lowerLeftPt -> y + 1LL,
+                                rec -> upperRightPt -> x - 1LL, rec -> upperRightPt -> y - 1LL);
+        }
+        case DATATYPE_TEXT: {
+            struct Rectangle *pos = ((struct Text *)data -> content) -> position;
+            return !isInsideBox(tileBox, pos -> lowerLeftPt -> x + 1LL, pos -> lowerLeftPt -> y + 1LL,
+                                pos -> upperRightPt -> x - 1LL, pos -> upperRightPt -> y - 1LL);
+        }
+        case DATATYPE_CIRCLE: {
+            // Neither outside the ring nor within its hole
+            struct Circle *cir = (struct Circle *)data -> content;
+            long long int outer = cir -> radius + 2LL, inner = max(cir -> radius - 2LL, 0LL);
+            return getSqrDistanceToBox(cir -> centerPt -> x, cir -> centerPt -> y, tileBox) <= outer * outer
+                && getSqrFarthestInBox(cir -> centerPt -> x, cir -> centerPt -> y, tileBox) >= inner * inner;
+        }
+        case DATATYPE_ELLIPSE: {
+            // Not within the rectangle inscribed in the ellipse
+            struct Ellipse *elp = (struct Ellipse *)data -> content;
+            long long int halfWidth = (long long int)(elp -> majorSemiAxis / sqrt(2.0)) - 2;
+            long long int halfHeight = (long long int)(elp -> minorSemiAxis / sqrt(2.0)) - 2;
+            return !isInsideBox(tileBox, elp -> centerPt -> x - halfWidth, elp -> centerPt -> y - halfHeight,
+                                elp -> centerPt -> x + halfWidth, elp -> centerPt -> y + halfHeight);
+        }
+        default: {
+            return true;
+        }
+    }
+}
+
+static void getTileBox(const struct TileRenderer *renderer, int tileX, int tileY, struct BoundingBox *tileBox) {
+    tileBox -> minx = renderer -> area.minx + tileX * renderer -> tileSize;
+    tileBox -> miny = renderer -> area.miny + tileY * renderer -> tileSize;
+    tileBox -> maxx = min(tileBox -> minx + renderer -> tileSize - 1, renderer -> area.maxx);
+    tileBox -> maxy = min(tileBox -> miny + renderer -> tileSize - 1, renderer -> area.maxy);
+}
+
+// Check whether an item spanning several tiles touches the given one, single tile items always do
+static bool isItemInTile(const struct TileRenderer *renderer, int itemId, int tileX, int tileY, bool isSpanning) {
+    if (!isSpanning) {
+        return true;
+    }
+    struct BoundingBox tileBox;
+    getTileBox(renderer, tileX, tileY, &tileBox);
+    return isOutlineNear(renderer -> items[itemId], &tileBox);
+}
+
+// Bin every shape of the list into the tiles it crosses, keeping list order within each tile
+// Returns false if out of memory
+// Complexity: O(n + tiles + binned shapes), the outline test running twice per spanned tile
+static bool binShapes(struct TileRenderer *renderer, const struct LinkedList *list) {
+    if (!reserveItems(renderer, list -> listSize)) {
+        return false;
+    }
+    renderer -> itemNum = 0;
+    for (struct LinkedNode *cntNode = list -> head; cntNode != NULL && cntNode -> data != NULL; cntNode = cntNode -> next) {
+        int itemId = renderer -> itemNum++;
+        struct BoundingBox *cntBox = &renderer -> itemBoxes[itemId];
+        renderer -> items[itemId] = cntNode -> data;
+        *cntBox = cntNode -> box;
+        cntBox -> minx -= TILE_RENDER_MARGIN;
+        cntBox -> miny -= TILE_RENDER_MARGIN;
+        cntBox -> maxx += TILE_RENDER_MARGIN;
+        cntBox -> maxy += TILE_RENDER_MARGIN;
+    }
+
+    int tileNum = renderer -> tileNumX * renderer -> tileNumY;
+    if (!reserveTiles(renderer, tileNum)) {
+        return false;
+    }
+
+    // Count, then turn counts into bin offsets
+    for (int i = 0; i <= tileNum; i++) {
+        renderer -> binBegin[i] = 0;
+    }
+    renderer -> stats.drawnNum = 0;
+    for (int i = 0; i < renderer -> itemNum; i++) {
+        int minTileX, minTileY, maxTileX, maxTileY;
+        if (!getTileRange(renderer, &renderer -> itemBoxes[i], &minTileX, &minTileY, &maxTileX, &maxTileY)) {
+            continue;
+        }
+        renderer -> stats.drawnNum++;
+        bool isSpanning = minTileX != maxTileX || minTileY != maxTileY;
+        for (int tileY = minTileY; tileY <= maxTileY; tileY++) {
+            for (int tileX = minTileX; tileX <= maxTileX; tileX++) {
+                if (isItemInTile(renderer, i, tileX, tileY, isSpanning)) {
+                    renderer -> binBegin[tileY * renderer -> tileNumX + tileX + 1]++;
+                }
+            }
+        }
+    }
+    for (int i = 0; i < tileNum; i++) {
+        renderer -> binBegin[i + 1] += renderer -> binBegin[i];
+        renderer -> binFill[i] = renderer -> binBegin[i];
+    }
+
+    if (!reserveArray((void **)&renderer -> binItems, &renderer -> binCapacity, renderer -> binBegin[tileNum], sizeof(int))) {
+        return false;
+    }
+    for (int i = 0; i < renderer -> itemNum; i++) {
+        int minTileX, minTileY, maxTileX, maxTileY;
+        if (!getTileRange(renderer, &renderer -> itemBoxes[i], &minTileX, &minTileY, &maxTileX, &maxTileY)) {
+            continue;
+        }
+        bool isSpanning = minTileX != maxTileX || minTileY != maxTileY;
+        for (int tileY = minTileY; tileY <= maxTileY; tileY++) {
+            for (int tileX = minTileX; tileX <= maxTileX; tileX++) {
+                if (isItemInTile(renderer, i, tileX, tileY, isSpanning)) {
+                    renderer -> binItems[renderer -> binFill[tileY * renderer -> tileNumX + tileX]++] = i;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static void skipTextHook(void *impl, const struct Vertex *startPt, const struct Vertex *endPt, const char *text,
+                         unsigned int color, bool isDraft) {
+    (void)impl;
+    (void)startPt;
+    (void)endPt;
+    (void)text;
+    (void)color;
+    (void)isDraft;
+}
+
+static void initTileBackend(const struct TileRenderer *renderer, struct FrameBuffer *fb, struct RenderBackend *backend) {
+    initFrameBufferBackend(fb, backend);
+    if (renderer -> isTextSkipped) {
+        backend -> textFunc = skipTextHook;
+    }
+}
+
+// Same as fbRedrawAll(), leaving text out if asked to
+static void renderOneThread(struct TileRenderer *renderer, struct FrameBuffer *fb, const struct LinkedList *list) {
+    fbFillRect(fb, fb -> clip.minx, fb -> clip.miny, fb -> clip.maxx, fb -> clip.maxy, fb -> bgColor);
+    struct RenderBackend backend;
+    initTileBackend(renderer, fb, &backend);
+    renderer -> stats.drawnNum = renderer -> stats.culledNum = 0;
+    renderList(&backend, list, fb -> color, false, &fb -> clip, &renderer -> stats);
+}
+
+static void renderTile(void *arg, int tileId) {
+    const struct TileRenderer *renderer = (const struct TileRenderer *)arg;
+    int tileX = tileId % renderer -> tileNumX, tileY = tileId / renderer -> tileNumX;
+    struct BoundingBox tileBox;
+    getTileBox(renderer, tileX, tileY, &tileBox);
+
+    // Same pixels, private clip
+    struct FrameBuffer tileFb = *renderer -> fb;
+    setFrameBufferClip(&tileFb, &tileBox);
+    fbFillRect(&tileFb, tileBox.minx, tileBox.miny, tileBox.maxx, tileBox.maxy, tileFb.bgColor);
+
+    struct RenderBackend backend;
+    initTileBackend(renderer, &tileFb, &backend);
+    for (int i = renderer -> binBegin[tileId]; i < renderer -> binBegin[tileId + 1]; i++) {
+        renderNodeData(&backend, renderer -> items[renderer -> binItems[i]], tileFb.color, false, 0, 0);
+    }
+}
+
+void fbRedrawAllTiled(struct TileRenderer *renderer, struct FrameBuffer *fb, const struct LinkedList *list) {
+    assert(renderer != NULL && fb != NULL && list != NULL);
+    int threadNum = getThreadPoolSize(renderer -> pool);
+    if (threadNum == 1) {
+        renderOneThread(renderer, fb, list);
+        return;
+    }
+
+    renderer -> fb = fb;
+    renderer -> area = fb -> clip;
+    renderer -> stats.drawnNum = 0;
+    renderer -> stats.culledNum = list -> listSize;
+    if (renderer -> area.minx > renderer -> area.maxx || renderer -> area.miny > renderer -> area.maxy) {
+        return;
+    }
+
+    // Largest tiles still giving every thread a few to balance the load
+    long long int areaSize = ((long long int)renderer -> area.maxx - renderer -> area.minx + 1)
+                           * ((long long int)renderer -> area.maxy - renderer -> area.miny + 1);
+    renderer -> tileSize = max((int)sqrt((double)areaSize / ((long long int)threadNum * TILE_RENDER_TASKS_PER_THREAD)),
+                               TILE_RENDER_MIN_SIZE);
+    renderer -> tileNumX = (renderer -> area.maxx - renderer -> area.minx) / renderer -> tileSize + 1;
+    renderer -> tileNumY = (renderer -> area.maxy - renderer -> area.miny) / renderer -> tileSize + 1;
+
+    if (!binShapes(renderer, list)) {
+        renderOneThread(renderer, fb, list);
+        return;
+    }
+    renderer -> stats.culledNum = renderer -> itemNum - renderer -> stats.drawnNum;
+    runThreadPool(renderer -> pool, renderer -> tileNumX * renderer -> tileNumY, renderTile, renderer);
+}
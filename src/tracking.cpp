@@ -0,0 +1,434 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+
+#include "distance.h"
+#include "tracking.h"
+
+void initTracker(struct Tracker *tracker, const struct LinkedList *list, const struct RenderBackend *backend,
+                 const struct DamagePainter *painter, const struct BoundingBox *canvasBox) {
+    assert(tracker != NULL && list != NULL && backend != NULL && painter != NULL && canvasBox != NULL);
+    tracker -> list = list;
+    tracker -> backend = backend;
+    tracker -> painter = painter;
+    tracker -> canvasBox = *canvasBox;
+    tracker -> textBoxFunc = NULL;
+    tracker -> isFirstFrame = true;
+}
+
+// Repaint the committed shapes where the last draft and the one at newBox lie, everywhere on the first frame
+// Complexity: O(k log n + pixels) with an R-tree attached, k being the shapes crossing the damage
+static void repaintTracked(struct Tracker *tracker, const struct BoundingBox *newBox) {
+    struct Damage damage;
+    initDamage(&damage);
+    if (tracker -> isFirstFrame) {
+        addDamage(&damage, &tracker -> canvasBox);
+    } else {
+        addDamage(&damage, &tracker -> draftBox);
+        addDamage(&damage, newBox);
+    }
+    clipDamage(&damage, &tracker -> canvasBox);
+    repaintDamage(tracker -> list, &damage, tracker -> painter);
+
+    tracker -> draftBox = *newBox;
+    tracker -> isFirstFrame = false;
+}
+
+void drawTrackedShape(struct Tracker *tracker, const struct Vertex *startPt, const struct Vertex *endPt,
+                      int shapeType, unsigned int color) {
+    assert(tracker != NULL && startPt != NULL && endPt != NULL);
+    struct BoundingBox newBox;
+    getShapeBoundingBox(startPt, endPt, shapeType, &newBox);
+    repaintTracked(tracker, &newBox);
+    renderShape(tracker -> backend, startPt, endPt, shapeType, color);
+}
+
+void drawTrackedData(struct Tracker *tracker, const struct NodeData *data, const struct Vertex *startPt,
+                     const struct Vertex *endPt, unsigned int color) {
+    assert(tracker != NULL && data != NULL && startPt != NULL && endPt != NULL);
+    if (data -> type != DATATYPE_TEXT) {
+        drawTrackedShape(tracker, startPt, endPt, data -> type, color);
+        return;
+    }
+
+    const struct Text *txt = (const struct Text *)data -> content;
+    struct BoundingBox newBox;
+    if (tracker -> textBoxFunc != NULL) {
+        tracker -> textBoxFunc(startPt, endPt, txt -> content, &newBox);
+    } else {
+        getShapeBoundingBox(startPt, endPt, DATATYPE_TEXT, &newBox);
+    }
+    repaintTracked(tracker, &newBox);
+    tracker -> backend -> textFunc(tracker -> backend -> impl, startPt, endPt, txt -> content, color, true);
+}
+
+void getEditAssistPts(const struct LinkedNode *node, struct Vertex *assistPts) {
+    assert(node != NULL && node -> data != NULL && assistPts != NULL);
+
+    // Handles sit on the extent kept with the node, except on the ends of a segment
+    int minx = node -> box.minx, miny = node -> box.miny;
+    int maxx = node -> box.maxx, maxy = node -> box.maxy;
+    int drawConf = 0;
+
+    switch (node -> data -> type) {
+        case DATATYPE_SEGMENT: {
+            struct Segment *seg = (struct Segment *)node -> data -> content;
+            miny = seg -> leftPt -> y, maxy = seg -> rightPt -> y;
+            drawConf = EDIT_ASSIST_DRAW_SIDE_SAME;
+            break;
+        }
+        case DATATYPE_RECTANGLE:
+        case DATATYPE_ELLIPSE: {
+            drawConf = EDIT_ASSIST_DRAW_SIDE_SAME + EDIT_ASSIST_DRAW_SIDE_NON_SAME + EDIT_ASSIST_DRAW_MID;
+            break;
+        }
+        case DATATYPE_CIRCLE: {
+            drawConf = EDIT_ASSIST_DRAW_MID;
+            break;
+        }
+        case DATATYPE_TEXT: {
+            drawConf = EDIT_ASSIST_DRAW_SIDE_SAME + EDIT_ASSIST_DRAW_SIDE_NON_SAME;
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+
+    for (int i = 0; i < EDIT_ASSIST_MAX_NUM; i++) {
+        const int xType = i / 3, yType = i % 3;
+        assistPts[i].x = -1;
+        assistPts[i].y = -1;
+
+        // Validate
+        if (!(drawConf & EDIT_ASSIST_DRAW_SIDE_SAME)) {
+            if (xType != 2 && yType != 2 && xType == yType) {
+                continue;
+            }
+        }
+        if (!(drawConf & EDIT_ASSIST_DRAW_SIDE_NON_SAME)) {
+            if (xType != 2 && yType != 2 && xType != yType) {
+                continue;
+            }
+        }
+        if (!(drawConf & EDIT_ASSIST_DRAW_MID)) {
+            if (xType == 2 || yType == 2) {
+                continue;
+            }
+        }
+
+        if (xType == 0) {
+            assistPts[i].x = minx;
+        } else if (xType == 1) {
+            assistPts[i].x = maxx;
+        } else {
+            assistPts[i].x = (minx + maxx) / 2;
+        }
+
+        if (yType == 0) {
+            assistPts[i].y = miny;
+        } else if (yType == 1) {
+            assistPts[i].y = maxy;
+        } else {
+            assistPts[i].y = (miny + maxy) / 2;
+        }
+    }
+}
+
+bool getTrackedPts(const struct NodeData *data, const struct Vertex *assistPts, int assistId,
+                   struct Vertex *startPt, struct Vertex *endPt) {
+    assert(data != NULL && assistPts != NULL && startPt != NULL && endPt != NULL);
+
+    if (assistId == -1) {
+        if (data -> type == DATATYPE_CIRCLE) {
+            assistId = 2;
+        } else {
+            assistId = 0;
+        }
+    }
+
+    const int xType = assistId / 3, yType = assistId % 3;
+    int startPtx = 0, startPty = 0;
+    int endPtx = assistPts[assistId].x, endPty = assistPts[assistId].y;
+
+    switch (data -> type) {
+        case DATATYPE_SEGMENT: {
+            struct Segment *seg = (struct Segment *)data -> content;
+            if (xType == 0) {
+                startPtx = seg -> rightPt -> x;
+                startPty = seg -> rightPt -> y;
+            } else {
+                startPtx = seg -> leftPt -> x;
+                startPty = seg -> leftPt -> y;
+            }
+            break;
+        }
+        case DATATYPE_RECTANGLE: {
+            struct Rectangle *rec = (struct Rectangle *)data -> content;
+
+            if (xType == 0) {
+                startPtx = rec -> upperRightPt -> x;
+            } else {
+                startPtx = rec -> lowerLeftPt -> x;
+                if (xType == 2) {
+                    endPtx = rec -> upperRightPt -> x;
+                }
+            }
+            if (yType == 0) {
+                startPty = rec -> upperRightPt -> y;
+            } else {
+                startPty = rec -> lowerLeftPt -> y;
+                if (yType == 2) {
+                    endPty = rec -> upperRightPt -> y;
+                }
+            }
+            break;
+        }
+        case DATATYPE_CIRCLE: {
+            struct Circle *cir = (struct Circle *)data -> content;
+
+            if (xType == 2) {
+                startPtx = endPtx;
+                if (yType == 0) {
+                    startPty = endPty + cir -> radius * 2;
+                } else {
+                    startPty = endPty - cir -> radius * 2;
+                }
+            }
+            if (yType == 2) {
+                if (xType == 0) {
+                    startPtx = endPtx + cir -> radius * 2;
+                } else {
+                    startPtx = endPtx - cir -> radius * 2;
+                }
+                startPty = endPty;
+            }
+            break;
+        }
+        case DATATYPE_ELLIPSE: {
+            struct Ellipse *elp = (struct Ellipse *)data -> content;
+
+            if (xType == 0) {
+                startPtx = elp -> centerPt -> x + elp -> majorSemiAxis;
+            } else {
+                startPtx = elp -> centerPt -> x - elp -> majorSemiAxis;
+                if (xType == 2) {
+                    endPtx = elp -> centerPt -> x + elp -> majorSemiAxis;
+                }
+            }
+            if (yType == 0) {
+                startPty = elp -> centerPt -> y + elp -> minorSemiAxis;
+            } else {
+                startPty = elp -> centerPt -> y - elp -> minorSemiAxis;
+                if (yType == 2) {
+                    endPty = elp -> centerPt -> y + elp -> minorSemiAxis;
+                }
+            }
+
+            break;
+        }
+        case DATATYPE_TEXT: {
+            struct Text *txt = (struct Text *)data -> content;
+            struct Rectangle *pos = (struct Rectangle *)txt -> position;
+
+            if (xType == 0) {
+                startPtx = pos -> upperRightPt -> x;
+            } else {
+                startPtx = pos -> lowerLeftPt -> x;
+                if (xType == 2) {
+                    endPtx = pos -> upperRightPt -> x;
+                }
+            }
+            if (yType == 0) {
+                startPty = pos -> upperRightPt -> y;
+            } else {
+                startPty = pos -> lowerLeftPt -> y;
+                if (yType == 2) {
+                    endPty = pos -> upperRightPt -> y;
+                }
+            }
+            break;
+        }
+        default: {
+            return false;
+        }
+    }
+
+    startPt -> x = startPtx;
+    startPt -> y = startPty;
+    endPt -> x = endPtx;
+    endPt -> y = endPty;
+    return true;
+}
+
+void resizeTrackedPts(int assistId, const struct Vertex *origPt, int x, int y, struct Vertex *endPt) {
+    assert(origPt != NULL && endPt != NULL);
+    const int xType = assistId / 3, yType = assistId % 3;
+    endPt -> x = xType == 2 ? origPt -> x : x;
+    endPt -> y = yType == 2 ? origPt -> y : y;
+}
+
+void moveTrackedPts(struct Vertex *cursorPt, int x, int y, struct Vertex *startPt, struct Vertex *endPt) {
+    assert(cursorPt != NULL && startPt != NULL && endPt != NULL);
+    int deltax = x - cursorPt -> x, deltay = y - cursorPt -> y;
+    cursorPt -> x = x;
+    cursorPt -> y = y;
+
+    startPt -> x += deltax;
+    startPt -> y += deltay;
+    endPt -> x += deltax;
+    endPt -> y += deltay;
+}
+
+void getShapeBoundingBox(const struct Vertex *startPt, const struct Vertex *endPt, int shapeType, struct BoundingBox *box) {
+    assert(startPt != NULL && endPt != NULL && box != NULL);
+
+    // Same geometry as renderShape()
+    switch (shapeType) {
+        case DATATYPE_CIRCLE: {
+            struct Vertex centerPt = {(startPt -> x + endPt -> x) / 2, (startPt -> y + endPt -> y) / 2};
+            int radius = sqrt(getSqrEuclideanDistance(&centerPt, endPt));
+            box -> minx = centerPt.x - radius;
+            box -> miny = centerPt.y - radius;
+            box -> maxx = centerPt.x + radius;
+            box -> maxy = centerPt.y + radius;
+            break;
+        }
+        case DATATYPE_ELLIPSE: {
+            struct Vertex centerPt = {(startPt -> x + endPt -> x) / 2, (startPt -> y + endPt -> y) / 2};
+            int majorSemiAxis = abs(endPt -> x - centerPt.x);
+            int minorSemiAxis = abs(endPt -> y - centerPt.y);
+            box -> minx = centerPt.x - majorSemiAxis;
+            box -> miny = centerPt.y - minorSemiAxis;
+            box -> maxx = centerPt.x + majorSemiAxis;
+            box -> maxy = centerPt.y + minorSemiAxis;
+            break;
+        }
+        default: {
+            box -> minx = min(startPt -> x, endPt -> x);
+            box -> miny = min(startPt -> y, endPt -> y);
+            box -> maxx = max(startPt -> x, endPt -> x);
+            box -> maxy = max(startPt -> y, endPt -> y);
+            break;
+        }
+    }
+}
+
+// Copy a point into a vertex of its own, for a shape to keep
+static struct Vertex * copyVertex(const struct Vertex *vtx) {
+    return makeVertex(vtx -> x, vtx -> y);
+}
+
+struct LinkedNode *saveShape(struct LinkedList *list, const struct Vertex *startPt, const struct Vertex *endPt, int shapeType) {
+    assert(list != NULL && startPt != NULL && endPt != NULL);
+
+    switch (shapeType) {
+        case DATATYPE_SEGMENT: {
+            if (getManhattanDistance(startPt, endPt) <= FINDRULE_VARIATION) {
+                break;
+            }
+            struct LinkedNode *res = addNodeAtTail(list, makeData(makeSegment(copyVertex(startPt), copyVertex(endPt)), DATATYPE_SEGMENT));
+            return res;
+        }
+        case DATATYPE_RECTANGLE: {
+            if (abs(startPt -> x - endPt -> x) <= FINDRULE_VARIATION || abs(startPt -> y - endPt -> y) <= FINDRULE_VARIATION) {
+                break;
+            }
+            struct LinkedNode *res = addNodeAtTail(list, makeData(makeRectangle(copyVertex(startPt), copyVertex(endPt)), DATATYPE_RECTANGLE));
+            return res;
+        }
+        case DATATYPE_CIRCLE: {
+            struct Vertex centerPt = {(startPt -> x + endPt -> x) / 2, (startPt -> y + endPt -> y) / 2};
+            int radius = sqrt(getSqrEuclideanDistance(&centerPt, endPt));
+            if (radius <= FINDRULE_VARIATION) {
+                break;
+            }
+            struct LinkedNode *res = addNodeAtTail(list, makeData(makeCircle(copyVertex(&centerPt), radius), DATATYPE_CIRCLE));
+            return res;
+        }
+        case DATATYPE_ELLIPSE: {
+            struct Vertex centerPt = {(startPt -> x + endPt -> x) / 2, (startPt -> y + endPt -> y) / 2};
+            int majorSemiAxis = abs(endPt -> x - centerPt.x);
+            int minorSemiAxis = abs(endPt -> y - centerPt.y);
+            if (majorSemiAxis <= FINDRULE_VARIATION || minorSemiAxis <= FINDRULE_VARIATION) {
+                break;
+            }
+            struct LinkedNode *res = addNodeAtTail(list, makeData(makeEllipse(copyVertex(&centerPt), majorSemiAxis, minorSemiAxis), DATATYPE_ELLIPSE));
+            return res;
+        }
+        case DATATYPE_TEXT: {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+void editShape(struct LinkedList *list, struct LinkedNode *node, const struct Vertex *startPt, const struct Vertex *endPt) {
+    assert(list != NULL && node != NULL && node -> data != NULL && startPt != NULL && endPt != NULL);
+
+    switch (node -> data -> type) {
+        case DATATYPE_SEGMENT: {
+            if (getManhattanDistance(startPt, endPt) <= FINDRULE_VARIATION) {
+                break;
+            }
+            editNode(list, node, makeData(makeSegment(copyVertex(startPt), copyVertex(endPt)), DATATYPE_SEGMENT), destroyRule);
+            return;
+        }
+        case DATATYPE_RECTANGLE: {
+            if (abs(startPt -> x - endPt -> x) <= FINDRULE_VARIATION || abs(startPt -> y - endPt -> y) <= FINDRULE_VARIATION) {
+                break;
+            }
+            editNode(list, node, makeData(makeRectangle(copyVertex(startPt), copyVertex(endPt)), DATATYPE_RECTANGLE), destroyRule);
+            return;
+        }
+        case DATATYPE_CIRCLE: {
+            struct Vertex centerPt = {(startPt -> x + endPt -> x) / 2, (startPt -> y + endPt -> y) / 2};
+            int radius = sqrt(getSqrEuclideanDistance(&centerPt, endPt));
+            if (radius <= FINDRULE_VARIATION) {
+                break;
+            }
+            editNode(list, node, makeData(makeCircle(copyVertex(&centerPt), radius), DATATYPE_CIRCLE), destroyRule);
+            return;
+        }
+        case DATATYPE_ELLIPSE: {
+            struct Vertex centerPt = {(startPt -> x + endPt -> x) / 2, (startPt -> y + endPt -> y) / 2};
+            int majorSemiAxis = abs(endPt -> x - centerPt.x);
+            int minorSemiAxis = abs(endPt -> y - centerPt.y);
+            if (majorSemiAxis <= FINDRULE_VARIATION || minorSemiAxis <= FINDRULE_VARIATION) {
+                break;
+            }
+            editNode(list, node, makeData(makeEllipse(copyVertex(&centerPt), majorSemiAxis, minorSemiAxis), DATATYPE_ELLIPSE), destroyRule);
+            return;
+        }
+        case DATATYPE_TEXT: {
+            break;
+        }
+    }
+}
+
+struct LinkedNode *saveText(struct LinkedList *list, const struct Vertex *startPt, const struct Vertex *endPt,
+                            const char *text, int fontWidth, int fontHeight) {
+    struct LinkedNode *res = addNodeAtTail(list, makeData(makeText(makeRectangle(copyVertex(startPt), copyVertex(endPt)), text, fontWidth, fontHeight), DATATYPE_TEXT));
+    return res;
+}
+
+void editText(struct LinkedList *list, struct LinkedNode *node, const struct Vertex *startPt, const struct Vertex *endPt,
+              const char *text, int fontWidth, int fontHeight) {
+    assert(list != NULL && node != NULL && node -> data != NULL && startPt != NULL && endPt != NULL);
+
+    // The old content is copied before editNode() destroys it
+    if (text == NULL || fontWidth < 0 || fontHeight < 0) {
+        struct Text *txt = (struct Text *)node -> data -> content;
+        text = txt -> content;
+        fontWidth = txt -> fontWidth;
+        fontHeight = txt -> fontHeight;
+    }
+
+    if (abs(startPt -> x - endPt -> x) <= FINDRULE_VARIATION || abs(startPt -> y - endPt -> y) <= FINDRULE_VARIATION) {
+        return;
+    }
+
+    editNode(list, node, makeData(makeText(makeRectangle(copyVertex(startPt), copyVertex(endPt)), text, fontWidth, fontHeight), DATATYPE_TEXT), destroyRule);
+}
@@ -0,0 +1,383 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#include "undo.h"
+
+// What a step owns depends on which side of it the list is: an inserted node once the insertion is undone,
+// a removed node or a cleared chain until the removal is undone, and always the data an edited node does not hold.
+// A move owns nothing, it remembers where the node is not.
+// On a list owning documentRegion, a clear sets aside the whole generation of the region instead, and holds
+// whichever generation the list is not on. What other steps own then goes with the generation they were recorded in.
+struct UndoStep {
+    int kind;
+    bool isDetached;
+    // Head of the chain for UNDO_STEP_CLEAR
+    struct LinkedNode *node;
+    // Where a detached node is linked back after, or the other position of a moved one
+    struct LinkedNode *prev;
+    long long int rank;
+    struct NodeData *data;
+    void (*destroyDataFunc)(struct NodeData *);
+    // Bytes of the shapes involved, held only while owned
+    long long int shapeSize;
+    // Generation of documentRegion the step was recorded in
+    long long int generation;
+    // Generation set aside by UNDO_STEP_CLEAR, NULL when the chain is kept node by node
+    struct PoolRegionState *regionState;
+};
+
+// Steps from begin to current can be undone, those from current to end redone
+struct UndoHistory {
+    struct ListIndex index;
+    struct UndoStep *steps;
+    int capacity, begin, current, end;
+    long long int memorySize;
+    void (*destroyDataFunc)(struct NodeData *);
+    // documentRegion if the list owns it, NULL otherwise
+    struct PoolRegion *region;
+
+    // While a step is undone or redone, the hooks hand it what the list lets go of instead of recording anything
+    struct UndoStep *applyingStep;
+    // Position of the node about to move
+    struct LinkedNode *movingPrev;
+    long long int movingRank;
+};
+
+static long long int getDataMemory(const struct NodeData *data) {
+    long long int size = sizeof(struct NodeData);
+    switch (data -> type) {
+        case DATATYPE_SEGMENT: {
+            return size + sizeof(struct Segment) + 2 * sizeof(struct Vertex);
+        }
+        case DATATYPE_RECTANGLE: {
+            return size + sizeof(struct Rectangle) + 2 * sizeof(struct Vertex);
+        }
+        case DATATYPE_CIRCLE: {
+            return size + sizeof(struct Circle) + sizeof(struct Vertex);
+        }
+        case DATATYPE_ELLIPSE: {
+            return size + sizeof(struct Ellipse) + sizeof(struct Vertex);
+        }
+        case DATATYPE_TEXT: {
+            const struct Text *txt = (const struct Text *)data -> content;
+            return size + sizeof(struct Text) + sizeof(struct Rectangle) + 2 * sizeof(struct Vertex) + strlen(txt -> content) + 1;
+        }
+        default: {
+            return size;
+        }
+    }
+}
+
+static long long int getNodeMemory(const struct LinkedNode *node) {
+    return sizeof(struct LinkedNode) + getDataMemory(node -> data);
+}
+
+static bool isOwning(const struct UndoStep *step) {
+    return step -> kind == UNDO_STEP_EDIT || step -> isDetached;
+}
+
+static long long int getStepMemory(const struct UndoStep *step) {
+    return sizeof(struct UndoStep) + (isOwning(step) ? step -> shapeSize : 0);
+}
+
+// Free what the step owns
+// Complexity: O(1), O(n) for a cleared chain kept node by node
+static void releaseStep(struct UndoHistory *history, struct UndoStep *step) {
+    history -> memorySize -= getStepMemory(step);
+    if (step -> regionState != NULL) {
+        dropPoolRegionState(history -> region, step -> regionState);
+    } else if (history -> region != NULL && step -> generation != history -> region -> generation) {
+        // Set aside by a later clear, it goes with that generation
+    } else if (step -> kind == UNDO_STEP_EDIT) {
+        step -> destroyDataFunc(step -> data);
+    } else if (step -> isDetached) {
+        struct LinkedNode *cntNode = step -> node;
+        while (cntNode != NULL) {
+            struct LinkedNode *delNode = cntNode;
+            cntNode = step -> kind == UNDO_STEP_CLEAR ? cntNode -> next : NULL;
+            destroyNode(delNode, step -> destroyDataFunc);
+        }
+    }
+}
+
+static void releaseSteps(struct UndoHistory *history, int begin, int end) {
+    for (int i = begin; i < end; i++) {
+        releaseStep(history, &history -> steps[i]);
+    }
+}
+
+// Record a change, forgetting every undone one and, past the limits, the oldest ones
+// Returns false if out of memory, the history is then forgotten as a whole since it no longer matches the list
+// Complexity: O(1) amortized, plus whatever forgotten steps hold
+static bool pushStep(struct UndoHistory *history, const struct UndoStep *step) {
+    releaseSteps(history, history -> current, history -> end);
+    history -> end = history -> current;
+
+    if (history -> end == history -> capacity) {
+        if (history -> begin > 0) {
+            memmove(history -> steps, history -> steps + history -> begin,
+                    sizeof(struct UndoStep) * (history -> end - history -> begin));
+            history -> end -= history -> begin;
+            history -> begin = 0;
+        } else {
+            int newCapacity = history -> capacity * 2;
+            errno = 0;
+            struct UndoStep *newSteps = (struct UndoStep *)realloc(history -> steps, sizeof(struct UndoStep) * newCapacity);
+            if (newSteps == NULL) {
+                perror("pushStep");
+                clearUndoHistory(history);
+                return false;
+            }
+            history -> steps = newSteps;
+            history -> capacity = newCapacity;
+        }
+    }
+
+    history -> steps[history -> end] = *step;
+    history -> steps[history -> end++].generation = history -> region == NULL ? 0 : history -> region -> generation;
+    history -> current = history -> end;
+    history -> memorySize += getStepMemory(step);
+
+    while (history -> current - history -> begin > 1 &&
+           (history -> current - history -> begin > UNDO_MAX_STEPS || history -> memorySize > UNDO_MEMORY_LIMIT)) {
+        releaseStep(history, &history -> steps[history -> begin++]);
+    }
+    return true;
+}
+
+static void initStep(struct UndoStep *step, int kind, struct LinkedNode *node,
+                     void (*destroyDataFunc)(struct NodeData *)) {
+    memset(step, 0, sizeof(struct UndoStep));
+    step -> kind = kind;
+    step -> node = node;
+    step -> destroyDataFunc = destroyDataFunc;
+}
+
+static void insertHook(void *impl, struct LinkedNode *node) {
+    struct UndoHistory *history = (struct UndoHistory *)impl;
+    if (history -> applyingStep != NULL) {
+        return;
+    }
+    struct UndoStep step;
+    initStep(&step, UNDO_STEP_INSERT, node, history -> destroyDataFunc);
+    step.shapeSize = getNodeMemory(node);
+    pushStep(history, &step);
+}
+
+static void preReorderHook(void *impl, struct LinkedNode *node) {
+    struct UndoHistory *history = (struct UndoHistory *)impl;
+    history -> movingPrev = node -> prev;
+    history -> movingRank = node -> rank;
+}
+
+static void reorderHook(void *impl, struct LinkedNode *node) {
+    struct UndoHistory *history = (struct UndoHistory *)impl;
+    if (history -> applyingStep != NULL) {
+        return;
+    }
+    struct UndoStep step;
+    initStep(&step, UNDO_STEP_MOVE, node, history -> destroyDataFunc);
+    step.prev = history -> movingPrev;
+    step.rank = history -> movingRank;
+    pushStep(history, &step);
+}
+
+static bool retainNodeHook(void *impl, struct LinkedNode *node, void (*destroyDataFunc)(struct NodeData *)) {
+    struct UndoHistory *history = (struct UndoHistory *)impl;
+    if (history -> applyingStep != NULL) {
+        history -> applyingStep -> isDetached = true;
+        history -> applyingStep -> prev = node -> prev;
+        return true;
+    }
+    // The caller keeps the content, so the removal cannot be undone and neither can anything before it
+    if (destroyDataFunc == NULL) {
+        clearUndoHistory(history);
+        return false;
+    }
+    struct UndoStep step;
+    initStep(&step, UNDO_STEP_REMOVE, node, destroyDataFunc);
+    step.isDetached = true;
+    step.prev = node -> prev;
+    step.shapeSize = getNodeMemory(node);
+    return pushStep(history, &step);
+}
+
+static bool retainDataHook(void *impl, struct LinkedNode *node, struct NodeData *oldData,
+                           void (*destroyDataFunc)(struct NodeData *)) {
+    struct UndoHistory *history = (struct UndoHistory *)impl;
+    if (history -> applyingStep != NULL) {
+        history -> applyingStep -> data = oldData;
+        history -> applyingStep -> shapeSize = getDataMemory(oldData);
+        return true;
+    }
+    struct UndoStep step;
+    initStep(&step, UNDO_STEP_EDIT, node, destroyDataFunc);
+    step.data = oldData;
+    step.shapeSize = getDataMemory(oldData);
+    return pushStep(history, &step);
+}
+
+// Complexity: O(1) when the list owns documentRegion, O(n) otherwise to weigh the chain
+static bool retainListHook(void *impl, struct LinkedNode *head, struct LinkedNode *tail, int size,
+                           void (*destroyDataFunc)(struct NodeData *)) {
+    (void)tail;
+    (void)size;
+    struct UndoHistory *history = (struct UndoHistory *)impl;
+    if (history -> applyingStep != NULL) {
+        history -> applyingStep -> isDetached = true;
+        return true;
+    }
+    if (destroyDataFunc == NULL) {
+        clearUndoHistory(history);
+        return false;
+    }
+    struct UndoStep step;
+    initStep(&step, UNDO_STEP_CLEAR, head, destroyDataFunc);
+    step.isDetached = true;
+    if (history -> region != NULL) {
+        step.shapeSize = getPoolRegionBytes(history -> region, NULL);
+    } else {
+        for (const struct LinkedNode *cntNode = head; cntNode != NULL; cntNode = cntNode -> next) {
+            step.shapeSize += getNodeMemory(cntNode);
+        }
+    }
+    if (!pushStep(history, &step)) {
+        return false;
+    }
+    // Set aside once older steps are forgotten, those of this generation can still be freed one by one.
+    // Should it fail, the chain is simply kept node by node
+    if (history -> region != NULL) {
+        history -> steps[history -> end - 1].regionState = setAsidePoolRegion(history -> region);
+    }
+    return true;
+}
+
+// Swap the list and the step to the other side of the change
+// Complexity: O(1) amortized, O(n) to link a cleared chain back
+static void applyStep(struct UndoHistory *history, struct LinkedList *list, struct UndoStep *step) {
+    history -> memorySize -= getStepMemory(step);
+    history -> applyingStep = step;
+    switch (step -> kind) {
+        case UNDO_STEP_INSERT:
+        case UNDO_STEP_REMOVE: {
+            if (step -> isDetached) {
+                relinkNode(list, step -> node, step -> prev);
+                step -> isDetached = false;
+            } else {
+                deleteNode(list, step -> node, step -> destroyDataFunc);
+                assert(step -> isDetached);
+            }
+            break;
+        }
+        case UNDO_STEP_EDIT: {
+            editNode(list, step -> node, step -> data, step -> destroyDataFunc);
+            break;
+        }
+        case UNDO_STEP_MOVE: {
+            struct LinkedNode *prevNode = step -> node -> prev;
+            long long int rank = step -> node -> rank;
+            moveNodeAfter(list, step -> node, step -> prev, step -> rank);
+            step -> prev = prevNode;
+            step -> rank = rank;
+            break;
+        }
+        case UNDO_STEP_CLEAR: {
+            if (step -> isDetached) {
+                if (step -> regionState != NULL) {
+                    swapPoolRegion(history -> region, step -> regionState);
+                }
+                relinkNodes(list, step -> node);
+                step -> isDetached = false;
+            } else {
+                destroyLinkedList(list, step -> destroyDataFunc);
+                assert(step -> isDetached);
+                if (step -> regionState != NULL) {
+                    swapPoolRegion(history -> region, step -> regionState);
+                }
+            }
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+    history -> applyingStep = NULL;
+    history -> memorySize += getStepMemory(step);
+}
+
+struct UndoHistory * makeUndoHistory(struct LinkedList *list, void (*destroyDataFunc)(struct NodeData *)) {
+    assert(list != NULL && destroyDataFunc != NULL);
+    errno = 0;
+    struct UndoHistory *history = (struct UndoHistory *)calloc(1, sizeof(struct UndoHistory));
+    struct UndoStep *steps = (struct UndoStep *)malloc(sizeof(struct UndoStep) * UNDO_INIT_CAPACITY);
+    if (history == NULL || steps == NULL) {
+        perror("makeUndoHistory");
+        free(history);
+        free(steps);
+        return NULL;
+    }
+    history -> steps = steps;
+    history -> capacity = UNDO_INIT_CAPACITY;
+    history -> destroyDataFunc = destroyDataFunc;
+    history -> region = list -> ownsRegion ? &documentRegion : NULL;
+
+    history -> index.kind = LIST_INDEX_UNDO;
+    history -> index.impl = history;
+    history -> index.insertFunc = insertHook;
+    history -> index.preReorderFunc = preReorderHook;
+    history -> index.reorderFunc = reorderHook;
+    history -> index.retainNodeFunc = retainNodeHook;
+    history -> index.retainDataFunc = retainDataHook;
+    history -> index.retainListFunc = retainListHook;
+    attachIndex(list, &history -> index);
+    return history;
+}
+
+void destroyUndoHistory(struct UndoHistory *history, struct LinkedList *list) {
+    assert(history != NULL && list != NULL);
+    detachIndex(list, &history -> index);
+    clearUndoHistory(history);
+    free(history -> steps);
+    free(history);
+    history = NULL;
+}
+
+void clearUndoHistory(struct UndoHistory *history) {
+    assert(history != NULL && history -> applyingStep == NULL);
+    releaseSteps(history, history -> begin, history -> end);
+    history -> begin = history -> current = history -> end = 0;
+    assert(history -> memorySize == 0);
+}
+
+bool undoChange(struct UndoHistory *history, struct LinkedList *list) {
+    assert(history != NULL && list != NULL);
+    if (history -> current == history -> begin) {
+        return false;
+    }
+    applyStep(history, list, &history -> steps[--history -> current]);
+    return true;
+}
+
+bool redoChange(struct UndoHistory *history, struct LinkedList *list) {
+    assert(history != NULL && list != NULL);
+    if (history -> current == history -> end) {
+        return false;
+    }
+    applyStep(history, list, &history -> steps[history -> current++]);
+    return true;
+}
+
+// Complexity: O(steps)
+void getUndoStatus(const struct UndoHistory *history, struct UndoStatus *status) {
+    assert(history != NULL && status != NULL);
+    status -> undoNum = history -> current - history -> begin;
+    status -> redoNum = history -> end - history -> current;
+    status -> memorySize = history -> memorySize;
+    status -> maxStepSize = 0;
+    for (int i = history -> begin; i < history -> end; i++) {
+        status -> maxStepSize = max(status -> maxStepSize, getStepMemory(&history -> steps[i]));
+    }
+}
@@ -0,0 +1,532 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <assert.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "vectorexport.h"
+#include "textwriter.h"
+#include "datatypes.h"
+#include "render.h"
+
+// Room reserved for one element or operator sequence, text content aside
+#define VECTOR_ELEMENT_MAX 1024
+
+// Width of a monospace glyph in em, that of PDF Courier
+#define VECTOR_GLYPH_WIDTH 0.6
+
+// Control point distance of a cubic Bezier quarter ellipse, per unit of radius
+#define VECTOR_BEZIER_KAPPA 0.5522847498
+
+// Decimals kept for curve control points and text scaling
+#define VECTOR_DECIMALS 2
+#define VECTOR_SCALE_DECIMALS 4
+
+// PDF objects are 1 catalog, 2 page tree, 3 page, 4 font, 5 content stream and 6 its length,
+// object 0 being the head of the free list
+#define PDF_OBJECT_NUMBER 7
+
+struct VectorTarget {
+    struct TextWriter *writer;
+    // Colors in effect, 0xRRGGBB, so that unchanged ones are not written again
+    unsigned int strokeColor, fillColor;
+};
+
+int getVectorFormat(const char *path) {
+    assert(path != NULL);
+    const char *extension = strrchr(path, '.');
+    if (extension == NULL || strlen(extension) != 4) {
+        return VECTOR_FORMAT_NONE;
+    }
+    char lower[4];
+    for (int i = 0; i < 3; i++) {
+        lower[i] = tolower((unsigned char)extension[i + 1]);
+    }
+    lower[3] = '\0';
+    if (strcmp(lower, "svg") == 0) {
+        return VECTOR_FORMAT_SVG;
+    }
+    if (strcmp(lower, "pdf") == 0) {
+        return VECTOR_FORMAT_PDF;
+    }
+    return VECTOR_FORMAT_NONE;
+}
+
+static int putString(char *out, const char *text) {
+    int length = strlen(text);
+    memcpy(out, text, length);
+    return length;
+}
+
+// Puts ` name="value"`
+static int putAttribute(char *out, const char *name, long long int value) {
+    int length = 0;
+    out[length++] = ' ';
+    length += putString(out + length, name);
+    out[length++] = '=';
+    out[length++] = '"';
+    length += formatInt(out + length, value);
+    out[length++] = '"';
+    return length;
+}
+
+// Puts #rrggbb
+static int putHexColor(char *out, unsigned int color) {
+    static const char hexDigits[] = "0123456789abcdef";
+    out[0] = '#';
+    for (int i = 0; i < 6; i++) {
+        out[i + 1] = hexDigits[(color >> (20 - 4 * i)) & 0xF];
+    }
+    return 7;
+}
+
+// Puts ` name="#rrggbb"`
+static int putColorAttribute(char *out, const char *name, unsigned int color) {
+    int length = 0;
+    out[length++] = ' ';
+    length += putString(out + length, name);
+    out[length++] = '=';
+    out[length++] = '"';
+    length += putHexColor(out + length, color);
+    out[length++] = '"';
+    return length;
+}
+
+// Puts the stroke attribute unless the enclosing group already strokes with color
+static int putSvgStroke(char *out, const struct VectorTarget *target, unsigned int color) {
+    color &= 0xFFFFFF;
+    return color == target -> strokeColor ? 0 : putColorAttribute(out, "stroke", color);
+}
+
+// Get the length of the UTF-8 sequence text starts with
+// Returns 0 if it does not start with a whole one
+static int getUtf8Length(const unsigned char *text, int textLength) {
+    int length = text[0] < 0x80 ? 1 : text[0] < 0xC2 ? 0 : text[0] < 0xE0 ? 2 : text[0] < 0xF0 ? 3 : text[0] < 0xF5 ? 4 : 0;
+    if (length > textLength) {
+        return 0;
+    }
+    for (int i = 1; i < length; i++) {
+        if ((text[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+// Text typed into EGE input boxes is in the ANSI code page on Windows, it is converted to the UTF-8
+// the document declares. Elsewhere it is taken to be UTF-8 already, and bytes breaking it become '?'
+// Returns the length put into out, which holds up to 3 bytes for every byte of text
+static int putUtf8Text(char *out, const char *text, int textLength) {
+#ifdef _WIN32
+    wchar_t wideText[DATATYPE_TEXT_MAX_LENGTH];
+    int wideLength = MultiByteToWideChar(CP_ACP, 0, text, textLength, wideText, DATATYPE_TEXT_MAX_LENGTH);
+    int utf8Length = wideLength <= 0 ? 0 : WideCharToMultiByte(CP_UTF8, 0, wideText, wideLength, out, 3 * textLength, NULL, NULL);
+    if (utf8Length > 0) {
+        return utf8Length;
+    }
+#endif
+    const unsigned char *bytes = (const unsigned char *)text;
+    int length = 0;
+    for (int i = 0; i < textLength; ) {
+        int sequenceLength = getUtf8Length(bytes + i, textLength - i);
+        if (sequenceLength == 0) {
+            out[length++] = '?';
+            i++;
+            continue;
+        }
+        memcpy(out + length, bytes + i, sequenceLength);
+        length += sequenceLength;
+        i += sequenceLength;
+    }
+    return length;
+}
+
+// Characters with a meaning in XML are escaped, control characters it forbids become spaces
+// Returns the length put into out, which holds up to 5 bytes for every byte of text
+static int putSvgText(char *out, const char *text, int textLength) {
+    char utf8Text[3 * DATATYPE_TEXT_MAX_LENGTH];
+    assert(textLength <= DATATYPE_TEXT_MAX_LENGTH);
+    textLength = putUtf8Text(utf8Text, text, textLength);
+    int length = 0;
+    for (int i = 0; i < textLength; i++) {
+        unsigned char c = utf8Text[i];
+        if (c == '&') {
+            length += putString(out + length, "&amp;");
+        } else if (c == '<') {
+            length += putString(out + length, "&lt;");
+        } else if (c == '>') {
+            length += putString(out + length, "&gt;");
+        } else {
+            out[length++] = c < 0x20 ? ' ' : c;
+        }
+    }
+    return length;
+}
+
+static void svgLineHook(void *impl, int x0, int y0, int x1, int y1, unsigned int color) {
+    struct VectorTarget *target = (struct VectorTarget *)impl;
+    char *out = reserveTextWriter(target -> writer, VECTOR_ELEMENT_MAX);
+    int length = putString(out, "<line");
+    length += putAttribute(out + length, "x1", x0);
+    length += putAttribute(out + length, "y1", y0);
+    length += putAttribute(out + length, "x2", x1);
+    length += putAttribute(out + length, "y2", y1);
+    length += putSvgStroke(out + length, target, color);
+    length += putString(out + length, "/>\n");
+    commitTextWriter(target -> writer, length);
+}
+
+static void svgRectangleHook(void *impl, int left, int top, int right, int bottom, unsigned int color) {
+    struct VectorTarget *target = (struct VectorTarget *)impl;
+    char *out = reserveTextWriter(target -> writer, VECTOR_ELEMENT_MAX);
+    int length = putString(out, "<rect");
+    length += putAttribute(out + length, "x", min(left, right));
+    length += putAttribute(out + length, "y", min(top, bottom));
+    length += putAttribute(out + length, "width", abs(right - left));
+    length += putAttribute(out + length, "height", abs(bottom - top));
+    length += putSvgStroke(out + length, target, color);
+    length += putString(out + length, "/>\n");
+    commitTextWriter(target -> writer, length);
+}
+
+static void svgCircleHook(void *impl, int centerx, int centery, int radius, unsigned int color) {
+    struct VectorTarget *target = (struct VectorTarget *)impl;
+    char *out = reserveTextWriter(target -> writer, VECTOR_ELEMENT_MAX);
+    int length = putString(out, "<circle");
+    length += putAttribute(out + length, "cx", centerx);
+    length += putAttribute(out + length, "cy", centery);
+    length += putAttribute(out + length, "r", radius);
+    length += putSvgStroke(out + length, target, color);
+    length += putString(out + length, "/>\n");
+    commitTextWriter(target -> writer, length);
+}
+
+static void svgEllipseHook(void *impl, int centerx, int centery, int xRadius, int yRadius, unsigned int color) {
+    struct VectorTarget *target = (struct VectorTarget *)impl;
+    char *out = reserveTextWriter(target -> writer, VECTOR_ELEMENT_MAX);
+    int length = putString(out, "<ellipse");
+    length += putAttribute(out + length, "cx", centerx);
+    length += putAttribute(out + length, "cy", centery);
+    length += putAttribute(out + length, "rx", xRadius);
+    length += putAttribute(out + length, "ry", yRadius);
+    length += putSvgStroke(out + length, target, color);
+    length += putString(out + length, "/>\n");
+    commitTextWriter(target -> writer, length);
+}
+
+// Bounds are included, as with EGE bar()
+static void svgBarHook(void *impl, int left, int top, int right, int bottom, unsigned int color) {
+    struct VectorTarget *target = (struct VectorTarget *)impl;
+    char *out = reserveTextWriter(target -> writer, VECTOR_ELEMENT_MAX);
+    int length = putString(out, "<rect");
+    length += putAttribute(out + length, "x", min(left, right));
+    length += putAttribute(out + length, "y", min(top, bottom));
+    length += putAttribute(out + length, "width", abs(right - left) + 1);
+    length += putAttribute(out + length, "height", abs(bottom - top) + 1);
+    length += putColorAttribute(out + length, "fill", color & 0xFFFFFF);
+    length += putString(out + length, " stroke=\"none\"/>\n");
+    commitTextWriter(target -> writer, length);
+}
+
+// Sits on the bottom of its box, stretched to the box width
+static void svgTextHook(void *impl, const struct Vertex *startPt, const struct Vertex *endPt, const char *text,
+                        unsigned int color, bool isDraft) {
+    (void)isDraft;
+    struct VectorTarget *target = (struct VectorTarget *)impl;
+    int width = abs(endPt -> x - startPt -> x), height = abs(endPt -> y - startPt -> y);
+    int textLength = min((int)strlen(text), DATATYPE_TEXT_MAX_LENGTH);
+    if (height == 0 || textLength == 0) {
+        return;
+    }
+    char *out = reserveTextWriter(target -> writer, VECTOR_ELEMENT_MAX + 5 * textLength);
+    int length = putString(out, "<text");
+    length += putAttribute(out + length, "x", min(startPt -> x, endPt -> x));
+    length += putAttribute(out + length, "y", max(startPt -> y, endPt -> y));
+    length += putAttribute(out + length, "font-size", height);
+    if (width > 0) {
+        length += putAttribute(out + length, "textLength", width);
+        length += putString(out + length, " lengthAdjust=\"spacingAndGlyphs\"");
+    }
+    length += putColorAttribute(out + length, "fill", color & 0xFFFFFF);
+    length += putString(out + length, " stroke=\"none\">");
+    length += putSvgText(out + length, text, textLength);
+    length += putString(out + length, "</text>\n");
+    commitTextWriter(target -> writer, length);
+}
+
+// Complexity: O(n)
+bool exportSvg(const struct LinkedList *list, const char *path, int width, int height,
+               unsigned int color, unsigned int bgColor) {
+    assert(list != NULL && path != NULL && width > 0 && height > 0);
+    struct TextWriter *writer = makeTextWriter(path);
+    if (writer == NULL) {
+        return false;
+    }
+    struct VectorTarget target = {writer, color & 0xFFFFFF, bgColor & 0xFFFFFF};
+
+    char *out = reserveTextWriter(writer, VECTOR_ELEMENT_MAX);
+    int length = putString(out, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                                "<svg xmlns=\"http://www.w3.org/2000/svg\"");
+    length += putAttribute(out + length, "width", width);
+    length += putAttribute(out + length, "height", height);
+    length += putString(out + length, " viewBox=\"0 0 ");
+    length += formatInt(out + length, width);
+    out[length++] = ' ';
+    length += formatInt(out + length, height);
+    length += putString(out + length, "\">\n<rect");
+    length += putAttribute(out + length, "width", width);
+    length += putAttribute(out + length, "height", height);
+    length += putColorAttribute(out + length, "fill", target.fillColor);
+    length += putString(out + length, "/>\n<g fill=\"none\"");
+    length += putColorAttribute(out + length, "stroke", target.strokeColor);
+    length += putString(out + length, " font-family=\"monospace\">\n");
+    commitTextWriter(writer, length);
+
+    struct RenderBackend backend = {
+        &target, svgLineHook, svgRectangleHook, svgCircleHook, svgEllipseHook, svgBarHook, svgTextHook
+    };
+    renderList(&backend, list, color, false, NULL, NULL);
+
+    writeString(writer, "</g>\n</svg>\n");
+    return destroyTextWriter(writer);
+}
+
+static int putNumber(char *out, long long int value) {
+    int length = formatInt(out, value);
+    out[length++] = ' ';
+    return length;
+}
+
+static int putFixed(char *out, double value, int decimals) {
+    int length = formatFixed(out, value, decimals);
+    out[length++] = ' ';
+    return length;
+}
+
+// Puts "r g b operator" with the components scaled to [0, 1]
+static int putPdfColor(char *out, unsigned int color, const char *colorOperator) {
+    int length = 0;
+    for (int shift = 16; shift >= 0; shift -= 8) {
+        length += putFixed(out + length, ((color >> shift) & 0xFF) / 255.0, 3);
+    }
+    length += putString(out + length, colorOperator);
+    out[length++] = '\n';
+    return length;
+}
+
+static int putPdfStroke(char *out, struct VectorTarget *target, unsigned int color) {
+    color &= 0xFFFFFF;
+    if (color == target -> strokeColor) {
+        return 0;
+    }
+    target -> strokeColor = color;
+    return putPdfColor(out, color, "RG");
+}
+
+static int putPdfFill(char *out, struct VectorTarget *target, unsigned int color) {
+    color &= 0xFFFFFF;
+    if (color == target -> fillColor) {
+        return 0;
+    }
+    target -> fillColor = color;
+    return putPdfColor(out, color, "rg");
+}
+
+// Characters closing the string or escaping are escaped, control characters become spaces
+static int putPdfText(char *out, const char *text, int textLength) {
+    int length = 0;
+    for (int i = 0; i < textLength; i++) {
+        unsigned char c = text[i];
+        if (c == '(' || c == ')' || c == '\\') {
+            out[length++] = '\\';
+        }
+        out[length++] = c < 0x20 ? ' ' : c;
+    }
+    return length;
+}
+
+static void pdfLineHook(void *impl, int x0, int y0, int x1, int y1, unsigned int color) {
+    struct VectorTarget *target = (struct VectorTarget *)impl;
+    char *out = reserveTextWriter(target -> writer, VECTOR_ELEMENT_MAX);
+    int length = putPdfStroke(out, target, color);
+    length += putNumber(out + length, x0);
+    length += putNumber(out + length, y0);
+    length += putString(out + length, "m ");
+    length += putNumber(out + length, x1);
+    length += putNumber(out + length, y1);
+    length += putString(out + length, "l S\n");
+    commitTextWriter(target -> writer, length);
+}
+
+static void pdfRectangleHook(void *impl, int left, int top, int right, int bottom, unsigned int color) {
+    struct VectorTarget *target = (struct VectorTarget *)impl;
+    char *out = reserveTextWriter(target -> writer, VECTOR_ELEMENT_MAX);
+    int length = putPdfStroke(out, target, color);
+    length += putNumber(out + length, min(left, right));
+    length += putNumber(out + length, min(top, bottom));
+    length += putNumber(out + length, abs(right - left));
+    length += putNumber(out + length, abs(bottom - top));
+    length += putString(out + length, "re S\n");
+    commitTextWriter(target -> writer, length);
+}
+
+// Four cubic Bezier quarters, starting from the rightmost point
+static void pdfEllipseHook(void *impl, int centerx, int centery, int xRadius, int yRadius, unsigned int color) {
+    struct VectorTarget *target = (struct VectorTarget *)impl;
+    const double x = centerx, y = centery, rx = xRadius, ry = yRadius;
+    const double kx = VECTOR_BEZIER_KAPPA * rx, ky = VECTOR_BEZIER_KAPPA * ry;
+    const double controlPoints[12][2] = {
+        {x + rx, y + ky}, {x + kx, y + ry}, {x, y + ry},
+        {x - kx, y + ry}, {x - rx, y + ky}, {x - rx, y},
+        {x - rx, y - ky}, {x - kx, y - ry}, {x, y - ry},
+        {x + kx, y - ry}, {x + rx, y - ky}, {x + rx, y}
+    };
+    char *out = reserveTextWriter(target -> writer, VECTOR_ELEMENT_MAX);
+    int length = putPdfStroke(out, target, color);
+    length += putNumber(out + length, centerx + xRadius);
+    length += putNumber(out + length, centery);
+    length += putString(out + length, "m\n");
+    for (int i = 0; i < 12; i++) {
+        length += putFixed(out + length, controlPoints[i][0], VECTOR_DECIMALS);
+        length += putFixed(out + length, controlPoints[i][1], VECTOR_DECIMALS);
+        if (i % 3 == 2) {
+            length += putString(out + length, "c\n");
+        }
+    }
+    length += putString(out + length, "h S\n");
+    commitTextWriter(target -> writer, length);
+}
+
+static void pdfCircleHook(void *impl, int centerx, int centery, int radius, unsigned int color) {
+    pdfEllipseHook(impl, centerx, centery, radius, radius, color);
+}
+
+// Bounds are included, as with EGE bar()
+static void pdfBarHook(void *impl, int left, int top, int right, int bottom, unsigned int color) {
+    struct VectorTarget *target = (struct VectorTarget *)impl;
+    char *out = reserveTextWriter(target -> writer, VECTOR_ELEMENT_MAX);
+    int length = putPdfFill(out, target, color);
+    length += putNumber(out + length, min(left, right));
+    length += putNumber(out + length, min(top, bottom));
+    length += putNumber(out + length, abs(right - left) + 1);
+    length += putNumber(out + length, abs(bottom - top) + 1);
+    length += putString(out + length, "re f\n");
+    commitTextWriter(target -> writer, length);
+}
+
+// Sits on the bottom of its box, the text matrix undoes the page flip and stretches glyphs to the box width
+static void pdfTextHook(void *impl, const struct Vertex *startPt, const struct Vertex *endPt, const char *text,
+                        unsigned int color, bool isDraft) {
+    (void)isDraft;
+    struct VectorTarget *target = (struct VectorTarget *)impl;
+    int width = abs(endPt -> x - startPt -> x), height = abs(endPt -> y - startPt -> y);
+    int textLength = min((int)strlen(text), DATATYPE_TEXT_MAX_LENGTH);
+    if (height == 0 || textLength == 0) {
+        return;
+    }
+    double scale = width > 0 ? width / (VECTOR_GLYPH_WIDTH * height * textLength) : 1.0;
+    char *out = reserveTextWriter(target -> writer, VECTOR_ELEMENT_MAX + 2 * textLength);
+    int length = putPdfFill(out, target, color);
+    length += putString(out + length, "BT /F1 ");
+    length += putNumber(out + length, height);
+    length += putString(out + length, "Tf ");
+    length += putFixed(out + length, scale, VECTOR_SCALE_DECIMALS);
+    length += putString(out + length, "0 0 -1 ");
+    length += putNumber(out + length, min(startPt -> x, endPt -> x));
+    length += putNumber(out + length, max(startPt -> y, endPt -> y));
+    length += putString(out + length, "Tm (");
+    length += putPdfText(out + length, text, textLength);
+    length += putString(out + length, ") Tj ET\n");
+    commitTextWriter(target -> writer, length);
+}
+
+static void beginPdfObject(struct TextWriter *writer, long long int *offsets, int number) {
+    assert(number > 0 && number < PDF_OBJECT_NUMBER);
+    offsets[number] = writer -> offset;
+    writeInt(writer, number);
+    writeString(writer, " 0 obj\n");
+}
+
+// Cross-reference entries are exactly 20 bytes, offsets padded to 10 digits
+static void writePdfXref(struct TextWriter *writer, const long long int *offsets) {
+    writeString(writer, "xref\n0 ");
+    writeInt(writer, PDF_OBJECT_NUMBER);
+    writeString(writer, "\n0000000000 65535 f \n");
+    for (int i = 1; i < PDF_OBJECT_NUMBER; i++) {
+        char digits[TEXT_WRITER_MAX_NUMBER];
+        int digitNum = formatInt(digits, offsets[i]);
+        char *out = reserveTextWriter(writer, 20);
+        memset(out, '0', 10);
+        memcpy(out + 10 - digitNum, digits, digitNum);
+        memcpy(out + 10, " 00000 n \n", 10);
+        commitTextWriter(writer, 20);
+    }
+}
+
+// Complexity: O(n)
+bool exportPdf(const struct LinkedList *list, const char *path, int width, int height,
+               unsigned int color, unsigned int bgColor) {
+    assert(list != NULL && path != NULL && width > 0 && height > 0);
+    struct TextWriter *writer = makeTextWriter(path);
+    if (writer == NULL) {
+        return false;
+    }
+    long long int offsets[PDF_OBJECT_NUMBER] = {0};
+
+    // The binary comment tells transfer tools not to touch line ends
+    writeString(writer, "%PDF-1.4\n%\xE2\xE3\xCF\xD3\n");
+    beginPdfObject(writer, offsets, 1);
+    writeString(writer, "<< /Type /Catalog /Pages 2 0 R >>\nendobj\n");
+    beginPdfObject(writer, offsets, 2);
+    writeString(writer, "<< /Type /Pages /Kids [3 0 R] /Count 1 >>\nendobj\n");
+    beginPdfObject(writer, offsets, 3);
+    writeString(writer, "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 ");
+    writeInt(writer, width);
+    writeChar(writer, ' ');
+    writeInt(writer, height);
+    writeString(writer, "] /Resources << /Font << /F1 4 0 R >> >> /Contents 5 0 R >>\nendobj\n");
+    beginPdfObject(writer, offsets, 4);
+    writeString(writer, "<< /Type /Font /Subtype /Type1 /BaseFont /Courier >>\nendobj\n");
+
+    // The stream length is only known at its end, so it is an indirect object written afterwards
+    beginPdfObject(writer, offsets, 5);
+    writeString(writer, "<< /Length 6 0 R >>\nstream\n");
+    long long int streamBegin = writer -> offset;
+
+    // Flip the page so that y goes down as on screen, then paint the background
+    struct VectorTarget target = {writer, 0, 0};
+    char *out = reserveTextWriter(writer, VECTOR_ELEMENT_MAX);
+    int length = putString(out, "1 0 0 -1 0 ");
+    length += putNumber(out + length, height);
+    length += putString(out + length, "cm\n");
+    length += putPdfFill(out + length, &target, bgColor);
+    length += putString(out + length, "0 0 ");
+    length += putNumber(out + length, width);
+    length += putNumber(out + length, height);
+    length += putString(out + length, "re f\n");
+    commitTextWriter(writer, length);
+
+    struct RenderBackend backend = {
+        &target, pdfLineHook, pdfRectangleHook, pdfCircleHook, pdfEllipseHook, pdfBarHook, pdfTextHook
+    };
+    renderList(&backend, list, color, false, NULL, NULL);
+
+    long long int streamLength = writer -> offset - streamBegin;
+    writeString(writer, "\nendstream\nendobj\n");
+    beginPdfObject(writer, offsets, 6);
+    writeInt(writer, streamLength);
+    writeString(writer, "\nendobj\n");
+
+    long long int xrefOffset = writer -> offset;
+    writePdfXref(writer, offsets);
+    writeString(writer, "trailer\n<< /Size ");
+    writeInt(writer, PDF_OBJECT_NUMBER);
+    writeString(writer, " /Root 1 0 R >>\nstartxref\n");
+    writeInt(writer, xrefOffset);
+    writeString(writer, "\n%%EOF\n");
+    return destroyTextWriter(writer);
+}